@@ -91,6 +91,11 @@ namespace tair
     virtual int get_range(int area, const data_entry &pkey, const data_entry &start_key, const data_entry &end_key, 
                           int offset, int limit, std::vector<data_entry *>  &values,short type=CMD_RANGE_ALL)
     { return TAIR_RETURN_NOT_SUPPORTED; }
+    virtual int get_range_cursor(int area, const data_entry &pkey, const data_entry &start_key, const data_entry &end_key,
+                                 int limit, std::vector<data_entry *> &values, data_entry &cursor, short type=CMD_RANGE_ALL)
+    { return TAIR_RETURN_NOT_SUPPORTED; }
+    virtual int del_range_all(int area, const data_entry &pkey, const data_entry &start_key, const data_entry &end_key)
+    { return TAIR_RETURN_NOT_SUPPORTED; }
     virtual int hides(int area, const tair_dataentry_set &mkey_set, key_code_map_t &key_code_map)
     { return TAIR_RETURN_NOT_SUPPORTED; }
     virtual int removes(int area, const tair_dataentry_set &mkey_set, key_code_map_t &key_code_map)
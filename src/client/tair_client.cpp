@@ -76,9 +76,11 @@ namespace tair {
       cmd_map["release_mem"] = &tair_client::do_cmd_release_mem;
       cmd_map["backup_db"] = &tair_client::do_cmd_backup_db;
       cmd_map["unload_backuped_db"] = &tair_client::do_cmd_unload_backuped_db;
+      cmd_map["checkpoint_db"] = &tair_client::do_cmd_checkpoint_db;
       cmd_map["pause_gc"] = &tair_client::do_cmd_pause_gc;
       cmd_map["resume_gc"] = &tair_client::do_cmd_resume_gc;
       cmd_map["start_balance"] = &tair_client::do_cmd_start_balance;
+      cmd_map["balance_dry_run"] = &tair_client::do_cmd_balance_dry_run;
       cmd_map["stop_balance"] = &tair_client::do_cmd_stop_balance;
       cmd_map["set_balance_wait"] = &tair_client::do_cmd_set_balance_wait_ms;
       cmd_map["pause_rsync"] = &tair_client::do_cmd_pause_rsync;
@@ -472,6 +474,17 @@ namespace tair {
             );
       }
 
+      if (cmd == NULL || strcmp(cmd, "checkpoint_db") == 0) {
+         fprintf(stderr,
+                 "------------------------------------------------\n"
+                 "SYNOPSIS   : checkpoint_db dir [ds_addr]\n"
+                 "DESCRIPTION: make openable copy of ldb of all tairserver or specified `ds_addr under `dir on server,\n"
+                 "\t     sstables are hard linked. ship and catch up it by tool ldb_checkpoint\n"
+                 "\tdir: checkpoint directory on server, must be on the same file system as data dir to link sstables\n"
+                 "\tds_addr: address of tairserver\n"
+            );
+      }
+
       if (cmd == NULL || strcmp(cmd, "hide") == 0) {
         fprintf(stderr,
             "------------------------------------------------\n"
@@ -1835,6 +1848,11 @@ namespace tair {
      do_cmd_op_ds_or_not(param, "unload_backuped_db", TAIR_SERVER_CMD_UNLOAD_BACKUPED_DB);
    }
 
+   void tair_client::do_cmd_checkpoint_db(VSTRING& param)
+   {
+     do_cmd_op_ds_or_not(param, "checkpoint_db", TAIR_SERVER_CMD_CHECKPOINT_DB, 1);
+   }
+
    void tair_client::do_cmd_pause_gc(VSTRING& param)
    {
      do_cmd_op_ds_or_not(param, "pause_gc", TAIR_SERVER_CMD_PAUSE_GC);
@@ -1860,6 +1878,15 @@ namespace tair {
      do_cmd_op_ds_or_not(param, "start_balance", TAIR_SERVER_CMD_START_BALANCE);
    }
 
+   void tair_client::do_cmd_balance_dry_run(VSTRING& param)
+   {
+     // start balance but only report balance plan in server log
+     char dry_run[] = TAIR_BALANCE_DRY_RUN;
+     VSTRING cmd_param(1, dry_run);
+     cmd_param.insert(cmd_param.end(), param.begin(), param.end());
+     do_cmd_op_ds_or_not(cmd_param, "balance_dry_run", TAIR_SERVER_CMD_START_BALANCE, 1);
+   }
+
    void tair_client::do_cmd_stop_balance(VSTRING& param)
    {
      do_cmd_op_ds_or_not(param, "stop_balance", TAIR_SERVER_CMD_STOP_BALANCE);
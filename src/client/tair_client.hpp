@@ -103,11 +103,13 @@ namespace tair {
       void do_cmd_release_mem(VSTRING &param);
       void do_cmd_backup_db(VSTRING& param);
       void do_cmd_unload_backuped_db(VSTRING& param);
+      void do_cmd_checkpoint_db(VSTRING& param);
       void do_cmd_pause_gc(VSTRING &param);
       void do_cmd_resume_gc(VSTRING &param);
       void do_cmd_pause_rsync(VSTRING& param);
       void do_cmd_resume_rsync(VSTRING& param);
       void do_cmd_start_balance(VSTRING& param);
+      void do_cmd_balance_dry_run(VSTRING& param);
       void do_cmd_stop_balance(VSTRING& param);
       void do_cmd_set_balance_wait_ms(VSTRING &param);
       void do_cmd_set_config(VSTRING& param);
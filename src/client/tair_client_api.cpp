@@ -299,6 +299,17 @@ namespace tair {
     return impl == NULL ? TAIR_RETURN_NOT_INIT : impl->get_range(area, pkey, start_key, end_key, offset, limit, values, type);
   }
 
+  int tair_client_api::get_range_cursor(int area, const data_entry &pkey, const data_entry &start_key, const data_entry &end_key,
+      int limit, vector<data_entry *> &values, data_entry &cursor, short type)
+  {
+    return impl == NULL ? TAIR_RETURN_NOT_INIT : impl->get_range_cursor(area, pkey, start_key, end_key, limit, values, cursor, type);
+  }
+
+  int tair_client_api::del_range_all(int area, const data_entry &pkey, const data_entry &start_key, const data_entry &end_key)
+  {
+    return impl == NULL ? TAIR_RETURN_NOT_INIT : impl->del_range_all(area, pkey, start_key, end_key);
+  }
+
   int tair_client_api::removes(int area, const tair_dataentry_set &mkey_set, key_code_map_t &key_code_map)
   {
     return impl == NULL ? TAIR_RETURN_NOT_INIT : impl->removes(area, mkey_set, key_code_map);
@@ -650,4 +661,62 @@ namespace tair {
     return impl->query_from_invalidserver(stats);
   }
 
+  tair_range_iterator::tair_range_iterator(tair_client_api *client, int area, const data_entry &pkey,
+      const data_entry &start_key, const data_entry &end_key, int page_limit, short type)
+    : client(client), area(area), pkey(pkey), start_key(start_key), end_key(end_key),
+      page_limit(page_limit), type(type), done(true), pos(0)
+  {
+    has_key = type == CMD_RANGE_ALL || type == CMD_RANGE_KEY_ONLY ||
+      type == CMD_RANGE_ALL_REVERSE || type == CMD_RANGE_KEY_ONLY_REVERSE;
+    has_value = type == CMD_RANGE_ALL || type == CMD_RANGE_VALUE_ONLY ||
+      type == CMD_RANGE_ALL_REVERSE || type == CMD_RANGE_VALUE_ONLY_REVERSE;
+  }
+
+  tair_range_iterator::~tair_range_iterator()
+  {
+    clear_page();
+  }
+
+  int tair_range_iterator::first()
+  {
+    cursor.set_data(NULL, 0);
+    done = false;
+    return fetch();
+  }
+
+  int tair_range_iterator::next()
+  {
+    if (!valid()) {
+      return TAIR_RETURN_SUCCESS;
+    }
+    pos += (has_key ? 1 : 0) + (has_value ? 1 : 0);
+    return valid() ? TAIR_RETURN_SUCCESS : fetch();
+  }
+
+  int tair_range_iterator::fetch()
+  {
+    clear_page();
+    while (!done && page.empty()) {
+      int ret = client->get_range_cursor(area, pkey, start_key, end_key, page_limit, page, cursor, type);
+      if (ret == TAIR_RETURN_SUCCESS || ret == TAIR_RETURN_DATA_NOT_EXIST) {
+        done = true;
+      } else if (ret != TAIR_HAS_MORE_DATA) {
+        // range is broken, first() restarts it
+        clear_page();
+        done = true;
+        return ret;
+      }
+    }
+    return TAIR_RETURN_SUCCESS;
+  }
+
+  void tair_range_iterator::clear_page()
+  {
+    for (size_t i = 0; i < page.size(); ++i) {
+      delete page[i];
+    }
+    page.clear();
+    pos = 0;
+  }
+
 } /* tair */
@@ -321,6 +321,25 @@ namespace tair {
     int get_range(int area, const data_entry &pkey, const data_entry &start_key, const data_entry &end_key, 
         int offset, int limit, vector<data_entry *> &values, short type=CMD_RANGE_ALL);
 
+    /**
+     * @brief like get_range, but page by cursor instead of offset, each page costs
+     *        no more than reading it. see also tair_range_iterator.
+     * @param cursor: opaque position to resume from, empty for the first page;
+     *                set to the position of next page, or cleared when range is done.
+     * @return TAIR_RETURN_SUCCESS -- range is done, <0 -- fail, or TAIR_HAS_MORE_DATA -- call again with cursor.
+     */
+    int get_range_cursor(int area, const data_entry &pkey, const data_entry &start_key, const data_entry &end_key,
+        int limit, vector<data_entry *> &values, data_entry &cursor, short type=CMD_RANGE_ALL);
+
+    /**
+     * @brief remove all skeys in [start_key, end_key) of pkey at once, deleted items are not returned.
+     *        cost does not grow with the number of items, only supported by ldb.
+     * @param start_key: start skey, from the first skey if equals ""
+     * @param end_key: end skey(excluded), to the last skey if equals ""
+     * @return TAIR_RETURN_SUCCESS -- success, TAIR_RETURN_DATA_NOT_EXIST -- empty range, <0 -- fail.
+     */
+    int del_range_all(int area, const data_entry &pkey, const data_entry &start_key, const data_entry &end_key);
+
     /**
      * @brief remove multiple items, which were merged with the same prefix key
      * @param mkey_set: set of merged keys
@@ -632,5 +651,52 @@ protected:
     typedef data_entry_local_cache cache_type;
     cache_type *cache_impl[TAIR_MAX_AREA_COUNT];
   };
+
+  /**
+   * @brief iterate a range of prefix key, pages are fetched by get_range_cursor
+   *        when needed. entries are owned by iterator, valid until next().
+   *
+   *   tair_range_iterator it(&client, area, pkey, start_key, end_key);
+   *   for (ret = it.first(); it.valid(); ret = it.next()) { it.key(); it.value(); }
+   *   // ret < 0 if failed
+   */
+  class tair_range_iterator
+  {
+  public:
+    // page_limit: max entries per page, 0 for default
+    tair_range_iterator(tair_client_api *client, int area, const data_entry &pkey,
+        const data_entry &start_key, const data_entry &end_key, int page_limit = 0, short type = CMD_RANGE_ALL);
+    ~tair_range_iterator();
+
+    // (re)start from start_key
+    int first();
+    int next();
+    bool valid() const { return pos < page.size(); }
+
+    // NULL if not requested by type
+    const data_entry *key() const { return has_key ? page[pos] : NULL; }
+    const data_entry *value() const { return has_value ? page[pos + (has_key ? 1 : 0)] : NULL; }
+
+  private:
+    int fetch();
+    void clear_page();
+
+    tair_client_api *client;
+    int area;
+    data_entry pkey;
+    data_entry start_key;
+    data_entry end_key;
+    int page_limit;
+    short type;
+    bool has_key;
+    bool has_value;
+    data_entry cursor;
+    bool done;
+    vector<data_entry *> page;
+    size_t pos;
+
+    tair_range_iterator(const tair_range_iterator &);
+    tair_range_iterator &operator=(const tair_range_iterator &);
+  };
 }
 #endif
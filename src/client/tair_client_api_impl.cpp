@@ -1741,6 +1741,29 @@ FAIL:
 
   int tair_client_impl::get_range(int area, const data_entry &pkey, const data_entry &start_key, const data_entry &end_key, 
       int offset, int limit, vector<data_entry *> &values,short type)
+  {
+    return do_get_range(area, pkey, start_key, end_key, offset, limit, values, type, NULL);
+  }
+
+  int tair_client_impl::get_range_cursor(int area, const data_entry &pkey, const data_entry &start_key, const data_entry &end_key,
+      int limit, vector<data_entry *> &values, data_entry &cursor, short type)
+  {
+    return do_get_range(area, pkey, start_key, end_key, 0, limit, values, type, &cursor);
+  }
+
+  int tair_client_impl::del_range_all(int area, const data_entry &pkey, const data_entry &start_key, const data_entry &end_key)
+  {
+    // nothing is returned, offset and limit are ignored by server
+    vector<data_entry *> values;
+    int ret = do_get_range(area, pkey, start_key, end_key, 0, 0, values, CMD_DEL_RANGE_ALL, NULL);
+    for (size_t i = 0; i < values.size(); ++i) {
+      delete values[i];
+    }
+    return ret;
+  }
+
+  int tair_client_impl::do_get_range(int area, const data_entry &pkey, const data_entry &start_key, const data_entry &end_key,
+      int offset, int limit, vector<data_entry *> &values, short type, data_entry *cursor)
   {
     if ( area < 0 || area >= TAIR_MAX_AREA_COUNT) {
       return TAIR_RETURN_INVALID_ARGUMENT;
@@ -1774,6 +1797,10 @@ FAIL:
     packet->key_start.set_prefix_size(merge_skey.get_prefix_size());
     packet->key_end.set_data(merge_ekey.get_data(), merge_ekey.get_size());
     packet->key_end.set_prefix_size(merge_ekey.get_prefix_size());
+    if (cursor != NULL) {
+      packet->range_flag = RANGE_FLAG_CURSOR;
+      packet->cursor = *cursor;
+    }
 
     int ret = TAIR_RETURN_SEND_FAILED;
     base_packet *tpacket = 0;
@@ -1816,6 +1843,16 @@ FAIL:
           ret = TAIR_HAS_MORE_DATA;
         }
       }
+      if (cursor != NULL) {
+        if (resp->get_hascursor()) {
+          *cursor = resp->cursor;
+        } else if (ret == TAIR_HAS_MORE_DATA) {
+          // server without cursor mode
+          ret = TAIR_RETURN_NOT_SUPPORTED;
+        } else if (ret == TAIR_RETURN_SUCCESS || ret == TAIR_RETURN_DATA_NOT_EXIST) {
+          cursor->set_data(NULL, 0);
+        }
+      }
     }
 
     this_wait_object_manager->destroy_wait_object(cwo);
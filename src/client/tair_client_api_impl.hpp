@@ -186,6 +186,11 @@ namespace tair {
     int get_range(int area, const data_entry &pkey, const data_entry &start_key, const data_entry &end_key, 
         int offset, int limit, vector<data_entry *>  &values,short type=CMD_RANGE_ALL);
 
+    int get_range_cursor(int area, const data_entry &pkey, const data_entry &start_key, const data_entry &end_key,
+        int limit, vector<data_entry *> &values, data_entry &cursor, short type=CMD_RANGE_ALL);
+
+    int del_range_all(int area, const data_entry &pkey, const data_entry &start_key, const data_entry &end_key);
+
     int hides(int area, const tair_dataentry_set &mkey_set, key_code_map_t &key_code_map);
 
     int removes(int area, const tair_dataentry_set &mkey_set, key_code_map_t &key_code_map);
@@ -281,6 +286,10 @@ namespace tair {
   private:
 
     bool startup(uint64_t master_cfgsvr, uint64_t slave_cfgsvr, const char *group_name);
+
+    // cursor mode if cursor is not NULL
+    int do_get_range(int area, const data_entry &pkey, const data_entry &start_key, const data_entry &end_key,
+        int offset, int limit, vector<data_entry *> &values, short type, data_entry *cursor);
     bool directup(uint64_t data_server);
 
     bool initialize();
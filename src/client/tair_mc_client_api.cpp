@@ -280,6 +280,14 @@ namespace tair
       return read_client->delegate.get_range(area, pkey, start_key, end_key, offset, limit, values, type);
    }
 
+   int tair_mc_client_api::get_range_cursor(int area, const data_entry &pkey, const data_entry &start_key,
+                                            const data_entry &end_key, int limit, vector<data_entry *> &values,
+                                            data_entry &cursor, short type)
+   {
+      tair_client_wrapper_sptr read_client = controller.choose_client_wrapper_for_read();
+      return read_client->delegate.get_range_cursor(area, pkey, start_key, end_key, limit, values, cursor, type);
+   }
+
    int tair_mc_client_api::removes(int area, const tair_dataentry_set &mkey_set, key_code_map_t &key_code_map)
    {
       const client_vector_sptr write_clients = controller.choose_client_wrapper_for_write();
@@ -295,6 +295,12 @@ namespace tair
       int get_range(int area, const data_entry &pkey, const data_entry &start_key, const data_entry &end_key,
                     int offset, int limit, vector<data_entry *> &values, short type=CMD_RANGE_ALL);
 
+      /**
+       * @brief like get_range, but page by cursor, see tair_client_api::get_range_cursor
+       */
+      int get_range_cursor(int area, const data_entry &pkey, const data_entry &start_key, const data_entry &end_key,
+                           int limit, vector<data_entry *> &values, data_entry &cursor, short type=CMD_RANGE_ALL);
+
       /**
        * @brief remove multiple items, which were merged with the same prefix key
        * @param mkey_set: set of merged keys
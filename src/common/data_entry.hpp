@@ -38,8 +38,10 @@ namespace tair
        {
          alloc = false;
          data = NULL;
+         unpin_ = NULL;
 
-         set_data(entry.data, entry.size, entry.alloc, entry.has_merged);
+         // pinned data is owned by entry only
+         set_data(entry.data, entry.size, entry.alloc || entry.unpin_ != NULL, entry.has_merged);
          prefix_size = entry.prefix_size;
          has_merged = entry.has_merged;
          has_meta_merged = entry.has_meta_merged;
@@ -53,7 +55,7 @@ namespace tair
        {
          if (this == &entry)
            return *this;
-         set_data(entry.data, entry.size, entry.alloc, entry.has_merged);
+         set_data(entry.data, entry.size, entry.alloc || entry.unpin_ != NULL, entry.has_merged);
          prefix_size = entry.prefix_size;
          has_merged = entry.has_merged;
          has_meta_merged = entry.has_meta_merged;
@@ -163,6 +165,7 @@ namespace tair
          if (m_true_data&& alloc) {
            free(m_true_data);
          }
+         unpin();
          //free_data();
        }
 
@@ -201,6 +204,7 @@ namespace tair
            memcpy(m_true_data+2, data, size);
 
            if(alloc) {free(data);data=NULL;}
+           unpin();
            //reset flags;
            hashcode = 0;
            data=m_true_data;
@@ -268,6 +272,18 @@ namespace tair
          }
        }
 
+       // data is memory pinned by storage engine (eg. block cache of ldb),
+       // not copied. (*unpin)(arg) is called when data is freed.
+       typedef void (*unpin_function)(void *arg);
+       void set_pinned_data(const char *data, int size, unpin_function unpin, void *arg)
+       {
+         free_data();
+         this->data = this->m_true_data = (char *) data;
+         this->size = this->m_true_size = size;
+         unpin_ = unpin;
+         unpin_arg_ = arg;
+       }
+
        void set_alloced_data(const char *data, int size)
        {
          free_data();
@@ -464,6 +480,8 @@ namespace tair
          size = m_true_size = 0;
          prefix_size = 0;
          data = m_true_data = NULL;
+         unpin_ = NULL;
+         unpin_arg_ = NULL;
 
          has_merged = false;
          has_meta_merged = false;
@@ -478,6 +496,7 @@ namespace tair
          if (m_true_data&& alloc) {
            free(m_true_data);
          }
+         unpin();
          data = NULL;
          m_true_data = NULL;
          alloc = false;
@@ -488,6 +507,15 @@ namespace tair
        }
 
      private:
+       inline void unpin()
+       {
+         if (unpin_ != NULL) {
+           (*unpin_)(unpin_arg_);
+           unpin_ = NULL;
+           unpin_arg_ = NULL;
+         }
+       }
+
        int size;
        int prefix_size;
        char *data;
@@ -496,6 +524,8 @@ namespace tair
 
        int m_true_size;  //if has_merged ,or m_true_size=size+2
        char *m_true_data; //if has_merged arae,same as data,or data=m_true_data+2;
+       unpin_function unpin_;  //not NULL if data is pinned
+       void *unpin_arg_;
      public:
        bool has_merged;
        bool has_meta_merged;
@@ -104,6 +104,10 @@
 //hasnext flag for getrange
 #define FLAG_HASNEXT                (0x01)
 #define FLAG_HASNEXT_MASK           (0xFFFE)
+//response of getrange carries a cursor to resume from
+#define FLAG_HASCURSOR              (0x02)
+//request flag of getrange: cursor mode, offset is ignored
+#define RANGE_FLAG_CURSOR           (0x01)
 //////////////////////////////////////////////
 #define TAIRPUBLIC_SECTION           "public"
 #define TAIRSERVER_SECTION           "tairserver"
@@ -137,6 +141,7 @@
 #define TAIR_DUMP_DIR                "data_dump_dir"
 #define TAIR_DEFAULT_DUMP_DIR        "dump"
 #define TAIR_TASK_QUEUE_SIZE         "task_queue_size"
+#define TAIR_READ_THREAD_COUNT       "read_thread_num"
 #define TAIR_DO_RSYNC                "do_rsync"
 #define TAIR_RSYNC_MTIME_CARE        "rsync_mtime_care"
 #define TAIR_RSYNC_WAIT_US           "rsync_wait_us"
@@ -190,15 +195,34 @@
 // LDB
 #define LDB_DATA_DIR                    "data_dir"
 #define LDB_DEFAULT_DATA_DIR            "data/ldb"
+#define LDB_DATA_DIR_TARGET_SIZE        "ldb_data_dir_target_size"
+#define LDB_EXTRA_DATA_DIRS             "ldb_extra_data_dirs"
 #define LDB_DB_INSTANCE_COUNT           "ldb_db_instance_count"
 #define LDB_BUCKET_INDEX_TO_INSTANCE_STRATEGY "ldb_bucket_index_to_instance_strategy"
 #define LDB_BUCKET_INDEX_FILE_DIR       "ldb_bucket_index_file_dir"
 #define LDB_BUCKET_INDEX_CAN_UPDATE     "ldb_bucket_index_can_update"
+#define LDB_BALANCE_SAMPLE_SECONDS      "ldb_balance_sample_seconds"
+#define LDB_BALANCE_SIZE_WEIGHT         "ldb_balance_size_weight"
+#define LDB_BALANCE_TOLERANCE_PERCENT   "ldb_balance_tolerance_percent"
+#define LDB_BALANCE_MAX_MOVE_SIZE       "ldb_balance_max_move_size"
 #define LDB_LOAD_BACKUP_VERSION         "ldb_load_backup_version"
+#define LDB_CONCURRENT_MEMTABLE_WRITE   "ldb_concurrent_memtable_write"
+#define LDB_PINNED_GET                  "ldb_pinned_get"
+#define LDB_OPEN_THREAD_COUNT           "ldb_open_thread_count"
+#define LDB_RECOVER_LOG_THREADS         "ldb_recover_log_threads"
+#define LDB_PRELOAD_TABLE_THREADS       "ldb_preload_table_threads"
 #define LDB_DB_VERSION_CARE             "ldb_db_version_care"
 #define LDB_CACHE_STAT_FILE_SIZE        "ldb_cache_stat_file_size"
+#define LDB_CACHE_HOT_KEY_COUNT         "ldb_cache_hot_key_count"
+#define LDB_CACHE_HOT_KEY_SAVE_INTERVAL "ldb_cache_hot_key_save_interval"
+#define LDB_CACHE_WARM_UP_RATE          "ldb_cache_warm_up_rate"
 #define LDB_COMPACT_GC_RANGE            "ldb_compact_gc_range"
 #define LDB_CHECK_COMPACT_INTERVAL      "ldb_check_compact_interval"
+#define LDB_COMPACT_EXPIRED_MIN_SIZE    "ldb_compact_expired_min_size"
+#define LDB_COMPACT_EXPIRED_FILE_COUNT  "ldb_compact_expired_file_count"
+#define LDB_PERSIST_FILE_TIME_META      "ldb_persist_file_time_meta"
+#define LDB_GC_BUCKET_RECLAIM           "ldb_gc_bucket_reclaim"
+#define LDB_RANGE_DELETION_COMPACT_TRIGGER "ldb_range_deletion_compact_trigger"
 #define LDB_USE_CACHE_COUNT             "ldb_use_cache_count"
 #define LDB_MIGRATE_BATCH_COUNT         "ldb_migrate_batch_count"
 #define LDB_MIGRATE_BATCH_SIZE          "ldb_migrate_batch_size"
@@ -217,8 +241,14 @@
 #define LDB_TARGET_FILE_SIZE            "ldb_target_file_size"
 #define LDB_BLOCK_SIZE                  "ldb_block_size"
 #define LDB_BLOCK_RESTART_INTERVAL      "ldb_block_restart_interval"
+#define LDB_DATA_BLOCK_HASH_INDEX       "ldb_data_block_hash_index"
+#define LDB_BLOB_VALUE_SIZE             "ldb_blob_value_size"
+#define LDB_BLOB_GC_RATIO               "ldb_blob_gc_ratio"
 #define LDB_TABLE_CACHE_SIZE            "ldb_table_cache_size"
 #define LDB_BLOCK_CACHE_SIZE            "ldb_block_cache_size"
+#define LDB_BLOCK_CACHE_SHARD_BITS      "ldb_block_cache_shard_bits"
+#define LDB_SHARED_BLOCK_CACHE_SIZE     "ldb_shared_block_cache_size"
+#define LDB_SHARED_WRITE_BUFFER_SIZE    "ldb_shared_write_buffer_size"
 #define LDB_ARENABLOCK_SIZE             "ldb_arenablock_size"
 #define LDB_COMPRESSION                 "ldb_compression"
 #define LDB_L0_COMPACTION_TRIGGER       "ldb_l0_compaction_trigger"
@@ -228,9 +258,14 @@
 #define LDB_BASE_LEVEL_SIZE             "ldb_base_level_size"
 #define LDB_READ_VERIFY_CHECKSUMS       "ldb_read_verify_checksums"
 #define LDB_WRITE_SYNC                  "ldb_write_sync"
+#define LDB_PIPELINED_LOG_SYNC          "ldb_pipelined_log_sync"
+#define LDB_LOG_SYNC_DELAY_US           "ldb_log_sync_delay_us"
 #define LDB_BLOOMFILTER_BITS_PER_KEY    "ldb_bloomfilter_bits_per_key"
+#define LDB_BLOOMFILTER_LEVEL_BITS_PER_KEY "ldb_bloomfilter_level_bits_per_key"
+#define LDB_FILTER_POLICY               "ldb_filter_policy"
 #define LDB_FILTER_BASE_LOGARITHM       "ldb_filter_base_logarithm"
 #define LDB_RANGE_MAX_SIZE              "ldb_range_max_size"
+#define LDB_PREFIX_GETS_MERGE_GAP       "ldb_prefix_gets_merge_gap"
 #define LDB_LIMIT_COMPACT_LEVEL_COUNT   "ldb_limit_compact_level_count"
 #define LDB_LIMIT_COMPACT_COUNT_INTERVAL "ldb_limit_compact_count_interval"
 #define LDB_LIMIT_COMPACT_TIME_INTERVAL "ldb_limit_compact_time_interval"
@@ -238,6 +273,17 @@
 #define LDB_LIMIT_DELETE_OBSOLETE_FILE_INTERVAL      "ldb_limit_delete_obsolete_file_interval"
 #define LDB_DO_SEEK_COMPACTION          "ldb_do_seek_compaction"
 #define LDB_DO_SPLIT_MMT_COMPACTION     "ldb_do_split_mmt_compaction"
+#define LDB_NEGATIVE_CACHE_SLOT_COUNT   "ldb_negative_cache_slot_count"
+#define LDB_VERSION_INDEX_SLOT_COUNT    "ldb_version_index_slot_count"
+#define LDB_FLUSH_RATE_LIMIT            "ldb_flush_rate_limit"
+#define LDB_COMPACTION_RATE_LIMIT       "ldb_compaction_rate_limit"
+#define LDB_SCAN_RATE_LIMIT             "ldb_scan_rate_limit"
+#define LDB_RATE_LIMIT_TARGET_READ_LATENCY "ldb_rate_limit_target_read_latency"
+#define LDB_RATE_LIMIT_MIN_PERCENT      "ldb_rate_limit_min_percent"
+#define LDB_MIGRATE_BY_FILE             "ldb_migrate_by_file"
+#define LDB_SCAN_READAHEAD_SIZE         "ldb_scan_readahead_size"
+#define LDB_SCAN_PREFETCH_TABLE         "ldb_scan_prefetch_table"
+#define LDB_KEY_FORMAT                  "ldb_key_format"
 
 // file storage engine config items
 #define FDB_INDEX_MMAP_SIZE             "index_mmap_size"
@@ -385,6 +431,8 @@ enum {
    TAIR_RETURN_HIDDEN = -3969,
    TAIR_RETURN_QUEUE_OVERFLOWED = -3968,
    TAIR_RETURN_SHOULD_PROXY = -3967,
+   // server internal: get needs disk read, but can't block now
+   TAIR_RETURN_WOULD_BLOCK = -3966,
 
    // for lock
    TAIR_RETURN_LOCK_EXIST = -3975,
@@ -414,6 +462,13 @@ enum {
    TAIR_RETURN_NONE_DATASERVER = -5113,
 };
 
+// how get may read storage engine
+enum {
+   TAIR_READ_BLOCKING = 0,      // read disk if needed
+   TAIR_READ_NONBLOCKING,       // read memory only, TAIR_RETURN_WOULD_BLOCK if disk read is needed
+   TAIR_READ_RESUMED,           // blocking read resuming a nonblocking one, stat is not counted again
+};
+
 enum {
    TAIR_SERVERFLAG_CLIENT = 0,
    TAIR_SERVERFLAG_DUPLICATE,
@@ -461,10 +516,14 @@ typedef enum {
   TAIR_SERVER_CMD_SET_BALANCE_WAIT_MS,
   TAIR_SERVER_CMD_MIGRATE_BUCKET,
   TAIR_SERVER_CMD_UNLOAD_BACKUPED_DB,
+  TAIR_SERVER_CMD_CHECKPOINT_DB,
   // all cmd type should be less TAIR_SERVER_CMD_MAX_TYPE
   TAIR_SERVER_CMD_MAX_TYPE,
 } ServerCmdType;
 
+// param of TAIR_SERVER_CMD_START_BALANCE: only report balance plan, move nothing
+#define TAIR_BALANCE_DRY_RUN "dry_run"
+
 typedef enum {
   CMD_RANGE_ALL = 1,  
   CMD_RANGE_VALUE_ONLY,  
@@ -475,6 +534,8 @@ typedef enum {
   // all GET_RANGE_CMD should < DEL_RANGE_CMD
   CMD_DEL_RANGE,
   CMD_DEL_RANGE_REVERSE,
+  // delete the whole range at once, offset and limit are ignored
+  CMD_DEL_RANGE_ALL,
 } RangeCmdType;
 
 typedef enum {
@@ -15,6 +15,7 @@
  *
  */
 #include <tbsys.h>
+#include <fcntl.h>
 #include "packets/op_cmd_packet.hpp"
 #include "util.hpp"
 #include "define.hpp"
@@ -292,8 +293,118 @@ namespace tair {
       return flag;
    }
 
+   bool migrate_manager::send_migrate_file(uint64_t server_id, request_migrate_file *packet, int wait_ms)
+   {
+      bool ret = true;
+      request_migrate_file *temp_packet = new request_migrate_file(*packet);
+      wait_object *cwo = wait_object_mgr.create_wait_object();
+      if (conn_mgr->sendPacket(server_id, temp_packet, NULL, (void*)((long)cwo->get_id())) == false) {
+         log_error("send migrate file packet to %s failure, bucket: %d",
+                   tbsys::CNetUtil::addrToString(server_id).c_str(), packet->bucket_no);
+         delete temp_packet;
+         ret = false;
+      } else {
+         cwo->wait_done(1, wait_ms);
+         base_packet *tpacket = cwo->get_packet();
+         if (tpacket == NULL || tpacket->getPCode() != TAIR_RESP_RETURN_PACKET) {
+            log_error("send migrate file packet 2 failure, server: %s, bucket: %d",
+                      tbsys::CNetUtil::addrToString(server_id).c_str(), packet->bucket_no);
+            ret = false;
+         } else if (((response_return *)tpacket)->get_code() != TAIR_RETURN_SUCCESS) {
+            log_error("migrate file not return success, server: %s, type: %d, ret: %d",
+                      tbsys::CNetUtil::addrToString(server_id).c_str(), packet->type, ((response_return *)tpacket)->get_code());
+            ret = false;
+         }
+      }
+      wait_object_mgr.destroy_wait_object(cwo);
+      return ret;
+   }
+
+   // Ship sstable files of bucket, then let target servers ingest them.
+   // Unlike send_packet(), any failure just gives up, caller will migrate in item way.
+   bool migrate_manager::migrate_data_by_file(int db_id, const vector<uint64_t>& dest_servers)
+   {
+      vector<std::string> files;
+      int rc = storage_mgr->export_bucket(db_id, files);
+      if (rc != TAIR_RETURN_SUCCESS) {
+         if (rc != TAIR_RETURN_NOT_SUPPORTED) {
+            log_warn("export bucket %d fail, ret: %d, migrate items instead", db_id, rc);
+         }
+         return false;
+      }
+
+      bool flag = true;
+      int64_t total_size = 0;
+      request_migrate_file packet;
+      packet.server_flag = TAIR_SERVERFLAG_MIGRATE;
+      packet.bucket_no = db_id;
+      char *buf = new char[MIGRATE_FILE_PIECE_LEN];
+
+      for (vector<std::string>::iterator file_it = files.begin(); flag && file_it != files.end(); ++file_it) {
+         int fd = ::open(file_it->c_str(), O_RDONLY);
+         if (fd < 0) {
+            log_error("open migrate file %s fail: %s", file_it->c_str(), strerror(errno));
+            flag = false;
+            break;
+         }
+         std::string::size_type pos = file_it->rfind('/');
+         packet.type = MIGRATE_FILE_DATA;
+         packet.name = (pos == std::string::npos) ? *file_it : file_it->substr(pos + 1);
+         packet.offset = 0;
+         while (flag) {
+            ssize_t n = ::pread(fd, buf, MIGRATE_FILE_PIECE_LEN, packet.offset);
+            if (n < 0) {
+               log_error("read migrate file %s fail: %s", file_it->c_str(), strerror(errno));
+               flag = false;
+            }
+            // empty file is also sent once
+            if (n <= 0 && packet.offset > 0) {
+               break;
+            }
+            packet.data.assign(buf, n > 0 ? n : 0);
+            for (vector<uint64_t>::const_iterator it = dest_servers.begin(); flag && it != dest_servers.end(); ++it) {
+               flag = !is_stopped && !_stop && send_migrate_file(*it, &packet, timeout);
+            }
+            packet.offset += packet.data.size();
+            total_size += packet.data.size();
+            if (n < MIGRATE_FILE_PIECE_LEN) {
+               break;
+            }
+         }
+         ::close(fd);
+      }
+      delete [] buf;
+      packet.data.clear();
+      packet.name.clear();
+      packet.offset = 0;
+
+      // ingest may rewrite all files, wait longer
+      packet.type = MIGRATE_FILE_INGEST;
+      for (vector<uint64_t>::const_iterator it = dest_servers.begin(); flag && it != dest_servers.end(); ++it) {
+         flag = !is_stopped && !_stop && send_migrate_file(*it, &packet, MIGRATE_FILE_INGEST_TIMEOUT);
+      }
+      if (!flag) {
+         // best effort, clean files received by target servers
+         packet.type = MIGRATE_FILE_ABORT;
+         for (vector<uint64_t>::const_iterator it = dest_servers.begin(); it != dest_servers.end(); ++it) {
+            send_migrate_file(*it, &packet, timeout);
+         }
+      }
+      storage_mgr->end_export_bucket(db_id);
+      log_warn("migrate bucket %d by file end. file count: %lu, total size: %"PRI64_PREFIX"d, suc: %d",
+               db_id, files.size(), total_size, flag);
+      return flag;
+   }
+
    bool migrate_manager::migrate_data_file(int db_id, vector<uint64_t> dest_servers)
    {
+      if (migrate_data_by_file(db_id, dest_servers)) {
+         return true;
+      }
+      if (is_stopped || _stop) {
+         return false;
+      }
+
       bool flag = true;
       bool tag = false;
       md_info info;
@@ -35,6 +35,7 @@
 #include "mupdate_packet.hpp"
 #include "response_return_packet.hpp"
 #include "migrate_finish_packet.hpp"
+#include "migrate_file_packet.hpp"
 
 namespace tair {
    using namespace std;
@@ -42,6 +43,8 @@ namespace tair {
    const static uint MIGRATE_LOCK_LOG_LEN = 1 * 1024 * 1024;
    const static uint MUPDATE_PACKET_HEADER_LEN = 8 + 4;
    const static int MISECONDS_WAITED_FOR_WRITE = 500000;
+   const static int MIGRATE_FILE_PIECE_LEN = 512 * 1024;
+   const static int MIGRATE_FILE_INGEST_TIMEOUT = 60000;
    class heartbeat_thread;
 
    class migrate_manager: public base_migrate, public tbsys::CDefaultRunnable, public tbnet::IPacketHandler {
@@ -66,6 +69,8 @@ namespace tair {
 
    private:
       bool migrate_data_file(int bucket_number, vector<uint64_t> dest_servers);
+      bool migrate_data_by_file(int bucket_number, const vector<uint64_t>& dest_servers);
+      bool send_migrate_file(uint64_t server_id, request_migrate_file *packet, int wait_ms);
       bool migrate_log(int bucket_number, vector<uint64_t> dest_servers, lsn_type start_lsn, lsn_type end_lsn);
       template<typename P> bool send_packet(vector<uint64_t> dest_servers, P *packet, int db_id);
       bool finish_migrate_data(std::vector<uint64_t>& dest_servers, int db_id);
@@ -17,11 +17,19 @@
 #include "request_processor.hpp"
 
 namespace tair {
+   // keys of continuation belong to request, plugins root is not owned
+   static void free_get_continuation(get_continuation *cont)
+   {
+      delete cont->resp;
+      delete cont;
+   }
+
    request_processor::request_processor(tair_manager *tair_mgr, heartbeat_thread *heart_beat, tbnet::ConnectionManager *connection_mgr)
    {
       this->tair_mgr = tair_mgr;
       this->heart_beat = heart_beat;
       this->connection_mgr = connection_mgr;
+      request_get::free_continuation = &free_get_continuation;
    }
 
    request_processor::~request_processor()
@@ -79,11 +87,18 @@ namespace tair {
       return rc;
    }
 
-   int request_processor::process(request_get *request, bool &send_return, uint32_t &resp_size)
+   int request_processor::process(request_get *request, bool &send_return, uint32_t &resp_size, bool blocking_read)
    {
+      send_return = false;
+      if (request->continuation != NULL) {
+         return continue_get(request, resp_size);
+      }
+
       int rc = TAIR_RETURN_FAILED;
       resp_size = 0;
       response_get *resp = new response_get();
+      get_continuation *cont = NULL;
+      int read_mode = blocking_read ? TAIR_READ_BLOCKING : TAIR_READ_NONBLOCKING;
       if (tair_mgr->is_working() == false) {
          rc = TAIR_RETURN_SERVER_CAN_NOT_WORK;
       } else {
@@ -116,8 +131,16 @@ namespace tair {
                   continue;
                }
                PROFILER_BEGIN("do get");
-               int rev = tair_mgr->get(request->area, *key, *data);
+               // data lives in response only
+               int rev = tair_mgr->get(request->area, *key, *data, true, true, read_mode);
                PROFILER_END();
+               if (rev == TAIR_RETURN_WOULD_BLOCK) {
+                  if (cont == NULL) {
+                     cont = new get_continuation();
+                  }
+                  cont->keys.push_back(std::make_pair(key, plugin_root));
+                  continue;
+               }
 
                PROFILER_BEGIN("do response plugin");
                tair_mgr->plugins_manager.do_response_plugins(rev, plugin::PLUGIN_TYPE_SYSTEM,
@@ -136,7 +159,10 @@ namespace tair {
                data = NULL;
             }
 
-            if (count == request->key_count) {
+            if (cont != NULL) {
+              cont->count = count;
+            }
+            else if (count == request->key_count) {
               rc = TAIR_RETURN_SUCCESS;
             }
             else if (count > 0) {
@@ -165,24 +191,96 @@ namespace tair {
                else {
                   data = new data_entry();
                   PROFILER_BEGIN("do get");
-                  rc = tair_mgr->get(request->area, *(request->key), *data);
+                  // data lives in response only
+                  rc = tair_mgr->get(request->area, *(request->key), *data, true, true, read_mode);
                   PROFILER_END();
 
-                  PROFILER_BEGIN("do response plugin");
-                  tair_mgr->plugins_manager.do_response_plugins(rc, plugin::PLUGIN_TYPE_SYSTEM,
-                                                                TAIR_REQ_GET_PACKET,request->area, (request->key), data, plugin_root);
-                  PROFILER_END();
-                  if (rc == TAIR_RETURN_SUCCESS) {
-                     resp->add_key_data(request->key, data);
-                     request->key = NULL;
-                     log_debug("get return %s", resp->data->get_data());
-                  } else {
+                  if (rc == TAIR_RETURN_WOULD_BLOCK) {
+                     cont = new get_continuation();
+                     cont->count = 0;
+                     cont->keys.push_back(std::make_pair(request->key, plugin_root));
                      delete data;
+                  } else {
+                     PROFILER_BEGIN("do response plugin");
+                     tair_mgr->plugins_manager.do_response_plugins(rc, plugin::PLUGIN_TYPE_SYSTEM,
+                                                                   TAIR_REQ_GET_PACKET,request->area, (request->key), data, plugin_root);
+                     PROFILER_END();
+                     if (rc == TAIR_RETURN_SUCCESS) {
+                        resp->add_key_data(request->key, data);
+                        request->key = NULL;
+                        log_debug("get return %s", resp->data->get_data());
+                     } else {
+                        delete data;
+                     }
                   }
                }
             }
          }
       }
+
+      if (cont != NULL) {
+         // response is sent by continue_get()
+         cont->resp = resp;
+         request->continuation = cont;
+         PROFILER_DUMP();
+         PROFILER_STOP();
+         return TAIR_RETURN_WOULD_BLOCK;
+      }
+
+      send_get_response(request, resp, rc, resp_size);
+      return rc;
+   }
+
+   // read keys left by nonblocking get, the only key of single get or part of batch get
+   int request_processor::continue_get(request_get *request, uint32_t &resp_size)
+   {
+      get_continuation *cont = request->continuation;
+      request->continuation = NULL;
+      response_get *resp = cont->resp;
+      uint32_t count = cont->count;
+      int rc = TAIR_RETURN_FAILED;
+
+      PROFILER_START("continued get operation start");
+      for (size_t i = 0; i < cont->keys.size(); ++i) {
+         data_entry *key = cont->keys[i].first;
+         data_entry *data = new data_entry();
+         PROFILER_BEGIN("do get");
+         int rev = tair_mgr->get(request->area, *key, *data, true, true, TAIR_READ_RESUMED);
+         PROFILER_END();
+
+         PROFILER_BEGIN("do response plugin");
+         tair_mgr->plugins_manager.do_response_plugins(rev, plugin::PLUGIN_TYPE_SYSTEM,
+                                                       TAIR_REQ_GET_PACKET, request->area, key, data, cont->keys[i].second);
+         PROFILER_END();
+         if (rev != TAIR_RETURN_SUCCESS) {
+            delete data;
+         } else if (request->key_list != NULL) {
+            ++count;
+            resp->add_key_data(new data_entry(*key), data);
+         } else {
+            resp->add_key_data(request->key, data);
+            request->key = NULL;
+         }
+         rc = rev;
+      }
+
+      if (request->key_list != NULL) {
+         if (count == request->key_count) {
+            rc = TAIR_RETURN_SUCCESS;
+         } else if (count > 0) {
+            rc = TAIR_RETURN_PARTIAL_SUCCESS;
+         } else {
+            rc = TAIR_RETURN_DATA_NOT_EXIST;
+         }
+      }
+      delete cont;
+
+      send_get_response(request, resp, rc, resp_size);
+      return rc;
+   }
+
+   void request_processor::send_get_response(request_get *request, response_get *resp, int rc, uint32_t &resp_size)
+   {
       resp->config_version = heart_beat->get_client_version();
       resp->setChannelId(request->getChannelId());
       resp->set_code(rc);
@@ -193,9 +291,6 @@ namespace tair {
       } 
       PROFILER_DUMP();
       PROFILER_STOP();
-
-      send_return = false;
-      return rc;
    }
 
     int request_processor::process(request_hide *request, bool &send_return)
@@ -399,7 +494,7 @@ namespace tair {
       int size = 0;
       plugin::plugins_root* plugin_root = NULL;
       uint64_t target_server_id = 0;
-      bool has_next;
+      bool has_next = false;
 
       PROFILER_START("range operation start");
       request->key_start.server_flag = request->server_flag;
@@ -421,7 +516,8 @@ namespace tair {
          tair_dataentry_vector *result = new tair_dataentry_vector();
          if (request->cmd < CMD_DEL_RANGE){
             PROFILER_BEGIN("do get_range");
-            rc = tair_mgr->get_range(request->area, request->key_start, request->key_end, request->offset ,request->limit, request->cmd, *result, has_next);
+            rc = tair_mgr->get_range(request->area, request->key_start, request->key_end, request->offset ,request->limit, request->cmd, *result, has_next,
+                                     (request->range_flag & RANGE_FLAG_CURSOR) ? &request->cursor : NULL);
             PROFILER_END();
          } else {
             PROFILER_BEGIN("del get_range");
@@ -438,6 +534,9 @@ namespace tair {
          resp->setChannelId(request->getChannelId());
          resp->set_code(rc); 
          resp->set_hasnext(has_next); 
+         if (has_next && (request->range_flag & RANGE_FLAG_CURSOR) && request->cmd < CMD_DEL_RANGE) {
+            resp->set_cursor(request->cursor);
+         }
          resp->set_cmd(request->cmd);
          size = result->size();
          resp->set_key_count(size);
@@ -681,6 +780,43 @@ namespace tair {
      return rc;
    }
 
+   int request_processor::process(request_migrate_file *request, bool &send_return)
+   {
+     send_return = true;
+
+     if (tair_mgr->is_working() == false) {
+       return TAIR_RETURN_SERVER_CAN_NOT_WORK;
+     }
+
+     if (request->server_flag != TAIR_SERVERFLAG_MIGRATE) {
+       log_warn("request_migrate_file have no MIGRATE flag");
+       return TAIR_RETURN_INVALID_ARGUMENT;
+     }
+
+     int rc = TAIR_RETURN_SUCCESS;
+     storage::storage_manager *storage_mgr = tair_mgr->get_storage_manager();
+     switch (request->type) {
+     case MIGRATE_FILE_DATA:
+       rc = storage_mgr->import_bucket_file(request->bucket_no, request->name.c_str(), request->offset,
+                                            request->data.data(), request->data.size());
+       break;
+     case MIGRATE_FILE_INGEST:
+       rc = storage_mgr->ingest_bucket(request->bucket_no, false);
+       break;
+     case MIGRATE_FILE_ABORT:
+       rc = storage_mgr->ingest_bucket(request->bucket_no, true);
+       break;
+     default:
+       rc = TAIR_RETURN_INVALID_ARGUMENT;
+       break;
+     }
+     if (rc != TAIR_RETURN_SUCCESS) {
+       log_warn("migrate file of bucket %d fail, type: %d, name: %s, rc: %d",
+                request->bucket_no, request->type, request->name.c_str(), rc);
+     }
+     return rc;
+   }
+
   int request_processor::process(request_lock *request, bool &send_return)
   {
     send_return = true;
@@ -846,7 +982,21 @@ namespace tair {
          it = request->key_list->begin();
          data_entry *mkey = *it;
          plocker.lock(*mkey);
-         for (; it != request->key_list->end(); ++it) {
+         // keys under one pkey are adjacent in storage, get them in one go if supported
+         std::vector<data_entry*> keys(request->key_list->begin(), request->key_list->end());
+         std::vector<data_entry*> values;
+         std::vector<int> rcs;
+         bool batched = false;
+         if (keys.size() > 1) {
+           values.resize(keys.size());
+           for (size_t i = 0; i < values.size(); ++i) {
+             values[i] = new data_entry();
+           }
+           PROFILER_BEGIN("do prefix gets");
+           batched = tair_mgr->prefix_gets(request->area, keys, values, rcs) == TAIR_RETURN_SUCCESS;
+           PROFILER_END();
+         }
+         for (size_t index = 0; it != request->key_list->end(); ++it, ++index) {
            data_entry *key = (*it);
            // set pkey first
            if (resp->pkey == NULL) {
@@ -866,12 +1016,19 @@ namespace tair {
                log_debug("plugin return %d, skip excute", plugin_ret);
                rc = TAIR_RETURN_PLUGIN_ERROR;
              } else {
-               PROFILER_BEGIN("do get");
-               if (data == NULL) {
-                 data = new data_entry();
+               if (batched) {
+                 delete data;
+                 data = values[index];
+                 values[index] = NULL;
+                 rc = rcs[index];
+               } else {
+                 PROFILER_BEGIN("do get");
+                 if (data == NULL) {
+                   data = new data_entry();
+                 }
+                 rc = tair_mgr->get(request->area, *key, *data);
+                 PROFILER_END();
                }
-               rc = tair_mgr->get(request->area, *key, *data);
-               PROFILER_END();
 
                PROFILER_BEGIN("do response plugin");
                tair_mgr->plugins_manager.do_response_plugins(rc, plugin::PLUGIN_TYPE_SYSTEM,
@@ -898,6 +1055,9 @@ namespace tair {
            delete data;
            data = NULL;
          }
+         for (size_t i = 0; i < values.size(); ++i) {
+           delete values[i];
+         }
          if (count == request->key_count) {
            rc = TAIR_RETURN_SUCCESS;
          } else if (count > 0) {
@@ -38,15 +38,27 @@
 #include "op_cmd_packet.hpp"
 #include "get_range_packet.hpp"
 #include "expire_packet.hpp"
+#include "migrate_file_packet.hpp"
 
 namespace tair {
+  // get that needs disk reads is continued in read thread: response holding
+  // keys got from memory, and keys left to read with their request plugins.
+  // request_get frees it if the request is dropped before continued.
+  struct get_continuation {
+    response_get *resp;
+    uint32_t count;
+    std::vector<std::pair<data_entry*, plugin::plugins_root*> > keys;
+  };
+
   class request_processor {
   public:
     request_processor(tair_manager *tair_mgr, heartbeat_thread *heart_beat, tbnet::ConnectionManager *connection_mgr);
     ~request_processor();
 
     int process(request_put *request, bool &send_return, uint32_t &resp_size);
-    int process(request_get *request, bool &send_return, uint32_t &resp_size);
+    // if blocking_read is false, keys not in memory are left in request->continuation and
+    // TAIR_RETURN_WOULD_BLOCK is returned, call again with it in a thread that can block.
+    int process(request_get *request, bool &send_return, uint32_t &resp_size, bool blocking_read = true);
     int process(request_get_range *request, bool &send_return);
     int process(request_hide *request, bool &send_return);
     int process(request_get_hidden *request, bool &send_return);
@@ -64,9 +76,12 @@ namespace tair {
     int process(request_prefix_get_hiddens *request, bool &send_return);
     int process(request_op_cmd *request, bool &send_return);
     int process(request_expire *request, bool &send_return);
+    int process(request_migrate_file *request, bool &send_return);
 
   private:
     bool do_proxy(uint64_t target_server_id, base_packet *proxy_packet, base_packet *packet);
+    int continue_get(request_get *request, uint32_t &resp_size);
+    void send_get_response(request_get *request, response_get *resp, int rc, uint32_t &resp_size);
 
   private:
     tair_manager *tair_mgr;
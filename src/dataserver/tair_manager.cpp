@@ -767,7 +767,7 @@
       return result;
     }
 
-    int tair_manager::get(int area, data_entry &key, data_entry &value, bool with_stat)
+    int tair_manager::get(int area, data_entry &key, data_entry &value, bool with_stat, bool pinned, int read_mode)
     {
       if (!localmode && status != STATUS_CAN_WORK) {
         return TAIR_RETURN_SERVER_CAN_NOT_WORK;
@@ -787,8 +787,13 @@
       int bucket_number = get_bucket_number(key);
       log_debug("get request will server in bucket: %d", bucket_number);
       PROFILER_BEGIN("get from storage engine");
-      int rc = storage_mgr->get(bucket_number, mkey, value, with_stat);
+      int rc = pinned ? storage_mgr->get_pinned(bucket_number, mkey, value, with_stat, read_mode) :
+        storage_mgr->get(bucket_number, mkey, value, with_stat);
       PROFILER_END();
+      if (rc == TAIR_RETURN_WOULD_BLOCK) {
+        // counted when it is resumed
+        return rc;
+      }
       key.data_meta = mkey.data_meta;
       if (with_stat)
         TAIR_STAT.stat_get(area, rc);
@@ -800,7 +805,49 @@
       return rc;
     }
 
-    int tair_manager::get_range(int32_t area, data_entry &key_start, data_entry &key_end, int offset, int limit, int type, std::vector<data_entry*> &result, bool &has_next)
+    int tair_manager::prefix_gets(int area, std::vector<data_entry*> &keys, std::vector<data_entry*> &values, std::vector<int> &rcs)
+    {
+      if (!localmode && status != STATUS_CAN_WORK) {
+        return TAIR_RETURN_SERVER_CAN_NOT_WORK;
+      }
+
+      if (area < 0 || area >= TAIR_MAX_AREA_COUNT || keys.empty() || keys.size() != values.size()) {
+        return TAIR_RETURN_INVALID_ARGUMENT;
+      }
+
+      int bucket_number = get_bucket_number(*keys[0]);
+      std::vector<data_entry> mkeys(keys.size());
+      std::vector<data_entry*> mkey_ptrs(keys.size());
+      for (size_t i = 0; i < keys.size(); ++i) {
+        if (keys[i]->get_size() >= TAIR_MAX_KEY_SIZE || keys[i]->get_size() < 1) {
+          return TAIR_RETURN_ITEMSIZE_ERROR;
+        }
+        if ((int)get_bucket_number(*keys[i]) != bucket_number) {
+          return TAIR_RETURN_INVALID_ARGUMENT;
+        }
+        mkeys[i] = *keys[i];
+        mkeys[i].merge_area(area);
+        mkey_ptrs[i] = &mkeys[i];
+      }
+
+      PROFILER_BEGIN("prefix gets from storage engine");
+      int rc = storage_mgr->prefix_gets(bucket_number, mkey_ptrs, values, rcs);
+      PROFILER_END();
+      if (rc != TAIR_RETURN_SUCCESS) {
+        return rc;
+      }
+
+      for (size_t i = 0; i < keys.size(); ++i) {
+        keys[i]->data_meta = mkeys[i].data_meta;
+        TAIR_STAT.stat_get(area, rcs[i]);
+        if (rcs[i] == TAIR_RETURN_SUCCESS && (values[i]->data_meta.flag & TAIR_ITEM_FLAG_DELETED)) {
+          rcs[i] = TAIR_RETURN_HIDDEN;
+        }
+      }
+      return TAIR_RETURN_SUCCESS;
+    }
+
+    int tair_manager::get_range(int32_t area, data_entry &key_start, data_entry &key_end, int offset, int limit, int type, std::vector<data_entry*> &result, bool &has_next, data_entry *cursor)
     {
       if (status != STATUS_CAN_WORK) {
         return TAIR_RETURN_SERVER_CAN_NOT_WORK;
@@ -819,7 +866,7 @@
       key_end.merge_area(area);
 
       PROFILER_BEGIN("get range from storage engine");
-      int rc = storage_mgr->get_range(bucket_number, key_start, key_end, offset, limit, type, result, has_next);
+      int rc = storage_mgr->get_range(bucket_number, key_start, key_end, offset, limit, type, result, has_next, cursor);
       PROFILER_END();
 
       //TAIR_STAT.stat_get_range(area, rc);
@@ -76,7 +76,13 @@ namespace tair {
       int put(int area, data_entry &key, data_entry &value, int expire_time,base_packet *request=NULL,int version=0);
       //int put(int area, data_entry &key, data_entry &value, int expire_time,request_put *request,int version);
       int add_count(int area, data_entry &key, int count, int init_value, int *result_value, int expire_time,base_packet * request,int version);
-      int get(int area, data_entry &key, data_entry &value, bool with_stat = true);
+      // value may reference memory pinned by storage engine if pinned is true, see storage_manager::get_pinned(),
+      // read_mode(TAIR_READ_*) only works with pinned get.
+      int get(int area, data_entry &key, data_entry &value, bool with_stat = true, bool pinned = false,
+              int read_mode = TAIR_READ_BLOCKING);
+      // like get of each key, keys are in one bucket. rcs[i] is result of keys[i] filled into values[i],
+      // fail if keys can not be got in one go (eg. not supported by storage engine)
+      int prefix_gets(int area, std::vector<data_entry*> &keys, std::vector<data_entry*> &values, std::vector<int> &rcs);
       int hide(int area, data_entry &key, base_packet *request = NULL, int heart_version = 0);
       int get_hidden(int area, data_entry &key, data_entry &value);
       int remove(int area, data_entry &key,request_remove *request=NULL,int version=0);
@@ -90,7 +96,7 @@ namespace tair {
       int direct_put(data_entry &key, data_entry &value);
       int direct_remove(data_entry &key);
 
-      int get_range(int32_t area, data_entry &key_start, data_entry &key_end, int offset, int limit, int type, std::vector<data_entry*> &result, bool &has_next);
+      int get_range(int32_t area, data_entry &key_start, data_entry &key_end, int offset, int limit, int type, std::vector<data_entry*> &result, bool &has_next, data_entry *cursor = NULL);
       int del_range(int32_t area, data_entry &key_start, data_entry &key_end, int offset, int limit, int type, std::vector<data_entry*> &result, bool &has_next);
       int lock(int area, LockType lock_type, data_entry& key, base_packet *request = NULL, int heart_version = 0);
 
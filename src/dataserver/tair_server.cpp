@@ -30,6 +30,9 @@ namespace tair {
       thread_count = TBSYS_CONFIG.getInt(TAIRSERVER_SECTION, TAIR_PROCESS_THREAD_COUNT, -1);
       task_queue_size = TBSYS_CONFIG.getInt(TAIRSERVER_SECTION,TAIR_TASK_QUEUE_SIZE,100);
       if (thread_count < 0) thread_count = sysconf(_SC_NPROCESSORS_CONF);
+      // 0: process threads read disk themselves
+      read_thread_count = thread_count > 0 ? TBSYS_CONFIG.getInt(TAIRSERVER_SECTION, TAIR_READ_THREAD_COUNT, 0) : 0;
+      if (read_thread_count < 0) read_thread_count = 0;
       if (thread_count > 0) {
          setBatchPushPacket(true);
       }
@@ -56,6 +59,9 @@ namespace tair {
          task_queue_thread.start();
          duplicate_task_queue_thread.start();
       }
+      if (read_thread_count > 0) {
+         read_task_queue_thread.start();
+      }
       heartbeat.start();
       async_task_queue_thread.start();
       TAIR_STAT.start();
@@ -83,6 +89,9 @@ namespace tair {
          task_queue_thread.wait();
          duplicate_task_queue_thread.wait();
       }
+      if (read_thread_count > 0) {
+         read_task_queue_thread.wait();
+      }
       heartbeat.wait();
       async_task_queue_thread.wait();
       transport.wait();
@@ -101,6 +110,10 @@ namespace tair {
             task_queue_thread.stop();
             duplicate_task_queue_thread.stop();
          }
+         if (read_thread_count > 0) {
+            log_info("will stop readTaskQueue");
+            read_task_queue_thread.stop();
+         }
          log_info("will stop heartbeatThread");
          heartbeat.stop();
          log_info("will stop yncTaskQueue");
@@ -129,6 +142,11 @@ namespace tair {
          // m_duplicateTaskQueueThread should have m_threadCount * (server_copy_count-1) thread, but we do not know server_copy_count here
          // m_threadCount just ok.
       }
+      if (read_thread_count > 0) {
+         // args tells handlePacketQueue() that it runs in read thread
+         read_task_queue_thread.setThreadParameter(read_thread_count, this, &read_task_queue_thread);
+         log_info("get needing disk read is done in %d read threads", read_thread_count);
+      }
       async_task_queue_thread.setThreadParameter(1, this, NULL);
 
       conn_manager = new tbnet::ConnectionManager(&transport, &streamer, this);
@@ -266,7 +284,16 @@ namespace tair {
          case TAIR_REQ_GET_PACKET:
          {
             request_get *npacket = (request_get*)packet;
-            ret = req_processor->process(npacket, send_return, stat.out);
+            // process thread reads memory only if there are read threads to read disk
+            bool blocking_read = read_thread_count == 0 || args == &read_task_queue_thread;
+            ret = req_processor->process(npacket, send_return, stat.out, blocking_read);
+            if (ret == TAIR_RETURN_WOULD_BLOCK) {
+               // packet goes on in read thread, stat is added up there
+               if (read_task_queue_thread.push(packet, task_queue_size, false)) {
+                  return false;
+               }
+               ret = req_processor->process(npacket, send_return, stat.out);
+            }
             send_return = false;
             break;
          }
@@ -370,6 +397,12 @@ namespace tair {
             ret = req_processor->process(mpacket, send_return);
             break;
          }
+         case TAIR_REQ_MIGRATE_FILE_PACKET:
+         {
+            request_migrate_file *mpacket = (request_migrate_file *)(packet);
+            ret = req_processor->process(mpacket, send_return);
+            break;
+         }
          case TAIR_STAT_CMD_VIEW:
          {
             stat_cmd_view_packet *stat_packet = (stat_cmd_view_packet *)(packet);
@@ -69,9 +69,12 @@ namespace tair {
       tbnet::PacketQueueThread task_queue_thread;
       tbnet::PacketQueueThread duplicate_task_queue_thread;
       tbnet::PacketQueueThread async_task_queue_thread;
+      // gets needing disk reads, so process threads only serve data in memory
+      tbnet::PacketQueueThread read_task_queue_thread;
       tair_manager *tair_mgr;
       heartbeat_thread heartbeat;
       int thread_count;
+      int read_thread_count;
       int task_queue_size;
       wait_object_manager wait_object_mgr;
       request_processor *req_processor;
@@ -91,6 +91,7 @@ namespace tair {
 
       TAIR_REQ_DUMP_BUCKET_PACKET = 1200,
       TAIR_REQ_MIG_FINISH_PACKET,
+      TAIR_REQ_MIGRATE_FILE_PACKET,
 
       TAIR_REQ_DUPLICATE_PACKET = 1300,
       TAIR_RESP_DUPLICATE_PACKET,
@@ -18,6 +18,9 @@
 #define TAIR_PACKET_GET_PACKET_H
 #include "base_packet.hpp"
 namespace tair {
+   struct get_continuation;
+   typedef void (*free_get_continuation_func)(get_continuation *continuation);
+
    class request_get : public base_packet {
    public:
       request_get()
@@ -28,6 +31,7 @@ namespace tair {
          key_count = 0;
          key = NULL;
          key_list = NULL;
+         continuation = NULL;
       }
 
       request_get(request_get &packet)
@@ -38,6 +42,7 @@ namespace tair {
          key_count = packet.key_count;
          key = NULL;
          key_list = NULL;
+         continuation = NULL;
          if (packet.key != NULL) {
             key = new data_entry();
             key->clone(*packet.key);
@@ -54,6 +59,11 @@ namespace tair {
 
       ~request_get()
         {
+         // request dropped(e.g. timeout in queue) before its get is continued
+         if (continuation != NULL && free_continuation != NULL) {
+            free_continuation(continuation);
+            continuation = NULL;
+         }
          if (key_list) {
             tair_dataentry_set::iterator it;
             for (it=key_list->begin(); it!=key_list->end(); ++it) {
@@ -220,6 +230,10 @@ namespace tair {
       uint32_t           key_count;
       data_entry         *key;
       tair_dataentry_set *key_list;
+      // server side only: get left to read thread, see request_processor
+      get_continuation   *continuation;
+      // set by server side, which knows get_continuation
+      static free_get_continuation_func free_continuation;
 
    };
    class response_get : public base_packet {
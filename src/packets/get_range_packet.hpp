@@ -22,6 +22,7 @@ namespace tair {
         area = 0;
         offset = 0;
         limit = 0;
+        range_flag = 0;
       }
 
       request_get_range(request_get_range &packet)
@@ -34,6 +35,8 @@ namespace tair {
         limit = packet.limit;
         key_start = packet.key_start;
         key_end = packet.key_end;
+        range_flag = packet.range_flag;
+        cursor = packet.cursor;
       }
 
       ~request_get_range()
@@ -50,6 +53,11 @@ namespace tair {
 
         key_start.encode(output);
         key_end.encode(output);
+        // old servers drain the tail, so it is only written in cursor mode
+        if (range_flag != 0) {
+          output->writeInt8(range_flag);
+          cursor.encode(output);
+        }
         return true;
       }
 
@@ -59,6 +67,7 @@ namespace tair {
           log_warn( "buffer data too few.");
           return false;
         }
+        int start_len = input->getDataLen();
         server_flag = input->readInt8();
         cmd = input->readInt16();
         area = input->readInt16();
@@ -67,6 +76,10 @@ namespace tair {
 
         key_start.decode(input);
         key_end.decode(input);
+        if (header->_dataLen > start_len - input->getDataLen()) {
+          range_flag = input->readInt8();
+          cursor.decode(input);
+        }
 
         return true;
       }
@@ -78,6 +91,10 @@ namespace tair {
       uint32_t limit;
       data_entry key_start;
       data_entry key_end;
+      // RANGE_FLAG_CURSOR: offset is ignored, and a non-empty cursor got
+      // from last response is the position to resume from.
+      uint8_t range_flag;
+      data_entry cursor;
   };
 
   class response_get_range : public base_packet {
@@ -122,6 +139,9 @@ namespace tair {
           }
           output->writeInt32(0);
         }
+        if (flag & FLAG_HASCURSOR) {
+          cursor.encode(output);
+        }
         return true;
       }
 
@@ -153,6 +173,18 @@ namespace tair {
         return flag & FLAG_HASNEXT;
       }
 
+      // position to resume from, set only in cursor mode when range is not done
+      void set_cursor(const data_entry &key)
+      {
+        cursor = key;
+        flag |= FLAG_HASCURSOR;
+      }
+
+      bool get_hascursor()
+      {
+        return flag & FLAG_HASCURSOR;
+      }
+
       bool decode(tbnet::DataBuffer *input, tbnet::PacketHeader *header)
       {
         if (header->_dataLen < 8) 
@@ -177,6 +209,10 @@ namespace tair {
         {
           input->readInt32();
         }
+        if (flag & FLAG_HASCURSOR)
+        {
+          cursor.decode(input);
+        }
 
         return true;
       }
@@ -221,6 +257,7 @@ namespace tair {
       uint16_t flag;
       tair_dataentry_vector *key_data_vector;
       tair_dataentry_set  *proxyed_key_list;
+      data_entry cursor;
     private:
       int code;
       response_get_range(const response_get_range&);
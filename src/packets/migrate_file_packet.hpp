@@ -0,0 +1,111 @@
+/*
+ * (C) 2007-2010 Alibaba Group Holding Limited
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * migrate file packet
+ * this packet is for migrate only, ship bucket's data file
+ * (eg. ldb's sstable) to target server piece by piece.
+ *
+ * Version: $Id$
+ *
+ * Authors:
+ *   agent <agent@local>
+ *
+ */
+#ifndef TAIR_PACKET_MIGRATE_FILE_PACKET_H
+#define TAIR_PACKET_MIGRATE_FILE_PACKET_H
+#include "base_packet.hpp"
+namespace tair {
+   enum {
+      // one piece of data file
+      MIGRATE_FILE_DATA = 1,
+      // all files are sent, load them into storage
+      MIGRATE_FILE_INGEST,
+      // migrate is given up, clean files sent
+      MIGRATE_FILE_ABORT,
+   };
+
+   class request_migrate_file : public base_packet {
+   public:
+
+      request_migrate_file()
+      {
+         setPCode(TAIR_REQ_MIGRATE_FILE_PACKET);
+         server_flag = 0;
+         type = MIGRATE_FILE_DATA;
+         bucket_no = 0;
+         offset = 0;
+      }
+
+      request_migrate_file(request_migrate_file &packet)
+      {
+         setPCode(TAIR_REQ_MIGRATE_FILE_PACKET);
+         server_flag = packet.server_flag;
+         type = packet.type;
+         bucket_no = packet.bucket_no;
+         name = packet.name;
+         offset = packet.offset;
+         data = packet.data;
+      }
+
+      ~request_migrate_file()
+      {
+      }
+
+      bool encode(tbnet::DataBuffer *output)
+      {
+         output->writeInt8(server_flag);
+         output->writeInt8(type);
+         output->writeInt32(bucket_no);
+         output->writeString(name);
+         output->writeInt64(offset);
+         output->writeInt32(data.size());
+         if (!data.empty()) {
+            output->writeBytes(data.data(), data.size());
+         }
+         return true;
+      }
+
+      bool decode(tbnet::DataBuffer *input, tbnet::PacketHeader *header)
+      {
+         if (header->_dataLen < 22) {
+            log_warn( "buffer data too few.");
+            return false;
+         }
+         server_flag = input->readInt8();
+         type = input->readInt8();
+         bucket_no = input->readInt32();
+         char *tmp = NULL;
+         input->readString(tmp, 0);
+         if (tmp != NULL) {
+            name = tmp;
+            ::free(tmp);
+         }
+         offset = input->readInt64();
+         int size = input->readInt32();
+         if (size < 0 || size > input->getDataLen()) {
+            log_warn("invalid migrate file data size: %d", size);
+            return false;
+         }
+         if (size > 0) {
+            data.resize(size);
+            input->readBytes(&data[0], size);
+         }
+         return true;
+      }
+
+   public:
+      uint8_t server_flag;
+      uint8_t type;
+      int bucket_no;
+      // file name, no directory
+      std::string name;
+      // where data is in file
+      int64_t offset;
+      std::string data;
+   };
+}
+#endif
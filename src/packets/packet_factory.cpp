@@ -29,6 +29,7 @@
 #include "heartbeat_packet.hpp"
 #include "inc_dec_packet.hpp"
 #include "migrate_finish_packet.hpp"
+#include "migrate_file_packet.hpp"
 #include "mupdate_packet.hpp"
 #include "ping_packet.hpp"
 #include "put_packet.hpp"
@@ -64,6 +65,8 @@
 #include "inval_stat_packet.hpp"
 #include "inval_heartbeat_packet.hpp"
   namespace tair {
+    free_get_continuation_func request_get::free_continuation = NULL;
+
     tbnet::Packet *tair_packet_factory::createPacket(int pcode)
     {
       tbnet::Packet *packet = NULL;
@@ -74,6 +77,9 @@
         case TAIR_REQ_MUPDATE_PACKET:
           packet = new tair::request_mupdate();
           break;
+        case TAIR_REQ_MIGRATE_FILE_PACKET:
+          packet = new tair::request_migrate_file();
+          break;
         case TAIR_REQ_MPUT_PACKET:
           packet = new tair::request_mput();
           break;
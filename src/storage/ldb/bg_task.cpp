@@ -29,7 +29,9 @@ namespace tair
       ////////// LdbCompactTask
       LdbCompactTask::LdbCompactTask()
         : stop_(false), db_(NULL), min_time_hour_(0), max_time_hour_(0),
-          round_largest_filenumber_(0), is_compacting_(false)
+          round_largest_filenumber_(0), is_compacting_(false),
+          expired_min_size_(0), expired_file_count_(0), gc_bucket_reclaim_(true),
+          range_deletion_trigger_(0)
       {
       }
 
@@ -40,6 +42,14 @@ namespace tair
 
       void LdbCompactTask::runTimerTask()
       {
+        if (gc_bucket_reclaim_ && !stop_ && db_->gc_factory()->can_gc())
+        {
+          reclaim_gc_buckets();
+        }
+        if (range_deletion_trigger_ > 0 && !stop_ && too_many_range_deletions())
+        {
+          compact_for_range_deletion();
+        }
         if (should_compact())
         {
           do_compact();
@@ -56,6 +66,12 @@ namespace tair
 
           const char* time_range = TBSYS_CONFIG.getString(TAIRLDB_SECTION, LDB_COMPACT_GC_RANGE, "2-7");
           reset_time_range(time_range);
+
+          expired_min_size_ = atoll(TBSYS_CONFIG.getString(TAIRLDB_SECTION, LDB_COMPACT_EXPIRED_MIN_SIZE, "1048576"));
+          expired_file_count_ = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_COMPACT_EXPIRED_FILE_COUNT, 10);
+          log_warn("compact expired min size: %"PRI64_PREFIX"u, file count: %d", expired_min_size_, expired_file_count_);
+          gc_bucket_reclaim_ = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_GC_BUCKET_RECLAIM, 1) > 0;
+          range_deletion_trigger_ = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_RANGE_DELETION_COMPACT_TRIGGER, 64);
         }
         else
         {
@@ -114,11 +130,18 @@ namespace tair
         //        so first compact files whose range is in gc_buckets' range.
         //    3). If Rule-2 run and gc-buckets is over, gc area. Based on key format, area is matter to range someway,
         //        compact gc-areas.
-        // 2. Expired items has nothing to do with range and filenumber, so if we want to compact over all expired
-        //    items, we can do nothing except compacting the whole db(that's expensive). Maybe some statics can
-        //    join in the strategy.
+        // 2. Expired items has nothing to do with range and filenumber, but each sstable records its entries'
+        //    expired time range(leveldb::FileTimeMeta), so
+        //    1). files whose entries are all expired are deleted directly without rewriting.
+        //    2). files with most estimated expired size are compacted first.
+        // 3. Range deleted items (del_range) are dropped when files holding them are compacted,
+        //    range deletion is forgotten then.
+        // 4. Blob files (ldb_blob_value_size) with much garbage are rewritten after all above,
+        //    which turn more values into garbage.
         compact_for_gc();
+        compact_for_range_deletion();
         compact_for_expired();
+        compact_for_blob();
       }
 
       void LdbCompactTask::compact_for_gc()
@@ -134,9 +157,97 @@ namespace tair
         }
       }
 
+      void LdbCompactTask::compact_for_range_deletion()
+      {
+        int remaining = 0;
+        leveldb::Status status = db_->db()->CompactRangeDeletions(&remaining);
+        if (!status.ok())
+        {
+          log_error("[%d] compact for range deletion fail, error: %s", db_->index(), status.ToString().c_str());
+        }
+        else if (remaining > 0)
+        {
+          log_warn("[%d] compact for range deletion, remaining: %d", db_->index(), remaining);
+        }
+      }
+
+      bool LdbCompactTask::too_many_range_deletions()
+      {
+        std::string count;
+        return db_->db()->GetProperty("leveldb.num-range-deletions", &count) &&
+          atoi(count.c_str()) > range_deletion_trigger_;
+      }
+
       void LdbCompactTask::compact_for_expired()
       {
-        // TODO
+        uint64_t deleted_size = 0;
+        leveldb::Status status = db_->db()->DeleteExpiredFiles(&deleted_size);
+        if (!status.ok())
+        {
+          log_error("[%d] delete expired files fail, error: %s", db_->index(), status.ToString().c_str());
+        }
+        else if (deleted_size > 0)
+        {
+          log_warn("[%d] delete expired files, size: %"PRI64_PREFIX"u", db_->index(), deleted_size);
+        }
+
+        if (expired_min_size_ > 0)
+        {
+          uint32_t start_time = time(NULL);
+          uint64_t expired_size = 0, total_expired_size = 0;
+          int32_t i = 0;
+          for (i = 0; !stop_ && status.ok() && i < expired_file_count_ && is_compact_time(); ++i)
+          {
+            status = db_->db()->CompactExpiredFile(expired_min_size_, &expired_size);
+            if (!status.ok())
+            {
+              log_error("[%d] compact expired file fail, error: %s", db_->index(), status.ToString().c_str());
+            }
+            else if (expired_size <= 0) // no file has so much expired data
+            {
+              break;
+            }
+            total_expired_size += expired_size;
+            // just have a rest..
+            ::sleep(1);
+          }
+
+          if (i > 0)
+          {
+            log_warn("[%d] compact expired files, count: %d, expired size: %"PRI64_PREFIX"u, cost: %u",
+                     db_->index(), i, total_expired_size, static_cast<uint32_t>(time(NULL) - start_time));
+          }
+        }
+      }
+
+      void LdbCompactTask::compact_for_blob()
+      {
+        uint32_t start_time = time(NULL);
+        uint64_t reclaimed_size = 0, total_reclaimed_size = 0;
+        int32_t i = 0;
+        leveldb::Status status;
+        for (i = 0; !stop_ && is_compact_time(); ++i)
+        {
+          status = db_->db()->CollectBlobGarbage(&reclaimed_size);
+          if (!status.ok())
+          {
+            log_error("[%d] collect blob garbage fail, error: %s", db_->index(), status.ToString().c_str());
+            break;
+          }
+          else if (reclaimed_size <= 0) // no blob file has so much garbage
+          {
+            break;
+          }
+          total_reclaimed_size += reclaimed_size;
+          // just have a rest..
+          ::sleep(1);
+        }
+
+        if (total_reclaimed_size > 0)
+        {
+          log_warn("[%d] collect blob garbage, count: %d, reclaimed size: %"PRI64_PREFIX"u, cost: %u",
+                   db_->index(), i, total_reclaimed_size, static_cast<uint32_t>(time(NULL) - start_time));
+        }
       }
 
       void LdbCompactTask::compact_gc(GcType gc_type, bool& all_done)
@@ -212,6 +323,51 @@ namespace tair
         }
       }
 
+      // Closed buckets' data is gone in files written before gc node is added (numbered less than
+      // gc node's file_number), so files whose key range is in one such bucket are deleted as
+      // a whole, then only files on bucket boundary need compaction. Gc node is still removed
+      // by compact_gc(), which handles files written after.
+      void LdbCompactTask::reclaim_gc_buckets()
+      {
+        std::vector<GcNode> nodes;
+        db_->gc_factory()->get_gc_nodes(GC_BUCKET, nodes);
+
+        std::map<int32_t, uint32_t> reclaimed;
+        for (size_t i = 0; i < nodes.size() && !stop_ && db_->gc_factory()->can_gc(); ++i)
+        {
+          const GcNode& node = nodes[i];
+          std::map<int32_t, uint32_t>::iterator it = reclaimed_buckets_.find(node.key_);
+          if (it != reclaimed_buckets_.end() && it->second == node.when_)
+          {
+            reclaimed[node.key_] = node.when_;
+            continue;
+          }
+
+          uint32_t start_time = time(NULL);
+          std::vector<ScanKey> scan_keys;
+          build_scan_key(GC_BUCKET, node.key_, scan_keys);
+          leveldb::Slice start(scan_keys[0].start_key_), end(scan_keys[0].end_key_);
+          uint64_t deleted_size = 0;
+          leveldb::Status status = db_->db()->DeleteFilesInRange(node.file_number_, start, end, &deleted_size);
+          if (status.ok())
+          {
+            status = db_->db()->CompactRangeSelfLevel(node.file_number_, &start, &end);
+          }
+
+          if (!status.ok())
+          {
+            DUMP_GCNODE(error, node, "[%d] reclaim gc bucket fail, error: %s",
+                        db_->index(), status.ToString().c_str());
+            continue;
+          }
+          DUMP_GCNODE(warn, node, "[%d] reclaim gc bucket, deleted files size: %"PRI64_PREFIX"u, cost: %u",
+                      db_->index(), deleted_size, static_cast<uint32_t>(time(NULL) - start_time));
+          reclaimed[node.key_] = node.when_;
+        }
+        // forget buckets whose gc node is gone
+        reclaimed_buckets_.swap(reclaimed);
+      }
+
       void LdbCompactTask::build_scan_key(GcType type, int32_t key, std::vector<ScanKey>& scan_keys)
       {
         switch (type)
@@ -17,6 +17,7 @@
 #ifndef TAIR_STORAGE_LDB_BG_TASK_H
 #define TAIR_STORAGE_LDB_BG_TASK_H
 
+#include <map>
 #include "Timer.h"
 
 namespace leveldb
@@ -59,7 +60,11 @@ namespace tair
 
         void compact_for_gc();
         void compact_gc(GcType gc_type, bool& all_done);
+        void reclaim_gc_buckets();
+        void compact_for_range_deletion();
+        bool too_many_range_deletions();
         void compact_for_expired();
+        void compact_for_blob();
 
         void build_scan_key(GcType type, int32_t key, std::vector<ScanKey>& scan_keys);
 
@@ -72,6 +77,16 @@ namespace tair
         uint64_t round_largest_filenumber_;
         tbsys::CThreadMutex lock_;
         bool is_compacting_;
+        // min estimated expired size of file to compact for expired
+        uint64_t expired_min_size_;
+        // max file count to compact for expired in one task round
+        int32_t expired_file_count_;
+        // reclaim closed buckets' space at once
+        bool gc_bucket_reclaim_;
+        // bucket => when_ of gc node reclaimed
+        std::map<int32_t, uint32_t> reclaimed_buckets_;
+        // reclaim range deletions out of compact time range when more than this
+        int32_t range_deletion_trigger_;
       };
       typedef tbutil::Handle<LdbCompactTask> LdbCompactTaskPtr;
 
@@ -14,12 +14,15 @@
  *
  */
 
+#include <math.h>
+#include <stdlib.h>
 #include <tbsys.h>
 
 #include "leveldb/db.h"
 #include "leveldb/slice.h"
 #include "leveldb/write_batch.h"
 #include "leveldb/options.h"
+#include "leveldb/rate_limiter.h"
 #include "db/dbformat.h"
 
 #include "ldb_manager.hpp"
@@ -33,8 +36,8 @@ namespace tair
     namespace ldb
     {
       //////////////////// LdbBalancer::Balancer
-      LdbBalancer::Balancer::Balancer(LdbBalancer* owner, LdbManager* manager) :
-        owner_(owner), manager_(manager)
+      LdbBalancer::Balancer::Balancer(LdbBalancer* owner, LdbManager* manager, bool dry_run) :
+        owner_(owner), manager_(manager), dry_run_(dry_run)
       {
       }
 
@@ -50,114 +53,261 @@ namespace tair
         BucketIndexer::INDEX_BUCKET_MAP index_map;
         // get current bucket index map
         manager_->get_index_map(index_map);
+        // get load of each bucket
+        INDEX_LOAD_MAP load_map;
+        get_load(index_map, load_map);
         // get unit to be balanced
         std::vector<Unit> units;
-        try_balance(index_map, units);
-        if (!units.empty())
+        if (!_stop)
+        {
+          try_balance(load_map, units);
+        }
+        if (!units.empty() && !dry_run_)
         {
           do_balance(units);
         }
         delete this;
       }
 
-      void LdbBalancer::Balancer::try_balance(const BucketIndexer::INDEX_BUCKET_MAP& index_map, std::vector<Unit>& result_units)
+      void LdbBalancer::Balancer::get_load(const BucketIndexer::INDEX_BUCKET_MAP& index_map, INDEX_LOAD_MAP& load_map)
       {
-        result_units.clear();
-
-        int32_t bucket_count = 0;
-        for (BucketIndexer::INDEX_BUCKET_MAP::const_iterator it = index_map.begin();
-             it != index_map.end();
-             ++it)
+        int32_t sample_seconds = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_BALANCE_SAMPLE_SECONDS, 60);
+        int32_t size_weight = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_BALANCE_SIZE_WEIGHT, 50);
+        if (size_weight < 0 || size_weight > 100)
         {
-          bucket_count += it->size();
+          log_warn("invalid %s: %d, use 50", LDB_BALANCE_SIZE_WEIGHT, size_weight);
+          size_weight = 50;
         }
-        if (bucket_count == 0)
+
+        // read/write count is accumulated, get the rate by sampling twice
+        std::vector<std::vector<uint32_t> > start_counts(index_map.size());
+        load_map.clear();
+        load_map.resize(index_map.size());
+        uint64_t data_size = 0;
+        uint32_t read_count = 0, write_count = 0;
+        for (size_t index = 0; index < index_map.size(); ++index)
         {
-          return;
+          LdbInstance* instance = manager_->get_instance(index);
+          for (size_t i = 0; i < index_map[index].size(); ++i)
+          {
+            int32_t bucket = index_map[index][i];
+            load_map[index].push_back(BucketLoad(bucket));
+            read_count = write_count = 0;
+            instance->get_bucket_load(bucket, data_size, read_count, write_count);
+            start_counts[index].push_back(read_count + write_count);
+          }
         }
 
-        int32_t average = bucket_count / index_map.size();
-        int32_t remainder = bucket_count % index_map.size();
-
-        BucketIndexer::INDEX_BUCKET_MAP result_index_map(index_map.size());
-
-        // first pull out
-        for (size_t index = 0; index < index_map.size(); ++index)
+        if (sample_seconds > 0)
         {
-          std::vector<int32_t> buckets = index_map[index];
-          // avoid sequential buckets
-          std::random_shuffle(buckets.begin(), buckets.end());
+          log_warn("sample bucket read/write rate for %d(s)", sample_seconds);
+          TAIR_SLEEP(_stop, sample_seconds);
+        }
 
-          std::vector<int32_t>::iterator bit = buckets.begin();
-          int32_t more = buckets.size() - average;
+        uint64_t total_size = 0;
+        double total_ops = 0;
+        int32_t bucket_count = 0;
+        for (size_t index = 0; index < load_map.size(); ++index)
+        {
+          LdbInstance* instance = manager_->get_instance(index);
+          for (size_t i = 0; i < load_map[index].size(); ++i)
+          {
+            BucketLoad& load = load_map[index][i];
+            if (instance->get_bucket_load(load.bucket_, data_size, read_count, write_count))
+            {
+              load.data_size_ = data_size;
+              if (sample_seconds > 0)
+              {
+                // count may wrap around
+                load.ops_ = static_cast<double>(static_cast<uint32_t>(read_count + write_count - start_counts[index][i])) /
+                  sample_seconds;
+              }
+            }
+            total_size += load.data_size_;
+            total_ops += load.ops_;
+            ++bucket_count;
+          }
+        }
 
-          if (more > 0)
+        // weight of size and rate, the one without any load gives its weight to the other,
+        // and bucket count is balanced if no load at all.
+        double weight_size = total_size > 0 ? size_weight : 0;
+        double weight_ops = total_ops > 0 ? 100 - size_weight : 0;
+        if (weight_size + weight_ops <= 0)
+        {
+          weight_size = total_size > 0 ? 1 : 0;
+          weight_ops = total_ops > 0 ? 1 : 0;
+        }
+        for (size_t index = 0; index < load_map.size(); ++index)
+        {
+          for (size_t i = 0; i < load_map[index].size(); ++i)
           {
-            if (remainder > 0)
+            BucketLoad& load = load_map[index][i];
+            if (weight_size + weight_ops > 0)
             {
-              remainder--;
-              more--;
+              load.load_ = ((weight_size > 0 ? weight_size * load.data_size_ / total_size : 0) +
+                            (weight_ops > 0 ? weight_ops * load.ops_ / total_ops : 0)) /
+                (weight_size + weight_ops);
             }
-            if (more > 0)
+            else
             {
-              // this bucket need balance later
-              for (int i = 0; i < more; ++i)
-              {
-                // pull out the more
-                result_units.push_back(Unit(*bit++, index, 0));
-              }
+              load.load_ = 1.0 / bucket_count;
             }
           }
+        }
+      }
 
-          // add out-of-balance ones to result index map
-          result_index_map[index].insert(result_index_map[index].end(), bit, buckets.end());
+      std::string LdbBalancer::Balancer::load_to_string(const INDEX_LOAD_MAP& load_map)
+      {
+        std::string result;
+        char buf[128];
+        for (size_t index = 0; index < load_map.size(); ++index)
+        {
+          uint64_t data_size = 0;
+          double ops = 0, load = 0;
+          for (size_t i = 0; i < load_map[index].size(); ++i)
+          {
+            data_size += load_map[index][i].data_size_;
+            ops += load_map[index][i].ops_;
+            load += load_map[index][i].load_;
+          }
+          snprintf(buf, sizeof(buf), "[%lu: buckets %lu, size %"PRI64_PREFIX"uM, ops %.1f/s, load %.2f%%]",
+                   index, load_map[index].size(), data_size >> 20, ops, load * 100);
+          result.append(buf);
         }
+        return result;
+      }
 
-        if (result_units.empty())
+      // Greedy: move one bucket from the most loaded instance to the least loaded one,
+      // the bucket whose load is closest to half of their gap, until peak load is
+      // within tolerance or nothing helps. Move size is bounded by ldb_balance_max_move_size.
+      void LdbBalancer::Balancer::try_balance(const INDEX_LOAD_MAP& load_map, std::vector<Unit>& result_units)
+      {
+        result_units.clear();
+        if (load_map.empty())
         {
-          log_warn("NO NEED balance, input: %s", BucketIndexer::to_string(index_map).c_str());
+          return;
         }
-        else
+
+        int32_t tolerance = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_BALANCE_TOLERANCE_PERCENT, 5);
+        uint64_t max_move_size = strtoull(TBSYS_CONFIG.getString(TAIRLDB_SECTION, LDB_BALANCE_MAX_MOVE_SIZE, "0"), NULL, 10);
+
+        INDEX_LOAD_MAP result_load_map(load_map);
+        std::vector<double> loads(load_map.size(), 0);
+        double total_load = 0;
+        int32_t bucket_count = 0;
+        for (size_t index = 0; index < load_map.size(); ++index)
+        {
+          for (size_t i = 0; i < load_map[index].size(); ++i)
+          {
+            loads[index] += load_map[index][i].load_;
+          }
+          total_load += loads[index];
+          bucket_count += load_map[index].size();
+        }
+        if (bucket_count == 0)
         {
-          // second push in
-          // avoid too A => B
-          std::random_shuffle(result_units.begin(), result_units.end());
+          return;
+        }
+        const double limit = total_load / load_map.size() * (100 + (tolerance > 0 ? tolerance : 0)) / 100;
 
-          std::vector<Unit>::iterator uit = result_units.begin();
-          for (size_t index = 0; index < result_index_map.size(); ++index)
+        // bucket => index of unit, moved bucket moves again just changes its destination
+        std::unordered_map<int32_t, size_t> unit_index;
+        uint64_t move_size = 0;
+        // every move lowers sum of squared instance loads, bucket count bounds it anyway
+        for (int32_t round = 0; round < bucket_count; ++round)
+        {
+          size_t max_index = 0, min_index = 0;
+          for (size_t index = 1; index < loads.size(); ++index)
           {
-            std::vector<int32_t>& buckets = result_index_map[index];
-            int32_t less = average - buckets.size();
-            if (less >= 0)
+            if (loads[index] > loads[max_index])
             {
-              if (remainder > 0)
-              {
-                less++;
-                remainder--;
-              }
+              max_index = index;
+            }
+            if (loads[index] < loads[min_index])
+            {
+              min_index = index;
+            }
+          }
+          if (loads[max_index] <= limit)
+          {
+            break;
+          }
 
-              if (less > 0)
-              {
-                // balance some
-                for (int32_t i = 0; i < less; ++i, ++uit)
-                {
-                  uit->to_ = index;
-                  buckets.push_back(uit->bucket_);
-                }
-              }
+          const double gap = loads[max_index] - loads[min_index];
+          std::vector<BucketLoad>& from = result_load_map[max_index];
+          int32_t best = -1;
+          for (size_t i = 0; i < from.size(); ++i)
+          {
+            // moving load >= gap makes min instance the new peak
+            if (from[i].load_ <= 0 || from[i].load_ >= gap ||
+                (max_move_size > 0 && move_size + from[i].data_size_ > max_move_size))
+            {
+              continue;
+            }
+            if (best < 0)
+            {
+              best = i;
+              continue;
+            }
+            double diff = fabs(from[i].load_ - gap / 2), best_diff = fabs(from[best].load_ - gap / 2);
+            if (diff < best_diff || (diff == best_diff && from[i].data_size_ < from[best].data_size_))
+            {
+              best = i;
             }
           }
+          if (best < 0)
+          {
+            break;
+          }
+
+          BucketLoad load = from[best];
+          from.erase(from.begin() + best);
+          result_load_map[min_index].push_back(load);
+          loads[max_index] -= load.load_;
+          loads[min_index] += load.load_;
+          move_size += load.data_size_;
+
+          std::unordered_map<int32_t, size_t>::iterator it = unit_index.find(load.bucket_);
+          if (it == unit_index.end())
+          {
+            unit_index[load.bucket_] = result_units.size();
+            result_units.push_back(Unit(load.bucket_, max_index, min_index));
+          }
+          else
+          {
+            result_units[it->second].to_ = min_index;
+          }
+        }
 
+        // bucket moved back to where it was
+        std::vector<Unit> units;
+        for (std::vector<Unit>::iterator it = result_units.begin(); it != result_units.end(); ++it)
+        {
+          if (it->from_ != it->to_)
+          {
+            units.push_back(*it);
+          }
+        }
+        result_units.swap(units);
+
+        if (result_units.empty())
+        {
+          log_warn("%sNO NEED balance, input: %s", dry_run_ ? "DRY RUN, " : "",
+                   load_to_string(load_map).c_str());
+        }
+        else
+        {
           std::string units_str;
           for (std::vector<Unit>::iterator it = result_units.begin(); it != result_units.end(); ++it)
           {
             units_str.append(it->to_string());
           }
 
-          log_warn("NEED balance. input: %s, output: %s, balance units: (%lu) %s",
-                   BucketIndexer::to_string(index_map).c_str(),
-                   BucketIndexer::to_string(result_index_map).c_str(),
-                   result_units.size(), units_str.c_str());
+          log_warn("%sNEED balance. input: %s, output: %s, move size: %"PRI64_PREFIX"uM, balance units: (%lu) %s",
+                   dry_run_ ? "DRY RUN, " : "",
+                   load_to_string(load_map).c_str(), load_to_string(result_load_map).c_str(),
+                   move_size >> 20, result_units.size(), units_str.c_str());
         }
       }
 
@@ -300,6 +450,11 @@ namespace tair
               break;
             }
 
+            if (process <= DOING)
+            {
+              // bound balance io with migration's
+              manager_->get_instance(unit.from_)->scan_rate_limiter()->Request(batch_size);
+            }
             batch_size = 0;
             batch.Clear();
 
@@ -327,6 +482,9 @@ namespace tair
           // when data is still in memtable(ForceCompactMemTable() is asynced).
           // TODO: consummate update-with-bucket to fix this.
           to_db->ForceCompactMemTable();
+          // data written directly to to_db, what to_db's negative cache has said may be wrong now.
+          manager_->get_instance(unit.to_)->negative_cache()->invalidate_all();
+          manager_->get_instance(unit.to_)->version_index()->clear();
           ret = manager_->reindex_bucket(bucket, unit.from_, unit.to_);
           if (ret != TAIR_RETURN_SUCCESS)
           {
@@ -367,7 +525,7 @@ namespace tair
         }
       }
 
-      void LdbBalancer::start()
+      void LdbBalancer::start(bool dry_run)
       {
         if (balancer_ != NULL)
         {
@@ -375,9 +533,9 @@ namespace tair
         }
         else
         {
-          balancer_ = new Balancer(this, manager_);
+          balancer_ = new Balancer(this, manager_, dry_run);
           balancer_->start();
-          log_warn("balance start.");
+          log_warn("balance start. dry run: %s", dry_run ? "yes" : "no");
         }
       }
 
@@ -45,14 +45,16 @@ namespace tair
       class BucketIndexer;
       class LdbManager;
 
-      // balance ldb instance one-time
+      // balance ldb instance one-time.
+      // Bucket load is weighted by data size and read/write rate, buckets are
+      // moved to minimise the peak instance load.
       class LdbBalancer
       {
       public:
         class Balancer : public tbsys::CDefaultRunnable
         {
         public:
-          Balancer(LdbBalancer* owner, LdbManager* manager);
+          Balancer(LdbBalancer* owner, LdbManager* manager, bool dry_run);
           virtual ~Balancer();
 
           void run(tbsys::CThread* thread, void* arg);
@@ -78,23 +80,40 @@ namespace tair
           }
         };
 
+        // load of one bucket
+        struct BucketLoad
+        {
+          BucketLoad(int32_t bucket) :
+            bucket_(bucket), data_size_(0), ops_(0), load_(0)
+          {}
+
+          int32_t bucket_;
+          uint64_t data_size_;  // bytes
+          double ops_;          // read/write per second
+          double load_;         // weighted share of all instances' load
+        };
+        typedef std::vector<std::vector<BucketLoad> > INDEX_LOAD_MAP;
+
         static const int32_t MAX_BATCH_SIZE = 512 << 10;                // 512k
 
         private:
-          void try_balance(const BucketIndexer::INDEX_BUCKET_MAP& index_map, std::vector<Unit>& result_units);
+          void get_load(const BucketIndexer::INDEX_BUCKET_MAP& index_map, INDEX_LOAD_MAP& load_map);
+          void try_balance(const INDEX_LOAD_MAP& load_map, std::vector<Unit>& result_units);
+          std::string load_to_string(const INDEX_LOAD_MAP& load_map);
           int do_balance(const std::vector<Unit>& units);
           int do_one_balance(const Unit& unit);
 
         private:
           LdbBalancer* owner_;
           LdbManager* manager_;
+          bool dry_run_;        // only report balance plan
         };
 
       public:
         LdbBalancer(LdbManager* manager);
         ~LdbBalancer();
 
-        void start();
+        void start(bool dry_run = false);
         void stop();
         void set_wait_us(int64_t us);
         int64_t get_wait_us();
@@ -6,7 +6,8 @@
  * published by the Free Software Foundation.
  *
  * leveldb bloom filter. just modify leveldb/util/bloom.cc, we skip ldb specified
- * bytes when do hash and add stat
+ * bytes when do hash and add stat. cache-line blocked variant and per level
+ * bits per key are supported too.
  *
  * Version: $Id$
  *
@@ -15,6 +16,14 @@
  *
  */
 #include <atomic.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <string>
+#include <vector>
 
 #include "leveldb/filter_policy.h"
 #include "leveldb/slice.h"
@@ -23,6 +32,7 @@
 #include "ldb_define.hpp"
 #include "ldb_cache_stat.hpp"
 #include "common/log.hpp"
+#include "common/util.hpp"
 
 namespace tair
 {
@@ -57,25 +67,66 @@ namespace tair
       };
 
       static uint32_t BloomHash(const leveldb::Slice& key) {
-        return leveldb::Hash(key.data() + LDB_FILTER_SKIP_SIZE, key.size() - LDB_FILTER_SKIP_SIZE, 0xbc9f1d34);
+        return leveldb::Hash(key.data() + LdbKey::expired_time_size(), key.size() - LdbKey::expired_time_size(), 0xbc9f1d34);
+      }
+
+      // bits per key of filter built for each level.
+      // "level_bits_per_key" is like "10,10,10,8,8,6", levels not listed use the last one,
+      // unknown level(-1) uses bits_per_key.
+      class LdbFilterBits {
+      public:
+        LdbFilterBits(int bits_per_key, const char* level_bits_per_key)
+          : bits_per_key_(bits_per_key) {
+          std::vector<std::string> bits;
+          tair::util::string_util::split_str(level_bits_per_key, ", ", bits);
+          for (size_t i = 0; i < bits.size(); ++i) {
+            int b = atoi(bits[i].c_str());
+            level_bits_.push_back(b > 0 ? b : bits_per_key);
+          }
+        }
+
+        int get(int level) const {
+          if (level < 0 || level_bits_.empty()) {
+            return bits_per_key_;
+          }
+          return static_cast<size_t>(level) < level_bits_.size() ? level_bits_[level] : level_bits_.back();
+        }
+
+        std::string to_string() const {
+          char buf[32];
+          snprintf(buf, sizeof(buf), "%d", bits_per_key_);
+          std::string ret(buf);
+          for (size_t i = 0; i < level_bits_.size(); ++i) {
+            snprintf(buf, sizeof(buf), "%s%d", i == 0 ? " level: " : ",", level_bits_[i]);
+            ret.append(buf);
+          }
+          return ret;
+        }
+
+      private:
+        int bits_per_key_;
+        std::vector<int> level_bits_;
+      };
+
+      static size_t BloomProbes(int bits_per_key) {
+        // We intentionally round down to reduce probing cost a little bit
+        size_t k = static_cast<size_t>(bits_per_key * 0.69);  // 0.69 =~ ln(2)
+        if (k < 1) k = 1;
+        if (k > 30) k = 30;
+        return k;
       }
 
       class LdbBloomFilterPolicy : public leveldb::FilterPolicy {
       private:
-        size_t bits_per_key_;
-        size_t k_;
+        LdbFilterBits bits_;
 
       public:
         // use static global stat
         static LdbBloomStat stat_[TAIR_MAX_AREA_COUNT];
 
       public:
-        explicit LdbBloomFilterPolicy(int bits_per_key)
-          : bits_per_key_(bits_per_key) {
-          // We intentionally round down to reduce probing cost a little bit
-          k_ = static_cast<size_t>(bits_per_key * 0.69);  // 0.69 =~ ln(2)
-          if (k_ < 1) k_ = 1;
-          if (k_ > 30) k_ = 30;
+        explicit LdbBloomFilterPolicy(int bits_per_key, const char* level_bits_per_key = NULL)
+          : bits_(bits_per_key, level_bits_per_key) {
         }
 
         virtual const char* Name() const {
@@ -83,8 +134,14 @@ namespace tair
         }
 
         virtual void CreateFilter(const leveldb::Slice* keys, int n, std::string* dst) const {
+          CreateFilterForLevel(keys, n, dst, -1);
+        }
+
+        virtual void CreateFilterForLevel(const leveldb::Slice* keys, int n, std::string* dst, int level) const {
+          const int bits_per_key = bits_.get(level);
+          const size_t k = BloomProbes(bits_per_key);
           // Compute bloom filter size (in both bits and bytes)
-          size_t bits = n * bits_per_key_;
+          size_t bits = n * bits_per_key;
 
           // For small n, we can see a very high false positive rate.  Fix it
           // by enforcing a minimum bloom filter length.
@@ -95,14 +152,14 @@ namespace tair
 
           const size_t init_size = dst->size();
           dst->resize(init_size + bytes, 0);
-          dst->push_back(static_cast<char>(k_));  // Remember # of probes in filter
+          dst->push_back(static_cast<char>(k));  // Remember # of probes in filter
           char* array = &(*dst)[init_size];
           for (int32_t i = 0; i < n; i++) {
             // Use double-hashing to generate a sequence of hash values.
             // See analysis in [Kirsch,Mitzenmacher 2006].
             uint32_t h = BloomHash(keys[i]);
             const uint32_t delta = (h >> 17) | (h << 15);  // Rotate right 17 bits
-            for (size_t j = 0; j < k_; j++) {
+            for (size_t j = 0; j < k; j++) {
               const uint32_t bitpos = h % bits;
               array[bitpos/8] |= (1 << (bitpos % 8));
               h += delta;
@@ -112,7 +169,7 @@ namespace tair
 
         virtual bool KeyMayMatch(const leveldb::Slice& key, const leveldb::Slice& bloom_filter) const {
           PROFILER_BEGIN("bloom");
-          int area = LdbKey::decode_area(key.data() + LDB_KEY_META_SIZE);
+          int area = LdbKey::decode_area_with_key(key.data());
           stat_[area].add_get_count();
           const size_t len = bloom_filter.size();
           if (len < 2) {
@@ -152,10 +209,191 @@ namespace tair
 
       LdbBloomStat LdbBloomFilterPolicy::stat_[TAIR_MAX_AREA_COUNT];
 
+      // Cache-line blocked bloom filter. Hash of key picks one 64-byte block and all
+      // probes of the key fall into that block, so one lookup touches one or two(filter
+      // data is not aligned) cache lines instead of k random ones, and probes are checked
+      // all at once against a mask of the block(with SSE2 if available). False positive
+      // rate is a little higher than LdbBloomFilterPolicy at same bits per key, because
+      // keys are not spread evenly over blocks.
+      //
+      // filter format:
+      //     block     char[64] * n
+      //     k         1 byte
+      // filter less than 512 bits is one short block of 8 ~ 56 bytes, not to waste memory
+      // for small data blocks.
+      //
+      // Name is different from LdbBloomFilterPolicy, so after switching policy, filters
+      // of old tables are not used until the tables are compacted.
+      class LdbBlockedBloomFilterPolicy : public leveldb::FilterPolicy {
+      private:
+        static const size_t BLOCK_SIZE = 64;
+        static const size_t BLOCK_BITS = BLOCK_SIZE * 8;
+        LdbFilterBits bits_;
+
+      public:
+        explicit LdbBlockedBloomFilterPolicy(int bits_per_key, const char* level_bits_per_key = NULL)
+          : bits_(bits_per_key, level_bits_per_key) {
+        }
+
+        virtual const char* Name() const {
+          return "ldb.LdbBlockedBloomFilter";
+        }
+
+        virtual void CreateFilter(const leveldb::Slice* keys, int n, std::string* dst) const {
+          CreateFilterForLevel(keys, n, dst, -1);
+        }
+
+        virtual void CreateFilterForLevel(const leveldb::Slice* keys, int n, std::string* dst, int level) const {
+          const int bits_per_key = bits_.get(level);
+          const size_t k = BloomProbes(bits_per_key);
+          const size_t bits = n * bits_per_key;
+          size_t blocks = 1;
+          size_t block_size = BLOCK_SIZE;
+          if (bits < BLOCK_BITS) {
+            // one short block, round up to 8 bytes
+            block_size = bits < 64 ? 8 : (bits + 63) / 64 * 8;
+          } else {
+            // round to nearest block count, so memory is the same as classic one on average
+            blocks = (bits + BLOCK_BITS / 2) / BLOCK_BITS;
+          }
+          const uint32_t block_bits = block_size * 8;
+
+          const size_t init_size = dst->size();
+          dst->resize(init_size + blocks * block_size, 0);
+          dst->push_back(static_cast<char>(k));  // Remember # of probes in filter
+          char* array = &(*dst)[init_size];
+          for (int32_t i = 0; i < n; i++) {
+            const uint32_t h = BloomHash(keys[i]);
+            char* block = array + block_index(h, blocks) * block_size;
+            const uint32_t h2 = probe_hash(h);
+            uint32_t bitpos = h2 >> 23;
+            const uint32_t delta = probe_delta(h2);
+            for (size_t j = 0; j < k; j++) {
+              const uint32_t pos = fold(bitpos, block_bits);
+              block[pos/8] |= (1 << (pos % 8));
+              bitpos += delta;
+            }
+          }
+        }
+
+        virtual bool KeyMayMatch(const leveldb::Slice& key, const leveldb::Slice& bloom_filter) const {
+          PROFILER_BEGIN("bloom");
+          int area = LdbKey::decode_area_with_key(key.data());
+          LdbBloomFilterPolicy::stat_[area].add_get_count();
+          const size_t len = bloom_filter.size();
+          if (len < 2) {
+            LdbBloomFilterPolicy::stat_[area].add_miss_count();
+            PROFILER_END();
+            return false;
+          }
+
+          const char* array = bloom_filter.data();
+          const size_t k = array[len-1];
+          if (k > 30 || (len - 1 > BLOCK_SIZE && (len - 1) % BLOCK_SIZE != 0)) {
+            // Reserved for potentially new encodings. Consider it a match.
+            PROFILER_END();
+            return true;
+          }
+
+          const uint32_t h = BloomHash(key);
+          const uint32_t h2 = probe_hash(h);
+          uint32_t bitpos = h2 >> 23;
+          const uint32_t delta = probe_delta(h2);
+          bool match = true;
+          if (len - 1 < BLOCK_SIZE) {
+            // short block, check probe by probe
+            const uint32_t block_bits = (len - 1) * 8;
+            for (size_t j = 0; j < k; j++) {
+              const uint32_t pos = fold(bitpos, block_bits);
+              if ((array[pos/8] & (1 << (pos % 8))) == 0) {
+                match = false;
+                break;
+              }
+              bitpos += delta;
+            }
+          } else {
+            const char* block = array + block_index(h, (len - 1) / BLOCK_SIZE) * BLOCK_SIZE;
+            // build mask of all probes, then check block in one pass
+            char mask[BLOCK_SIZE] __attribute__((aligned(16)));
+            memset(mask, 0, sizeof(mask));
+            for (size_t j = 0; j < k; j++) {
+              const uint32_t pos = bitpos & (BLOCK_BITS - 1);
+              mask[pos/8] |= (1 << (pos % 8));
+              bitpos += delta;
+            }
+            match = block_contains(block, mask);
+          }
+
+          if (!match) {
+            LdbBloomFilterPolicy::stat_[area].add_miss_count();
+          }
+          PROFILER_END();
+          return match;
+        }
+
+      private:
+        // high bits of hash pick block
+        static size_t block_index(uint32_t h, size_t blocks) {
+          return static_cast<size_t>((static_cast<uint64_t>(h) * blocks) >> 32);
+        }
+
+        // remix hash to pick bits in block, so they don't correlate with block index
+        static uint32_t probe_hash(uint32_t h) {
+          h ^= h >> 16;
+          return h * 0x85ebca6b;
+        }
+
+        // odd delta, so k(<= 30) probes never wrap to same bit of whole block
+        static uint32_t probe_delta(uint32_t h2) {
+          return ((h2 >> 14) & (BLOCK_BITS - 1)) | 1;
+        }
+
+        static uint32_t fold(uint32_t bitpos, uint32_t block_bits) {
+          return block_bits == BLOCK_BITS ? (bitpos & (BLOCK_BITS - 1)) : bitpos % block_bits;
+        }
+
+        // whether all bits set in mask are set in block
+        static bool block_contains(const char* block, const char* mask) {
+#if defined(__SSE2__)
+          __m128i miss = _mm_setzero_si128();
+          for (size_t i = 0; i < BLOCK_SIZE; i += 16) {
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+            const __m128i m = _mm_load_si128(reinterpret_cast<const __m128i*>(mask + i));
+            miss = _mm_or_si128(miss, _mm_andnot_si128(b, m));
+          }
+          return _mm_movemask_epi8(_mm_cmpeq_epi8(miss, _mm_setzero_si128())) == 0xffff;
+#else
+          uint64_t miss = 0;
+          for (size_t i = 0; i < BLOCK_SIZE; i += sizeof(uint64_t)) {
+            uint64_t b, m;
+            memcpy(&b, block + i, sizeof(b));
+            memcpy(&m, mask + i, sizeof(m));
+            miss |= m & ~b;
+          }
+          return miss == 0;
+#endif
+        }
+      };
+
       leveldb::FilterPolicy* NewLdbBloomFilterPolicy(int bits_per_key) {
         return new LdbBloomFilterPolicy(bits_per_key);
       }
 
+      // type: "bloom" or "blocked_bloom". return NULL if type is unknown.
+      leveldb::FilterPolicy* NewLdbFilterPolicy(const char* type, int bits_per_key, const char* level_bits_per_key) {
+        leveldb::FilterPolicy* policy = NULL;
+        if (strcmp(type, "bloom") == 0) {
+          policy = new LdbBloomFilterPolicy(bits_per_key, level_bits_per_key);
+        } else if (strcmp(type, "blocked_bloom") == 0) {
+          policy = new LdbBlockedBloomFilterPolicy(bits_per_key, level_bits_per_key);
+        }
+        if (policy != NULL) {
+          log_warn("use filter policy %s, bits per key: %s", policy->Name(),
+                   LdbFilterBits(bits_per_key, level_bits_per_key).to_string().c_str());
+        }
+        return policy;
+      }
+
       void get_bloom_stats(cache_stat* ldb_cache_stat) {
         for (size_t i = 0; i < TAIR_MAX_AREA_COUNT; ++i) {
           // NOTE: use current cache stat temporarily. ugly..
@@ -15,6 +15,7 @@
  */
 #include <tbsys.h>
 #include "common/log.hpp"
+#include "common/util.hpp"
 
 #include "ldb_cache_stat.hpp"
 
@@ -386,6 +387,113 @@ namespace tair
         }
         return ret;
       }
+
+      static const char HOT_KEY_MAGIC[16] = "TAIR_HOTKEY_100";
+
+      CacheHotKeys::CacheHotKeys()
+      {
+      }
+
+      CacheHotKeys::~CacheHotKeys()
+      {
+      }
+
+      bool CacheHotKeys::start(const char* dir, int32_t index)
+      {
+        if (dir == NULL)
+        {
+          return false;
+        }
+        char file_name[TAIR_MAX_PATH_LEN];
+        snprintf(file_name, sizeof(file_name), "%s/ldb_cache_hot_keys.%d", dir, index);
+        file_name_.assign(file_name);
+        return true;
+      }
+
+      int CacheHotKeys::save(const HOT_KEY_LIST& keys)
+      {
+        if (file_name_.empty())
+        {
+          return TAIR_RETURN_FAILED;
+        }
+
+        std::string buf(RESERVE_SIZE, '\0');
+        memcpy(&buf[0], HOT_KEY_MAGIC, sizeof(HOT_KEY_MAGIC));
+        tair::util::coding_util::encode_fixed32(&buf[sizeof(HOT_KEY_MAGIC)], keys.size());
+        tair::util::coding_util::encode_fixed32(&buf[sizeof(HOT_KEY_MAGIC) + 4], time(NULL));
+        char head[8];
+        for (HOT_KEY_LIST::const_iterator it = keys.begin(); it != keys.end(); ++it)
+        {
+          tair::util::coding_util::encode_fixed32(head, it->first);
+          tair::util::coding_util::encode_fixed32(head + 4, it->second.size());
+          buf.append(head, sizeof(head));
+          buf.append(it->second);
+        }
+
+        std::string tmp_file_name = file_name_ + ".tmp";
+        tair::common::FileOperation file(tmp_file_name, O_RDWR | O_LARGEFILE | O_CREAT | O_TRUNC);
+        int ret = TAIR_RETURN_SUCCESS;
+        int32_t write_len = file.write_file(buf.data(), buf.size());
+        if (write_len != static_cast<int32_t>(buf.size()))
+        {
+          log_error("save cache hot keys to %s fail, ret: %d", tmp_file_name.c_str(), write_len);
+          file.unlink_file();
+          ret = TAIR_RETURN_FAILED;
+        }
+        else if ((ret = file.rename_file(file_name_.c_str())) != TAIR_RETURN_SUCCESS)
+        {
+          log_error("rename %s to %s fail. error: %s", tmp_file_name.c_str(), file_name_.c_str(), strerror(errno));
+          file.unlink_file();
+        }
+        return ret;
+      }
+
+      int CacheHotKeys::load(HOT_KEY_LIST& keys)
+      {
+        if (file_name_.empty() || ::access(file_name_.c_str(), F_OK) != 0)
+        {
+          return TAIR_RETURN_FAILED;
+        }
+
+        tair::common::FileOperation file(file_name_, O_RDONLY | O_LARGEFILE);
+        int64_t file_size = file.get_file_size();
+        if (file_size < RESERVE_SIZE || file_size > INT_MAX)
+        {
+          log_error("invalid cache hot keys file %s, size: %"PRI64_PREFIX"d", file_name_.c_str(), file_size);
+          return TAIR_RETURN_FAILED;
+        }
+
+        std::string buf(file_size, '\0');
+        if (file.pread_file(&buf[0], file_size, 0) != file_size ||
+            memcmp(buf.data(), HOT_KEY_MAGIC, sizeof(HOT_KEY_MAGIC)) != 0)
+        {
+          log_error("read cache hot keys file %s fail", file_name_.c_str());
+          return TAIR_RETURN_FAILED;
+        }
+
+        uint32_t count = tair::util::coding_util::decode_fixed32(&buf[sizeof(HOT_KEY_MAGIC)]);
+        const char* pos = buf.data() + RESERVE_SIZE;
+        const char* end = buf.data() + buf.size();
+        keys.clear();
+        keys.reserve(count);
+        while (keys.size() < count && end - pos >= 8)
+        {
+          int32_t bucket = tair::util::coding_util::decode_fixed32(pos);
+          uint32_t key_size = tair::util::coding_util::decode_fixed32(pos + 4);
+          pos += 8;
+          if (static_cast<uint32_t>(end - pos) < key_size)
+          {
+            break;
+          }
+          keys.push_back(std::make_pair(bucket, std::string(pos, key_size)));
+          pos += key_size;
+        }
+        if (keys.size() != count)
+        {
+          log_warn("cache hot keys file %s is truncated, expect %u keys, get %lu", file_name_.c_str(), count, keys.size());
+        }
+        return TAIR_RETURN_SUCCESS;
+      }
     }
   }
 }
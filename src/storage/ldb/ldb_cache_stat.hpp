@@ -22,6 +22,8 @@
 
 #include "storage/mdb/mdb_stat.hpp"
 #include <climits>
+#include <string>
+#include <vector>
 
 //class tair::common::FileOperation;
 
@@ -149,6 +151,28 @@ namespace tair
         char* buf_pos_;
         int32_t remain_buf_stat_count_;
       };
+
+      // hottest keys of one ldb cache, saved periodically and
+      // loaded to warm up the cache after restart.
+      // file: header(RESERVE_SIZE) then records of
+      //   bucket fixed32, key_size fixed32, key(area + user key as in cache)
+      class CacheHotKeys
+      {
+      public:
+        typedef std::vector<std::pair<int32_t, std::string> > HOT_KEY_LIST; // bucket => key
+
+        CacheHotKeys();
+        ~CacheHotKeys();
+        static const int32_t RESERVE_SIZE = 64;
+
+        bool start(const char* dir, int32_t index);
+        // save into temporary file and rename, old file is intact if fail
+        int save(const HOT_KEY_LIST& keys);
+        int load(HOT_KEY_LIST& keys);
+
+      private:
+        std::string file_name_;
+      };
     }
   }
 }
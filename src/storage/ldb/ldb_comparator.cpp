@@ -17,6 +17,7 @@
 #include "ldb_define.hpp"
 #include "ldb_gc_factory.hpp"
 #include "ldb_comparator.hpp"
+#include "util/hash.h"
 
 namespace tair
 {
@@ -24,12 +25,11 @@ namespace tair
   {
     namespace ldb
     {
-      static const size_t LDB_COMPARE_SKIP_SIZE = LDB_EXPIRED_TIME_SIZE;
-      BitcmpLdbComparatorImpl::BitcmpLdbComparatorImpl() : gc_(NULL)
+      BitcmpLdbComparatorImpl::BitcmpLdbComparatorImpl() : gc_(NULL), skip_(LdbKey::expired_time_size())
       {
       }
 
-      BitcmpLdbComparatorImpl::BitcmpLdbComparatorImpl(LdbGcFactory* gc) : gc_(gc)
+      BitcmpLdbComparatorImpl::BitcmpLdbComparatorImpl(LdbGcFactory* gc) : gc_(gc), skip_(LdbKey::expired_time_size())
       {
       }
 
@@ -39,16 +39,16 @@ namespace tair
 
       const char* BitcmpLdbComparatorImpl::Name() const
       {
-        return "ldb.LdbComparator";
+        // keys of different format never go into one db
+        return skip_ > 0 ? "ldb.LdbComparator" : "ldb.LdbComparatorV2";
       }
 
       // skip expired time
       int BitcmpLdbComparatorImpl::Compare(const leveldb::Slice& a, const leveldb::Slice& b) const
       {
-        assert(a.size() > LDB_COMPARE_SKIP_SIZE && b.size() > LDB_COMPARE_SKIP_SIZE);
-        const int min_len = (a.size() < b.size()) ? a.size() - LDB_COMPARE_SKIP_SIZE :
-          b.size() - LDB_COMPARE_SKIP_SIZE;
-        int r = memcmp(a.data() + LDB_COMPARE_SKIP_SIZE, b.data() + LDB_COMPARE_SKIP_SIZE, min_len);
+        assert(a.size() > skip_ && b.size() > skip_);
+        const int min_len = (a.size() < b.size()) ? a.size() - skip_ : b.size() - skip_;
+        int r = memcmp(a.data() + skip_, b.data() + skip_, min_len);
         if (r == 0)
         {
           if (a.size() < b.size())
@@ -70,8 +70,8 @@ namespace tair
       {
         // Find length of common prefix
         size_t min_length = std::min(start->size(), limit.size());
-        assert(min_length > LDB_COMPARE_SKIP_SIZE);
-        size_t diff_index = LDB_COMPARE_SKIP_SIZE;
+        assert(min_length > skip_);
+        size_t diff_index = skip_;
         while ((diff_index < min_length) &&
                ((*start)[diff_index] == limit[diff_index]))
         {
@@ -98,7 +98,7 @@ namespace tair
       {
         // Find first character that can be incremented
         size_t n = key->size();
-        for (size_t i = LDB_COMPARE_SKIP_SIZE; i < n; i++)
+        for (size_t i = skip_; i < n; i++)
         {
           const uint8_t byte = (*key)[i];
           if (byte != static_cast<uint8_t>(0xff))
@@ -111,6 +111,13 @@ namespace tair
         // *key is a run of 0xffs.  Leave it alone.
       }
 
+      bool BitcmpLdbComparatorImpl::Hash(const leveldb::Slice& key, uint32_t* hash) const
+      {
+        assert(key.size() > skip_);
+        *hash = leveldb::Hash(key.data() + skip_, key.size() - skip_, 0x7a3c9d15);
+        return true;
+      }
+
       bool BitcmpLdbComparatorImpl::ShouldDrop(const char* key, int64_t sequence, uint32_t will_gc) const
       {
         if (gc_ == NULL || gc_->empty())
@@ -125,8 +132,8 @@ namespace tair
         //  Gc factory's check depends on no condition here, because every items will be checked
         //  by gc.
 
-        // key format
-        //     expired_time  fixed32
+        // key format (see LDB_KEY_FORMAT_V1/V2)
+        //     expired_time  fixed32 (v1 only)
         //     bucket_number 3bytes
         //     area_number   2bytes
         //     user_key      ...
@@ -138,7 +145,7 @@ namespace tair
         if (0 == will_gc || (0 != will_gc && gc_->can_gc_))
         {
           const char* pkey = key;
-          pkey += LDB_EXPIRED_TIME_SIZE;
+          pkey += skip_;
 
           // To decode as later as possible, check empty and check need_gc separately, so need lock here.
           tbsys::CRLockGuard guard(gc_->lock_);
@@ -161,14 +168,59 @@ namespace tair
       {
         UNUSED(sequence);
         // check expired time here. see ShouldDrop()
-        uint32_t expired_time = tair::util::coding_util::decode_fixed32(key);
+        // v2 key has no expired time, entry is checked with value by the other one.
+        uint32_t expired_time = skip_ > 0 ? tair::util::coding_util::decode_fixed32(key) : 0;
         return expired_time > 0 && expired_time < (now > 0 ? now : time(NULL));
       }
 
+      bool BitcmpLdbComparatorImpl::ShouldDropMaybe(const leveldb::Slice& key, const leveldb::Slice& value,
+                                                    int64_t sequence, uint32_t now) const
+      {
+        UNUSED(sequence);
+        uint32_t expired_time = 0;
+        return GetExpiredTime(key, value, &expired_time) &&
+          expired_time > 0 && expired_time < (now > 0 ? now : time(NULL));
+      }
+
       bool BitcmpLdbComparatorImpl::ShouldStopBefore(const leveldb::Slice& start_key, const leveldb::Slice& key) const
       {
-        return LdbKey::decode_bucket_number_with_key(key.data()) !=
-          LdbKey::decode_bucket_number_with_key(start_key.data());
+        return LdbKey::decode_bucket_number(key.data() + skip_) !=
+          LdbKey::decode_bucket_number(start_key.data() + skip_);
+      }
+
+      bool BitcmpLdbComparatorImpl::GetTimeMeta(const leveldb::Slice& key, const leveldb::Slice& value,
+                                                 uint32_t* expired_time, uint32_t* modify_time) const
+      {
+        bool ret = value.size() >= static_cast<size_t>(LDB_ITEM_META_BASE_SIZE) &&
+          GetExpiredTime(key, value, expired_time);
+        if (ret)
+        {
+          *modify_time = reinterpret_cast<const LdbItemMetaBase*>(value.data())->mdate_;
+        }
+        return ret;
+      }
+
+      bool BitcmpLdbComparatorImpl::GetExpiredTime(const leveldb::Slice& key, const leveldb::Slice& value,
+                                                   uint32_t* expired_time) const
+      {
+        bool ret = false;
+        if (skip_ > 0)
+        {
+          ret = key.size() >= skip_;
+          if (ret)
+          {
+            *expired_time = tair::util::coding_util::decode_fixed32(key.data());
+          }
+        }
+        else
+        {
+          ret = value.size() >= static_cast<size_t>(LDB_ITEM_META_BASE_SIZE);
+          if (ret)
+          {
+            *expired_time = reinterpret_cast<const LdbItemMetaBase*>(value.data())->edate_;
+          }
+        }
+        return ret;
       }
 
       const leveldb::Comparator* LdbComparator(LdbGcFactory* gc)
@@ -42,10 +42,22 @@ namespace tair
         virtual bool ShouldDrop(const char* key, int64_t sequence, uint32_t will_gc = 0) const;
         // should drop this key based on some condition. (user defined)
         virtual bool ShouldDropMaybe(const char* key, int64_t sequence, uint32_t now = 0) const;
+        // expired time in key(v1) or value's meta(v2)
+        virtual bool ShouldDropMaybe(const leveldb::Slice& key, const leveldb::Slice& value,
+                                     int64_t sequence, uint32_t now = 0) const;
         // should stop build sst before `key based on `start_key
         virtual bool ShouldStopBefore(const leveldb::Slice& start_key, const leveldb::Slice& key) const;
+        // expired time in key(v1) or value's meta(v2), modify time in value's meta
+        virtual bool GetTimeMeta(const leveldb::Slice& key, const leveldb::Slice& value,
+                                 uint32_t* expired_time, uint32_t* modify_time) const;
+        // skip expired time, same as Compare()
+        virtual bool Hash(const leveldb::Slice& key, uint32_t* hash) const;
       private:
+        bool GetExpiredTime(const leveldb::Slice& key, const leveldb::Slice& value, uint32_t* expired_time) const;
+
         LdbGcFactory* gc_;
+        // bytes of expired time before bucket number in key, skipped by comparing
+        const size_t skip_;
       };
 
       class NumericalComparatorImpl : public leveldb::Comparator
@@ -64,8 +76,13 @@ namespace tair
         virtual bool ShouldDrop(const char* key, int64_t sequence, uint32_t will_gc = 0) const;
         // should drop this key based on some condition. (user defined)
         virtual bool ShouldDropMaybe(const char* key, int64_t sequence, uint32_t now = 0) const;
+        virtual bool ShouldDropMaybe(const leveldb::Slice& key, const leveldb::Slice& value,
+                                     int64_t sequence, uint32_t now = 0) const;
         // should stop build sst before `key based on `start_key
         virtual bool ShouldStopBefore(const leveldb::Slice& start_key, const leveldb::Slice& key) const;
+        // expired time in key(v1) or value's meta(v2), modify time in value's meta
+        virtual bool GetTimeMeta(const leveldb::Slice& key, const leveldb::Slice& value,
+                                 uint32_t* expired_time, uint32_t* modify_time) const;
       private:
         //const char *PrefixCheck(const char *key, size_t len) const;
         //const char *KeyToNumber(const char *key, size_t len, int64_t &number, const char *&number_p) const;
@@ -76,6 +93,8 @@ namespace tair
       private:
         const char number_delim_; //special char befor number
         size_t meta_len_;       //skip meta_len_
+        const size_t skip_;           //expired time before bucket number
+        const size_t meta_all_size_;  //expired time, bucket number and area
         leveldb::Comparator* ldb_comparator_; 
       }; 
 
@@ -27,10 +27,13 @@ namespace tair
   {
     namespace ldb
     {
+      int32_t LdbKey::format_ = LDB_KEY_FORMAT_V1;
+      int32_t LdbKey::expired_time_size_ = LDB_EXPIRED_TIME_SIZE;
+
       void ldb_key_printer(const leveldb::Slice& key, std::string& output)
       {
         // we only care bucket number, area and first byte of key now
-        if (key.size() < LDB_KEY_META_SIZE + LDB_KEY_AREA_SIZE + 1)
+        if (key.size() < static_cast<size_t>(LdbKey::meta_size() + LDB_KEY_AREA_SIZE + 1))
         {
           log_error("invalid ldb key. igore print");
           output.append("DiRtY");
@@ -41,11 +44,11 @@ namespace tair
           int32_t skip = 0;
           // bucket number
           skip += snprintf(buf + skip, sizeof(buf) - skip, "%d",
-                          LdbKey::decode_bucket_number(key.data() + LDB_EXPIRED_TIME_SIZE));
+                          LdbKey::decode_bucket_number_with_key(key.data()));
           // area
-          skip += snprintf(buf + skip, sizeof(buf) - skip, "-%d", LdbKey::decode_area(key.data() + LDB_KEY_META_SIZE));
+          skip += snprintf(buf + skip, sizeof(buf) - skip, "-%d", LdbKey::decode_area_with_key(key.data()));
           // first byte of key
-          skip += snprintf(buf + skip, sizeof(buf) - skip, "-0x%X", *(key.data() + LDB_KEY_META_SIZE + LDB_KEY_AREA_SIZE));
+          skip += snprintf(buf + skip, sizeof(buf) - skip, "-0x%X", *(key.data() + LdbKey::meta_size() + LDB_KEY_AREA_SIZE));
           output.append(buf);
         }
       }
@@ -466,7 +469,7 @@ namespace tair
 
       void LdbBucketDataIter::seek_to_first()
       {
-        char scan_key[LDB_KEY_META_SIZE];
+        char scan_key[LDB_KEY_META_MAX_SIZE];
         LdbKey::build_key_meta(scan_key, bucket_);
 
         log_snapshot_ = dynamic_cast<const leveldb::LogSnapshotImpl*>(db_->GetLogSnapshot());
@@ -481,7 +484,7 @@ namespace tair
         scan_options.fill_cache = false;
 
         db_it_ = db_->NewIterator(scan_options);
-        db_it_->Seek(leveldb::Slice(scan_key, sizeof(scan_key)));
+        db_it_->Seek(leveldb::Slice(scan_key, LdbKey::meta_size()));
         db_sanity();
       }
 
@@ -40,10 +40,22 @@ namespace tair
     {
       const static int LDB_EXPIRED_TIME_SIZE = sizeof(uint32_t);
       const static int LDB_KEY_BUCKET_NUM_SIZE = 3;
-      const static int LDB_KEY_META_SIZE = LDB_KEY_BUCKET_NUM_SIZE + LDB_EXPIRED_TIME_SIZE;
+      // key meta size of LDB_KEY_FORMAT_V1, enough for key meta of any format
+      const static int LDB_KEY_META_MAX_SIZE = LDB_KEY_BUCKET_NUM_SIZE + LDB_EXPIRED_TIME_SIZE;
       const static int LDB_KEY_AREA_SIZE = 2;
       const static int MAX_BUCKET_NUMBER = (1 << 24) - 2;
-      const static int LDB_FILTER_SKIP_SIZE = LDB_EXPIRED_TIME_SIZE;
+
+      // key format, fixed since db is created (comparator name differs by format)
+      //   v1: expired_time fixed32 | bucket_number 3bytes | area 2bytes | user_key
+      //       comparator and filter skip expired time.
+      //   v2: bucket_number 3bytes | area 2bytes | user_key
+      //       expired time is only in value meta (edate_), keys are compared as
+      //       they are, and adjacent keys share prefix in block.
+      enum
+      {
+        LDB_KEY_FORMAT_V1 = 1,
+        LDB_KEY_FORMAT_V2 = 2,
+      };
 
       extern void ldb_key_printer(const leveldb::Slice& key, std::string& output);
       extern bool get_db_stat(leveldb::DB* db, std::string& value, const char* property);
@@ -95,10 +107,10 @@ namespace tair
           if (key_data != NULL && key_size > 0)
           {
             free();
-            data_size_ = key_size + LDB_KEY_META_SIZE;
+            data_size_ = key_size + meta_size();
             data_ = new char[data_size_];
             build_key_meta(data_, bucket_number, expired_time);
-            memcpy(data_ + LDB_KEY_META_SIZE, key_data, key_size);
+            memcpy(data_ + meta_size(), key_data, key_size);
             alloc_ = true;
           }
         }
@@ -129,15 +141,15 @@ namespace tair
         }
         inline char* key()
         {
-          return data_ != NULL ? data_ + LDB_KEY_META_SIZE : NULL;
+          return data_ != NULL ? data_ + meta_size() : NULL;
         }
         inline int32_t key_size()
         {
-          return data_size_ > LDB_KEY_META_SIZE ? (data_size_ - LDB_KEY_META_SIZE) : 0;
+          return data_size_ > meta_size() ? (data_size_ - meta_size()) : 0;
         }
         inline void incr_key(int index)
         {
-          index += LDB_KEY_META_SIZE + LDB_KEY_AREA_SIZE - 1; 
+          index += meta_size() + LDB_KEY_AREA_SIZE - 1; 
           while (index > 0)
             if ((uint8_t)data_[index] != 0xFF)
             {
@@ -147,6 +159,28 @@ namespace tair
             else
               index --;
         }
+        // key format of all dbs in process, set before any db or comparator is created
+        static void set_format(int32_t format)
+        {
+          format_ = format;
+          expired_time_size_ = format == LDB_KEY_FORMAT_V1 ? LDB_EXPIRED_TIME_SIZE : 0;
+        }
+        static int32_t format()
+        {
+          return format_;
+        }
+        // bytes before bucket number
+        static int32_t expired_time_size()
+        {
+          return expired_time_size_;
+        }
+        // bytes before area
+        static int32_t meta_size()
+        {
+          return expired_time_size_ + LDB_KEY_BUCKET_NUM_SIZE;
+        }
+
+        // buf must have meta_size() bytes, expired_time is dropped in v2
         static void build_key_meta(char* buf, int32_t bucket_number, uint32_t expired_time = 0)
         {
           // consistent key len SCAN_KEY_LEN
@@ -155,8 +189,11 @@ namespace tair
           // but user defined comparator need caculate datalen every time.
 
           // encode expired time
-          tair::util::coding_util::encode_fixed32(buf, expired_time);
-          encode_bucket_number(buf + LDB_EXPIRED_TIME_SIZE, bucket_number);
+          if (expired_time_size_ > 0)
+          {
+            tair::util::coding_util::encode_fixed32(buf, expired_time);
+          }
+          encode_bucket_number(buf + expired_time_size_, bucket_number);
         }
 
         static void encode_bucket_number(char* buf, int bucket_number)
@@ -169,12 +206,17 @@ namespace tair
 
         inline int32_t get_bucket_number()
         {
-          return decode_bucket_number(data_ + LDB_EXPIRED_TIME_SIZE);
+          return decode_bucket_number(data_ + expired_time_size_);
         }
 
         static int32_t decode_bucket_number_with_key(const char* key_buf)
         {
-          return decode_bucket_number(key_buf + LDB_EXPIRED_TIME_SIZE);
+          return decode_bucket_number(key_buf + expired_time_size_);
+        }
+
+        static int32_t decode_area_with_key(const char* key_buf)
+        {
+          return decode_area(key_buf + meta_size());
         }
 
         static int32_t decode_bucket_number(const char* buf)
@@ -200,27 +242,31 @@ namespace tair
 
         static void build_scan_key(int32_t bucket_number, std::string& start_key, std::string& end_key)
         {
-          char buf[LDB_KEY_META_SIZE];
+          char buf[LDB_KEY_META_MAX_SIZE];
           build_key_meta(buf, bucket_number);
-          start_key.assign(buf, LDB_KEY_META_SIZE);
+          start_key.assign(buf, meta_size());
           build_key_meta(buf, bucket_number+1);
-          end_key.assign(buf, LDB_KEY_META_SIZE);
+          end_key.assign(buf, meta_size());
         }
 
         static void build_scan_key_with_area(int32_t bucket_number, int32_t area, std::string& start_key, std::string& end_key)
         {
-          char buf[LDB_KEY_META_SIZE + LDB_KEY_AREA_SIZE];
+          char buf[LDB_KEY_META_MAX_SIZE + LDB_KEY_AREA_SIZE];
+          const int32_t size = meta_size() + LDB_KEY_AREA_SIZE;
 
           build_key_meta(buf, bucket_number);
-          encode_area(buf + LDB_KEY_META_SIZE, area);
-          start_key.assign(buf, sizeof(buf));
+          encode_area(buf + meta_size(), area);
+          start_key.assign(buf, size);
 
           build_key_meta(buf, bucket_number);
-          encode_area(buf + LDB_KEY_META_SIZE, area + 1);
-          end_key.assign(buf, sizeof(buf));
+          encode_area(buf + meta_size(), area + 1);
+          end_key.assign(buf, size);
         }
 
       private:
+        static int32_t format_;
+        static int32_t expired_time_size_;
+
         char* data_;
         int32_t data_size_;
         bool alloc_;
@@ -528,6 +528,30 @@ namespace tair
         return node;
       }
 
+      void LdbGcFactory::get_gc_nodes(GcType type, std::vector<GcNode>& nodes)
+      {
+        tbsys::CRLockGuard guard(lock_);
+        const GC_MAP* gc_container = NULL;
+        switch (type) {
+        case GC_BUCKET:
+          gc_container = &gc_buckets_;
+          break;
+        case GC_AREA:
+          gc_container = &gc_areas_;
+          break;
+        default:
+          log_error("get invalid gc type: %d", type);
+          break;
+        }
+        if (gc_container != NULL)
+        {
+          for (GC_MAP_CONST_ITER it = gc_container->begin(); it != gc_container->end(); ++it)
+          {
+            nodes.push_back(it->second);
+          }
+        }
+      }
+
       // user should hold CRLockGuard(lock_)
       bool LdbGcFactory::need_gc(int32_t key, uint64_t sequence, const GC_MAP& container)
       {
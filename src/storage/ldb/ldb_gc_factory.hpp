@@ -182,6 +182,7 @@ namespace tair
         int remove(const GcNode& node, GcType type);
 
         GcNode pick_gc_node(GcType type);
+        void get_gc_nodes(GcType type, std::vector<GcNode>& nodes);
         void try_evict();
 
         // check whether this key need gc, user should hold lock_(LdbComparator convient use)
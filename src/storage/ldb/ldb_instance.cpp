@@ -14,7 +14,13 @@
  *
  */
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+#include <leveldb/cache.h>
 #include <leveldb/env.h>
+#include <leveldb/rate_limiter.h>
 #include <leveldb/write_batch.h>
 #include <util/config.h>
 
@@ -36,19 +42,34 @@ namespace tair
     {
       using namespace tair::common;
 
+      // name of leveldb::IOType
+      static const char* IO_TYPE_NAME[leveldb::kNumIOTypes] = { "flush", "compaction", "scan" };
+      // files of migrating bucket are under db_path_ + MIGRATE_DIR_SUFFIX
+      static const char* MIGRATE_DIR_SUFFIX = "_migrate";
+      // empty file shipped with sstables of bucket, named by key format of them.
+      // no such file means LDB_KEY_FORMAT_V1 (sent by old server).
+      static const char* MIGRATE_KEY_FORMAT_PREFIX = "key_format.";
+
       LdbInstance::LdbInstance()
         : index_(0), db_version_care_(true), mutex_(NULL), db_(NULL), cache_(NULL),
-          scan_it_(NULL), scan_bucket_(-1), still_have_(true)
+          scan_it_(NULL), scan_bucket_(-1), still_have_(true),
+          rate_limit_target_latency_(0), rate_limit_min_percent_(0), migrate_by_file_(false),
+          shared_block_cache_(NULL), write_buffer_manager_(NULL)
       {
         db_path_[0] = '\0';
         stat_manager_ = new STAT_MANAGER_MAP();
+        atomic_set(&cache_fill_epoch_, 0);
       }
 
       LdbInstance::LdbInstance(int32_t index, bool db_version_care,
-                               storage::storage_manager* cache)
+                               storage::storage_manager* cache,
+                               leveldb::Cache* shared_block_cache,
+                               leveldb::WriteBufferManager* write_buffer_manager)
         : index_(index), db_version_care_(db_version_care), mutex_(NULL), db_(NULL),
           cache_(dynamic_cast<tair::mdb_manager*>(cache)),
-          scan_it_(NULL), scan_bucket_(-1), still_have_(true)
+          scan_it_(NULL), scan_bucket_(-1), still_have_(true),
+          rate_limit_target_latency_(0), rate_limit_min_percent_(0), migrate_by_file_(false),
+          shared_block_cache_(shared_block_cache), write_buffer_manager_(write_buffer_manager)
       {
         if (cache_ != NULL)
         {
@@ -56,6 +77,7 @@ namespace tair
         }
         db_path_[0] = '\0';
         stat_manager_ = new STAT_MANAGER_MAP();
+        atomic_set(&cache_fill_epoch_, 0);
       }
 
       LdbInstance::~LdbInstance()
@@ -90,6 +112,11 @@ namespace tair
         {
           delete options_.filter_policy;
         }
+        // delete allocated block cache (or view of shared one)
+        if (options_.block_cache != NULL)
+        {
+          delete options_.block_cache;
+        }
       }
 
       bool LdbInstance::init_db()
@@ -108,6 +135,7 @@ namespace tair
           }
           else
           {
+            int64_t start_us = tbsys::CTimeUtil::getTime();
             // leveldb data path
             snprintf(db_path_, sizeof(db_path_), "%s%d/ldb", data_dir, index_ + 1/*TODO: change to index*/);
 
@@ -115,15 +143,24 @@ namespace tair
             {
               log_error("mkdir fail: %s", db_path_);
             }
+            else if (!(ret = init_db_paths()))
+            {
+              log_error("init extra data dirs fail");
+            }
             else
             {
               sanitize_option();
+              negative_cache_.init(atoll(TBSYS_CONFIG.getString(TAIRLDB_SECTION, LDB_NEGATIVE_CACHE_SLOT_COUNT, "0")));
+              version_index_.init(atoll(TBSYS_CONFIG.getString(TAIRLDB_SECTION, LDB_VERSION_INDEX_SLOT_COUNT, "0")));
+              migrate_by_file_ = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_MIGRATE_BY_FILE, 0) > 0;
 
               log_warn("init ldb %d: table_cache_size: %lu, write_buffer: %lu, use_bloomfilter: %s, use_mmap: %s",
                        index_, options_.table_cache_size, options_.write_buffer_size,
                        options_.filter_policy != NULL ? "yes" : "no",
                        options_.kUseMmapRandomAccess ? "yes" : "no");
+              int64_t open_us = tbsys::CTimeUtil::getTime();
               leveldb::Status status = leveldb::DB::Open(options_, db_path_, &db_);
+              int64_t task_us = tbsys::CTimeUtil::getTime();
 
               if (!status.ok())
               {
@@ -146,6 +183,13 @@ namespace tair
                   destroy();
                 }
               }
+
+              // db open is split into manifest/log recovery and table preload in ldb LOG
+              int64_t end_us = tbsys::CTimeUtil::getTime();
+              log_warn("init ldb %d %s, cost %"PRI64_PREFIX"d us: prepare %"PRI64_PREFIX"d us, "
+                       "open db %"PRI64_PREFIX"d us, start tasks %"PRI64_PREFIX"d us",
+                       index_, ret ? "success" : "fail", end_us - start_us, open_us - start_us,
+                       task_us - open_us, end_us - task_us);
             }
           }
         }
@@ -213,6 +257,8 @@ namespace tair
         usleep(40);
         // add gc
         gc_.add(gc_buckets, GC_BUCKET);
+        // items of these buckets are gone
+        version_index_.clear();
 
         for (std::vector<stat_manager*>::iterator it = stop_stats.begin(); it != stop_stats.end(); ++it)
         {
@@ -275,6 +321,7 @@ namespace tair
         {
           return TAIR_RETURN_SERVER_CAN_NOT_WORK;
         }
+        stat_write(bucket_number, 1);
 
         uint32_t cdate = 0, mdate = 0, edate = 0;
         int stat_data_size = 0, stat_use_size = 0, item_count = 1;
@@ -308,13 +355,12 @@ namespace tair
         // version care or mtime_care
         if ((db_version_care_ && version_care) || mtime_care)
         {
+          int32_t db_value_size = 0, db_item_size = 0;
           PROFILER_BEGIN("db get");
-          rc = do_get(ldb_key, db_value, true/* get from cache */,
-                      false/* not fill cache */, false/* not update cache stat */);
+          rc = do_get_for_write(ldb_key, db_value, ldb_item, db_value_size, db_item_size);
           PROFILER_END();
           if (TAIR_RETURN_SUCCESS == rc)
           {
-            ldb_item.assign(const_cast<char*>(db_value.data()), db_value.size());
             // db mtime is later than request, then need not do operation any more
             need_op = !(mtime_care && ldb_item.mdate() > key.data_meta.mdate);
             log_debug("@@ mtime care: %d,np:%d, %d <> %d",mtime_care, need_op,ldb_item.mdate(),key.data_meta.mdate);
@@ -338,8 +384,8 @@ namespace tair
 
               if (rc == TAIR_RETURN_SUCCESS)
               {
-                stat_data_size -= ldb_key.key_size() + ldb_item.value_size();
-                stat_use_size -= ldb_key.size() + ldb_item.size();
+                stat_data_size -= ldb_key.key_size() + db_value_size;
+                stat_use_size -= ldb_key.size() + db_item_size;
                 item_count = 0;
               }
             }
@@ -383,6 +429,25 @@ namespace tair
           rc = do_put(ldb_key, ldb_item, SHOULD_PUT_FILL_CACHE(key.data_meta.flag), is_synced(key));
           PROFILER_END();
 
+          if (version_index_.enable())
+          {
+            if (TAIR_RETURN_SUCCESS == rc)
+            {
+              LdbVersionMeta vmeta;
+              vmeta.version_ = ldb_item.version();
+              vmeta.cdate_ = ldb_item.cdate();
+              vmeta.mdate_ = ldb_item.mdate();
+              vmeta.edate_ = ldb_item.edate();
+              vmeta.value_size_ = ldb_item.value_size();
+              vmeta.item_size_ = ldb_item.size();
+              version_index_.set(ldb_key.key(), ldb_key.key_size(), vmeta);
+            }
+            else
+            {
+              version_index_.remove(ldb_key.key(), ldb_key.key_size());
+            }
+          }
+
           if (TAIR_RETURN_SUCCESS == rc)
           {
             stat_data_size += ldb_key.key_size() + ldb_item.value_size();
@@ -441,6 +506,7 @@ namespace tair
         {
           return TAIR_RETURN_SERVER_CAN_NOT_WORK;
         }
+        stat_write(bucket_number, kvs.size());
 
         leveldb::WriteBatch batch;
         const bool synced = true;
@@ -496,6 +562,15 @@ namespace tair
         }
 
         leveldb::Status status = db_->Write(write_options_, &batch, bucket_number);
+        // key maybe exist now, no matter write succeed or not
+        for (size_t i = 0; i < kvs.size(); ++i)
+        {
+          if (kvs[i]->operation_type == 1)
+          {
+            negative_cache_.invalidate(kvs[i]->key->get_data(), kvs[i]->key->get_size());
+          }
+          version_index_.remove(kvs[i]->key->get_data(), kvs[i]->key->get_size());
+        }
         if (!status.ok())
         {
           log_error("direct update fail. %s", status.ToString().c_str());
@@ -524,6 +599,7 @@ namespace tair
         {
           return TAIR_RETURN_FAILED;
         }
+        stat_write(bucket_number, record_vec->size());
 
         leveldb::WriteBatch batch;
         int stat_data_size = 0, stat_use_size = 0, item_count = record_vec->size();
@@ -642,6 +718,17 @@ namespace tair
         {
           leveldb::Status status = db_->Write(write_options_, &batch, bucket_number);
 
+          if (negative_cache_.enable() || version_index_.enable())
+          {
+            for (tair::common::mput_record_vec::iterator it = record_vec->begin() ; it != record_vec->end(); ++it)
+            {
+              data_entry mkey = *((*it)->key);
+              mkey.merge_area(area);
+              negative_cache_.invalidate(mkey.get_data(), mkey.get_size());
+              version_index_.remove(mkey.get_data(), mkey.get_size());
+            }
+          }
+
           if (!status.ok())
           {
             log_error("update batch ldb fail. %s", status.ToString().c_str());
@@ -656,7 +743,8 @@ namespace tair
         return rc;
       }
 
-      int LdbInstance::get_range(int bucket_number, data_entry& key_start, data_entry& key_end, int offset, int limit, int type, std::vector<data_entry*> &result, bool &has_next)
+      int LdbInstance::get_range(int bucket_number, data_entry& key_start, data_entry& key_end, int offset, int limit, int type, std::vector<data_entry*> &result, bool &has_next,
+                                 data_entry* cursor)
       {
         if (db_ == NULL)
         {
@@ -667,6 +755,18 @@ namespace tair
           log_error("unknown cmd type:%d", type);
           return TAIR_RETURN_INVALID_ARGUMENT; 
         }
+        // resume position must be in the same area and prefix
+        bool resume = cursor != NULL && cursor->get_size() > 0;
+        if (resume && (cursor->get_size() < key_start.get_prefix_size() + LDB_KEY_AREA_SIZE ||
+                       memcmp(cursor->get_data(), key_start.get_data(), key_start.get_prefix_size() + LDB_KEY_AREA_SIZE) != 0))
+        {
+          log_error("invalid range cursor, size:%d prefixsize:%d", cursor->get_size(), key_start.get_prefix_size());
+          return TAIR_RETURN_INVALID_ARGUMENT;
+        }
+        if (cursor != NULL)
+        {
+          offset = 0;
+        }
 
         int total_size = 0;
         bool end_break = false;
@@ -691,7 +791,8 @@ namespace tair
         scan_read_options.fill_cache = false;
         iter = db_->NewIterator(scan_read_options);
 
-        LdbKey ldbkey(key_start.get_data(), key_start.get_size(), bucket_number);
+        LdbKey ldbkey(resume ? cursor->get_data() : key_start.get_data(),
+                      resume ? cursor->get_size() : key_start.get_size(), bucket_number);
         LdbKey ldbendkey(key_end.get_data(), key_end.get_size(), bucket_number);
 
         bool reverse_find_next = false;
@@ -701,7 +802,7 @@ namespace tair
           add_prefix(ldbendkey, key_end.get_prefix_size()); 
         }
         // if reverse scan && key_start's skey is "",  add_prefix to key_start for scan all prefix. 
-        if (reverse && (key_start.get_size()- key_start.get_prefix_size() == TAIR_AREA_ENCODE_SIZE))
+        if (reverse && !resume && (key_start.get_size()- key_start.get_prefix_size() == TAIR_AREA_ENCODE_SIZE))
         {
           add_prefix(ldbkey, key_start.get_prefix_size()); 
           reverse_find_next = true;
@@ -722,6 +823,18 @@ namespace tair
             iter->SeekToLast(); 
           }
         }
+        else if (reverse && resume)
+        {
+          // entry at cursor may be gone, never return entries before it again
+          if (!iter->Valid())
+          {
+            iter->SeekToLast();
+          }
+          else if (options_.comparator->Compare(iter->key(), slice_key_start) > 0)
+          {
+            iter->Prev();
+          }
+        }
 
         //iterate all keys
         while(iter->Valid() && count < limit) 
@@ -767,12 +880,39 @@ namespace tair
 
           count++;
           
-          if (total_size > range_max_size)
-            break;
-          reverse ? iter->Prev() : iter->Next();
+          if (cursor != NULL)
+          {
+            // cursor points to the next unread entry
+            reverse ? iter->Prev() : iter->Next();
+            if (total_size > range_max_size)
+              break;
+          }
+          else
+          {
+            if (total_size > range_max_size)
+              break;
+            reverse ? iter->Prev() : iter->Next();
+          }
         }
         
-        if (limit != count && !end_break && iter->Valid())        
+        if (cursor != NULL)
+        {
+          // iterator is at the next unread entry
+          has_next = !end_break && iter->Valid() &&
+            ((!reverse && options_.comparator->Compare(iter->key(), slice_key_end) < 0)
+             || (reverse && options_.comparator->Compare(iter->key(), slice_key_end) > 0));
+          if (has_next)
+          {
+            ldb_key.assign(const_cast<char*>(iter->key().data()), iter->key().size());
+            cursor->set_data(ldb_key.key(), ldb_key.key_size());
+            cursor->set_prefix_size(key_start.get_prefix_size());
+          }
+          else
+          {
+            cursor->set_data(NULL, 0);
+          }
+        }
+        else if (limit != count && !end_break && iter->Valid())        
         {
           has_next = true;
         }
@@ -792,12 +932,57 @@ namespace tair
         return rc;
       }
 
+      int LdbInstance::del_range_at_once(int bucket_number, data_entry& key_start, data_entry& key_end)
+      {
+        LdbKey ldbkey(key_start.get_data(), key_start.get_size(), bucket_number);
+        LdbKey ldbendkey(key_end.get_data(), key_end.get_size(), bucket_number);
+        // if key_end's skey is "",  add_prefix to key_end for all prefix.
+        if (key_end.get_size() - key_end.get_prefix_size() == TAIR_AREA_ENCODE_SIZE)
+        {
+          add_prefix(ldbendkey, key_end.get_prefix_size());
+        }
+
+        leveldb::Slice slice_key_start(ldbkey.data(), ldbkey.size());
+        leveldb::Slice slice_key_end(ldbendkey.data(), ldbendkey.size());
+        if (options_.comparator->Compare(slice_key_start, slice_key_end) >= 0)
+        {
+          return TAIR_RETURN_DATA_NOT_EXIST;
+        }
+
+        int rc = TAIR_RETURN_SUCCESS;
+        leveldb::Status status = db_->DeleteRange(write_options_, slice_key_start, slice_key_end);
+        if (!status.ok())
+        {
+          log_error("delete range fail. %s", status.ToString().c_str());
+          rc = TAIR_RETURN_FAILED;
+        }
+        else
+        {
+          // items in range are gone, cached ones can not be found without scanning,
+          // so expire the whole area in cache. bump epoch first, then concurrent reader
+          // won't fill item read before deletion.
+          atomic_inc(&cache_fill_epoch_);
+          if (cache_ != NULL)
+          {
+            cache_->raw_invalidate_area(LdbKey::decode_area(ldbkey.key()));
+          }
+          version_index_.clear();
+        }
+        return rc;
+      }
+
       int LdbInstance::del_range(int bucket_number, data_entry& key_start, data_entry& key_end, int offset, int limit, int type, std::vector<data_entry*> &result, bool &has_next)
       {
         if (db_ == NULL)
         {
           return TAIR_RETURN_SERVER_CAN_NOT_WORK;
         }
+        if (type == CMD_DEL_RANGE_ALL)
+        {
+          // deleted items are not returned, offset and limit are ignored
+          has_next = false;
+          return del_range_at_once(bucket_number, key_start, key_end);
+        }
         if (type != CMD_DEL_RANGE && type != CMD_DEL_RANGE_REVERSE)
         {
           log_error("unknown cmd type:%d", type);
@@ -805,6 +990,7 @@ namespace tair
         }
 
         bool reverse = (type == CMD_DEL_RANGE_REVERSE);
+
         bool synced = false;
         bool end_break = false;
         leveldb::Iterator *iter;
@@ -887,7 +1073,9 @@ namespace tair
           batch.Delete(leveldb::Slice(ldb_key.data(), ldb_key.size()), synced);
           batch_count++;
           batch_size += ldb_key.size();
-          
+          // blind write must not trust meta of deleted item
+          version_index_.remove(ldb_key.key(), ldb_key.key_size());
+
           if (total_size > range_max_size)
             break;
           reverse ? iter->Prev() : iter->Next();
@@ -944,20 +1132,33 @@ namespace tair
         return rc;
       }
 
-      int LdbInstance::get(int bucket_number, tair::common::data_entry& key, tair::common::data_entry& value)
+      static void release_pinned_value(void* arg)
+      {
+        delete reinterpret_cast<leveldb::PinnableSlice*>(arg);
+      }
+
+      int LdbInstance::get(int bucket_number, tair::common::data_entry& key, tair::common::data_entry& value, bool pin,
+                           int read_mode)
       {
         if (db_ == NULL)
         {
           return TAIR_RETURN_SERVER_CAN_NOT_WORK;
         }
+        // resumed read is counted by the nonblocking one
+        const bool update_stat = read_mode != TAIR_READ_RESUMED;
+        if (update_stat)
+        {
+          stat_read(bucket_number);
+        }
 
         LdbKey ldb_key(key.get_data(), key.get_size(), bucket_number);
         LdbItem ldb_item;
         std::string db_value;
+        leveldb::PinnableSlice* pinned = NULL;
 
         // first get from cache, no need lock here
         PROFILER_BEGIN("direct cache get");
-        int rc = do_cache_get(ldb_key, db_value, true/* update stat */);
+        int rc = do_cache_get(ldb_key, db_value, update_stat);
         PROFILER_END();
         // cache miss, but not expired, cause cache expired, db expired too.
         if (rc != TAIR_RETURN_SUCCESS)
@@ -966,15 +1167,36 @@ namespace tair
           tbsys::CThreadGuard mutex_guard(get_mutex(key));
           PROFILER_END();
           PROFILER_BEGIN("db get");
-          rc = do_get(ldb_key, db_value, false/* not get from cache */, true/* fill cache */);
+          if (pin)
+          {
+            pinned = new leveldb::PinnableSlice();
+          }
+          rc = do_get(ldb_key, db_value, false/* not get from cache */, true/* fill cache */, update_stat, pinned,
+                      TAIR_READ_NONBLOCKING == read_mode);
           PROFILER_END();
         }
 
         if (rc == TAIR_RETURN_SUCCESS)
         {
-          ldb_item.assign(const_cast<char*>(db_value.data()), db_value.size());
+          if (pinned != NULL)
+          {
+            ldb_item.assign(const_cast<char*>(pinned->data()), pinned->size());
+          }
+          else
+          {
+            ldb_item.assign(const_cast<char*>(db_value.data()), db_value.size());
+          }
           // already check expired. no need here.
-          value.set_data(ldb_item.value(), ldb_item.value_size());
+          if (pinned != NULL && pinned->IsPinned())
+          {
+            // value is referenced until data of value is freed (eg. response is sent)
+            value.set_pinned_data(ldb_item.value(), ldb_item.value_size(), release_pinned_value, pinned);
+            pinned = NULL;
+          }
+          else
+          {
+            value.set_data(ldb_item.value(), ldb_item.value_size());
+          }
 
           // update meta info
           key.data_meta.flag = value.data_meta.flag = ldb_item.flag();
@@ -990,16 +1212,195 @@ namespace tair
 
         log_debug("ldb::get rc: %d, key len: %d, key prefix len:%d , value len: %d, meta_version:%u ", rc, key.get_size(), key.get_prefix_size(), value.get_size(), ldb_item.meta().base_.meta_version_);
 
+        if (pinned != NULL)
+        {
+          delete pinned;
+        }
         return rc;
       }
 
 
+      // order of ldb keys, by index
+      struct LdbKeyIndexLess
+      {
+        LdbKeyIndexLess(const leveldb::Comparator* cmp, std::vector<LdbKey*>& keys) : cmp_(cmp), keys_(keys) {}
+        bool operator()(size_t a, size_t b) const
+        {
+          return cmp_->Compare(leveldb::Slice(keys_[a]->data(), keys_[a]->size()),
+                               leveldb::Slice(keys_[b]->data(), keys_[b]->size())) < 0;
+        }
+        const leveldb::Comparator* cmp_;
+        std::vector<LdbKey*>& keys_;
+      };
+
+      int LdbInstance::prefix_gets(int bucket_number, std::vector<data_entry*>& keys,
+                                   std::vector<data_entry*>& values, std::vector<int>& rcs)
+      {
+        if (db_ == NULL)
+        {
+          return TAIR_RETURN_SERVER_CAN_NOT_WORK;
+        }
+        // walk iterator when average data size between adjacent keys is no more than this
+        static int merge_gap = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_PREFIX_GETS_MERGE_GAP, 16<<10); // 16K
+        // seeking fewer keys costs less than estimating density
+        static const size_t MIN_MERGE_KEY_COUNT = 4;
+        // seek when target is still not reached after so many steps
+        static const int MAX_MERGE_STEPS = 16;
+
+        size_t n = keys.size();
+        std::vector<LdbKey*> ldb_keys(n);
+        std::vector<std::string> db_values(n);
+        std::vector<size_t> db_keys;
+        rcs.assign(n, TAIR_RETURN_DATA_NOT_EXIST);
+
+        for (size_t i = 0; i < n; ++i)
+        {
+          stat_read(bucket_number);
+          ldb_keys[i] = new LdbKey(keys[i]->get_data(), keys[i]->get_size(), bucket_number);
+          if (do_cache_get(*ldb_keys[i], db_values[i], true/* update stat */) == TAIR_RETURN_SUCCESS)
+          {
+            rcs[i] = TAIR_RETURN_SUCCESS;
+          }
+          else if (!negative_cache_.hit(ldb_keys[i]->key(), ldb_keys[i]->key_size()))
+          {
+            db_keys.push_back(i);
+          }
+        }
+
+        bool merge = false;
+        if (!db_keys.empty())
+        {
+          // values read from snapshot are not filled into cache, they may be overwritten meanwhile
+          uint32_t negative_epoch = negative_cache_.epoch();
+          leveldb::ReadOptions snapshot_read_options = read_options_;
+          snapshot_read_options.snapshot = db_->GetSnapshot();
+          std::sort(db_keys.begin(), db_keys.end(), LdbKeyIndexLess(options_.comparator, ldb_keys));
+
+          if (merge_gap > 0 && db_keys.size() >= MIN_MERGE_KEY_COUNT)
+          {
+            LdbKey* first = ldb_keys[db_keys.front()];
+            LdbKey* last = ldb_keys[db_keys.back()];
+            leveldb::Range range(leveldb::Slice(first->data(), first->size()), leveldb::Slice(last->data(), last->size()));
+            uint64_t range_size = 0;
+            db_->GetApproximateSizes(&range, 1, &range_size);
+            merge = range_size / (db_keys.size() - 1) <= static_cast<uint64_t>(merge_gap);
+          }
+
+          if (merge)
+          {
+            leveldb::Iterator* iter = db_->NewIterator(snapshot_read_options);
+            for (size_t i = 0; i < db_keys.size(); ++i)
+            {
+              size_t index = db_keys[i];
+              leveldb::Slice target(ldb_keys[index]->data(), ldb_keys[index]->size());
+              int steps = 0;
+              if (i == 0)
+              {
+                iter->Seek(target);
+              }
+              while (iter->Valid() && options_.comparator->Compare(iter->key(), target) < 0)
+              {
+                if (++steps > MAX_MERGE_STEPS)
+                {
+                  iter->Seek(target);
+                  break;
+                }
+                iter->Next();
+              }
+              if (!iter->status().ok())
+              {
+                log_error("prefix gets iterate fail: %s", iter->status().ToString().c_str());
+                for (; i < db_keys.size(); ++i)
+                {
+                  rcs[db_keys[i]] = TAIR_RETURN_FAILED;
+                }
+                break;
+              }
+              if (iter->Valid() && options_.comparator->Compare(iter->key(), target) == 0)
+              {
+                db_values[index].assign(iter->value().data(), iter->value().size());
+                rcs[index] = TAIR_RETURN_SUCCESS;
+              }
+            }
+            delete iter;
+          }
+          else
+          {
+            for (size_t i = 0; i < db_keys.size(); ++i)
+            {
+              size_t index = db_keys[i];
+              leveldb::Status status = db_->Get(snapshot_read_options,
+                                                leveldb::Slice(ldb_keys[index]->data(), ldb_keys[index]->size()),
+                                                &db_values[index]);
+              rcs[index] = status.ok() ? TAIR_RETURN_SUCCESS :
+                (status.IsNotFound() ? TAIR_RETURN_DATA_NOT_EXIST : TAIR_RETURN_FAILED);
+            }
+          }
+          db_->ReleaseSnapshot(snapshot_read_options.snapshot);
+
+          // only confirmed unexist key goes into negative cache
+          for (size_t i = 0; i < db_keys.size(); ++i)
+          {
+            size_t index = db_keys[i];
+            if (TAIR_RETURN_DATA_NOT_EXIST == rcs[index])
+            {
+              negative_cache_.add(ldb_keys[index]->key(), ldb_keys[index]->key_size(), negative_epoch);
+            }
+          }
+        }
+
+        LdbItem ldb_item;
+        for (size_t i = 0; i < n; ++i)
+        {
+          if (TAIR_RETURN_SUCCESS == rcs[i])
+          {
+            data_entry& key = *keys[i];
+            data_entry& value = *values[i];
+            ldb_item.assign(const_cast<char*>(db_values[i].data()), db_values[i].size());
+            value.set_data(ldb_item.value(), ldb_item.value_size());
+            // update meta info
+            key.data_meta.flag = value.data_meta.flag = ldb_item.flag();
+            key.data_meta.cdate = value.data_meta.cdate = ldb_item.cdate();
+            key.data_meta.edate = value.data_meta.edate = ldb_item.edate();
+            key.data_meta.mdate = value.data_meta.mdate = ldb_item.mdate();
+            key.data_meta.version = value.data_meta.version = ldb_item.version();
+            key.data_meta.keysize = value.data_meta.keysize = key.get_size();
+            key.data_meta.valsize = value.data_meta.valsize = ldb_item.value_size();
+            key.data_meta.prefixsize = value.data_meta.prefixsize = ldb_item.prefix_size();
+            key.set_prefix_size(ldb_item.prefix_size());
+          }
+          delete ldb_keys[i];
+        }
+
+        log_debug("ldb::prefix_gets keys: %lu, read db: %lu, merge: %d", n, db_keys.size(), merge);
+        return TAIR_RETURN_SUCCESS;
+      }
+
+      int LdbInstance::warm_up(int bucket_number, tair::common::data_entry& key)
+      {
+        if (db_ == NULL || cache_ == NULL)
+        {
+          return TAIR_RETURN_SERVER_CAN_NOT_WORK;
+        }
+
+        LdbKey ldb_key(key.get_data(), key.get_size(), bucket_number);
+        std::string db_value;
+        int rc = do_cache_get(ldb_key, db_value, false/* not update stat */);
+        if (rc != TAIR_RETURN_SUCCESS)
+        {
+          tbsys::CThreadGuard mutex_guard(get_mutex(key));
+          rc = do_get(ldb_key, db_value, false/* not get from cache */, true/* fill cache */, false/* not update stat */);
+        }
+        return rc;
+      }
+
       int LdbInstance::remove(int bucket_number, tair::common::data_entry& key, bool version_care)
       {
         if (db_ == NULL)
         {
           return TAIR_RETURN_SERVER_CAN_NOT_WORK;
         }
+        stat_write(bucket_number, 1);
 
         int rc = TAIR_RETURN_SUCCESS;
 
@@ -1044,6 +1445,7 @@ namespace tair
           {
             rc = do_remove(ldb_key, synced);
           }
+          version_index_.remove(ldb_key.key(), ldb_key.key_size());
 
           if (TAIR_RETURN_SUCCESS == rc)
           {
@@ -1091,6 +1493,17 @@ namespace tair
             log_error("rename db %s to back db %s fail. error: %s", db_path_, back_db_path.c_str(), strerror(errno));
             ret = TAIR_RETURN_FAILED;
           }
+          // tables under extra data dirs go with db
+          for (size_t i = 1; TAIR_RETURN_SUCCESS == ret && i < options_.db_paths.size(); ++i)
+          {
+            const char* path = options_.db_paths[i].path.c_str();
+            std::string back_path = get_back_path(path);
+            if (::access(path, F_OK) == 0 && ::rename(path, back_path.c_str()) != 0)
+            {
+              log_error("rename db path %s to back path %s fail. error: %s", path, back_path.c_str(), strerror(errno));
+              ret = TAIR_RETURN_FAILED;
+            }
+          }
 
           db_->ResetDbName(back_db_path);
           break;
@@ -1123,6 +1536,11 @@ namespace tair
           ret = set_config(params);
           break;
         }
+        case TAIR_SERVER_CMD_CHECKPOINT_DB:
+        {
+          ret = checkpoint(params);
+          break;
+        }
         default:
         {
           break;
@@ -1141,12 +1559,10 @@ namespace tair
           scan_it_ = NULL;
         }
 
-        char scan_key[LDB_KEY_META_SIZE];
+        char scan_key[LDB_KEY_META_MAX_SIZE];
         LdbKey::build_key_meta(scan_key, bucket_number);
 
-        leveldb::ReadOptions scan_read_options = read_options_;
-        scan_read_options.fill_cache = false; // not fill cache
-        scan_it_ = db_->NewIterator(scan_read_options);
+        scan_it_ = db_->NewIterator(scan_read_options_);
         if (NULL == scan_it_)
         {
           log_error("get ldb scan iterator fail");
@@ -1154,7 +1570,7 @@ namespace tair
         }
         else
         {
-          scan_it_->Seek(leveldb::Slice(scan_key, sizeof(scan_key)));
+          scan_it_->Seek(leveldb::Slice(scan_key, LdbKey::meta_size()));
         }
 
         if (ret)
@@ -1198,7 +1614,7 @@ namespace tair
           while (batch_size < migrate_batch_size && batch_count < migrate_batch_count && scan_it_->Valid())
           {
             // match bucket
-            if (LdbKey::decode_bucket_number(scan_it_->key().data() + LDB_EXPIRED_TIME_SIZE) == scan_bucket_)
+            if (LdbKey::decode_bucket_number_with_key(scan_it_->key().data()) == scan_bucket_)
             {
               ldb_key.assign(const_cast<char*>(scan_it_->key().data()), scan_it_->key().size());
               ldb_item.assign(const_cast<char*>(scan_it_->value().data()), scan_it_->value().size());
@@ -1237,6 +1653,8 @@ namespace tair
             }
           }
           log_debug("migrate count: %lu, size: %d", list.size(), batch_size);
+          // throttle next batch
+          options_.env->GetRateLimiter(leveldb::kIOScan)->Request(batch_size);
           if (list.empty())
           {
             still_have_ = false;
@@ -1246,6 +1664,214 @@ namespace tair
         return still_have_;
       }
 
+      int LdbInstance::export_bucket(int bucket_number, std::vector<std::string>& files)
+      {
+        if (db_ == NULL)
+        {
+          return TAIR_RETURN_SERVER_CAN_NOT_WORK;
+        }
+        if (!migrate_by_file_)
+        {
+          return TAIR_RETURN_NOT_SUPPORTED;
+        }
+
+        std::string dir = migrate_dir(bucket_number, true);
+        // files left by last failed migrate
+        remove_migrate_dir(dir);
+
+        std::string start_key, end_key;
+        LdbKey::build_scan_key(bucket_number, start_key, end_key);
+
+        leveldb::ReadOptions export_read_options = scan_read_options_;
+        export_read_options.snapshot = db_->GetSnapshot();
+        leveldb::Status status = db_->ExportTables(export_read_options, start_key, end_key, dir, &files);
+        db_->ReleaseSnapshot(export_read_options.snapshot);
+
+        if (!status.ok())
+        {
+          log_error("export bucket %d to %s fail: %s", bucket_number, dir.c_str(), status.ToString().c_str());
+          remove_migrate_dir(dir);
+          files.clear();
+          return TAIR_RETURN_FAILED;
+        }
+        char format_file[TAIR_MAX_PATH_LEN];
+        snprintf(format_file, sizeof(format_file), "%s/%s%d", dir.c_str(), MIGRATE_KEY_FORMAT_PREFIX, LdbKey::format());
+        status = leveldb::WriteStringToFile(options_.env, leveldb::Slice(), format_file);
+        if (!status.ok())
+        {
+          log_error("write %s fail: %s", format_file, status.ToString().c_str());
+          remove_migrate_dir(dir);
+          files.clear();
+          return TAIR_RETURN_FAILED;
+        }
+        files.push_back(format_file);
+        log_warn("export bucket %d to %s, file count: %lu", bucket_number, dir.c_str(), files.size());
+        return TAIR_RETURN_SUCCESS;
+      }
+
+      void LdbInstance::end_export_bucket(int bucket_number)
+      {
+        remove_migrate_dir(migrate_dir(bucket_number, true));
+      }
+
+      int LdbInstance::import_bucket_file(int bucket_number, const char* name, int64_t offset, const char* data, int32_t size)
+      {
+        if (db_ == NULL)
+        {
+          return TAIR_RETURN_SERVER_CAN_NOT_WORK;
+        }
+        // only file name, no way to write to other directory
+        if (name == NULL || name[0] == '\0' || strchr(name, '/') != NULL || offset < 0)
+        {
+          log_error("invalid migrate file of bucket %d: %s, offset: %"PRI64_PREFIX"d", bucket_number, name != NULL ? name : "", offset);
+          return TAIR_RETURN_FAILED;
+        }
+
+        std::string dir = migrate_dir(bucket_number, false);
+        options_.env->CreateDir(std::string(db_path_) + MIGRATE_DIR_SUFFIX);
+        options_.env->CreateDir(dir);
+        std::string file_name = dir + "/" + name;
+
+        int ret = TAIR_RETURN_SUCCESS;
+        // first piece starts a new file, drop what last failed migrate left
+        int fd = ::open(file_name.c_str(), O_WRONLY | O_CREAT | (offset == 0 ? O_TRUNC : 0), 0644);
+        struct stat st;
+        if (fd < 0)
+        {
+          log_error("open migrate file %s fail: %s", file_name.c_str(), strerror(errno));
+          ret = TAIR_RETURN_FAILED;
+        }
+        else if (::fstat(fd, &st) != 0 || st.st_size != offset)
+        {
+          // some piece is lost
+          log_error("migrate file %s size mismatch, expect offset: %"PRI64_PREFIX"d", file_name.c_str(), offset);
+          ret = TAIR_RETURN_FAILED;
+        }
+        else
+        {
+          int32_t written = 0;
+          while (written < size)
+          {
+            ssize_t n = ::pwrite(fd, data + written, size - written, offset + written);
+            if (n < 0 && errno == EINTR)
+            {
+              continue;
+            }
+            if (n <= 0)
+            {
+              log_error("write migrate file %s fail: %s", file_name.c_str(), strerror(errno));
+              ret = TAIR_RETURN_FAILED;
+              break;
+            }
+            written += n;
+          }
+        }
+        if (fd >= 0)
+        {
+          ::close(fd);
+        }
+        return ret;
+      }
+
+      // statistics of ingested items
+      static void ingest_stat_visitor(void* arg, const leveldb::Slice& key, const leveldb::Slice& value)
+      {
+        __gnu_cxx::hash_map<int32_t, UpdateStat>& stats = *reinterpret_cast<__gnu_cxx::hash_map<int32_t, UpdateStat>*>(arg);
+        if (key.size() < static_cast<size_t>(LdbKey::meta_size() + LDB_KEY_AREA_SIZE))
+        {
+          return;
+        }
+        LdbItem ldb_item;
+        ldb_item.assign(const_cast<char*>(value.data()), value.size());
+        UpdateStat& ustat = stats[LdbKey::decode_area_with_key(key.data())];
+        ++ustat.item_count_;
+        ustat.data_size_ += key.size() - LdbKey::meta_size() + ldb_item.value_size();
+        ustat.use_size_ += key.size() + value.size();
+      }
+
+      int LdbInstance::ingest_bucket(int bucket_number, bool abort)
+      {
+        if (db_ == NULL)
+        {
+          return TAIR_RETURN_SERVER_CAN_NOT_WORK;
+        }
+
+        int ret = TAIR_RETURN_SUCCESS;
+        std::string dir = migrate_dir(bucket_number, false);
+        if (!abort)
+        {
+          std::vector<std::string> children;
+          std::vector<std::string> files;
+          options_.env->GetChildren(dir, &children);
+          // exported file number keeps key order
+          std::sort(children.begin(), children.end());
+          int32_t key_format = LDB_KEY_FORMAT_V1;
+          const size_t prefix_len = strlen(MIGRATE_KEY_FORMAT_PREFIX);
+          for (size_t i = 0; i < children.size(); ++i)
+          {
+            if (children[i].compare(0, prefix_len, MIGRATE_KEY_FORMAT_PREFIX) == 0)
+            {
+              key_format = atoi(children[i].c_str() + prefix_len);
+            }
+            else if (children[i] != "." && children[i] != "..")
+            {
+              files.push_back(dir + "/" + children[i]);
+            }
+          }
+
+          __gnu_cxx::hash_map<int32_t, UpdateStat> stats;
+          leveldb::Status status;
+          if (key_format != LdbKey::format())
+          {
+            // source migrates in item way then, which encodes keys in our format
+            status = leveldb::Status::NotSupported("key format mismatch");
+          }
+          else
+          {
+            status = db_->IngestTables(files, ingest_stat_visitor, &stats);
+          }
+          if (!status.ok())
+          {
+            log_error("ingest bucket %d from %s fail: %s", bucket_number, dir.c_str(), status.ToString().c_str());
+            ret = TAIR_RETURN_FAILED;
+          }
+          else
+          {
+            // items ingested are not known by caches
+            negative_cache_.invalidate_all();
+            version_index_.clear();
+            for (__gnu_cxx::hash_map<int32_t, UpdateStat>::iterator it = stats.begin(); it != stats.end(); ++it)
+            {
+              stat_add(bucket_number, it->first, it->second.data_size_, it->second.use_size_, it->second.item_count_);
+            }
+            log_warn("ingest bucket %d from %s, file count: %lu", bucket_number, dir.c_str(), files.size());
+          }
+        }
+        remove_migrate_dir(dir);
+        return ret;
+      }
+
+      std::string LdbInstance::migrate_dir(int bucket_number, bool out)
+      {
+        char dir[TAIR_MAX_PATH_LEN];
+        snprintf(dir, sizeof(dir), "%s%s/%s_%d", db_path_, MIGRATE_DIR_SUFFIX, out ? "out" : "in", bucket_number);
+        return dir;
+      }
+
+      void LdbInstance::remove_migrate_dir(const std::string& dir)
+      {
+        std::vector<std::string> children;
+        options_.env->GetChildren(dir, &children);
+        for (size_t i = 0; i < children.size(); ++i)
+        {
+          if (children[i] != "." && children[i] != "..")
+          {
+            options_.env->DeleteFile(dir + "/" + children[i]);
+          }
+        }
+        options_.env->DeleteDir(dir);
+      }
+
       void LdbInstance::get_stats(tair_stat* stat)
       {
         if (NULL != db_)        // not init now, no stat
@@ -1264,6 +1890,42 @@ namespace tair
             }
           }
 
+          if (negative_cache_.enable())
+          {
+            int32_t lookup_count = negative_cache_.lookup_count();
+            int32_t hit_count = negative_cache_.hit_count();
+            negative_cache_.reset_stat();
+            log_info("ldb %d negative cache lookup: %d, hit: %d, hit rate: %.2f%%",
+                     index_, lookup_count, hit_count,
+                     lookup_count > 0 ? hit_count * 100.0 / lookup_count : 0.0);
+          }
+
+          if (version_index_.enable())
+          {
+            int32_t put_count = atomic_read(&blind_write_stat_.put_count_);
+            int32_t index_hit_count = atomic_read(&blind_write_stat_.index_hit_count_);
+            int32_t proved_new_count = atomic_read(&blind_write_stat_.proved_new_count_);
+            int32_t read_count = atomic_read(&blind_write_stat_.read_count_);
+            uint32_t interval = time(NULL) - blind_write_stat_.last_reset_time_;
+            blind_write_stat_.reset();
+            log_info("ldb %d blind write put: %d (%.2f/s), version index hit: %d, proved new: %d, read before write: %d",
+                     index_, put_count, interval > 0 ? static_cast<double>(put_count) / interval : 0.0,
+                     index_hit_count, proved_new_count, read_count);
+          }
+
+          for (int type = 0; type < leveldb::kNumIOTypes; ++type)
+          {
+            leveldb::RateLimiter* limiter = options_.env->GetRateLimiter(static_cast<leveldb::IOType>(type));
+            if (limiter->GetBytesPerSecond() > 0)
+            {
+              log_info("ldb %d %s rate limit: %"PRI64_PREFIX"d, current: %"PRI64_PREFIX"d, "
+                       "request: %"PRI64_PREFIX"u, throttled: %"PRI64_PREFIX"u bytes %"PRI64_PREFIX"u us",
+                       index_, IO_TYPE_NAME[type], limiter->GetBytesPerSecond(), limiter->GetCurrentBytesPerSecond(),
+                       limiter->RequestBytes(), limiter->ThrottledBytes(), limiter->ThrottledMicros());
+              limiter->ResetStat();
+            }
+          }
+
           if (stat != NULL)
           {
             // get all stat information
@@ -1290,6 +1952,31 @@ namespace tair
         if (get_db_stat(db_, stat_value, "ranges"))
         {
           fprintf(stderr, "==== statdb instance %d ====\n%s", index_, stat_value.c_str());
+          // compaction, write stall and cache statistics
+          if (get_db_stat(db_, stat_value, "stats"))
+          {
+            fprintf(stderr, "%s", stat_value.c_str());
+          }
+          if (negative_cache_.enable())
+          {
+            fprintf(stderr, "negative cache slots: %"PRI64_PREFIX"d, lookup: %d, hit: %d\n",
+                    negative_cache_.slot_count(), negative_cache_.lookup_count(), negative_cache_.hit_count());
+          }
+          if (version_index_.enable())
+          {
+            fprintf(stderr, "version index slots: %"PRI64_PREFIX"d, put: %d, index hit: %d, proved new: %d, read: %d\n",
+                    version_index_.slot_count(), atomic_read(&blind_write_stat_.put_count_),
+                    atomic_read(&blind_write_stat_.index_hit_count_), atomic_read(&blind_write_stat_.proved_new_count_),
+                    atomic_read(&blind_write_stat_.read_count_));
+          }
+          for (int type = 0; type < leveldb::kNumIOTypes; ++type)
+          {
+            leveldb::RateLimiter* limiter = options_.env->GetRateLimiter(static_cast<leveldb::IOType>(type));
+            fprintf(stderr, "%s rate limit: %"PRI64_PREFIX"d, current: %"PRI64_PREFIX"d, "
+                    "request: %"PRI64_PREFIX"u, throttled: %"PRI64_PREFIX"u bytes %"PRI64_PREFIX"u us\n",
+                    IO_TYPE_NAME[type], limiter->GetBytesPerSecond(), limiter->GetCurrentBytesPerSecond(),
+                    limiter->RequestBytes(), limiter->ThrottledBytes(), limiter->ThrottledMicros());
+          }
         }
         else
         {
@@ -1334,6 +2021,42 @@ namespace tair
         return s.ok() ? TAIR_RETURN_SUCCESS : TAIR_RETURN_FAILED;
       }
 
+      // checkpoint of db "<data_dir><index>/ldb" goes to "<dir>/<basename(data_dir)><index>/ldb",
+      // so checkpoint dir can be used as data dir prefix of another server.
+      int LdbInstance::checkpoint(const std::vector<std::string>& params)
+      {
+        if (params.empty() || params[0].empty())
+        {
+          log_error("checkpoint db but no dir");
+          return TAIR_RETURN_FAILED;
+        }
+
+        std::string db_path(db_path_);
+        std::string::size_type pos = db_path.rfind('/');
+        if (pos != std::string::npos && pos > 0)
+        {
+          pos = db_path.rfind('/', pos - 1);
+        }
+        std::string path = params[0] + "/" + (pos != std::string::npos ? db_path.substr(pos + 1) : db_path);
+        if (!tbsys::CFileUtil::mkdirs(const_cast<char*>(path.c_str())))
+        {
+          log_error("mkdir checkpoint dir fail: %s", path.c_str());
+          return TAIR_RETURN_FAILED;
+        }
+
+        int64_t start_us = tbsys::CTimeUtil::getTime();
+        uint64_t sequence = 0;
+        leveldb::Status s = db_->Checkpoint(path, &sequence);
+        if (!s.ok())
+        {
+          log_error("checkpoint db %s to %s fail: %s", db_path_, path.c_str(), s.ToString().c_str());
+          return TAIR_RETURN_FAILED;
+        }
+        log_warn("checkpoint db %s to %s, sequence: %"PRI64_PREFIX"u, cost: %"PRI64_PREFIX"d us",
+                 db_path_, path.c_str(), sequence, tbsys::CTimeUtil::getTime() - start_us);
+        return TAIR_RETURN_SUCCESS;
+      }
+
       int LdbInstance::set_config(std::vector<std::string>& params)
       {
         int ret = TAIR_RETURN_SUCCESS;
@@ -1402,6 +2125,47 @@ namespace tair
           {
             leveldb::config::kDoSplitMmtCompaction = (atoi(config_value.c_str()) > 0);
           }
+          else if (config_key == LDB_FLUSH_RATE_LIMIT)
+          {
+            set_rate_limit(leveldb::kIOFlush, atoll(config_value.c_str()));
+          }
+          else if (config_key == LDB_COMPACTION_RATE_LIMIT)
+          {
+            set_rate_limit(leveldb::kIOCompaction, atoll(config_value.c_str()));
+          }
+          else if (config_key == LDB_SCAN_RATE_LIMIT)
+          {
+            set_rate_limit(leveldb::kIOScan, atoll(config_value.c_str()));
+          }
+          else if (config_key == LDB_MIGRATE_BY_FILE)
+          {
+            migrate_by_file_ = (atoi(config_value.c_str()) > 0);
+          }
+          else if (config_key == LDB_RATE_LIMIT_TARGET_READ_LATENCY || config_key == LDB_RATE_LIMIT_MIN_PERCENT)
+          {
+            int64_t value = atoll(config_value.c_str());
+            if (value < 0 || (config_key == LDB_RATE_LIMIT_MIN_PERCENT && value > 100))
+            {
+              log_error("invalid value %s to set %s, ignore it.", config_value.c_str(), config_key.c_str());
+              ret = TAIR_RETURN_FAILED;
+            }
+            else
+            {
+              if (config_key == LDB_RATE_LIMIT_TARGET_READ_LATENCY)
+              {
+                rate_limit_target_latency_ = value;
+              }
+              else
+              {
+                rate_limit_min_percent_ = value;
+              }
+              // re-tune with current rate
+              set_rate_limit(leveldb::kIOCompaction,
+                             options_.env->GetRateLimiter(leveldb::kIOCompaction)->GetBytesPerSecond());
+              set_rate_limit(leveldb::kIOScan,
+                             options_.env->GetRateLimiter(leveldb::kIOScan)->GetBytesPerSecond());
+            }
+          }
           // ignore unknown config
         }
         return ret;
@@ -1418,6 +2182,8 @@ namespace tair
             it->second->stat_reset(area); // clear stat value for this area.
           }
           ret = gc_.add(area, GC_AREA);
+          // items of this area are gone
+          version_index_.clear();
         }
         return ret;
       }
@@ -1435,6 +2201,7 @@ namespace tair
         leveldb::Status status = db_->Put(write_options_, leveldb::Slice(ldb_key.data(), ldb_key.size()),
                                           leveldb::Slice(ldb_item.data(), ldb_item.size()), synced);
         PROFILER_END();
+        negative_cache_.invalidate(ldb_key.key(), ldb_key.key_size());
         if (!status.ok())
         {
           log_error("update ldb item fail. %s", status.ToString().c_str());
@@ -1491,25 +2258,49 @@ namespace tair
         return rc;
       }
 
-      int LdbInstance::do_get(LdbKey& ldb_key, std::string& value, bool from_cache, bool fill_cache, bool update_stat)
+      int LdbInstance::do_get(LdbKey& ldb_key, std::string& value, bool from_cache, bool fill_cache, bool update_stat,
+                              leveldb::PinnableSlice* pinned, bool cache_only)
       {
         int rc = from_cache ? do_cache_get(ldb_key, value, update_stat) : TAIR_RETURN_FAILED;
 
         // cache miss, but not expired, cause cache expired, db expired too.
-        if (rc != TAIR_RETURN_SUCCESS)
+        if (rc != TAIR_RETURN_SUCCESS && negative_cache_.hit(ldb_key.key(), ldb_key.key_size()))
         {
+          log_debug("ldb negative cache hit");
+          rc = TAIR_RETURN_DATA_NOT_EXIST;
+        }
+        else if (rc != TAIR_RETURN_SUCCESS)
+        {
+          // get epoch before reading db
+          uint32_t negative_epoch = negative_cache_.epoch();
+          uint32_t cache_fill_epoch = atomic_read(&cache_fill_epoch_);
           PROFILER_BEGIN("db db get");
-          leveldb::Status status = db_->Get(read_options_, leveldb::Slice(ldb_key.data(), ldb_key.size()),
-                                            &value);
+          leveldb::Slice db_key(ldb_key.data(), ldb_key.size());
+          leveldb::ReadOptions read_options = read_options_;
+          read_options.cache_only = cache_only;
+          leveldb::Status status = pinned != NULL ? db_->Get(read_options, db_key, pinned) :
+            db_->Get(read_options, db_key, &value);
           PROFILER_END();
-          if (status.ok())
+          if (status.IsIncomplete())
+          {
+            rc = TAIR_RETURN_WOULD_BLOCK;
+          }
+          else if (status.ok())
           {
             rc = TAIR_RETURN_SUCCESS;
-            if (fill_cache && cache_ != NULL)     // fill cache
+            if (fill_cache && cache_ != NULL &&     // fill cache
+                cache_fill_epoch == static_cast<uint32_t>(atomic_read(&cache_fill_epoch_)))
             {
               PROFILER_BEGIN("db cache put");
               LdbItem ldb_item;
-              ldb_item.assign(const_cast<char*>(value.data()), value.size());
+              if (pinned != NULL)
+              {
+                ldb_item.assign(const_cast<char*>(pinned->data()), pinned->size());
+              }
+              else
+              {
+                ldb_item.assign(const_cast<char*>(value.data()), value.size());
+              }
               int tmp_rc = cache_->raw_put(ldb_key.key(), ldb_key.key_size(), ldb_item.data(), ldb_item.size(),
                                            ldb_item.flag(), ldb_item.edate());
               PROFILER_END();
@@ -1517,18 +2308,77 @@ namespace tair
               {
                 log_debug("::get. put cache fail, rc: %d", tmp_rc);
               }
+              else if (cache_fill_epoch != static_cast<uint32_t>(atomic_read(&cache_fill_epoch_)))
+              {
+                // range deleted meanwhile, filled item may be stale
+                cache_->raw_remove(ldb_key.key(), ldb_key.key_size());
+              }
             }
           }
           else
           {
             log_debug("get ldb item not found");
             rc = status.IsNotFound() ? TAIR_RETURN_DATA_NOT_EXIST : TAIR_RETURN_FAILED;
+            // only confirmed unexist key goes into negative cache
+            if (TAIR_RETURN_DATA_NOT_EXIST == rc)
+            {
+              negative_cache_.add(ldb_key.key(), ldb_key.key_size(), negative_epoch);
+            }
           }
         }
 
         return rc;
       }
 
+      // get item's meta before overwriting it. when version index is enable(blind write mode),
+      // try to know item's meta or prove item not exist without reading db.
+      int LdbInstance::do_get_for_write(LdbKey& ldb_key, std::string& value, LdbItem& ldb_item,
+                                        int32_t& value_size, int32_t& item_size)
+      {
+        int rc = TAIR_RETURN_FAILED;
+        bool known = false;
+        if (version_index_.enable())
+        {
+          atomic_inc(&blind_write_stat_.put_count_);
+          LdbVersionMeta vmeta;
+          if (version_index_.get(ldb_key.key(), ldb_key.key_size(), vmeta))
+          {
+            ldb_item.meta().base_.version_ = vmeta.version_;
+            ldb_item.meta().base_.cdate_ = vmeta.cdate_;
+            ldb_item.meta().base_.mdate_ = vmeta.mdate_;
+            ldb_item.meta().base_.edate_ = vmeta.edate_;
+            value_size = vmeta.value_size_;
+            item_size = vmeta.item_size_;
+            rc = TAIR_RETURN_SUCCESS;
+            known = true;
+            atomic_inc(&blind_write_stat_.index_hit_count_);
+          }
+          else if (!db_->KeyMayExist(read_options_, leveldb::Slice(ldb_key.data(), ldb_key.size())))
+          {
+            rc = TAIR_RETURN_DATA_NOT_EXIST;
+            known = true;
+            atomic_inc(&blind_write_stat_.proved_new_count_);
+          }
+          else
+          {
+            atomic_inc(&blind_write_stat_.read_count_);
+          }
+        }
+
+        if (!known)
+        {
+          rc = do_get(ldb_key, value, true/* get from cache */,
+                      false/* not fill cache */, false/* not update cache stat */);
+          if (TAIR_RETURN_SUCCESS == rc)
+          {
+            ldb_item.assign(const_cast<char*>(value.data()), value.size());
+            value_size = ldb_item.value_size();
+            item_size = ldb_item.size();
+          }
+        }
+        return rc;
+      }
+
       int LdbInstance::do_remove(LdbKey& ldb_key, bool synced, tair::common::entry_tailer* tailer)
       {
         // first remvoe db, then cache
@@ -1585,6 +2435,41 @@ namespace tair
         }
       }
 
+      void LdbInstance::stat_read(int32_t bucket_number)
+      {
+        STAT_MANAGER_MAP* tmp_stat_manager = stat_manager_;
+        STAT_MANAGER_MAP_ITER stat_it = tmp_stat_manager->find(bucket_number);
+        if (stat_it != tmp_stat_manager->end())
+        {
+          stat_it->second->inc_read_count();
+        }
+      }
+
+      void LdbInstance::stat_write(int32_t bucket_number, int32_t count)
+      {
+        STAT_MANAGER_MAP* tmp_stat_manager = stat_manager_;
+        STAT_MANAGER_MAP_ITER stat_it = tmp_stat_manager->find(bucket_number);
+        if (stat_it != tmp_stat_manager->end())
+        {
+          stat_it->second->add_write_count(count);
+        }
+      }
+
+      bool LdbInstance::get_bucket_load(int32_t bucket_number, uint64_t& data_size,
+                                        uint32_t& read_count, uint32_t& write_count)
+      {
+        STAT_MANAGER_MAP* tmp_stat_manager = stat_manager_;
+        STAT_MANAGER_MAP_ITER stat_it = tmp_stat_manager->find(bucket_number);
+        if (stat_it == tmp_stat_manager->end())
+        {
+          return false;
+        }
+        data_size = stat_it->second->get_data_size();
+        read_count = stat_it->second->get_read_count();
+        write_count = stat_it->second->get_write_count();
+        return true;
+      }
+
       void LdbInstance::get_buckets(std::vector<int32_t>& buckets)
       {
         STAT_MANAGER_MAP* tmp_stat_manager = stat_manager_;
@@ -1606,14 +2491,66 @@ namespace tair
         return (TAIR_SERVERFLAG_CLIENT != key.server_flag && TAIR_SERVERFLAG_PROXY != key.server_flag);
       }
 
+      // data_dir holds hot levels, and older levels go to ldb_extra_data_dirs
+      // ("dir:target_size,..." from fast to slow) when data_dir reaches ldb_data_dir_target_size.
+      bool LdbInstance::init_db_paths()
+      {
+        bool ret = true;
+        options_.db_paths.clear();
+        std::vector<std::string> extra_dirs;
+        tair::util::string_util::split_str(TBSYS_CONFIG.getString(TAIRLDB_SECTION, LDB_EXTRA_DATA_DIRS, ""),
+                                           ", ", extra_dirs);
+        if (!extra_dirs.empty())
+        {
+          options_.db_paths.push_back(leveldb::DbPath(db_path_,
+                                                      atoll(TBSYS_CONFIG.getString(TAIRLDB_SECTION, LDB_DATA_DIR_TARGET_SIZE, "0"))));
+          for (size_t i = 0; ret && i < extra_dirs.size(); ++i)
+          {
+            // dir:target_size, target size of the last one is ignored
+            std::string::size_type pos = extra_dirs[i].rfind(':');
+            std::string dir = extra_dirs[i].substr(0, pos);
+            int64_t target_size = pos != std::string::npos ? atoll(extra_dirs[i].c_str() + pos + 1) : 0;
+            // one sub dir per instance like data_dir
+            char path[TAIR_MAX_PATH_LEN];
+            snprintf(path, sizeof(path), "%s%d/ldb", dir.c_str(), index_ + 1);
+            if (!(ret = tbsys::CFileUtil::mkdirs(path)))
+            {
+              log_error("mkdir fail: %s", path);
+            }
+            else
+            {
+              options_.db_paths.push_back(leveldb::DbPath(path, target_size));
+            }
+          }
+        }
+
+        for (size_t i = 0; ret && i < options_.db_paths.size(); ++i)
+        {
+          log_warn("ldb %d data path %lu: %s, target size: %"PRI64_PREFIX"u", index_, i,
+                   options_.db_paths[i].path.c_str(), options_.db_paths[i].target_size);
+        }
+        return ret;
+      }
+
       void LdbInstance::sanitize_option()
       {
         options_.error_if_exists = false; // exist is ok
         options_.create_if_missing = true; // create if not exist
         options_.comparator = LdbComparator(&gc_);// self-defined comparator
         // can use one static filterpolicy instance
-        options_.filter_policy = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_USE_BLOOMFILTER, 0) > 0 ?
-          new LdbBloomFilterPolicy(TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_BLOOMFILTER_BITS_PER_KEY, 10)) : NULL;
+        options_.filter_policy = NULL;
+        if (TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_USE_BLOOMFILTER, 0) > 0)
+        {
+          const char* filter_policy = TBSYS_CONFIG.getString(TAIRLDB_SECTION, LDB_FILTER_POLICY, "bloom");
+          const int bits_per_key = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_BLOOMFILTER_BITS_PER_KEY, 10);
+          const char* level_bits_per_key = TBSYS_CONFIG.getString(TAIRLDB_SECTION, LDB_BLOOMFILTER_LEVEL_BITS_PER_KEY, "");
+          options_.filter_policy = NewLdbFilterPolicy(filter_policy, bits_per_key, level_bits_per_key);
+          if (NULL == options_.filter_policy)
+          {
+            log_warn("no such filter policy: %s. use bloom by default", filter_policy);
+            options_.filter_policy = NewLdbFilterPolicy("bloom", bits_per_key, level_bits_per_key);
+          }
+        }
         options_.paranoid_checks = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_PARANOID_CHECK, 0) > 0;
         options_.max_open_files = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_MAX_OPEN_FILES, 655350);
         options_.max_mem_usage_for_memtable = atoll(TBSYS_CONFIG.getString(TAIRLDB_SECTION, LDB_MAX_MEM_USAGE_FOR_MEMTABLE, "1073741824"));
@@ -1621,11 +2558,28 @@ namespace tair
         options_.block_size = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_BLOCK_SIZE, 4<<10); // 4K
         options_.table_cache_size = atoll(TBSYS_CONFIG.getString(TAIRLDB_SECTION, LDB_TABLE_CACHE_SIZE, "5368709120")); // 5G
         options_.block_cache_size = atoll(TBSYS_CONFIG.getString(TAIRLDB_SECTION, LDB_BLOCK_CACHE_SIZE, "8388608")); // 8M
+        // db_ is not opened yet, nobody uses old block cache
+        if (options_.block_cache != NULL)
+        {
+          delete options_.block_cache;
+        }
+        options_.block_cache = shared_block_cache_ != NULL ?
+          leveldb::NewAccountedCache(shared_block_cache_) :
+          leveldb::NewLRUCache(options_.block_cache_size,
+                               TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_BLOCK_CACHE_SHARD_BITS, 4));
+        options_.write_buffer_manager = write_buffer_manager_;
         options_.block_restart_interval = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_BLOCK_RESTART_INTERVAL, 16); // 16
+        options_.data_block_hash_index = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_DATA_BLOCK_HASH_INDEX, 0) > 0;
+        options_.blob_value_size = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_BLOB_VALUE_SIZE, 0); // off
+        options_.blob_gc_ratio = atof(TBSYS_CONFIG.getString(TAIRLDB_SECTION, LDB_BLOB_GC_RATIO, "0.5"));
+        options_.persist_file_time_meta = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_PERSIST_FILE_TIME_META, 0) > 0;
         options_.compression = static_cast<leveldb::CompressionType>(TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_COMPRESSION, leveldb::kSnappyCompression));
         // need reserve binlog when doing remote sync
         options_.reserve_log = TBSYS_CONFIG.getInt(TAIRSERVER_SECTION, TAIR_DO_RSYNC, 0) > 0;
         options_.load_backup_version = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_LOAD_BACKUP_VERSION, 0) > 0;
+        options_.concurrent_memtable_write = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_CONCURRENT_MEMTABLE_WRITE, 0) > 0;
+        options_.recover_log_threads = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_RECOVER_LOG_THREADS, 1);
+        options_.preload_table_threads = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_PRELOAD_TABLE_THREADS, 0); // off
         options_.kL0_CompactionTrigger = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_L0_COMPACTION_TRIGGER, 4);
         options_.kL0_SlowdownWritesTrigger = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_L0_SLOWDOWN_WRITE_TRIGGER, 8);
         options_.kL0_StopWritesTrigger = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_L0_STOP_WRITE_TRIGGER, 12);
@@ -1650,12 +2604,45 @@ namespace tair
         // Env::Default() is a global static instance.
         // We allocate one env to one leveldb instance here.
         options_.env = leveldb::Env::Instance();
+        init_rate_limit();
         read_options_.verify_checksums = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_READ_VERIFY_CHECKSUMS, 0) != 0;
         read_options_.fill_cache = true;
+        scan_read_options_ = read_options_;
+        scan_read_options_.fill_cache = false;
+        scan_read_options_.readahead_size = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_SCAN_READAHEAD_SIZE, 1<<20); // 1M
+        scan_read_options_.prefetch_table = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_SCAN_PREFETCH_TABLE, 1) != 0;
         write_options_.sync = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_WRITE_SYNC, 0) != 0;
+        options_.pipelined_log_sync = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_PIPELINED_LOG_SYNC, 0) != 0;
+        options_.log_sync_delay_us = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_LOG_SYNC_DELAY_US, 0);
         // remainning avaliable config: comparator, env, block cache.
       }
 
+      void LdbInstance::init_rate_limit()
+      {
+        rate_limit_target_latency_ =
+          atoll(TBSYS_CONFIG.getString(TAIRLDB_SECTION, LDB_RATE_LIMIT_TARGET_READ_LATENCY, "0"));
+        rate_limit_min_percent_ = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_RATE_LIMIT_MIN_PERCENT, 10);
+        set_rate_limit(leveldb::kIOFlush, atoll(TBSYS_CONFIG.getString(TAIRLDB_SECTION, LDB_FLUSH_RATE_LIMIT, "0")));
+        set_rate_limit(leveldb::kIOCompaction,
+                       atoll(TBSYS_CONFIG.getString(TAIRLDB_SECTION, LDB_COMPACTION_RATE_LIMIT, "0")));
+        set_rate_limit(leveldb::kIOScan, atoll(TBSYS_CONFIG.getString(TAIRLDB_SECTION, LDB_SCAN_RATE_LIMIT, "0")));
+      }
+
+      void LdbInstance::set_rate_limit(leveldb::IOType type, int64_t bytes_per_sec)
+      {
+        leveldb::RateLimiter* limiter = options_.env->GetRateLimiter(type);
+        limiter->SetBytesPerSecond(bytes_per_sec);
+        // flush is never tuned, write will be stalled by slow flush.
+        if (type != leveldb::kIOFlush)
+        {
+          limiter->SetAutoTune(bytes_per_sec * rate_limit_min_percent_ / 100, rate_limit_target_latency_);
+        }
+        log_warn("[%d] set rate limit, io type: %d, rate: %"PRI64_PREFIX"d, auto tune: %s, "
+                 "target read latency: %"PRI64_PREFIX"d, min percent: %d",
+                 index_, type, bytes_per_sec, limiter->IsAutoTune() ? "yes" : "no",
+                 rate_limit_target_latency_, rate_limit_min_percent_);
+      }
+
       tbsys::CThreadMutex* LdbInstance::get_mutex(const tair::common::data_entry& key)
       {
         tbsys::CThreadMutex* ret = NULL;
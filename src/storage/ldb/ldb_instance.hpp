@@ -18,12 +18,16 @@
 #define TAIR_STORAGE_LDB_INSTANCE_H
 
 #include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/pinnable_slice.h"
 
 #include "common/data_entry.hpp"
 #include "ldb_define.hpp"
 #include "ldb_gc_factory.hpp"
 #include "bg_task.hpp"
 #include "stat_manager.hpp"
+#include "ldb_negative_cache.hpp"
+#include "ldb_version_index.hpp"
 
 namespace tair
 {
@@ -40,7 +44,10 @@ namespace tair
         friend class LdbRemoteSyncLogReader;
       public:
         LdbInstance();
-        explicit LdbInstance(int32_t index, bool db_version_care, storage_manager* cache);
+        // shared_block_cache/write_buffer_manager: shared by all instances, owned by caller
+        explicit LdbInstance(int32_t index, bool db_version_care, storage_manager* cache,
+                             leveldb::Cache* shared_block_cache = NULL,
+                             leveldb::WriteBufferManager* write_buffer_manager = NULL);
         ~LdbInstance();
 
         typedef __gnu_cxx::hash_map<int32_t, stat_manager*> STAT_MANAGER_MAP;
@@ -56,10 +63,21 @@ namespace tair
                 bool version_care, int expire_time);
         int direct_mupdate(int bucket_number, const std::vector<operation_record*>& kvs);
         int batch_put(int bucket_number, int area, tair::common::mput_record_vec* record_vec, bool version_care);
-        int get(int bucket_number, tair::common::data_entry& key, tair::common::data_entry& value);
+        // value read from db (not cache) is pinned in ldb block cache if pin is true
+        // read_mode is TAIR_READ_*
+        int get(int bucket_number, tair::common::data_entry& key, tair::common::data_entry& value, bool pin = false,
+                int read_mode = TAIR_READ_BLOCKING);
+        // load item into cache if it is not there, no stat counted
+        int warm_up(int bucket_number, tair::common::data_entry& key);
         int remove(int bucket_number, tair::common::data_entry& key, bool version_care);
 
-        int get_range(int bucket_number, tair::common::data_entry& key_start, tair::common::data_entry& end_key, int offset, int limit, int type, std::vector<tair::common::data_entry*>& result, bool &has_next);
+        // cursor is opaque to client: the whole key (with area) of next entry to read
+        int get_range(int bucket_number, tair::common::data_entry& key_start, tair::common::data_entry& end_key, int offset, int limit, int type, std::vector<tair::common::data_entry*>& result, bool &has_next,
+                      tair::common::data_entry* cursor = NULL);
+        // keys share one prefix. values missed in cache are read from one snapshot,
+        // by seeking each key or by walking one iterator through sorted keys when they are dense.
+        int prefix_gets(int bucket_number, std::vector<tair::common::data_entry*>& keys,
+                        std::vector<tair::common::data_entry*>& values, std::vector<int>& rcs);
         int del_range(int bucket_number, tair::common::data_entry& key_start, tair::common::data_entry& end_key, int offset, int limit, int type, std::vector<tair::common::data_entry*>& result, bool &has_next);
 
         int op_cmd(ServerCmdType cmd, std::vector<std::string>& params);
@@ -68,10 +86,17 @@ namespace tair
         bool begin_scan(int bucket_number);
         bool end_scan();
         bool get_next_items(std::vector<item_data_info*>& list);
+
+        // migrate bucket by sstable files
+        int export_bucket(int bucket_number, std::vector<std::string>& files);
+        void end_export_bucket(int bucket_number);
+        int import_bucket_file(int bucket_number, const char* name, int64_t offset, const char* data, int32_t size);
+        int ingest_bucket(int bucket_number, bool abort);
         void get_stats(tair_stat* stat);
 
         int stat_db();
         int set_config(std::vector<std::string>& params);
+        int checkpoint(const std::vector<std::string>& params);
 
         int clear_area(int32_t area);
         bool exist(int32_t bucket_number);
@@ -79,6 +104,11 @@ namespace tair
         // stat util
         void stat_add(int32_t bucket_number, int32_t area, int32_t data_size, int32_t use_size, int32_t item_count);
         void stat_sub(int32_t bucket_number, int32_t area, int32_t data_size, int32_t use_size, int32_t item_count);
+        void stat_read(int32_t bucket_number);
+        void stat_write(int32_t bucket_number, int32_t count);
+        // load of bucket: data size and accumulated read/write count(wrap around),
+        // return false if bucket is not here
+        bool get_bucket_load(int32_t bucket_number, uint64_t& data_size, uint32_t& read_count, uint32_t& write_count);
 
         void get_buckets(std::vector<int32_t>& buckets);
 
@@ -86,23 +116,38 @@ namespace tair
         const char* db_path() { return db_path_; }
         // use inner leveldb/gc_factory when compact
         leveldb::DB* db() { return db_; }
+        // throttle background scan io, migration or balance eg.
+        leveldb::RateLimiter* scan_rate_limiter() { return options_.env->GetRateLimiter(leveldb::kIOScan); }
         LdbGcFactory* gc_factory() { return &gc_; }
         BgTask* bg_task() { return &bg_task_;}
+        LdbNegativeCache* negative_cache() { return &negative_cache_; }
+        LdbVersionIndex* version_index() { return &version_index_; }
 
       private:
         int do_cache_get(LdbKey& ldb_key, std::string& value, bool update_stat);
-        int do_get(LdbKey& ldb_key, std::string& value, bool from_cache, bool fill_cache, bool update_stat = true);
+        // read from db into *pinned instead of value if pinned is not NULL,
+        // TAIR_RETURN_WOULD_BLOCK if cache_only and db needs disk read
+        int do_get(LdbKey& ldb_key, std::string& value, bool from_cache, bool fill_cache, bool update_stat = true,
+                   leveldb::PinnableSlice* pinned = NULL, bool cache_only = false);
+        int do_get_for_write(LdbKey& ldb_key, std::string& value, LdbItem& ldb_item,
+                             int32_t& value_size, int32_t& item_size);
         int do_put(LdbKey& ldb_key, LdbItem& ldb_item, bool fill_cache, bool synced);
         int do_remove(LdbKey& ldb_key, bool synced, tair::common::entry_tailer* tailer = NULL);
+        int del_range_at_once(int bucket_number, tair::common::data_entry& key_start, tair::common::data_entry& key_end);
         bool is_mtime_care(const common::data_entry& key);
         bool is_synced(const common::data_entry& key);
         void add_prefix(LdbKey& ldb_key, int prefix_size);
         void fill_meta(tair::common::data_entry *data, LdbKey& key, LdbItem& item);
 
         bool init_db();
+        bool init_db_paths();
         void stop();
         void sanitize_option();
+        void init_rate_limit();
+        void set_rate_limit(leveldb::IOType type, int64_t bytes_per_sec);
         tbsys::CThreadMutex* get_mutex(const tair::common::data_entry& key);
+        std::string migrate_dir(int bucket_number, bool out);
+        void remove_migrate_dir(const std::string& dir);
 
       private:
         // index of this instance
@@ -116,6 +161,8 @@ namespace tair
         leveldb::Options options_;
         leveldb::WriteOptions write_options_;
         leveldb::ReadOptions read_options_;
+        // bulk scan for migration/dump: not fill cache, read ahead
+        leveldb::ReadOptions scan_read_options_;
         // lock to protect cache. cause leveldb and mdb has its own lock,
         // but the combination of operation over db_ and cache_ must atomic to avoid dirty data,
         // no matter op is read or write, cause read db means writing to cache.
@@ -137,6 +184,22 @@ namespace tair
         BgTask bg_task_;
         // gc cleared area and closed buckets
         LdbGcFactory gc_;
+        // keys confirmed not exist
+        LdbNegativeCache negative_cache_;
+        // bumped when cache is invalidated by range deletion. reader gets it BEFORE reading db,
+        // and fills cache only if it is unchanged, or stale item read before deletion may be filled.
+        atomic_t cache_fill_epoch_;
+        // meta of recently written items, for blind write
+        LdbVersionIndex version_index_;
+        LdbBlindWriteStat blind_write_stat_;
+        // auto tune compaction/scan rate limit by sstable read latency
+        int64_t rate_limit_target_latency_;
+        int32_t rate_limit_min_percent_;
+        // ship sstable files when migrating bucket
+        bool migrate_by_file_;
+        // shared by all instances, options_.block_cache is a view of it if not NULL
+        leveldb::Cache* shared_block_cache_;
+        leveldb::WriteBufferManager* write_buffer_manager_;
       };
     }
   }
@@ -15,6 +15,7 @@
  */
 
 #include <malloc.h>
+#include <algorithm>
 #ifdef WITH_TCMALLOC
 #include <google/malloc_extension.h>
 #endif
@@ -25,6 +26,8 @@
 #include "ldb_manager.hpp"
 #include "ldb_instance.hpp"
 #include "ldb_balancer.hpp"
+#include "leveldb/cache.h"
+#include "leveldb/write_buffer_manager.h"
 
 namespace tair
 {
@@ -282,6 +285,27 @@ namespace tair
         BucketIndexer::get_index_map(bm, total_, result);
       }
 
+      int MapBucketIndexer::checkpoint(const char* dir)
+      {
+        int ret = TAIR_RETURN_SUCCESS;
+        char file_name[TAIR_MAX_PATH_LEN];
+        snprintf(file_name, sizeof(file_name), "%s/ldb_bucket_index_map", dir);
+        FILE* file = ::fopen(file_name, "w");
+        if (NULL == file)
+        {
+          log_error("open checkpoint bucket index file %s fail, error: %s", file_name, strerror(errno));
+          ret = TAIR_RETURN_FAILED;
+        }
+        else
+        {
+          BUCKET_INDEX_MAP bm(*bucket_map_);
+          std::string index_str = BucketIndexer::to_string(total_, bm);
+          fprintf(file, "%s", index_str.c_str());
+          ::fclose(file);
+        }
+        return ret;
+      }
+
       int MapBucketIndexer::close_sharding_bucket(int32_t total, const std::vector<int32_t>& buckets,
                                                   INDEX_BUCKET_MAP& index_map, bool& updated)
       {
@@ -603,15 +627,111 @@ namespace tair
       }
 
 
+      ////////////////////////////////
+      // LdbInstanceOpener
+      ////////////////////////////////
+      LdbInstanceOpener::LdbInstanceOpener(LdbInstance** instances, const BucketIndexer::INDEX_BUCKET_MAP& index_map) :
+        instances_(instances), index_map_(index_map)
+      {
+        atomic_set(&next_, 0);
+        atomic_set(&failed_, 0);
+      }
+
+      LdbInstanceOpener::~LdbInstanceOpener()
+      {
+      }
+
+      void LdbInstanceOpener::run(tbsys::CThread* thread, void* arg)
+      {
+        UNUSED(thread);
+        UNUSED(arg);
+        int32_t i = 0;
+        while (atomic_read(&failed_) == 0 && (i = atomic_add_return(1, &next_) - 1) < static_cast<int32_t>(index_map_.size()))
+        {
+          int64_t start_us = tbsys::CTimeUtil::getTime();
+          log_warn("instance %d own %lu buckets.", i, index_map_[i].size());
+          if (!instances_[i]->init_buckets(index_map_[i]))
+          {
+            log_error("init buckets for db instance %d fail", i);
+            atomic_set(&failed_, 1);
+          }
+          else
+          {
+            log_warn("init buckets for db instance %d cost %"PRI64_PREFIX"d us", i, tbsys::CTimeUtil::getTime() - start_us);
+          }
+        }
+      }
+
+      ////////////////////////////////
+      // LdbCacheWarmer
+      ////////////////////////////////
+      LdbCacheWarmer::LdbCacheWarmer(LdbManager* manager) : manager_(manager), done_(false)
+      {
+      }
+
+      LdbCacheWarmer::~LdbCacheWarmer()
+      {
+      }
+
+      void LdbCacheWarmer::run(tbsys::CThread* thread, void* arg)
+      {
+        // keys per second, check every 100ms or so
+        int32_t rate = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_CACHE_WARM_UP_RATE, 5000);
+        int32_t check_count = rate > 10 ? rate / 10 : 1;
+
+        for (int32_t i = 0; i < manager_->cache_count_ && !_stop; ++i)
+        {
+          CacheHotKeys::HOT_KEY_LIST keys;
+          if (manager_->cache_hot_keys_[i].load(keys) != TAIR_RETURN_SUCCESS)
+          {
+            log_warn("no hot keys to warm up cache %d", i);
+            continue;
+          }
+
+          int64_t start_us = tbsys::CTimeUtil::getTime();
+          int64_t warmed_count = 0, skipped_count = 0;
+          data_entry key;
+          for (size_t k = 0; k < keys.size() && !_stop; ++k)
+          {
+            // bucket may be not here any more
+            LdbInstance* instance = manager_->get_db_instance(keys[k].first, false);
+            key.set_data(keys[k].second.data(), keys[k].second.size());
+            if (instance != NULL && instance->warm_up(keys[k].first, key) == TAIR_RETURN_SUCCESS)
+            {
+              ++warmed_count;
+            }
+            else
+            {
+              ++skipped_count;
+            }
+
+            if (rate > 0 && (k + 1) % check_count == 0)
+            {
+              int64_t wait_us = static_cast<int64_t>(k + 1) * 1000000 / rate - (tbsys::CTimeUtil::getTime() - start_us);
+              if (wait_us > 0)
+              {
+                ::usleep(wait_us);
+              }
+            }
+          }
+
+          log_warn("warm up cache %d, hot keys: %lu, warmed: %"PRI64_PREFIX"d, skipped: %"PRI64_PREFIX"d, cost: %"PRI64_PREFIX"d(ms)",
+                   i, keys.size(), warmed_count, skipped_count, (tbsys::CTimeUtil::getTime() - start_us) / 1000);
+        }
+        done_ = true;
+      }
+
       ////////////////////////////////
       // LdbManager
       ////////////////////////////////
       extern void get_bloom_stats(cache_stat* ldb_cache_stat);
 
       LdbManager::LdbManager() :
-        frozen_bucket_(-1), use_bloomfilter_(false), cache_(NULL), cache_count_(0), scan_ldb_(NULL),
+        frozen_bucket_(-1), use_bloomfilter_(false), pinned_get_(false), cache_(NULL), cache_count_(0), scan_ldb_(NULL),
         migrate_wait_us_(0), using_head_(NULL), using_tail_(NULL), last_release_time_(0),
-        remote_sync_logger_(NULL), balancer_(NULL)
+        cache_hot_keys_(NULL), cache_hot_key_count_(0), cache_hot_key_save_interval_s_(0), last_hot_key_save_time_(0),
+        cache_warmer_(NULL), remote_sync_logger_(NULL), balancer_(NULL), shared_block_cache_(NULL),
+        write_buffer_manager_(NULL)
       {
         init();
       }
@@ -626,12 +746,23 @@ namespace tair
         db_count_ = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_DB_INSTANCE_COUNT, 1);
         cache_count_ = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_USE_CACHE_COUNT, 1);
         use_bloomfilter_ = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_USE_BLOOMFILTER, 0) > 0;
+        pinned_get_ = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_PINNED_GET, 0) > 0;
+        // must be known before any comparator is created
+        int32_t key_format = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_KEY_FORMAT, LDB_KEY_FORMAT_V1);
+        if (key_format != LDB_KEY_FORMAT_V1 && key_format != LDB_KEY_FORMAT_V2)
+        {
+          log_error("invalid ldb key format: %d, use %d", key_format, LDB_KEY_FORMAT_V1);
+          key_format = LDB_KEY_FORMAT_V1;
+        }
+        LdbKey::set_format(key_format);
 
         if (cache_count_ > 0)
         {
           init_cache(cache_, cache_count_);
         }
 
+        init_cache_hot_keys();
+
         std::string cache_stat_path;
         if (cache_ != NULL || use_bloomfilter_)
         {
@@ -653,20 +784,36 @@ namespace tair
           }
         }
 
+        // one block cache and memtable budget for all instances, so that a busy
+        // instance can use memory idle ones don't need.
+        int64_t shared_block_cache_size = atoll(TBSYS_CONFIG.getString(TAIRLDB_SECTION, LDB_SHARED_BLOCK_CACHE_SIZE, "0"));
+        if (shared_block_cache_size > 0)
+        {
+          shared_block_cache_ = leveldb::NewLRUCache(shared_block_cache_size,
+                                                     TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_BLOCK_CACHE_SHARD_BITS, 4));
+        }
+        int64_t shared_write_buffer_size = atoll(TBSYS_CONFIG.getString(TAIRLDB_SECTION, LDB_SHARED_WRITE_BUFFER_SIZE, "0"));
+        if (shared_write_buffer_size > 0)
+        {
+          write_buffer_manager_ = new leveldb::WriteBufferManager(shared_write_buffer_size);
+        }
+
         bool db_version_care = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_DB_VERSION_CARE, 1) > 0;
         ldb_instance_ = new LdbInstance*[db_count_];
         for (int32_t i = 0; i < db_count_; ++i)
         {
-          ldb_instance_[i] = new LdbInstance(i, db_version_care, cache_ != NULL ? cache_[i % cache_count_] : NULL);
+          ldb_instance_[i] = new LdbInstance(i, db_version_care, cache_ != NULL ? cache_[i % cache_count_] : NULL,
+                                             shared_block_cache_, write_buffer_manager_);
         }
 
         const char* bucket_index_strategy = TBSYS_CONFIG.getString(TAIRLDB_SECTION, LDB_BUCKET_INDEX_TO_INSTANCE_STRATEGY,
                                                                    BI_STRATEGY_HASH);
         bucket_indexer_ = BucketIndexer::new_bucket_indexer(bucket_index_strategy);
 
-        log_warn("ldb storage engine construct count: %d, db version care: %s, cache count: %d, cache stat path: %s, bucket index strategy: %s",
+        log_warn("ldb storage engine construct count: %d, db version care: %s, cache count: %d, cache stat path: %s, bucket index strategy: %s, "
+                 "shared block cache: %"PRI64_PREFIX"d, shared write buffer: %"PRI64_PREFIX"d",
                  db_count_, db_version_care ? "yes" : "no", cache_count_, cache_stat_path.c_str(),
-                 bucket_index_strategy);
+                 bucket_index_strategy, shared_block_cache_size, shared_write_buffer_size);
 
         return TAIR_RETURN_SUCCESS;
       }
@@ -705,8 +852,83 @@ namespace tair
         return ret;
       }
 
+      void LdbManager::init_cache_hot_keys()
+      {
+        cache_hot_key_count_ = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_CACHE_HOT_KEY_COUNT, 0);
+        cache_hot_key_save_interval_s_ = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_CACHE_HOT_KEY_SAVE_INTERVAL, 600);
+        if (cache_ != NULL && cache_hot_key_count_ > 0)
+        {
+          const char* data_dir = TBSYS_CONFIG.getString(TAIRLDB_SECTION, LDB_DATA_DIR, LDB_DEFAULT_DATA_DIR);
+          char dir[TAIR_MAX_PATH_LEN];
+          cache_hot_keys_ = new CacheHotKeys[cache_count_];
+          for (int32_t i = 0; i < cache_count_; ++i)
+          {
+            // beside db of the first instance using this cache
+            snprintf(dir, sizeof(dir), "%s%d", data_dir, i + 1);
+            cache_hot_keys_[i].start(dir, i);
+          }
+          log_warn("cache hot keys enabled, count: %d, save interval: %d(s)",
+                   cache_hot_key_count_, cache_hot_key_save_interval_s_);
+        }
+      }
+
+      // lock_ hold
+      void LdbManager::maybe_save_cache_hot_keys()
+      {
+        uint32_t now = time(NULL);
+        // saving before warm up finished would lose keys not loaded yet
+        if (cache_hot_keys_ == NULL || cache_ == NULL || bucket_count == 0 ||
+            cache_warmer_ == NULL || !cache_warmer_->done() ||
+            now - last_hot_key_save_time_ < static_cast<uint32_t>(cache_hot_key_save_interval_s_))
+        {
+          return;
+        }
+        last_hot_key_save_time_ = now;
+
+        std::vector<std::string> keys;
+        std::string value;
+        LdbItem ldb_item;
+        for (int32_t i = 0; i < cache_count_; ++i)
+        {
+          keys.clear();
+          cache_[i]->raw_get_hot_keys(cache_hot_key_count_, keys);
+
+          CacheHotKeys::HOT_KEY_LIST hot_keys;
+          hot_keys.reserve(keys.size());
+          // coldest first, so lru order is kept after raw_get() touches them
+          for (std::vector<std::string>::reverse_iterator it = keys.rbegin(); it != keys.rend(); ++it)
+          {
+            int32_t user_key_size = static_cast<int32_t>(it->size()) - TAIR_AREA_ENCODE_SIZE;
+            if (user_key_size <= 0 ||
+                cache_[i]->raw_get(it->data(), it->size(), value, false) != TAIR_RETURN_SUCCESS)
+            {
+              continue;
+            }
+            // bucket is hashed as data_entry, prefix only if there is
+            ldb_item.assign(const_cast<char*>(value.data()), value.size());
+            int32_t hash_size = ldb_item.prefix_size() > 0 ? std::min(static_cast<int32_t>(ldb_item.prefix_size()), user_key_size) :
+              user_key_size;
+            uint32_t bucket = tair::util::string_util::mur_mur_hash(it->data() + TAIR_AREA_ENCODE_SIZE, hash_size) % bucket_count;
+            hot_keys.push_back(std::make_pair(static_cast<int32_t>(bucket), *it));
+          }
+          std::reverse(hot_keys.begin(), hot_keys.end());
+
+          int ret = cache_hot_keys_[i].save(hot_keys);
+          log_info("save cache %d hot keys: %lu, ret: %d", i, hot_keys.size(), ret);
+        }
+      }
+
       int LdbManager::destroy()
       {
+        // warmer uses instances
+        if (cache_warmer_ != NULL)
+        {
+          cache_warmer_->stop();
+          cache_warmer_->wait();
+          delete cache_warmer_;
+          cache_warmer_ = NULL;
+        }
+
         LdbInstance** instance = ldb_instance_;
         ldb_instance_ = NULL;
         destroy_container(instance, db_count_);
@@ -715,6 +937,12 @@ namespace tair
         cache_ = NULL;
         destroy_container(cache, cache_count_);
 
+        if (cache_hot_keys_ != NULL)
+        {
+          delete [] cache_hot_keys_;
+          cache_hot_keys_ = NULL;
+        }
+
         if (NULL != bucket_indexer_)
         {
           delete bucket_indexer_;
@@ -738,6 +966,18 @@ namespace tair
           delete balancer_;
         }
 
+        // all instances are gone, nobody uses them now
+        if (shared_block_cache_ != NULL)
+        {
+          delete shared_block_cache_;
+          shared_block_cache_ = NULL;
+        }
+        if (write_buffer_manager_ != NULL)
+        {
+          delete write_buffer_manager_;
+          write_buffer_manager_ = NULL;
+        }
+
         return TAIR_RETURN_SUCCESS;
       }
 
@@ -816,7 +1056,43 @@ namespace tair
         return rc;
       }
 
-      int LdbManager::get_range(int bucket_number, data_entry& key_start, data_entry& key_end, int offset, int limit, int type, std::vector<data_entry*>& result, bool &has_next)
+      int LdbManager::get_pinned(int bucket_number, data_entry& key, data_entry& value, bool stat, int read_mode)
+      {
+        int rc = TAIR_RETURN_SUCCESS;
+        LdbInstance* db_instance = get_db_instance(bucket_number, false);
+
+        if (db_instance == NULL)
+        {
+          log_error("ldb_bucket[%d] not exist", bucket_number);
+          rc = TAIR_RETURN_FAILED;
+        }
+        else
+        {
+          rc = db_instance->get(bucket_number, key, value, pinned_get_, read_mode);
+        }
+
+        return rc;
+      }
+
+      int LdbManager::prefix_gets(int bucket_number, std::vector<data_entry*>& keys, std::vector<data_entry*>& values, std::vector<int>& rcs)
+      {
+        int rc = TAIR_RETURN_SUCCESS;
+        LdbInstance* db_instance = get_db_instance(bucket_number, false);
+
+        if (db_instance == NULL)
+        {
+          log_error("ldb_bucket[%d] not exist", bucket_number);
+          rc = TAIR_RETURN_FAILED;
+        }
+        else
+        {
+          rc = db_instance->prefix_gets(bucket_number, keys, values, rcs);
+        }
+
+        return rc;
+      }
+
+      int LdbManager::get_range(int bucket_number, data_entry& key_start, data_entry& key_end, int offset, int limit, int type, std::vector<data_entry*>& result, bool &has_next, data_entry* cursor)
       {
         int rc = TAIR_RETURN_SUCCESS;
         LdbInstance* db_instance = get_db_instance(bucket_number, false);
@@ -829,7 +1105,7 @@ namespace tair
         else 
         {
           PROFILER_BEGIN("db_instance get_range");
-          rc = db_instance->get_range(bucket_number, key_start, key_end, offset, limit, type, result, has_next);
+          rc = db_instance->get_range(bucket_number, key_start, key_end, offset, limit, type, result, has_next, cursor);
           log_debug("after get_range key_count:%lu", result.size());
           PROFILER_END();
         }
@@ -922,16 +1198,24 @@ namespace tair
             balancer_->stop();
           }
 
-          for (int32_t i = 0; i < db_count_; ++i)
-          {
-            log_warn("instance %d own %lu buckets.", i, index_map[i].size());
-            ret = ldb_instance_[i]->init_buckets(index_map[i]);
-            if (!ret)
-            {
-              log_error("init buckets for db instance %d fail", i);
-              break;
-            }
-          }
+          // instances are independent, open them in parallel
+          int32_t thread_count = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_OPEN_THREAD_COUNT, 1);
+          thread_count = std::max(1, std::min(thread_count, db_count_));
+          int64_t start_us = tbsys::CTimeUtil::getTime();
+          LdbInstanceOpener opener(ldb_instance_, index_map);
+          opener.setThreadCount(thread_count);
+          opener.start();
+          opener.wait();
+          ret = opener.success();
+          log_warn("init buckets for %d db instances with %d threads %s, cost %"PRI64_PREFIX"d us",
+                   db_count_, thread_count, ret ? "success" : "fail", tbsys::CTimeUtil::getTime() - start_us);
+        }
+
+        // warm up caches once buckets are here
+        if (ret && cache_hot_keys_ != NULL && cache_warmer_ == NULL)
+        {
+          cache_warmer_ = new LdbCacheWarmer(this);
+          cache_warmer_->start();
         }
 
         return ret;
@@ -1025,6 +1309,48 @@ namespace tair
         return ret;
       }
 
+      int LdbManager::export_bucket(int bucket_number, std::vector<std::string>& files)
+      {
+        LdbInstance* db_instance = get_db_instance(bucket_number, false);
+        if (db_instance == NULL)
+        {
+          log_error("ldb_bucket[%d] not exist", bucket_number);
+          return TAIR_RETURN_FAILED;
+        }
+        return db_instance->export_bucket(bucket_number, files);
+      }
+
+      void LdbManager::end_export_bucket(int bucket_number)
+      {
+        LdbInstance* db_instance = get_db_instance(bucket_number, false);
+        if (db_instance != NULL)
+        {
+          db_instance->end_export_bucket(bucket_number);
+        }
+      }
+
+      int LdbManager::import_bucket_file(int bucket_number, const char* name, int64_t offset, const char* data, int32_t size)
+      {
+        LdbInstance* db_instance = get_db_instance(bucket_number);
+        if (db_instance == NULL)
+        {
+          log_error("ldb_bucket[%d] not exist", bucket_number);
+          return TAIR_RETURN_FAILED;
+        }
+        return db_instance->import_bucket_file(bucket_number, name, offset, data, size);
+      }
+
+      int LdbManager::ingest_bucket(int bucket_number, bool abort)
+      {
+        LdbInstance* db_instance = get_db_instance(bucket_number);
+        if (db_instance == NULL)
+        {
+          log_error("ldb_bucket[%d] not exist", bucket_number);
+          return TAIR_RETURN_FAILED;
+        }
+        return db_instance->ingest_bucket(bucket_number, abort);
+      }
+
       void LdbManager::set_area_quota(int area, uint64_t quota)
       {
         // we consider set area quota to cache
@@ -1113,6 +1439,12 @@ namespace tair
             }
             break;
           }
+          case TAIR_SERVER_CMD_CHECKPOINT_DB:
+          {
+            // instances are checked, so params[0] is the dir
+            ret = bucket_indexer_->checkpoint(params[0].c_str());
+            break;
+          }
           // fastdump cmd
           case TAIR_SERVER_CMD_RESET_DB:
           {
@@ -1125,7 +1457,7 @@ namespace tair
             {
               balancer_ = new LdbBalancer(this);
             }
-            balancer_->start();
+            balancer_->start(!params.empty() && params[0] == TAIR_BALANCE_DRY_RUN);
             break;
           }
           case TAIR_SERVER_CMD_STOP_BALANCE:
@@ -1269,7 +1601,8 @@ namespace tair
         for (i = 0; i < db_count_; ++i)
         {
           new_ldb_instance[i] = new LdbInstance(i, db_version_care,
-                                                new_cache != NULL ? new_cache[i % cache_count_] : NULL);
+                                                new_cache != NULL ? new_cache[i % cache_count_] : NULL,
+                                                shared_block_cache_, write_buffer_manager_);
           log_debug("reinit instance %d own %lu buckets.", i, tmp_buckets[i].size());
           if (!new_ldb_instance[i]->init_buckets(tmp_buckets[i]))
           {
@@ -1392,6 +1725,7 @@ namespace tair
           }
           cache_stat_.save(ldb_cache_stat, TAIR_MAX_AREA_COUNT);
         }
+        maybe_save_cache_hot_keys();
         maybe_exec_cmd();
       }
 
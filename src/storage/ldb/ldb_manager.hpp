@@ -33,6 +33,12 @@ namespace std {
 #include "ldb_cache_stat.hpp"
 #include "ldb_remote_sync_logger.hpp"
 
+namespace leveldb
+{
+  class Cache;
+  class WriteBufferManager;
+}
+
 namespace tair
 {
   class operation_record;
@@ -43,6 +49,7 @@ namespace tair
     {
       class LdbInstance;
       class LdbBalancer;
+      class LdbManager;
 
       ////////////////////////////////
       // UsingLdbManager
@@ -86,6 +93,8 @@ namespace tair
         virtual int32_t bucket_to_index(int32_t bucket_number, bool& recheck) = 0;
         virtual int reindex(int32_t bucket, int32_t from, int32_t to) = 0;
         virtual void get_index_map(INDEX_BUCKET_MAP& result) = 0;
+        // save bucket index into "dir" along with checkpoint of instances
+        virtual int checkpoint(const char* dir) { return TAIR_RETURN_SUCCESS; }
 
         static void get_index_map(const BUCKET_INDEX_MAP& bucket_map, int32_t index_count, INDEX_BUCKET_MAP& index_map);
         static std::string to_string(const INDEX_BUCKET_MAP& index_map);
@@ -126,6 +135,7 @@ namespace tair
         virtual int32_t bucket_to_index(int32_t bucket_number, bool& recheck);
         virtual int reindex(int32_t bucket, int32_t from, int32_t to);
         virtual void get_index_map(INDEX_BUCKET_MAP& result);
+        virtual int checkpoint(const char* dir);
 
       private:
         int close_sharding_bucket(int32_t total, const std::vector<int32_t>& buckets,
@@ -145,12 +155,46 @@ namespace tair
       };
 
 
+      // init buckets of ldb instances in parallel, most time of which is
+      // opening db (recovering manifest and logs) at startup.
+      class LdbInstanceOpener : public tbsys::CDefaultRunnable
+      {
+      public:
+        LdbInstanceOpener(LdbInstance** instances, const BucketIndexer::INDEX_BUCKET_MAP& index_map);
+        virtual ~LdbInstanceOpener();
+
+        void run(tbsys::CThread* thread, void* arg);
+        bool success() { return atomic_read(&failed_) == 0; }
+
+      private:
+        LdbInstance** instances_;
+        const BucketIndexer::INDEX_BUCKET_MAP& index_map_;
+        atomic_t next_;
+        atomic_t failed_;
+      };
+
+      // warm up ldb caches with saved hot keys in background after restart,
+      // service goes on meanwhile.
+      class LdbCacheWarmer : public tbsys::CDefaultRunnable
+      {
+      public:
+        explicit LdbCacheWarmer(LdbManager* manager);
+        virtual ~LdbCacheWarmer();
+
+        void run(tbsys::CThread* thread, void* arg);
+        bool done() { return done_; }
+
+      private:
+        LdbManager* manager_;
+        volatile bool done_;
+      };
 
       // manager hold buckets. single or multi leveldb instance based on config for test
       // it works, maybe make it common manager level.
       class LdbManager : public tair::storage::storage_manager
       {
         friend class LdbRemoteSyncLogger;
+        friend class LdbCacheWarmer;
       public:
         LdbManager();
         ~LdbManager();
@@ -160,10 +204,12 @@ namespace tair
         int direct_mupdate(int bucket_number, const std::vector<operation_record*>& kvs);
         int batch_put(int bucket_number, int area, mput_record_vec* record_vec, bool version_care);
         int get(int bucket_number, data_entry& key, data_entry& value, bool stat);
+        int get_pinned(int bucket_number, data_entry& key, data_entry& value, bool stat, int read_mode);
         int remove(int bucket_number, data_entry& key, bool version_care);
         int clear(int area);
 
-        int get_range(int bucket_number, data_entry& key_start, data_entry& end_key, int offset, int limit, int type, std::vector<data_entry*>& result, bool &has_next);
+        int get_range(int bucket_number, data_entry& key_start, data_entry& end_key, int offset, int limit, int type, std::vector<data_entry*>& result, bool &has_next, data_entry* cursor = NULL);
+        int prefix_gets(int bucket_number, std::vector<data_entry*>& keys, std::vector<data_entry*>& values, std::vector<int>& rcs);
         int del_range(int bucket_number, data_entry& key_start, data_entry& end_key, int offset, int limit, int type, std::vector<data_entry*>& result, bool &has_next);
 
         bool init_buckets(const std::vector <int>& buckets);
@@ -173,6 +219,11 @@ namespace tair
         void end_scan(md_info& info);
         bool get_next_items(md_info& info, std::vector <item_data_info *>& list);
 
+        int export_bucket(int bucket_number, std::vector<std::string>& files);
+        void end_export_bucket(int bucket_number);
+        int import_bucket_file(int bucket_number, const char* name, int64_t offset, const char* data, int32_t size);
+        int ingest_bucket(int bucket_number, bool abort);
+
         void set_area_quota(int area, uint64_t quota);
         void set_area_quota(std::map<int, uint64_t>& quota_map);
 
@@ -194,6 +245,8 @@ namespace tair
       private:
         int init();
         int init_cache(mdb_manager**& new_cache, int32_t count);
+        void init_cache_hot_keys();
+        void maybe_save_cache_hot_keys();
         int destroy();
 
         int do_reset_db();
@@ -219,10 +272,18 @@ namespace tair
         int32_t frozen_bucket_;
 
         bool use_bloomfilter_;
+        // whether value read from db is pinned in block cache until response is sent
+        bool pinned_get_;
         mdb_manager** cache_;
         int32_t cache_count_;
         // cache stat
         CacheStat cache_stat_;
+        // hot keys of each cache, NULL if not configured
+        CacheHotKeys* cache_hot_keys_;
+        int32_t cache_hot_key_count_;
+        int32_t cache_hot_key_save_interval_s_;
+        uint32_t last_hot_key_save_time_;
+        LdbCacheWarmer* cache_warmer_;
         LdbInstance* scan_ldb_;
         tbsys::CThreadMutex lock_;
         uint32_t migrate_wait_us_;
@@ -233,6 +294,9 @@ namespace tair
         LdbRemoteSyncLogger* remote_sync_logger_;
         // balancer
         LdbBalancer* balancer_;
+        // block cache and memtable budget shared by all instances, NULL if not configured
+        leveldb::Cache* shared_block_cache_;
+        leveldb::WriteBufferManager* write_buffer_manager_;
       };
     }
   }
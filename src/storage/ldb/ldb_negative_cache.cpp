@@ -0,0 +1,141 @@
+/*
+ * (C) 2007-2010 Alibaba Group Holding Limited
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * negative lookup cache
+ *
+ * Version: $Id$
+ *
+ * Authors:
+ *   agent <agent@local>
+ *
+ */
+
+#include "common/log.hpp"
+#include "common/hash.hpp"
+
+#include "ldb_negative_cache.hpp"
+
+namespace tair
+{
+  namespace storage
+  {
+    namespace ldb
+    {
+      LdbNegativeCache::LdbNegativeCache() : slots_(NULL), slot_count_(0)
+      {
+        atomic_set(&epoch_, 0);
+        reset_stat();
+      }
+
+      LdbNegativeCache::~LdbNegativeCache()
+      {
+        destroy();
+      }
+
+      bool LdbNegativeCache::init(int64_t slot_count)
+      {
+        if (slots_ != NULL)
+        {
+          log_warn("negative cache already init, slot count: %"PRI64_PREFIX"d", slot_count_);
+        }
+        else if (slot_count > 0)
+        {
+          slots_ = new uint64_t[slot_count];
+          slot_count_ = slot_count;
+          invalidate_all();
+          log_warn("init negative cache, slot count: %"PRI64_PREFIX"d, memory: %"PRI64_PREFIX"d",
+                   slot_count_, slot_count_ * static_cast<int64_t>(sizeof(uint64_t)));
+        }
+        return true;
+      }
+
+      void LdbNegativeCache::destroy()
+      {
+        if (slots_ != NULL)
+        {
+          delete [] slots_;
+          slots_ = NULL;
+          slot_count_ = 0;
+        }
+      }
+
+      bool LdbNegativeCache::hit(const char* key, int32_t key_size)
+      {
+        bool ret = false;
+        if (slots_ != NULL)
+        {
+          uint64_t fp = fingerprint(key, key_size);
+          ret = (*slot(fp) == fp);
+          atomic_inc(&lookup_count_);
+          if (ret)
+          {
+            atomic_inc(&hit_count_);
+          }
+        }
+        return ret;
+      }
+
+      void LdbNegativeCache::add(const char* key, int32_t key_size, uint32_t epoch)
+      {
+        if (slots_ != NULL && this->epoch() == epoch)
+        {
+          uint64_t fp = fingerprint(key, key_size);
+          volatile uint64_t* s = slot(fp);
+          *s = fp;
+          // store fingerprint before checking epoch again
+          __sync_synchronize();
+          // some write happened after we read db, the key may exist now, rollback.
+          if (this->epoch() != epoch && *s == fp)
+          {
+            *s = 0;
+          }
+        }
+      }
+
+      void LdbNegativeCache::invalidate(const char* key, int32_t key_size)
+      {
+        if (slots_ != NULL)
+        {
+          // inc epoch first, then concurrent add() will see it
+          atomic_inc(&epoch_);
+          uint64_t fp = fingerprint(key, key_size);
+          volatile uint64_t* s = slot(fp);
+          if (*s == fp)
+          {
+            *s = 0;
+          }
+        }
+      }
+
+      void LdbNegativeCache::invalidate_all()
+      {
+        if (slots_ != NULL)
+        {
+          atomic_inc(&epoch_);
+          for (int64_t i = 0; i < slot_count_; ++i)
+          {
+            slots_[i] = 0;
+          }
+        }
+      }
+
+      void LdbNegativeCache::reset_stat()
+      {
+        atomic_set(&lookup_count_, 0);
+        atomic_set(&hit_count_, 0);
+      }
+
+      uint64_t LdbNegativeCache::fingerprint(const char* key, int32_t key_size)
+      {
+        uint64_t fp = (static_cast<uint64_t>(mur_mur_hash2(key, key_size, 97)) << 32) |
+          mur_mur_hash2(key, key_size, 134217689);
+        // 0 means empty slot
+        return fp != 0 ? fp : 1;
+      }
+    }
+  }
+}
@@ -0,0 +1,80 @@
+/*
+ * (C) 2007-2010 Alibaba Group Holding Limited
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * negative lookup cache. remember keys that are confirmed not exist in ldb,
+ * so that get of unexist key (cache penetration check eg.) need not
+ * walk memtable/bloom/index block every time.
+ *
+ * Version: $Id$
+ *
+ * Authors:
+ *   agent <agent@local>
+ *
+ */
+
+#ifndef TAIR_STORAGE_LDB_NEGATIVE_CACHE_H
+#define TAIR_STORAGE_LDB_NEGATIVE_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic.h>
+
+namespace tair
+{
+  namespace storage
+  {
+    namespace ldb
+    {
+      // Direct-mapped fingerprint table, one 8 bytes slot per key, so memory is
+      // bounded by slot count. Collision just evicts the older one.
+      //
+      // Consistency: writer MUST invalidate() AFTER its data is written into db.
+      // reader get epoch() BEFORE reading db, and add() with this epoch when db says
+      // not found. add() gives up if any invalidate() happens in between, so
+      // this cache never says "not exist" to a key that exists, even without lock.
+      class LdbNegativeCache
+      {
+      public:
+        LdbNegativeCache();
+        ~LdbNegativeCache();
+
+        bool init(int64_t slot_count);
+        void destroy();
+        inline bool enable() const { return slots_ != NULL; }
+
+        // whether key is confirmed not exist
+        bool hit(const char* key, int32_t key_size);
+        // key is confirmed not exist when epoch is `epoch
+        void add(const char* key, int32_t key_size, uint32_t epoch);
+        // key maybe exist now
+        void invalidate(const char* key, int32_t key_size);
+        // all keys maybe exist now
+        void invalidate_all();
+
+        inline uint32_t epoch() { return atomic_read(&epoch_); }
+
+        // stat since last reset
+        inline int32_t lookup_count() { return atomic_read(&lookup_count_); }
+        inline int32_t hit_count() { return atomic_read(&hit_count_); }
+        inline int64_t slot_count() const { return slot_count_; }
+        void reset_stat();
+
+      private:
+        static uint64_t fingerprint(const char* key, int32_t key_size);
+        inline volatile uint64_t* slot(uint64_t fp) { return slots_ + fp % slot_count_; }
+
+      private:
+        volatile uint64_t* slots_;
+        int64_t slot_count_;
+        atomic_t epoch_;
+        atomic_t lookup_count_;
+        atomic_t hit_count_;
+      };
+    }
+  }
+}
+#endif
@@ -9,15 +9,16 @@ namespace tair
   {
     namespace ldb
     {
-      static const size_t LDB_COMPARE_SKIP_SIZE = LDB_EXPIRED_TIME_SIZE;
-      static const size_t LDB_COMPARE_META_ALL_SIZE = LDB_EXPIRED_TIME_SIZE + LDB_KEY_BUCKET_NUM_SIZE + LDB_KEY_AREA_SIZE;
-      NumericalComparatorImpl::NumericalComparatorImpl() : number_delim_(0), meta_len_(0)
+      NumericalComparatorImpl::NumericalComparatorImpl()
+        : number_delim_(0), meta_len_(0), skip_(LdbKey::expired_time_size()),
+          meta_all_size_(LdbKey::meta_size() + LDB_KEY_AREA_SIZE)
       {
         ldb_comparator_ = new BitcmpLdbComparatorImpl();
       }
 
       NumericalComparatorImpl::NumericalComparatorImpl(LdbGcFactory* gc, const char delim, size_t len) 
-        : number_delim_(delim), meta_len_(len)
+        : number_delim_(delim), meta_len_(len), skip_(LdbKey::expired_time_size()),
+          meta_all_size_(LdbKey::meta_size() + LDB_KEY_AREA_SIZE)
       {
         ldb_comparator_ = new BitcmpLdbComparatorImpl(gc);
       }
@@ -29,7 +30,7 @@ namespace tair
 
       const char* NumericalComparatorImpl::Name() const
       {
-        return "ldb.numericComparator";
+        return skip_ > 0 ? "ldb.numericComparator" : "ldb.numericComparatorV2";
       }
       
       //skip meta_size_, return pointer next
@@ -88,19 +89,19 @@ namespace tair
       // if no numbers found, treat it as string
       int  NumericalComparatorImpl::Compare(const leveldb::Slice& a, const leveldb::Slice& b) const
       {
-        assert(a.size() > LDB_COMPARE_META_ALL_SIZE && b.size() > LDB_COMPARE_META_ALL_SIZE );
+        assert(a.size() > meta_all_size_ && b.size() > meta_all_size_);
         int64_t num_a = 0, num_b = 0;
         int ret = 0;
         const char *prefix_a, *prefix_b, *delimiter_a, *delimiter_b, *suffix_a, *suffix_b;
 
-        prefix_a = MetaSkip(a.data() + LDB_COMPARE_META_ALL_SIZE, a.size() - LDB_COMPARE_META_ALL_SIZE);  
+        prefix_a = MetaSkip(a.data() + meta_all_size_, a.size() - meta_all_size_);
         delimiter_a = FindNumber(prefix_a, a.size() - (prefix_a - a.data()));
-        prefix_b = MetaSkip(b.data() + LDB_COMPARE_META_ALL_SIZE, b.size() - LDB_COMPARE_META_ALL_SIZE);  
+        prefix_b = MetaSkip(b.data() + meta_all_size_, b.size() - meta_all_size_);
         delimiter_b = FindNumber(prefix_b, b.size() - (prefix_b - b.data()));
         //compare bucket_num+area+meta+prefix
-        const size_t pre_len_a = delimiter_a - a.data() - LDB_COMPARE_SKIP_SIZE;
-        const size_t pre_len_b = delimiter_b - b.data() - LDB_COMPARE_SKIP_SIZE;
-        ret = StringCompare(a.data() + LDB_COMPARE_SKIP_SIZE, pre_len_a, b.data() + LDB_COMPARE_SKIP_SIZE, pre_len_b);
+        const size_t pre_len_a = delimiter_a - a.data() - skip_;
+        const size_t pre_len_b = delimiter_b - b.data() - skip_;
+        ret = StringCompare(a.data() + skip_, pre_len_a, b.data() + skip_, pre_len_b);
         if (ret == 0)
         {
           //prefixs equal, compare number
@@ -143,11 +144,23 @@ namespace tair
         return ldb_comparator_->ShouldDropMaybe(key, sequence, now);
       }
 
+      bool NumericalComparatorImpl::ShouldDropMaybe(const leveldb::Slice& key, const leveldb::Slice& value,
+                                                    int64_t sequence, uint32_t now) const
+      {
+        return ldb_comparator_->ShouldDropMaybe(key, value, sequence, now);
+      }
+
       bool NumericalComparatorImpl::ShouldStopBefore(const leveldb::Slice& start_key, const leveldb::Slice& key) const
       {
         return ldb_comparator_->ShouldStopBefore(start_key, key);
       }
 
+      bool NumericalComparatorImpl::GetTimeMeta(const leveldb::Slice& key, const leveldb::Slice& value,
+                                                uint32_t* expired_time, uint32_t* modify_time) const
+      {
+        return ldb_comparator_->GetTimeMeta(key, value, expired_time, modify_time);
+      }
+
       const leveldb::Comparator*  NumericalComparator(LdbGcFactory* gc, const char start, size_t len)
       {
         return new NumericalComparatorImpl(gc, start, len);
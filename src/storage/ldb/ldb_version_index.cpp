@@ -0,0 +1,135 @@
+/*
+ * (C) 2007-2010 Alibaba Group Holding Limited
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * in-memory version index
+ *
+ * Version: $Id$
+ *
+ * Authors:
+ *   agent <agent@local>
+ *
+ */
+
+#include "common/log.hpp"
+#include "common/hash.hpp"
+
+#include "ldb_version_index.hpp"
+
+namespace tair
+{
+  namespace storage
+  {
+    namespace ldb
+    {
+      LdbVersionIndex::LdbVersionIndex() : slots_(NULL), slot_count_(0)
+      {
+      }
+
+      LdbVersionIndex::~LdbVersionIndex()
+      {
+        destroy();
+      }
+
+      bool LdbVersionIndex::init(int64_t slot_count)
+      {
+        if (slots_ != NULL)
+        {
+          log_warn("version index already init, slot count: %"PRI64_PREFIX"d", slot_count_);
+        }
+        else if (slot_count > 0)
+        {
+          slots_ = new Slot[slot_count];
+          slot_count_ = slot_count;
+          clear();
+          log_warn("init version index, slot count: %"PRI64_PREFIX"d, memory: %"PRI64_PREFIX"d",
+                   slot_count_, slot_count_ * static_cast<int64_t>(sizeof(Slot)));
+        }
+        return true;
+      }
+
+      void LdbVersionIndex::destroy()
+      {
+        if (slots_ != NULL)
+        {
+          delete [] slots_;
+          slots_ = NULL;
+          slot_count_ = 0;
+        }
+      }
+
+      bool LdbVersionIndex::get(const char* key, int32_t key_size, LdbVersionMeta& meta)
+      {
+        bool ret = false;
+        if (slots_ != NULL)
+        {
+          uint64_t fp = fingerprint(key, key_size);
+          int64_t index = slot_index(fp);
+          {
+            tbsys::CThreadGuard guard(lock(index));
+            if (slots_[index].fp_ == fp)
+            {
+              meta = slots_[index].meta_;
+              ret = true;
+            }
+          }
+          // expired(or to be expired soon) item may be dropped by db, consider as unknown.
+          if (ret && meta.edate_ > 0 && meta.edate_ <= static_cast<uint32_t>(time(NULL)) + 1)
+          {
+            ret = false;
+          }
+        }
+        return ret;
+      }
+
+      void LdbVersionIndex::set(const char* key, int32_t key_size, const LdbVersionMeta& meta)
+      {
+        if (slots_ != NULL)
+        {
+          uint64_t fp = fingerprint(key, key_size);
+          int64_t index = slot_index(fp);
+          tbsys::CThreadGuard guard(lock(index));
+          slots_[index].fp_ = fp;
+          slots_[index].meta_ = meta;
+        }
+      }
+
+      void LdbVersionIndex::remove(const char* key, int32_t key_size)
+      {
+        if (slots_ != NULL)
+        {
+          uint64_t fp = fingerprint(key, key_size);
+          int64_t index = slot_index(fp);
+          tbsys::CThreadGuard guard(lock(index));
+          if (slots_[index].fp_ == fp)
+          {
+            slots_[index].fp_ = 0;
+          }
+        }
+      }
+
+      void LdbVersionIndex::clear()
+      {
+        if (slots_ != NULL)
+        {
+          for (int64_t i = 0; i < slot_count_; ++i)
+          {
+            tbsys::CThreadGuard guard(lock(i));
+            slots_[i].fp_ = 0;
+          }
+        }
+      }
+
+      uint64_t LdbVersionIndex::fingerprint(const char* key, int32_t key_size)
+      {
+        uint64_t fp = (static_cast<uint64_t>(mur_mur_hash2(key, key_size, 97)) << 32) |
+          mur_mur_hash2(key, key_size, 134217689);
+        // 0 means empty slot
+        return fp != 0 ? fp : 1;
+      }
+    }
+  }
+}
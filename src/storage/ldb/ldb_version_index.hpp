@@ -0,0 +1,120 @@
+/*
+ * (C) 2007-2010 Alibaba Group Holding Limited
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * in-memory version index of recently written items, so that version care
+ * put can skip "get" before "put" (blind write) when item's meta is known.
+ *
+ * Version: $Id$
+ *
+ * Authors:
+ *   agent <agent@local>
+ *
+ */
+
+#ifndef TAIR_STORAGE_LDB_VERSION_INDEX_H
+#define TAIR_STORAGE_LDB_VERSION_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include <atomic.h>
+#include <tbsys.h>
+
+namespace tair
+{
+  namespace storage
+  {
+    namespace ldb
+    {
+      // item meta that put needs when overwriting an exist item
+      struct LdbVersionMeta
+      {
+        LdbVersionMeta() : version_(0), cdate_(0), mdate_(0), edate_(0), value_size_(0), item_size_(0) {}
+        uint16_t version_;
+        uint32_t cdate_;
+        uint32_t mdate_;
+        uint32_t edate_;
+        // for statistics
+        int32_t value_size_;
+        int32_t item_size_;
+      };
+
+      // Direct-mapped key fingerprint => LdbVersionMeta, one slot per key,
+      // so memory is bounded by slot count. Collision just evicts the older one.
+      // Entry MUST be updated/removed along with item's write under the same
+      // key lock(LdbInstance::get_mutex()), then what index says is what db says.
+      class LdbVersionIndex
+      {
+      public:
+        LdbVersionIndex();
+        ~LdbVersionIndex();
+
+        bool init(int64_t slot_count);
+        void destroy();
+        inline bool enable() const { return slots_ != NULL; }
+
+        // return true if key exists and meta is known.
+        // expired item is considered as unknown.
+        bool get(const char* key, int32_t key_size, LdbVersionMeta& meta);
+        // key exists with meta now
+        void set(const char* key, int32_t key_size, const LdbVersionMeta& meta);
+        // key's meta is unknown now
+        void remove(const char* key, int32_t key_size);
+        // all keys' meta are unknown now
+        void clear();
+
+        inline int64_t slot_count() const { return slot_count_; }
+
+      private:
+        struct Slot
+        {
+          uint64_t fp_;
+          LdbVersionMeta meta_;
+        };
+
+        static const int32_t LOCK_COUNT = 256;
+
+        static uint64_t fingerprint(const char* key, int32_t key_size);
+        inline int64_t slot_index(uint64_t fp) const { return fp % slot_count_; }
+        inline tbsys::CThreadMutex* lock(int64_t index) { return locks_ + index % LOCK_COUNT; }
+
+      private:
+        Slot* slots_;
+        int64_t slot_count_;
+        tbsys::CThreadMutex locks_[LOCK_COUNT];
+      };
+
+      // blind write statistics
+      struct LdbBlindWriteStat
+      {
+        LdbBlindWriteStat()
+        {
+          reset();
+        }
+        void reset()
+        {
+          atomic_set(&put_count_, 0);
+          atomic_set(&index_hit_count_, 0);
+          atomic_set(&proved_new_count_, 0);
+          atomic_set(&read_count_, 0);
+          last_reset_time_ = time(NULL);
+        }
+
+        // put need check version
+        atomic_t put_count_;
+        // version known from index
+        atomic_t index_hit_count_;
+        // item is proved not exist, negative cache hit or filter miss
+        atomic_t proved_new_count_;
+        // fallback to read before write
+        atomic_t read_count_;
+        uint32_t last_reset_time_;
+      };
+    }
+  }
+}
+#endif
@@ -0,0 +1,276 @@
+// Copyright (c) 2026 agent <agent@local>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "db/blob_file.h"
+
+#include <algorithm>
+#include "db/dbformat.h"
+#include "db/filename.h"
+#include "db/version_edit.h"
+#include "util/coding.h"
+#include "util/crc32c.h"
+
+namespace leveldb {
+
+void BlobIndex::EncodeTo(std::string* dst) const {
+  PutVarint64(dst, file_number);
+  PutVarint64(dst, offset);
+  PutVarint64(dst, size);
+  dst->append(value_head.data(), value_head.size());
+}
+
+bool BlobIndex::DecodeFrom(const Slice& input) {
+  Slice in = input;
+  if (GetVarint64(&in, &file_number) &&
+      GetVarint64(&in, &offset) &&
+      GetVarint64(&in, &size)) {
+    value_head = in;
+    return true;
+  }
+  return false;
+}
+
+Slice EntryValueHead(ValueType type, const Slice& value) {
+  BlobIndex index;
+  if (type == kTypeBlobIndex && index.DecodeFrom(value)) {
+    return index.value_head;
+  }
+  return value;
+}
+
+BlobFileBuilder::BlobFileBuilder(const std::string& dbname, const Options& options,
+                                 uint64_t number, IOType io_type)
+    : env_(options.env),
+      dbname_(dbname),
+      min_value_size_(options.blob_value_size),
+      number_(number),
+      io_type_(io_type),
+      file_(NULL),
+      offset_(0),
+      entries_(0),
+      finished_(false) {
+}
+
+BlobFileBuilder::~BlobFileBuilder() {
+  // file is closed and released by Finish()
+  if (file_ != NULL) {
+    delete file_;
+    env_->DeleteFile(BlobFileName(dbname_, number_));
+  }
+}
+
+Status BlobFileBuilder::Separate(Slice* key, Slice* value) {
+  if (min_value_size_ == 0 || value->size() < min_value_size_ ||
+      ExtractValueType(*key) != kTypeValue) {
+    return Status::OK();
+  }
+
+  const Slice user_key = ExtractUserKey(*key);
+  BlobIndex index;
+  Status s = Add(user_key, *value, &index);
+  if (s.ok()) {
+    key_.assign(key->data(), key->size());
+    // type is the lowest byte of the tag
+    key_[key_.size() - kInternalKeySeqSize] = static_cast<char>(kTypeBlobIndex);
+    index_.clear();
+    index.EncodeTo(&index_);
+    *key = key_;
+    *value = index_;
+  }
+  return s;
+}
+
+Status BlobFileBuilder::Add(const Slice& user_key, const Slice& value, BlobIndex* index) {
+  assert(!finished_);
+  Status s;
+  if (file_ == NULL) {
+    s = env_->NewLimitedWritableFile(BlobFileName(dbname_, number_), &file_, io_type_);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+
+  record_.resize(kBlobRecordHeaderSize);
+  EncodeFixed32(&record_[4], static_cast<uint32_t>(user_key.size()));
+  EncodeFixed32(&record_[8], static_cast<uint32_t>(value.size()));
+  uint32_t crc = crc32c::Value(record_.data() + 4, kBlobRecordHeaderSize - 4);
+  crc = crc32c::Extend(crc, user_key.data(), user_key.size());
+  crc = crc32c::Extend(crc, value.data(), value.size());
+  EncodeFixed32(&record_[0], crc32c::Mask(crc));
+
+  s = file_->Append(record_);
+  if (s.ok()) {
+    s = file_->Append(user_key);
+  }
+  if (s.ok()) {
+    s = file_->Append(value);
+  }
+  if (s.ok()) {
+    index->file_number = number_;
+    index->offset = offset_;
+    index->size = kBlobRecordHeaderSize + user_key.size() + value.size();
+    index->value_head = Slice(value.data(), std::min(value.size(), kBlobValueHeadSize));
+    offset_ += index->size;
+    ++entries_;
+  }
+  return s;
+}
+
+Status BlobFileBuilder::Finish(BlobFileMeta* meta) {
+  Status s;
+  finished_ = true;
+  if (file_ != NULL) {
+    s = file_->Sync();
+    if (s.ok()) {
+      s = file_->Close();
+    }
+    delete file_;
+    file_ = NULL;
+  }
+  if (!s.ok()) {
+    env_->DeleteFile(BlobFileName(dbname_, number_));
+  }
+  meta->number = number_;
+  meta->file_size = s.ok() ? offset_ : 0;
+  meta->entries = entries_;
+  meta->garbage_size = 0;
+  return s;
+}
+
+BlobFileReader::BlobFileReader(SequentialFile* file)
+    : file_(file),
+      offset_(0) {
+}
+
+BlobFileReader::~BlobFileReader() {
+  delete file_;
+}
+
+bool BlobFileReader::Next(Slice* user_key, Slice* value, uint64_t* offset, uint64_t* size) {
+  if (!status_.ok()) {
+    return false;
+  }
+
+  char header[kBlobRecordHeaderSize];
+  Slice input;
+  status_ = file_->Read(kBlobRecordHeaderSize, &input, header);
+  if (!status_.ok() || input.empty()) {
+    return false;
+  }
+  if (input.size() < kBlobRecordHeaderSize) {
+    status_ = Status::Corruption("truncated blob record header");
+    return false;
+  }
+  const uint32_t key_size = DecodeFixed32(input.data() + 4);
+  const uint32_t value_size = DecodeFixed32(input.data() + 8);
+  const uint32_t expected_crc = crc32c::Unmask(DecodeFixed32(input.data()));
+  uint32_t crc = crc32c::Value(input.data() + 4, kBlobRecordHeaderSize - 4);
+
+  const size_t n = key_size + value_size;
+  scratch_.resize(n);
+  status_ = file_->Read(n, &input, &scratch_[0]);
+  if (status_.ok() && input.size() < n) {
+    status_ = Status::Corruption("truncated blob record");
+  }
+  if (status_.ok() && crc32c::Extend(crc, input.data(), n) != expected_crc) {
+    status_ = Status::Corruption("blob record checksum mismatch");
+  }
+  if (!status_.ok()) {
+    return false;
+  }
+
+  *user_key = Slice(input.data(), key_size);
+  *value = Slice(input.data() + key_size, value_size);
+  *offset = offset_;
+  *size = kBlobRecordHeaderSize + n;
+  offset_ += *size;
+  return true;
+}
+
+static void DeleteEntry(const Slice& key, void* value) {
+  delete reinterpret_cast<RandomAccessFile*>(value);
+}
+
+BlobFileCache::BlobFileCache(const std::string& dbname, const Options* options,
+                             size_t entries)
+    : env_(options->env),
+      dbname_(dbname),
+      cache_(NewLRUCache(entries)) {
+}
+
+BlobFileCache::~BlobFileCache() {
+  delete cache_;
+}
+
+Status BlobFileCache::FindFile(uint64_t file_number, Cache::Handle** handle) {
+  Status s;
+  char buf[sizeof(file_number)];
+  EncodeFixed64(buf, file_number);
+  Slice key(buf, sizeof(buf));
+  *handle = cache_->Lookup(key);
+  if (*handle == NULL) {
+    RandomAccessFile* file = NULL;
+    s = env_->NewRandomAccessFile(BlobFileName(dbname_, file_number), &file);
+    if (s.ok()) {
+      *handle = cache_->Insert(key, file, 1, 1, &DeleteEntry);
+    }
+  }
+  return s;
+}
+
+Status BlobFileCache::Get(const ReadOptions& options, const BlobIndex& index, std::string* value) {
+  if (index.size < kBlobRecordHeaderSize) {
+    return Status::Corruption("bad blob index");
+  }
+  if (options.cache_only) {
+    return Status::Incomplete("blob value is on disk");
+  }
+
+  Cache::Handle* handle = NULL;
+  Status s = FindFile(index.file_number, &handle);
+  if (!s.ok()) {
+    return s;
+  }
+
+  RandomAccessFile* file = reinterpret_cast<RandomAccessFile*>(cache_->Value(handle));
+  const size_t n = static_cast<size_t>(index.size);
+  char* buf = new char[n];
+  Slice record;
+  s = file->Read(index.offset, n, &record, buf);
+  if (s.ok() && record.size() < n) {
+    s = Status::Corruption("truncated blob record");
+  }
+  if (s.ok()) {
+    const uint32_t key_size = DecodeFixed32(record.data() + 4);
+    const uint32_t value_size = DecodeFixed32(record.data() + 8);
+    if (kBlobRecordHeaderSize + key_size + value_size != n) {
+      s = Status::Corruption("blob record size mismatch");
+    } else if (options.verify_checksums &&
+               crc32c::Unmask(DecodeFixed32(record.data())) !=
+               crc32c::Value(record.data() + 4, n - 4)) {
+      s = Status::Corruption("blob record checksum mismatch");
+    } else {
+      value->assign(record.data() + kBlobRecordHeaderSize + key_size, value_size);
+    }
+  }
+  delete[] buf;
+  cache_->Release(handle);
+  return s;
+}
+
+Status BlobFileCache::Get(const ReadOptions& options, const Slice& index, std::string* value) {
+  BlobIndex blob_index;
+  if (!blob_index.DecodeFrom(index)) {
+    return Status::Corruption("bad blob index");
+  }
+  return Get(options, blob_index, value);
+}
+
+void BlobFileCache::Evict(uint64_t file_number) {
+  char buf[sizeof(file_number)];
+  EncodeFixed64(buf, file_number);
+  cache_->Erase(Slice(buf, sizeof(buf)));
+}
+
+}  // namespace leveldb
@@ -0,0 +1,144 @@
+// Copyright (c) 2026 agent <agent@local>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Key-value separation: values not smaller than Options::blob_value_size
+// are moved out of tables into append-only blob files when memtable is
+// dumped or tables are compacted, and the entry in table keeps a BlobIndex
+// pointing to the value (type kTypeBlobIndex). Compaction then only moves
+// small indexes around. Space of dead values is reclaimed by
+// DB::CollectBlobGarbage().
+//
+// Blob file is a sequence of records:
+//    crc        fixed32   (masked crc32c of following fields)
+//    key_size   fixed32
+//    value_size fixed32
+//    user_key   char[key_size]
+//    value      char[value_size]
+
+#ifndef STORAGE_LEVELDB_DB_BLOB_FILE_H_
+#define STORAGE_LEVELDB_DB_BLOB_FILE_H_
+
+#include <string>
+#include <stdint.h>
+#include "db/dbformat.h"
+#include "leveldb/cache.h"
+#include "leveldb/env.h"
+#include "leveldb/options.h"
+#include "leveldb/slice.h"
+#include "leveldb/status.h"
+
+namespace leveldb {
+
+struct BlobFileMeta;
+
+static const size_t kBlobRecordHeaderSize = 12;
+// Head of value kept in BlobIndex, so Comparator::GetTimeMeta()
+// works without reading blob file.
+static const size_t kBlobValueHeadSize = 16;
+
+struct BlobIndex {
+  uint64_t file_number;
+  uint64_t offset;            // offset of record in blob file
+  uint64_t size;              // size of whole record
+  Slice value_head;
+
+  BlobIndex() : file_number(0), offset(0), size(0) { }
+
+  void EncodeTo(std::string* dst) const;
+  bool DecodeFrom(const Slice& input);
+};
+
+// Value of entry as Comparator::ShouldDropMaybe() and GetTimeMeta() see it:
+// value_head of BlobIndex for kTypeBlobIndex entry, else value itself.
+extern Slice EntryValueHead(ValueType type, const Slice& value);
+
+// Write records into blob file "number". File is created on first Add().
+class BlobFileBuilder {
+ public:
+  BlobFileBuilder(const std::string& dbname, const Options& options,
+                  uint64_t number, IOType io_type);
+  // Delete file if it is not finished
+  ~BlobFileBuilder();
+
+  // If internal key "*key" is a value entry whose value is large, append the
+  // value to blob file and point *key/*value to entry holding its BlobIndex.
+  // New *key/*value are backed by this builder until next call.
+  Status Separate(Slice* key, Slice* value);
+
+  // Sync and close file, fill *meta. meta->file_size is 0 if nothing is added.
+  Status Finish(BlobFileMeta* meta);
+
+  uint64_t number() const { return number_; }
+  uint64_t NumEntries() const { return entries_; }
+  uint64_t FileSize() const { return offset_; }
+
+ private:
+  Status Add(const Slice& user_key, const Slice& value, BlobIndex* index);
+
+  Env* const env_;
+  const std::string dbname_;
+  const size_t min_value_size_;
+  const uint64_t number_;
+  const IOType io_type_;
+  WritableFile* file_;
+  uint64_t offset_;
+  uint64_t entries_;
+  bool finished_;
+  std::string record_;
+  std::string key_;
+  std::string index_;
+
+  // No copying allowed
+  BlobFileBuilder(const BlobFileBuilder&);
+  void operator=(const BlobFileBuilder&);
+};
+
+// Read all records of a blob file in order.
+class BlobFileReader {
+ public:
+  explicit BlobFileReader(SequentialFile* file);
+  ~BlobFileReader();
+
+  // Read next record. Return false at the end of file or on error,
+  // which is kept in status().
+  bool Next(Slice* user_key, Slice* value, uint64_t* offset, uint64_t* size);
+  Status status() const { return status_; }
+
+ private:
+  SequentialFile* const file_;
+  uint64_t offset_;
+  Status status_;
+  std::string scratch_;
+
+  // No copying allowed
+  BlobFileReader(const BlobFileReader&);
+  void operator=(const BlobFileReader&);
+};
+
+// Cache of opened blob files. Thread-safe.
+class BlobFileCache {
+ public:
+  BlobFileCache(const std::string& dbname, const Options* options, size_t entries);
+  ~BlobFileCache();
+
+  // Read value pointed by "index" into *value.
+  Status Get(const ReadOptions& options, const BlobIndex& index, std::string* value);
+
+  // Decode "index" and read value it points to into *value.
+  Status Get(const ReadOptions& options, const Slice& index, std::string* value);
+
+  // Evict any entry for the specified file number
+  void Evict(uint64_t file_number);
+
+ private:
+  Env* const env_;
+  const std::string dbname_;
+  Cache* cache_;
+
+  Status FindFile(uint64_t file_number, Cache::Handle** handle);
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_DB_BLOB_FILE_H_
@@ -4,10 +4,12 @@
 
 #include "db/builder.h"
 
+#include "db/blob_file.h"
 #include "db/filename.h"
 #include "db/dbformat.h"
 #include "db/table_cache.h"
 #include "db/version_edit.h"
+#include "db/version_set.h"
 #include "leveldb/db.h"
 #include "leveldb/env.h"
 #include "leveldb/iterator.h"
@@ -20,33 +22,63 @@ Status BuildTable(const std::string& dbname,
                   const Comparator* user_comparator,
                   TableCache* table_cache,
                   Iterator* iter,
-                  FileMetaData* meta) {
+                  FileMetaData* meta,
+                  const Version* range_deletions,
+                  BlobFileBuilder* blob,
+                  SequenceNumber smallest_snapshot,
+                  VersionEdit* edit) {
   Status s;
   meta->file_size = 0;
+  meta->time_meta.Clear();
 
-  std::string fname = TableFileName(dbname, meta->number);
+  std::string fname = TableFileName(TablePath(options, dbname, meta->path_id), meta->number);
   if (iter->Valid()) {
     WritableFile* file;
-    s = env->NewWritableFile(fname, &file);
+    s = env->NewLimitedWritableFile(fname, &file, kIOFlush);
     if (!s.ok()) {
       return s;
     }
 
-    TableBuilder* builder = new TableBuilder(options, file);
-    meta->smallest.DecodeFrom(iter->key());
-    Slice smallest_user_key = meta->smallest.user_key();
-    for (; iter->Valid(); iter->Next()) {
+    // memtable is dumped to level-0 mostly
+    TableBuilder* builder = new TableBuilder(options, file, 0);
+    const std::string smallest_user_key = ExtractUserKey(iter->key()).ToString();
+    const bool check_range_deletion =
+      range_deletions != NULL && range_deletions->HasRangeDeletions();
+    ParsedInternalKey ikey;
+    for (; s.ok() && iter->Valid(); iter->Next()) {
       Slice key = iter->key();
-      if (user_comparator != NULL &&
+      if (config::kDoSplitMmtCompaction && user_comparator != NULL &&
           user_comparator->ShouldStopBefore(smallest_user_key, InternalKey::user_key(key))) {
         break;
       }
+      // entry covered by range deletion is dropped unless a snapshot may still see it
+      if (check_range_deletion && ParseInternalKey(key, &ikey)) {
+        const SequenceNumber covering =
+          range_deletions->RangeDeletionCovering(ikey.user_key, ikey.sequence);
+        if (covering != 0 && covering <= smallest_snapshot) {
+          continue;
+        }
+        if (covering != 0 && edit != NULL) {
+          edit->KeepRangeDeletion(covering);
+        }
+      }
+      Slice value = iter->value();
+      if (blob != NULL) {
+        s = blob->Separate(&key, &value);
+        if (!s.ok()) {
+          break;
+        }
+      }
+      if (builder->NumEntries() == 0) {
+        meta->smallest.DecodeFrom(key);
+      }
       meta->largest.DecodeFrom(key);
-      builder->Add(key, iter->value());
+      meta->time_meta.Add(user_comparator, key, value);
+      builder->Add(key, value);
     }
 
     // Finish and check for builder errors
-    if (s.ok()) {
+    if (s.ok() && builder->NumEntries() > 0) {
       s = builder->Finish();
       if (s.ok()) {
         meta->file_size = builder->FileSize();
@@ -58,7 +90,7 @@ Status BuildTable(const std::string& dbname,
     delete builder;
 
     // Finish and check for file errors
-    if (s.ok()) {
+    if (s.ok() && meta->file_size > 0) {
       s = file->Sync();
     }
     if (s.ok()) {
@@ -67,11 +99,12 @@ Status BuildTable(const std::string& dbname,
     delete file;
     file = NULL;
 
-    if (s.ok()) {
+    if (s.ok() && meta->file_size > 0) {
       // Verify that the table is usable
       Iterator* it = table_cache->NewIterator(ReadOptions(),
                                               meta->number,
-                                              meta->file_size);
+                                              meta->file_size,
+                                              meta->path_id);
       s = it->status();
       delete it;
     }
@@ -5,6 +5,7 @@
 #ifndef STORAGE_LEVELDB_DB_BUILDER_H_
 #define STORAGE_LEVELDB_DB_BUILDER_H_
 
+#include "db/dbformat.h"
 #include "leveldb/status.h"
 
 namespace leveldb {
@@ -12,9 +13,11 @@ namespace leveldb {
 struct Options;
 struct FileMetaData;
 
+class BlobFileBuilder;
 class Env;
 class Iterator;
 class TableCache;
+class Version;
 class VersionEdit;
 class Comparator;
 
@@ -23,13 +26,21 @@ class Comparator;
 // *meta will be filled with metadata about the generated table.
 // If no data is present in *iter, meta->file_size will be set to
 // zero, and no Table file will be produced.
+// Entries covered by range deletions of *range_deletions are dropped,
+// unless the deletion is newer than smallest_snapshot, then it is recorded
+// in *edit as kept (see VersionEdit::KeepRangeDeletion()).
+// Large values are moved into *blob if it is not NULL, caller finishes it.
 extern Status BuildTable(const std::string& dbname,
                          Env* env,
                          const Options& options,
                          const Comparator* user_comparator,
                          TableCache* table_cache,
                          Iterator* iter,
-                         FileMetaData* meta);
+                         FileMetaData* meta,
+                         const Version* range_deletions = NULL,
+                         BlobFileBuilder* blob = NULL,
+                         SequenceNumber smallest_snapshot = kMaxSequenceNumber,
+                         VersionEdit* edit = NULL);
 
 }  // namespace leveldb
 
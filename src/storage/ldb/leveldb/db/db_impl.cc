@@ -11,6 +11,7 @@
 #include <stdio.h>
 #include <vector>
 
+#include "db/blob_file.h"
 #include "db/builder.h"
 #include "db/db_iter.h"
 #include "db/dbformat.h"
@@ -23,9 +24,12 @@
 #include "db/write_batch_internal.h"
 #include "leveldb/db.h"
 #include "leveldb/env.h"
+#include "leveldb/pinnable_slice.h"
+#include "leveldb/rate_limiter.h"
 #include "leveldb/status.h"
 #include "leveldb/table.h"
 #include "leveldb/table_builder.h"
+#include "leveldb/write_buffer_manager.h"
 #include "port/port.h"
 #include "table/block.h"
 #include "table/merger.h"
@@ -42,14 +46,26 @@ struct DBImpl::Writer {
   WriteBatch* batch;
   bool sync;
   bool done;
+  // set by group leader when this writer should insert its own batch
+  // into "mem" concurrently (see Options::concurrent_memtable_write).
+  bool insert_mem;
+  MemTable* mem;
+  Writer* leader;
+  // blob gc or range deletion writer, always write alone
+  // (see WriteBlobRecords(), DeleteRange())
+  bool rewrite;
   port::CondVar cv;
 
-  explicit Writer(port::Mutex* mu) : cv(mu) { }
+  explicit Writer(port::Mutex* mu)
+    : insert_mem(false), mem(NULL), leader(NULL), rewrite(false), cv(mu) { }
 };
 
 struct DBImpl::CompactionState {
   Compaction* const compaction;
 
+  // Level output tables are installed into
+  int output_level;
+
   // Sequence numbers < smallest_snapshot are not significant since we
   // will never have to service a snapshot below smallest_snapshot.
   // Therefore if we have seen a sequence number S <= smallest_snapshot,
@@ -60,7 +76,9 @@ struct DBImpl::CompactionState {
   struct Output {
     uint64_t number;
     uint64_t file_size;
+    uint32_t path_id;
     InternalKey smallest, largest;
+    FileTimeMeta time_meta;
   };
   std::vector<Output> outputs;
 
@@ -70,16 +88,94 @@ struct DBImpl::CompactionState {
 
   uint64_t total_bytes;
 
+  // Blob file holding large values of all outputs, NULL if
+  // Options::blob_value_size is 0
+  BlobFileBuilder* blob;
+  BlobFileMeta blob_meta;
+  // Bytes of blob records referenced by dropped entries, per blob file
+  std::map<uint64_t, uint64_t> blob_garbage;
+
   Output* current_output() { return &outputs[outputs.size()-1]; }
 
   explicit CompactionState(Compaction* c)
       : compaction(c),
+        output_level(c->level() + 1),
         outfile(NULL),
         builder(NULL),
-        total_bytes(0) {
+        total_bytes(0),
+        blob(NULL) {
+  }
+
+  // Account blob record of a dropped entry as garbage
+  void DropEntry(const ParsedInternalKey& ikey, const Slice& value) {
+    BlobIndex index;
+    if (ikey.type == kTypeBlobIndex && index.DecodeFrom(value)) {
+      blob_garbage[index.file_number] += index.size;
+    }
+  }
+
+  // Return true if entry is covered by a range deletion every snapshot sees.
+  // Deletion newer than smallest_snapshot is recorded as kept by outputs.
+  bool RangeDeleted(const ParsedInternalKey& ikey) {
+    const SequenceNumber covering =
+      compaction->input_version()->RangeDeletionCovering(ikey.user_key, ikey.sequence);
+    if (covering > smallest_snapshot) {
+      compaction->edit()->KeepRangeDeletion(covering);
+      return false;
+    }
+    return covering != 0;
   }
 };
 
+// Records of log are inserted into memtable in chunks of at least this
+// size when Options::recover_log_threads > 1
+static const size_t kRecoverChunkMinBytes = 1 << 20;
+
+namespace {
+// Shared by threads of DBImpl::InsertLogRecords()
+struct LogRecordInserter {
+  port::Mutex mu;
+  port::CondVar cv;
+  const std::vector<std::string>* records;
+  MemTable* mem;
+  size_t next;
+  int running;
+  Status status;
+
+  LogRecordInserter() : cv(&mu), records(NULL), mem(NULL), next(0), running(0) { }
+};
+
+void InsertLogRecordWork(void* arg) {
+  // take some records each time to cut down locking
+  static const size_t kStride = 16;
+  LogRecordInserter* inserter = reinterpret_cast<LogRecordInserter*>(arg);
+  WriteBatch batch;
+  Status s;
+  inserter->mu.Lock();
+  while (inserter->next < inserter->records->size()) {
+    const size_t begin = inserter->next;
+    const size_t end = std::min(begin + kStride, inserter->records->size());
+    inserter->next = end;
+    inserter->mu.Unlock();
+    for (size_t i = begin; i < end; i++) {
+      WriteBatchInternal::SetContents(&batch, (*inserter->records)[i]);
+      Status r = WriteBatchInternal::InsertInto(&batch, inserter->mem, true);
+      if (s.ok() && !r.ok()) {
+        s = r;
+      }
+    }
+    inserter->mu.Lock();
+  }
+  if (inserter->status.ok() && !s.ok()) {
+    inserter->status = s;
+  }
+  if (--inserter->running == 0) {
+    inserter->cv.Signal();
+  }
+  inserter->mu.Unlock();
+}
+}  // namespace
+
 // Fix user-supplied options to be reasonable
 template <class T,class V>
 static void ClipToRange(T* ptr, V minvalue, V maxvalue) {
@@ -97,6 +193,8 @@ Options SanitizeOptions(const std::string& dbname,
   ClipToRange(&result.write_buffer_size,         64<<10, 1<<30);
   ClipToRange(&result.block_size,                1<<10,  4<<20);
   ClipToRange(&result.block_cache_size,          8<<20,  1<<30);
+  ClipToRange(&result.recover_log_threads,       1,      64);
+  ClipToRange(&result.preload_table_threads,     0,      64);
   if (result.info_log == NULL) {
     // Open a log file in the same directory as the db
     src.env->CreateDir(dbname);  // In case it does not exist
@@ -137,6 +235,13 @@ DBImpl::DBImpl(const Options& options, const std::string& dbname)
       logfile_number_(0),
       log_(NULL),
       tmp_batch_(new WriteBatch),
+      pending_mem_writers_(0),
+      log_sync_requested_(0),
+      log_synced_(0),
+      log_syncing_(false),
+      log_sync_cv_(&mutex_),
+      mem_reserved_(0),
+      imm_reserved_(0),
       min_snapshot_log_number_(~(uint64_t)0),
       // @@ for multi-bucket update
       imm_list_count_(0),
@@ -148,18 +253,21 @@ DBImpl::DBImpl(const Options& options, const std::string& dbname)
       has_limited_delete_obsolete_file_count_(0),
       bg_compaction_scheduled_(false),
       manual_compaction_(NULL),
-      today_start_(env_->TodayStart()) {
+      today_start_(env_->TodayStart()),
+      stats_start_micros_(env_->NowMicros()) {
   mem_->Ref();
   has_imm_.Release_Store(NULL);
+  memset(l0_history_, 0, sizeof(l0_history_));
 
   // // Reserve ten files or so for other uses and give the rest to TableCache.
   // const int table_cache_size = options.max_open_files - 10;
   // table_cache_ = new TableCache(dbname_, &options_, table_cache_size);
   // use memory charge limit for TableCache
   table_cache_ = new TableCache(dbname_, &options_, options_.table_cache_size);
+  blob_cache_ = new BlobFileCache(dbname_, &options_, options_.max_open_files);
 
   versions_ = new VersionSet(dbname_, &options_, table_cache_,
-                             &internal_comparator_);
+                             &internal_comparator_, blob_cache_);
 }
 
 DBImpl::~DBImpl() {
@@ -178,6 +286,9 @@ DBImpl::~DBImpl() {
   delete versions_;
   if (mem_ != NULL) mem_->Unref();
   if (imm_ != NULL) imm_->Unref();
+  if (options_.write_buffer_manager != NULL) {
+    options_.write_buffer_manager->FreeMem(mem_reserved_ + imm_reserved_);
+  }
   delete tmp_batch_;
   delete log_;
   //delete logfile_;
@@ -185,6 +296,7 @@ DBImpl::~DBImpl() {
     logfile_->Unref();
   }
   delete table_cache_;
+  delete blob_cache_;
 
   if (owns_info_log_) {
     delete options_.info_log;
@@ -271,6 +383,7 @@ void DBImpl::DeleteObsoleteFiles() {
           keep = (number >= versions_->ManifestFileNumber());
           break;
         case kTableFile:
+        case kBlobFile:
           keep = (live.find(number) != live.end());
           break;
         case kTempFile:
@@ -289,6 +402,8 @@ void DBImpl::DeleteObsoleteFiles() {
       if (!keep) {
         if (type == kTableFile) {
           table_cache_->Evict(number);
+        } else if (type == kBlobFile) {
+          blob_cache_->Evict(number);
         }
         Log(options_.info_log, "Delete type=%d #%lld\n",
             int(type),
@@ -301,6 +416,26 @@ void DBImpl::DeleteObsoleteFiles() {
       }
     }
   }
+
+  // table files under other paths
+  for (size_t p = 0; p < options_.db_paths.size(); p++) {
+    const std::string& path = options_.db_paths[p].path;
+    if (path == dbname_) {
+      continue;
+    }
+    filenames.clear();
+    env_->GetChildren(path, &filenames);
+    for (size_t i = 0; i < filenames.size(); i++) {
+      if (ParseFileName(filenames[i], &number, &type) &&
+          type == kTableFile && live.find(number) == live.end()) {
+        table_cache_->Evict(number);
+        Log(options_.info_log, "Delete type=%d #%lld in path %d\n",
+            int(type),
+            static_cast<unsigned long long>(number), static_cast<int>(p));
+        env_->DeleteFile(path + "/" + filenames[i]);
+      }
+    }
+  }
   PROFILER_END();
 }
 
@@ -330,6 +465,9 @@ Status DBImpl::Recover(VersionEdit* edit) {
   // may already exist from a previous failed creation attempt.
   env_->CreateDir(dbname_);
   env_->CreateDir(dblog_dir_);
+  for (size_t i = 0; i < options_.db_paths.size(); i++) {
+    env_->CreateDir(options_.db_paths[i].path);
+  }
   assert(db_lock_ == NULL);
   Status s = env_->LockFile(LockFileName(dbname_), &db_lock_);
   if (!s.ok()) {
@@ -353,7 +491,13 @@ Status DBImpl::Recover(VersionEdit* edit) {
     }
   }
 
+  uint64_t start_us = env_->NowMicros();
   s = versions_->Recover();
+  if (s.ok()) {
+    s = versions_->CheckPaths();
+  }
+  Log(options_.info_log, "Recover manifest cost %llu us",
+      (unsigned long long) (env_->NowMicros() - start_us));
   if (s.ok()) {
     SequenceNumber max_sequence(0);
 
@@ -388,6 +532,7 @@ Status DBImpl::Recover(VersionEdit* edit) {
 
     // Recover in the order in which the logs were generated
     std::sort(logs.begin(), logs.end());
+    start_us = env_->NowMicros();
     for (size_t i = 0; i < logs.size(); i++) {
       s = RecoverLogFile(logs[i], edit, &max_sequence);
 
@@ -396,6 +541,9 @@ Status DBImpl::Recover(VersionEdit* edit) {
       // update the file number allocation counter in VersionSet.
       versions_->MarkFileNumberUsed(logs[i]);
     }
+    Log(options_.info_log, "Recover %d logs with %d threads cost %llu us",
+        static_cast<int>(logs.size()), options_.recover_log_threads,
+        (unsigned long long) (env_->NowMicros() - start_us));
 
     if (s.ok()) {
       if (versions_->LastSequence() < max_sequence) {
@@ -407,6 +555,27 @@ Status DBImpl::Recover(VersionEdit* edit) {
   return s;
 }
 
+// Entries of all records have distinct sequence, so they can be inserted
+// into memtable in any order.
+Status DBImpl::InsertLogRecords(const std::vector<std::string>& records,
+                                MemTable* mem, int threads) {
+  LogRecordInserter inserter;
+  inserter.records = &records;
+  inserter.mem = mem;
+  // calling thread is one of the workers
+  inserter.running = threads;
+  for (int i = 1; i < threads; i++) {
+    env_->StartThread(&InsertLogRecordWork, &inserter);
+  }
+  InsertLogRecordWork(&inserter);
+  inserter.mu.Lock();
+  while (inserter.running > 0) {
+    inserter.cv.Wait();
+  }
+  inserter.mu.Unlock();
+  return inserter.status;
+}
+
 Status DBImpl::RecoverLogFile(uint64_t log_number,
                               VersionEdit* edit,
                               SequenceNumber* max_sequence) {
@@ -458,7 +627,13 @@ Status DBImpl::RecoverLogFile(uint64_t log_number,
   Log(options_.info_log, "Recovering log #%llu",
       (unsigned long long) log_number);
 
-  // Read all the records and add to a memtable
+  // Read all the records and add to a memtable.
+  // With recover_log_threads > 1, records are collected into chunk and
+  // inserted by several threads, memtable is checked between chunks.
+  const int threads = options_.recover_log_threads;
+  const size_t max_chunk_bytes = std::max(options_.write_buffer_size / 4, kRecoverChunkMinBytes);
+  std::vector<std::string> chunk;
+  size_t chunk_bytes = 0;
   std::string scratch;
   Slice record;
   WriteBatch batch;
@@ -471,19 +646,33 @@ Status DBImpl::RecoverLogFile(uint64_t log_number,
       continue;
     }
     WriteBatchInternal::SetContents(&batch, record);
+    const SequenceNumber last_seq =
+        WriteBatchInternal::Sequence(&batch) +
+        WriteBatchInternal::Count(&batch) - 1;
 
     if (mem == NULL) {
       mem = new MemTable(internal_comparator_, env_);
       mem->Ref();
     }
-    status = WriteBatchInternal::InsertInto(&batch, mem);
+    if (threads > 1) {
+      chunk.push_back(record.ToString());
+      chunk_bytes += record.size();
+      if (chunk_bytes < max_chunk_bytes) {
+        if (last_seq > *max_sequence) {
+          *max_sequence = last_seq;
+        }
+        continue;
+      }
+      status = InsertLogRecords(chunk, mem, threads);
+      chunk.clear();
+      chunk_bytes = 0;
+    } else {
+      status = WriteBatchInternal::InsertInto(&batch, mem);
+    }
     MaybeIgnoreError(&status);
     if (!status.ok()) {
       break;
     }
-    const SequenceNumber last_seq =
-        WriteBatchInternal::Sequence(&batch) +
-        WriteBatchInternal::Count(&batch) - 1;
     if (last_seq > *max_sequence) {
       *max_sequence = last_seq;
     }
@@ -500,6 +689,11 @@ Status DBImpl::RecoverLogFile(uint64_t log_number,
     }
   }
 
+  if (status.ok() && !chunk.empty()) {
+    status = InsertLogRecords(chunk, mem, threads);
+    MaybeIgnoreError(&status);
+  }
+
   if (status.ok() && mem != NULL) {
     status = WriteLevel0Table(mem, edit, NULL);
     // Reflect errors immediately so that conditions like full
@@ -519,23 +713,41 @@ Status DBImpl::RecoverLogFile(uint64_t log_number,
 // actually WriteLevel0Table() can be run by only one thread(compaction-thread)
 // and its mutlti-thread write-action(versionset::NewFileNumber()/table_cache_) is all thread-safe now,
 // so no mutex here.
+SequenceNumber DBImpl::SmallestSnapshot() {
+  mutex_.AssertHeld();
+  return snapshots_.empty() ? versions_->LastSequence() : snapshots_.oldest()->number_;
+}
+
 Status DBImpl::WriteLevel0Table(MemTable* mem, VersionEdit* edit,
-                                Version* base) {
+                                Version* base, SequenceNumber smallest_snapshot) {
+  if (base != NULL) {
+    edit->SetRangeDeletionBase(base->LastRangeDeletionSequence());
+  }
   Iterator* iter = mem->NewIterator();
   iter->SeekToFirst();
   Status s;
+  // large values of all tables go into one blob file
+  BlobFileBuilder* blob = NULL;
+  if (options_.blob_value_size > 0) {
+    const uint64_t blob_number = versions_->NewFileNumber();
+    pending_outputs_.insert(blob_number);
+    blob = new BlobFileBuilder(dbname_, options_, blob_number, kIOFlush);
+  }
   while (iter->Valid() && s.ok()) {
     const uint64_t start_micros = env_->NowMicros();
     FileMetaData meta;
     meta.number = versions_->NewFileNumber();
+    meta.path_id = versions_->PathIdForLevel(0);
     pending_outputs_.insert(meta.number);
     Log(options_.info_log, "Level-0 table #%llu: started",
         (unsigned long long) meta.number);
 
     {
       PROFILER_BEGIN("buildtab-");
-      s = BuildTable(dbname_, env_, options_, config::kDoSplitMmtCompaction ? user_comparator() : NULL,
-                     table_cache_, iter, &meta);
+      s = BuildTable(dbname_, env_, options_, user_comparator(),
+                     table_cache_, iter, &meta,
+                     base != NULL ? base : versions_->current(), blob,
+                     smallest_snapshot, edit);
       PROFILER_END();
     }
 
@@ -558,16 +770,34 @@ Status DBImpl::WriteLevel0Table(MemTable* mem, VersionEdit* edit,
         PROFILER_END();
       }
       edit->AddFile(level, meta.number, meta.file_size,
-                    meta.smallest, meta.largest);
+                    meta.smallest, meta.largest, meta.time_meta, meta.path_id);
     }
 
     CompactionStats stats;
+    stats.count = meta.file_size > 0 ? 1 : 0;
     stats.micros = env_->NowMicros() - start_micros;
     stats.bytes_written = meta.file_size;
-    stats_[level].Add(stats);
+    flush_stats_.Add(stats);
   }
   delete iter;
 
+  if (blob != NULL) {
+    BlobFileMeta blob_meta;
+    if (s.ok()) {
+      s = blob->Finish(&blob_meta);
+    }
+    if (s.ok() && blob_meta.file_size > 0) {
+      Log(options_.info_log, "Blob file #%llu: %llu values %llu bytes",
+          (unsigned long long) blob_meta.number,
+          (unsigned long long) blob_meta.entries,
+          (unsigned long long) blob_meta.file_size);
+      edit->AddBlobFile(blob_meta);
+      flush_stats_.bytes_written += blob_meta.file_size;
+    }
+    pending_outputs_.erase(blob->number());
+    delete blob;
+  }
+
   return s;
 }
 
@@ -589,9 +819,10 @@ Status DBImpl::CompactMemTable(bool compact_mlist) {
   // Save the contents of the memtable as a new Table
   Version* base = versions_->current();
   base->Ref();
+  const SequenceNumber smallest_snapshot = SmallestSnapshot();
   mutex_.Unlock();
   PROFILER_BEGIN("wL0Tab+");
-  s = WriteLevel0Table(imm_, &edit, base);
+  s = WriteLevel0Table(imm_, &edit, base, smallest_snapshot);
   PROFILER_END();
   mutex_.Lock();
   base->Unref();
@@ -617,6 +848,10 @@ Status DBImpl::CompactMemTable(bool compact_mlist) {
     imm_->Unref();
     imm_ = NULL;
     has_imm_.Release_Store(NULL);
+    if (options_.write_buffer_manager != NULL) {
+      options_.write_buffer_manager->FreeMem(imm_reserved_);
+    }
+    imm_reserved_ = 0;
     mutex_.Unlock();
     // do not DeleteObsoleteFiles() here
     // DeleteObsoleteFiles();
@@ -676,6 +911,7 @@ void DBImpl::TEST_CompactRange(int level, const Slice* begin,const Slice* end) {
   ManualCompaction manual;
   manual.level = level;
   manual.done = false;
+  manual.bg_compaction_func = &DBImpl::BackgroundCompaction;
   if (begin == NULL) {
     manual.begin = NULL;
   } else {
@@ -792,6 +1028,7 @@ Status DBImpl::MakeRoomForWrite(bool force, int bucket, BucketUpdate** bucket_up
   }
 
   if (ShouldLimitWrite((config::kL0_SlowdownWritesTrigger * 2) / 3)) {
+    RecordStall(kStallReject, 0);
     return Status::SlowWrite("too many L0 sst");
   }
 
@@ -837,14 +1074,17 @@ Status DBImpl::MakeRoomForWrite(bool force, int bucket, BucketUpdate** bucket_up
 
     MaybeScheduleCompaction();
 
+    const uint64_t stall_start = env_->NowMicros();
     mutex_.Unlock();
     env_->SleepForMicroseconds(10000);
     mutex_.Lock();
+    RecordStall(kStallMemTableCount, stall_start);
     Log(options_.info_log, "wait for less mmt. now %zd + %d", bucket_map_.size(), imm_list_count_);
   }
 
   // can't get space for new memtable
   if (retry > kRetryCount) {
+    RecordStall(kStallReject, 0);
     return Status::SlowWrite("too many mmt");
   }
 
@@ -936,15 +1176,17 @@ Status DBImpl::CompactMemTableList() {
     }
 
     Version* base;
+    SequenceNumber smallest_snapshot;
     {
       MutexLock l(&mutex_);
       base = versions_->current();
       base->Ref();
+      smallest_snapshot = SmallestSnapshot();
     }
 
     VersionEdit edit;
     BucketUpdate* bu = *imms[count];
-    s = WriteLevel0Table(bu->mem_, &edit, base);
+    s = WriteLevel0Table(bu->mem_, &edit, base, smallest_snapshot);
     if (!s.ok()) {
       break;
     }
@@ -1024,6 +1266,11 @@ Status DBImpl::CompactRangeSelfLevel(
   for (int level = 0; level < config::kNumLevels && manual.compaction_status.ok(); ++level) {
     ManualCompaction each_manual = manual;
     each_manual.level = level;
+    if (level == 0) {
+      // level-0 is dumped by memtable, apply no filter, so ignore filenumber limit,
+      // but files output by this compaction are not picked again.
+      each_manual.limit_filenumber = versions_->NextFileNumber();
+    }
     while (each_manual.compaction_status.ok() && !each_manual.done) {
       // still have other compaction running
       while (bg_compaction_scheduled_) {
@@ -1050,9 +1297,7 @@ void DBImpl::BackgroundCompactionSelfLevel() {
   ManualCompaction* m = manual_compaction_;
   Status status;
   do {
-    // level-0 is dumped by memtable, apply no filter, so ignore filenumber limit
-    c = versions_->
-      CompactRangeOneLevel(m->level, m->level > 0 ? m->limit_filenumber : ~(static_cast<uint64_t>(0)), m->begin, m->end);
+    c = versions_->CompactRangeOneLevel(m->level, m->limit_filenumber, m->begin, m->end);
     if (NULL == c) {            // no compact for this level
       Log(options_.info_log, "need no selfcom in level: %d\n", m->level);
       m->done = true;           // done all.
@@ -1068,6 +1313,7 @@ void DBImpl::BackgroundCompactionSelfLevel() {
 #endif
 
     CompactionState* compact = new CompactionState(c);
+    compact->output_level = c->level();
     status = DoCompactionWorkSelfLevel(compact);
     CleanupCompaction(compact);
     c->ReleaseInputs();
@@ -1112,11 +1358,11 @@ Status DBImpl::DoCompactionWorkSelfLevel(CompactionState* compact) {
   assert(compact->outfile == NULL);
 
   // consider snapshot here, but ShouldDrop() ignore it.
-  if (snapshots_.empty()) {
-    compact->smallest_snapshot = versions_->LastSequence();
-  } else {
-    compact->smallest_snapshot = snapshots_.oldest()->number_;
+  {
+    MutexLock l(&mutex_);
+    compact->smallest_snapshot = SmallestSnapshot();
   }
+  OpenCompactionBlobFile(compact);
 
   Iterator* input = versions_->MakeInputIterator(compact->compaction);
   input->SeekToFirst();
@@ -1125,6 +1371,7 @@ Status DBImpl::DoCompactionWorkSelfLevel(CompactionState* compact) {
   std::string current_user_key;
   bool has_current_user_key = false;
   SequenceNumber last_sequence_for_key = kMaxSequenceNumber;
+  const bool range_deletion = compact->compaction->input_version()->HasRangeDeletions();
 
   for (; input->Valid() && !shutting_down_.Acquire_Load(); ) {
     // Prioritize immutable compaction work
@@ -1171,6 +1418,9 @@ Status DBImpl::DoCompactionWorkSelfLevel(CompactionState* compact) {
       } else if (user_comparator()->ShouldDrop(ikey.user_key.data(), ikey.sequence, 1 /* will gc */)) {
         // user-defined should drop, no matter what conditon.
         drop = true;
+      } else if (range_deletion && compact->RangeDeleted(ikey)) {
+        // covered by range deletion no snapshot can see
+        drop = true;
       }
 
       last_sequence_for_key = ikey.sequence;
@@ -1185,7 +1435,9 @@ Status DBImpl::DoCompactionWorkSelfLevel(CompactionState* compact) {
         (int)last_sequence_for_key, (int)compact->smallest_snapshot);
 #endif
 
-    if (!drop) {
+    if (drop) {
+      compact->DropEntry(ikey, input->value());
+    } else {
       // Open output file if necessary
       if (compact->builder == NULL) {
         status = OpenCompactionOutputFile(compact);
@@ -1193,11 +1445,19 @@ Status DBImpl::DoCompactionWorkSelfLevel(CompactionState* compact) {
           break;
         }
       }
+      Slice value = input->value();
+      if (compact->blob != NULL) {
+        status = compact->blob->Separate(&key, &value);
+        if (!status.ok()) {
+          break;
+        }
+      }
       if (compact->builder->NumEntries() == 0) {
         compact->current_output()->smallest.DecodeFrom(key);
       }
       compact->current_output()->largest.DecodeFrom(key);
-      compact->builder->Add(key, input->value());
+      compact->current_output()->time_meta.Add(user_comparator(), key, value);
+      compact->builder->Add(key, value);
 
       // Close output file if it is big enough
       if (compact->builder->FileSize() >=
@@ -1221,10 +1481,14 @@ Status DBImpl::DoCompactionWorkSelfLevel(CompactionState* compact) {
   if (status.ok()) {
     status = input->status();
   }
+  if (status.ok()) {
+    status = FinishCompactionBlobFile(compact);
+  }
   delete input;
   input = NULL;
 
   CompactionStats stats;
+  stats.count = 1;
   stats.micros = env_->NowMicros() - start_micros - imm_micros;
   // only one level
   for (int i = 0; i < compact->compaction->num_input_files(0); i++) {
@@ -1234,6 +1498,7 @@ Status DBImpl::DoCompactionWorkSelfLevel(CompactionState* compact) {
   for (size_t i = 0; i < compact->outputs.size(); i++) {
     stats.bytes_written += compact->outputs[i].file_size;
   }
+  stats.bytes_written += compact->blob_meta.file_size;
 
   // stat add this level
   stats_[compact->compaction->level()].Add(stats);
@@ -1254,146 +1519,1286 @@ Status DBImpl::DoCompactionWorkSelfLevel(CompactionState* compact) {
   return status;
 }
 
-//////////////////////////////////////////
-// special write to support multi-bucket update
-//////////////////////////////////////////
-
-
-//////////////////////////////////////////////////
-
-void DBImpl::MaybeScheduleCompaction() {
+Status DBImpl::RunManualCompaction(ManualCompaction* manual) {
   mutex_.AssertHeld();
-  if (bg_compaction_scheduled_) {
-    Log(options_.info_log, "com running");
-    // Already scheduled
-  } else if (shutting_down_.Acquire_Load()) {
-    // DB is being deleted; no more background compactions
-  } else if (imm_ == NULL &&
-             imm_list_.empty() && // @@ imm list
-             manual_compaction_ == NULL &&
-             !versions_->NeedsCompaction()) {
-    Log(options_.info_log, "need no com");
-    // No work to be done
-  } else {
-    bg_compaction_scheduled_ = true;
-    env_->Schedule(&DBImpl::BGWork, this);
+  // avoid to miss bg_cv's signal() occasionally, use TimedCond() here
+  int64_t timed_us = 1000000;   // 1s
+  while (manual->compaction_status.ok() && !manual->done) {
+    // still have other compaction running
+    while (bg_compaction_scheduled_ || manual_compaction_ != NULL) {
+      bg_cv_.TimedWait(timed_us);
+    }
+    manual_compaction_ = manual;
+    MaybeScheduleCompaction();
+    if (!bg_compaction_scheduled_) {
+      // shutting down, no background compaction will run
+      manual_compaction_ = NULL;
+      manual->compaction_status = Status::IOError("Deleting DB during manual compaction");
+      break;
+    }
+    while (manual_compaction_ == manual) {
+      bg_cv_.TimedWait(timed_us);
+    }
   }
+  return manual->compaction_status;
 }
 
-void DBImpl::BGWork(void* db) {
-  reinterpret_cast<DBImpl*>(db)->BackgroundCall();
-}
+// Drop files whose entries have all expired. Deleting file with VersionEdit
+// must be done in background thread(files may be compaction inputs),
+// so run it as a manual compaction.
+Status DBImpl::DeleteExpiredFiles(uint64_t* deleted_size) {
+  ManualCompaction manual;
+  manual.level = 0;
+  manual.done = false;
+  manual.begin = NULL;
+  manual.end = NULL;
+  manual.reschedule = false;    // only run once
+  manual.bg_compaction_func = &DBImpl::BackgroundDeleteExpiredFiles;
 
-void DBImpl::BackgroundCall() {
-  PROFILER_START("compact start");
-  PROFILER_BEGIN("mutex");
   MutexLock l(&mutex_);
-  PROFILER_END();
+  Status s = RunManualCompaction(&manual);
+  if (deleted_size != NULL) {
+    *deleted_size = manual.result_size;
+  }
+  return s;
+}
+
+void DBImpl::BackgroundDeleteExpiredFiles() {
   assert(bg_compaction_scheduled_);
-  if (!shutting_down_.Acquire_Load()) {
-    if (manual_compaction_ != NULL) {
-      mutex_.Unlock();
-      (this->*manual_compaction_->bg_compaction_func)(); // use user-defined compaction function
-      mutex_.Lock();
+  assert(manual_compaction_ != NULL); // this must be a manual compaction
+
+  ManualCompaction* m = manual_compaction_;
+  mutex_.Lock();
+  Version* current = versions_->current();
+  current->Ref();
+  mutex_.Unlock();
+
+  VersionEdit edit;
+  current->LoadTimeMeta(&mutex_);
+  const uint32_t now = env_->NowSecs();
+  const int count = current->PickExpiredFiles(now, &edit, &m->result_size);
+
+  mutex_.Lock();
+  current->Unref();
+  mutex_.Unlock();
+
+  if (count > 0) {
+    Status status = versions_->LogAndApply(&edit, &mutex_);
+    VersionSet::LevelSummaryStorage tmp;
+    Log(options_.info_log, "Deleted %d expired files, %lld bytes %s: %s\n",
+        count,
+        static_cast<unsigned long long>(m->result_size),
+        status.ToString().c_str(),
+        versions_->LevelSummary(&tmp));
+    if (status.ok()) {
+      DeleteObsoleteFiles();
     } else {
-      PROFILER_BEGIN("do com+");
-      mutex_.Unlock();
-      BackgroundCompaction();   // use default compaction
-      mutex_.Lock();
-      PROFILER_END();
+      m->result_size = 0;
+      m->compaction_status = status;
     }
   }
 
-  bool reschedule = manual_compaction_ != NULL ? manual_compaction_->reschedule : true;
-  bg_compaction_scheduled_ = false;
+  m->done = true;
+  // Mark it as done
+  manual_compaction_ = NULL;
+}
 
-  // Previous compaction may have produced too many files in a level,
-  // so reschedule another compaction if needed.
-  if (reschedule) {
-    PROFILER_BEGIN("maybesche+");
-    MaybeScheduleCompaction();
-    PROFILER_END();
+namespace {
+struct DeleteFilesInRangeArg {
+  uint64_t limit_filenumber;
+  Slice begin;
+  Slice end;
+};
+}  // namespace
+
+Status DBImpl::DeleteFilesInRange(uint64_t limit_filenumber, const Slice& begin, const Slice& end,
+                                  uint64_t* deleted_size) {
+  DeleteFilesInRangeArg arg;
+  arg.limit_filenumber = limit_filenumber;
+  arg.begin = begin;
+  arg.end = end;
+
+  ManualCompaction manual;
+  manual.level = 0;
+  manual.done = false;
+  manual.begin = NULL;
+  manual.end = NULL;
+  manual.reschedule = false;    // only run once
+  manual.bg_compaction_func = &DBImpl::BackgroundDeleteFilesInRange;
+  manual.arg = &arg;
+
+  MutexLock l(&mutex_);
+  Status s = RunManualCompaction(&manual);
+  if (deleted_size != NULL) {
+    *deleted_size = manual.result_size;
   }
-  bg_cv_.SignalAll();
-  PROFILER_DUMP();
-  PROFILER_STOP();
+  return s;
 }
 
-void DBImpl::BackgroundCompaction() {
-  if (imm_ != NULL || !imm_list_.empty()) {
-    const uint64_t imm_start = env_->NowMicros();
-    Log(options_.info_log, "only com mem");
-    PROFILER_BEGIN("com mem+");
-    CompactMemTable();
-    PROFILER_END();
-    Log(options_.info_log, "only com mem cost %ld", env_->NowMicros() - imm_start);
-    return;
-  }
+void DBImpl::BackgroundDeleteFilesInRange() {
+  assert(bg_compaction_scheduled_);
+  assert(manual_compaction_ != NULL); // this must be a manual compaction
 
-  Compaction* c;
-  bool is_manual = (manual_compaction_ != NULL);
-  InternalKey manual_end;
-  if (is_manual) {
-    ManualCompaction* m = manual_compaction_;
-    c = versions_->CompactRange(m->level, m->begin, m->end);
-    m->done = (c == NULL);
-    if (c != NULL) {
-      manual_end = c->input(0, c->num_input_files(0) - 1)->largest;
-    }
-    Log(options_.info_log,
-        "Manual compaction at level-%d from %s .. %s; will stop at %s\n",
-        m->level,
-        (m->begin ? m->begin->DebugString().c_str() : "(begin)"),
-        (m->end ? m->end->DebugString().c_str() : "(end)"),
-        (m->done ? "(end)" : manual_end.DebugString().c_str()));
-  } else {
-    PROFILER_BEGIN("pickcom+");
-    c = versions_->PickCompaction();
-    PROFILER_END();
-  }
+  ManualCompaction* m = manual_compaction_;
+  DeleteFilesInRangeArg* arg = reinterpret_cast<DeleteFilesInRangeArg*>(m->arg);
+  mutex_.Lock();
+  Version* current = versions_->current();
+  current->Ref();
+  mutex_.Unlock();
 
-  Status status;
-  if (c == NULL) {
-    // Nothing to do
-  } else if (!is_manual && c->IsTrivialMove()) {
-    // Move file to next level
-    assert(c->num_input_files(0) == 1);
-    FileMetaData* f = c->input(0, 0);
-    c->edit()->DeleteFile(c->level(), f->number);
-    c->edit()->AddFile(c->level() + 1, f->number, f->file_size,
-                       f->smallest, f->largest);
-    PROFILER_BEGIN("com move lAa+");
-    status = versions_->LogAndApply(c->edit(), &mutex_);
-    PROFILER_END();
+  VersionEdit edit;
+  const int count = current->PickFilesInRange(arg->limit_filenumber, arg->begin, arg->end,
+                                              &edit, &m->result_size);
+
+  mutex_.Lock();
+  current->Unref();
+  mutex_.Unlock();
+
+  if (count > 0) {
+    Status status = versions_->LogAndApply(&edit, &mutex_);
     VersionSet::LevelSummaryStorage tmp;
-    Log(options_.info_log, "Moved #%lld to level-%d %lld bytes %s: %s\n",
-        static_cast<unsigned long long>(f->number),
-        c->level() + 1,
-        static_cast<unsigned long long>(f->file_size),
+    Log(options_.info_log, "Deleted %d files in range, %lld bytes %s: %s\n",
+        count,
+        static_cast<unsigned long long>(m->result_size),
         status.ToString().c_str(),
         versions_->LevelSummary(&tmp));
-  } else {
-    CompactionState* compact = new CompactionState(c);
-    PROFILER_BEGIN("do com work+");
-    status = DoCompactionWork(compact);
-    PROFILER_END();
-    PROFILER_BEGIN("cleanupcom+");
-    CleanupCompaction(compact);
-    PROFILER_END();
-    c->ReleaseInputs();
-    PROFILER_BEGIN("del obsofile+");
-    DeleteObsoleteFiles();
-    PROFILER_END();
+    if (status.ok()) {
+      DeleteObsoleteFiles();
+    } else {
+      m->result_size = 0;
+      m->compaction_status = status;
+    }
   }
-  delete c;
 
-  if (status.ok()) {
-    // Done
-  } else if (shutting_down_.Acquire_Load()) {
-    // Ignore compaction errors found during shutting down
-  } else {
-    Log(options_.info_log,
-        "Compaction error: %s", status.ToString().c_str());
+  m->done = true;
+  // Mark it as done
+  manual_compaction_ = NULL;
+}
+
+// Compact the file with most expired data into next level, where
+// expired entries are dropped if there is no older data in deeper levels.
+Status DBImpl::CompactExpiredFile(uint64_t min_expired_size, uint64_t* expired_size) {
+  *expired_size = 0;
+  std::string smallest_user_key, largest_user_key;
+  int level = 0;
+  uint64_t size = 0;
+  {
+    MutexLock l(&mutex_);
+    Version* current = versions_->current();
+    current->Ref();
+    mutex_.Unlock();
+    current->LoadTimeMeta(&mutex_);
+    mutex_.Lock();
+    current->Unref();
+    current = versions_->current();
+    FileMetaData* f = current->PickMostExpiredFile(env_->NowSecs(), &level, &size);
+    if (f == NULL || size < min_expired_size) {
+      return Status::OK();
+    }
+    smallest_user_key = f->smallest.user_key().ToString();
+    largest_user_key = f->largest.user_key().ToString();
+    Log(options_.info_log, "Compact expired file #%llu@%d, %lld bytes, expired %lld bytes\n",
+        static_cast<unsigned long long>(f->number), level,
+        static_cast<unsigned long long>(f->file_size),
+        static_cast<unsigned long long>(size));
+  }
+
+  InternalKey begin_storage(smallest_user_key, kMaxSequenceNumber, kValueTypeForSeek);
+  InternalKey end_storage(largest_user_key, 0, static_cast<ValueType>(0));
+  ManualCompaction manual;
+  manual.level = level;
+  manual.done = false;
+  manual.begin = &begin_storage;
+  manual.end = &end_storage;
+  manual.bg_compaction_func = &DBImpl::BackgroundCompaction;
+
+  MutexLock l(&mutex_);
+  Status s = RunManualCompaction(&manual);
+  if (s.ok()) {
+    *expired_size = size;
+  }
+  return s;
+}
+
+Status DBImpl::ExportTables(const ReadOptions& options, const Slice& begin, const Slice& end,
+                            const std::string& dir, std::vector<std::string>* files) {
+  env_->CreateDir(dir);         // Ignore error from CreateDir since it may exist
+
+  Status s;
+  uint64_t file_number = 0;
+  uint64_t total_size = 0;
+  WritableFile* file = NULL;
+  TableBuilder* builder = NULL;
+  // exported entries are seen as oldest ones, ingesting db will renew them.
+  std::string ikey;
+  Iterator* iter = NewIterator(options);
+  for (iter->Seek(begin); iter->Valid(); iter->Next()) {
+    if (!end.empty() && user_comparator()->Compare(iter->key(), end) >= 0) {
+      break;
+    }
+    if (builder == NULL) {
+      std::string fname = TableFileName(dir, ++file_number);
+      s = env_->NewLimitedWritableFile(fname, &file, kIOScan);
+      if (!s.ok()) {
+        break;
+      }
+      files->push_back(fname);
+      builder = new TableBuilder(options_, file);
+    }
+    ikey.clear();
+    AppendInternalKey(&ikey, ParsedInternalKey(iter->key(), 0, kTypeValue));
+    builder->Add(ikey, iter->value());
+
+    if (builder->FileSize() >= static_cast<uint64_t>(config::kTargetFileSize)) {
+      s = builder->Finish();
+      total_size += builder->FileSize();
+      delete builder;
+      builder = NULL;
+      if (s.ok()) {
+        s = file->Sync();
+      }
+      if (s.ok()) {
+        s = file->Close();
+      }
+      delete file;
+      file = NULL;
+      if (!s.ok()) {
+        break;
+      }
+    }
+  }
+  if (s.ok()) {
+    s = iter->status();
+  }
+  delete iter;
+
+  if (builder != NULL) {
+    if (s.ok()) {
+      s = builder->Finish();
+      total_size += builder->FileSize();
+    } else {
+      builder->Abandon();
+    }
+    delete builder;
+    if (s.ok()) {
+      s = file->Sync();
+    }
+    if (s.ok()) {
+      s = file->Close();
+    }
+    delete file;
+  }
+
+  Log(options_.info_log, "Export %d tables to %s, %lld bytes: %s",
+      static_cast<int>(files->size()), dir.c_str(),
+      static_cast<unsigned long long>(total_size), s.ToString().c_str());
+  return s;
+}
+
+// Range deletion is recorded in VersionEdit, so it takes effect at once
+// without writing every covered key. It is installed at the front of writer
+// queue like a write (see WriteBlobRecords()), so it is newer than all
+// entries written before and older than all written after, and it waits for
+// no compaction. Flush or compaction running meanwhile does not see it,
+// its output files get the deletion again when they are installed
+// (see VersionSet::RestampRangeDeletions()).
+Status DBImpl::DeleteRange(const WriteOptions& options, const Slice& begin, const Slice& end) {
+  if (user_comparator()->Compare(begin, end) >= 0) {
+    return Status::InvalidArgument("empty range to delete");
+  }
+  Writer w(&mutex_);
+  w.batch = NULL;
+  w.sync = true;
+  w.done = false;
+  w.rewrite = true;
+
+  MutexLock l(&mutex_);
+  writers_.push_back(&w);
+  // no group takes in rewrite writer (see BuildBatchGroup())
+  while (&w != writers_.front()) {
+    w.cv.Wait();
+  }
+
+  Status status = bg_error_;
+  if (status.ok()) {
+    // entries written before are covered, files created after hold none of them.
+    RangeDeletion deletion;
+    deletion.begin = begin.ToString();
+    deletion.end = end.ToString();
+    deletion.sequence = versions_->LastSequence() + 1;
+    deletion.file_number = versions_->NewFileNumber();
+    VersionEdit edit;
+    edit.AddRangeDeletion(deletion);
+    mutex_.Unlock();
+    status = versions_->LogAndApply(&edit, &mutex_);
+    mutex_.Lock();
+    // visible to snapshots taken from now on
+    if (status.ok() && versions_->LastSequence() < deletion.sequence) {
+      versions_->SetLastSequence(deletion.sequence);
+    }
+    Log(options_.info_log, "Delete range [%s, %s) @%llu #%llu: %s\n",
+        EscapeString(deletion.begin).c_str(), EscapeString(deletion.end).c_str(),
+        static_cast<unsigned long long>(deletion.sequence),
+        static_cast<unsigned long long>(deletion.file_number),
+        status.ToString().c_str());
+  }
+
+  writers_.pop_front();
+  if (!writers_.empty()) {
+    writers_.front()->cv.Signal();
+  }
+  return status;
+}
+
+// Covered entries are dropped when files holding them are rewritten,
+// then the range deletion is useless and removed.
+Status DBImpl::CompactRangeDeletions(int* remaining) {
+  std::vector<RangeDeletion> deletions;
+  {
+    MutexLock l(&mutex_);
+    Version* current = versions_->current();
+    for (size_t i = 0; i < current->RangeDeletions().size(); i++) {
+      if (current->RangeDeletionInFiles(current->RangeDeletions()[i])) {
+        deletions.push_back(current->RangeDeletions()[i]);
+      }
+    }
+  }
+
+  Status s;
+  for (size_t i = 0; s.ok() && i < deletions.size() && !shutting_down_.Acquire_Load(); i++) {
+    const Slice begin(deletions[i].begin), end(deletions[i].end);
+    s = CompactRangeSelfLevel(deletions[i].file_number, &begin, &end);
+  }
+
+  if (s.ok()) {
+    ManualCompaction manual;
+    manual.level = 0;
+    manual.done = false;
+    manual.begin = NULL;
+    manual.end = NULL;
+    manual.reschedule = false;    // only run once
+    manual.bg_compaction_func = &DBImpl::BackgroundRemoveRangeDeletions;
+
+    MutexLock l(&mutex_);
+    s = RunManualCompaction(&manual);
+    if (remaining != NULL) {
+      *remaining = versions_->current()->RangeDeletions().size();
+    }
+  }
+  return s;
+}
+
+void DBImpl::BackgroundRemoveRangeDeletions() {
+  assert(bg_compaction_scheduled_);
+  assert(manual_compaction_ != NULL); // this must be a manual compaction
+
+  ManualCompaction* m = manual_compaction_;
+  VersionEdit edit;
+  int count = 0;
+  mutex_.Lock();
+  Version* current = versions_->current();
+  for (size_t i = 0; i < current->RangeDeletions().size(); i++) {
+    const RangeDeletion& d = current->RangeDeletions()[i];
+    if (!RangeDeletionInMemTable(d) && !current->RangeDeletionInFiles(d)) {
+      edit.RemoveRangeDeletion(d.sequence);
+      ++count;
+    }
+  }
+  mutex_.Unlock();
+
+  if (count > 0) {
+    Status status = versions_->LogAndApply(&edit, &mutex_);
+    Log(options_.info_log, "Removed %d range deletions: %s\n",
+        count, status.ToString().c_str());
+    if (!status.ok()) {
+      m->compaction_status = status;
+    }
+  }
+
+  m->done = true;
+  // Mark it as done
+  manual_compaction_ = NULL;
+}
+
+static bool MemTableOlderThan(MemTable* mem, SequenceNumber sequence) {
+  return mem != NULL && mem->SmallestSequence() != 0 && mem->SmallestSequence() < sequence;
+}
+
+bool DBImpl::RangeDeletionInMemTable(const RangeDeletion& deletion) {
+  mutex_.AssertHeld();
+  if (MemTableOlderThan(mem_, deletion.sequence) ||
+      MemTableOlderThan(imm_, deletion.sequence)) {
+    return true;
+  }
+  for (BucketMap::iterator it = bucket_map_.begin(); it != bucket_map_.end(); ++it) {
+    if (MemTableOlderThan(it->second->mem_, deletion.sequence)) {
+      return true;
+    }
+  }
+  for (BucketList::iterator it = imm_list_.begin(); it != imm_list_.end(); ++it) {
+    if (MemTableOlderThan((*it)->mem_, deletion.sequence)) {
+      return true;
+    }
+  }
+  // tables being ingested may be older
+  for (std::set<uint64_t>::iterator it = pending_outputs_.begin(); it != pending_outputs_.end(); ++it) {
+    if (*it < deletion.file_number) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Blob garbage collection: live values of the blob file are written again
+// as new entries (in writer queue, so no user write to same key slips in
+// between the check and the write), and go into a new blob file when
+// memtable is dumped. Old file is deleted when no snapshot may still
+// read old entries pointing to it.
+Status DBImpl::CollectBlobGarbage(uint64_t* reclaimed_size) {
+  if (reclaimed_size != NULL) {
+    *reclaimed_size = 0;
+  }
+  uint64_t number = 0;
+  bool pending = false;
+  {
+    MutexLock l(&mutex_);
+    double max_ratio = 0;
+    const std::map<uint64_t, BlobFileMeta>& blob_files = versions_->current()->BlobFiles();
+    for (std::map<uint64_t, BlobFileMeta>::const_iterator it = blob_files.begin();
+         it != blob_files.end();
+         ++it) {
+      if (obsolete_blob_files_.count(it->first) > 0) {
+        continue;
+      }
+      const BlobFileMeta& f = it->second;
+      if (f.garbage_size >= f.file_size) {
+        // nothing to rewrite
+        obsolete_blob_files_[f.number] = versions_->LastSequence();
+      } else if (f.GarbageRatio() >= options_.blob_gc_ratio && f.GarbageRatio() > max_ratio) {
+        max_ratio = f.GarbageRatio();
+        number = f.number;
+      }
+    }
+    pending = !obsolete_blob_files_.empty();
+  }
+
+  Status s;
+  if (number != 0) {
+    bool deferred = false;
+    s = RewriteBlobFile(number, &deferred);
+    if (s.ok() && !deferred) {
+      MutexLock l(&mutex_);
+      obsolete_blob_files_[number] = versions_->LastSequence();
+      pending = true;
+    }
+  }
+
+  if (s.ok() && pending) {
+    ManualCompaction manual;
+    manual.level = 0;
+    manual.done = false;
+    manual.begin = NULL;
+    manual.end = NULL;
+    manual.reschedule = false;    // only run once
+    manual.bg_compaction_func = &DBImpl::BackgroundDeleteBlobFiles;
+
+    MutexLock l(&mutex_);
+    s = RunManualCompaction(&manual);
+    if (reclaimed_size != NULL) {
+      *reclaimed_size = manual.result_size;
+    }
+  }
+  return s;
+}
+
+namespace {
+// Copy first "size" bytes of file src to new file target.
+Status CopyFilePrefix(Env* env, const std::string& src, const std::string& target, uint64_t size) {
+  SequentialFile* sfile = NULL;
+  Status s = env->NewSequentialFile(src, &sfile);
+  if (!s.ok()) {
+    return s;
+  }
+  WritableFile* wfile = NULL;
+  s = env->NewWritableFile(target, &wfile);
+  if (s.ok()) {
+    const size_t kBufferSize = 1 << 20;
+    char* buf = new char[kBufferSize];
+    Slice data;
+    while (s.ok() && size > 0) {
+      s = sfile->Read(static_cast<size_t>(std::min<uint64_t>(size, kBufferSize)), &data, buf);
+      if (s.ok() && data.empty()) {
+        s = Status::IOError(src, "file is shorter than expected");
+      }
+      if (s.ok()) {
+        s = wfile->Append(data);
+        size -= data.size();
+      }
+    }
+    delete[] buf;
+    if (s.ok()) {
+      s = wfile->Sync();
+    }
+    if (s.ok()) {
+      s = wfile->Close();
+    }
+    delete wfile;
+    if (!s.ok()) {
+      env->DeleteFile(target);
+    }
+  }
+  delete sfile;
+  return s;
+}
+
+// SequentialFile ending at "limit" bytes, so a record torn by the limit
+// is seen as a truncated one at end of file.
+class LimitedSequentialFile : public SequentialFile {
+ public:
+  LimitedSequentialFile(SequentialFile* file, uint64_t limit) : file_(file), left_(limit) { }
+  virtual ~LimitedSequentialFile() { delete file_; }
+  virtual Status Read(size_t n, Slice* result, char* scratch) {
+    Status s = file_->Read(static_cast<size_t>(std::min<uint64_t>(n, left_)), result, scratch);
+    if (s.ok()) {
+      left_ -= result->size();
+    }
+    return s;
+  }
+  virtual Status Skip(uint64_t n) {
+    n = std::min(n, left_);
+    left_ -= n;
+    return file_->Skip(n);
+  }
+
+ private:
+  SequentialFile* file_;
+  uint64_t left_;
+};
+
+// Scan complete records of log file "fname" within first "size" bytes. Set
+// *end to the offset past the last one, and *sequence to its last sequence
+// if there is any record.
+Status ScanLogRecords(Env* env, const std::string& fname, uint64_t size,
+                      uint64_t* end, SequenceNumber* sequence) {
+  SequentialFile* file = NULL;
+  Status s = env->NewSequentialFile(fname, &file);
+  if (!s.ok()) {
+    return s;
+  }
+  LimitedSequentialFile limited_file(file, size);
+  log::Reader reader(&limited_file, NULL, true, 0);
+  Slice record;
+  std::string scratch;
+  *end = 0;
+  while (reader.ReadRecord(&record, &scratch)) {
+    *end = reader.EndOfLastRecordOffset();
+    if (record.size() >= 12) {
+      WriteBatch batch;
+      WriteBatchInternal::SetContents(&batch, record);
+      if (WriteBatchInternal::Count(&batch) > 0) {
+        *sequence = WriteBatchInternal::Sequence(&batch) + WriteBatchInternal::Count(&batch) - 1;
+      }
+    }
+  }
+  return s;
+}
+}  // namespace
+
+// Writes are only blocked while current version and log sizes are taken.
+// Tables and blob files are immutable, so hard links share them with db,
+// and referenced current version keeps them from being deleted meanwhile.
+// Only the newest log grows, and a log snapshot keeps the logs. Writers
+// append to log without mutex, so the newest log is cut at the last
+// complete record.
+Status DBImpl::Checkpoint(const std::string& dir, uint64_t* sequence) {
+  *sequence = 0;
+  if (env_->FileExists(CurrentFileName(dir))) {
+    return Status::InvalidArgument("checkpoint already exists", dir);
+  }
+  env_->CreateDir(dir);         // Ignore error from CreateDir since it may exist
+  const std::string log_dir = dir + "/logs/";
+  env_->CreateDir(log_dir);
+
+  VersionEdit edit;
+  std::vector<std::pair<std::string, std::string> > files;
+  std::vector<std::pair<uint64_t, uint64_t> > logs;  // (number, size)
+  uint64_t manifest_number = 0;
+  Version* current = NULL;
+  const Snapshot* log_snapshot = NULL;
+  Status s;
+  {
+    MutexLock l(&mutex_);
+    uint64_t min_log = versions_->LogNumber();
+    if (versions_->PrevLogNumber() != 0 && versions_->PrevLogNumber() < min_log) {
+      min_log = versions_->PrevLogNumber();
+    }
+    log_snapshot = log_snapshots_.New(versions_->LastSequence(), min_log);
+    min_snapshot_log_number_ = dynamic_cast<LogSnapshotImpl*>(log_snapshots_.oldest())->log_number_;
+    current = versions_->current();
+    current->Ref();
+    *sequence = versions_->LastSequence();
+    manifest_number = versions_->NewFileNumber();
+    versions_->GetCheckpoint(dir, &edit, &files);
+
+    std::vector<std::string> filenames;
+    env_->GetChildren(dblog_dir_, &filenames); // Ignoring errors on purpose
+    uint64_t number;
+    FileType type;
+    for (size_t i = 0; i < filenames.size(); i++) {
+      if (ParseFileName(filenames[i], &number, &type) && type == kLogFile && number >= min_log) {
+        uint64_t size = 0;
+        s = env_->GetFileSize(LogFileName(dblog_dir_, number), &size);
+        if (!s.ok()) {
+          break;
+        }
+        logs.push_back(std::make_pair(number, size));
+      }
+    }
+  }
+  std::sort(logs.begin(), logs.end());
+
+  for (size_t i = 0; s.ok() && i < files.size(); i++) {
+    if (!env_->LinkFile(files[i].first, files[i].second).ok()) {
+      uint64_t size = 0;
+      s = env_->GetFileSize(files[i].first, &size);
+      if (s.ok()) {
+        s = CopyFilePrefix(env_, files[i].first, files[i].second, size);
+      }
+    }
+  }
+
+  for (size_t i = 0; s.ok() && i < logs.size(); i++) {
+    const std::string fname = LogFileName(dblog_dir_, logs[i].first);
+    uint64_t end = 0;
+    s = ScanLogRecords(env_, fname, logs[i].second, &end, sequence);
+    if (s.ok()) {
+      s = CopyFilePrefix(env_, fname, LogFileName(log_dir, logs[i].first), end);
+    }
+  }
+
+  if (s.ok()) {
+    WritableFile* file = NULL;
+    s = env_->NewWritableFile(DescriptorFileName(dir, manifest_number), &file);
+    if (s.ok()) {
+      log::Writer manifest(file);
+      std::string record;
+      edit.EncodeTo(&record, options_.persist_file_time_meta);
+      s = manifest.AddRecord(record);
+      if (s.ok()) {
+        s = file->Sync();
+      }
+      if (s.ok()) {
+        s = file->Close();
+      }
+      delete file;
+    }
+  }
+  if (s.ok()) {
+    // copy is openable only after CURRENT is there
+    s = SetCurrentFile(env_, dir, manifest_number);
+  }
+
+  {
+    MutexLock l(&mutex_);
+    current->Unref();
+  }
+  ReleaseLogSnapshot(log_snapshot);
+  Log(options_.info_log, "checkpoint to %s, files: %zu, logs: %zu, sequence: %lu, %s",
+      dir.c_str(), files.size(), logs.size(), *sequence, s.ToString().c_str());
+  return s;
+}
+
+struct BlobRecord {
+  std::string key;
+  std::string value;
+  uint64_t offset;              // offset in blob file
+};
+
+Status DBImpl::RewriteBlobFile(uint64_t number, bool* deferred) {
+  static const size_t kBatchSize = 1 << 20;
+
+  SequentialFile* file = NULL;
+  Status s = env_->NewSequentialFile(BlobFileName(dbname_, number), &file);
+  if (!s.ok()) {
+    return s;
+  }
+  BlobFileReader reader(file);
+  std::vector<BlobRecord> records;
+  uint64_t total = 0, rewritten = 0;
+  bool eof = false;
+  while (s.ok() && !eof && !*deferred && !shutting_down_.Acquire_Load()) {
+    records.clear();
+    size_t size = 0;
+    Slice key, value;
+    uint64_t offset, record_size;
+    while (size < kBatchSize) {
+      if (!reader.Next(&key, &value, &offset, &record_size)) {
+        s = reader.status();
+        eof = true;
+        break;
+      }
+      records.push_back(BlobRecord());
+      records.back().key.assign(key.data(), key.size());
+      records.back().value.assign(value.data(), value.size());
+      records.back().offset = offset;
+      size += record_size;
+    }
+    if (s.ok() && !records.empty()) {
+      int count = 0;
+      s = WriteBlobRecords(number, records, &count, deferred);
+      total += records.size();
+      rewritten += count;
+    }
+  }
+  if (s.ok() && !eof && !*deferred) {
+    s = Status::IOError("Deleting DB during blob gc");
+  }
+
+  Log(options_.info_log, "Rewrite blob file #%llu: %llu of %llu values %s%s",
+      static_cast<unsigned long long>(number),
+      static_cast<unsigned long long>(rewritten),
+      static_cast<unsigned long long>(total),
+      s.ToString().c_str(), *deferred ? " (deferred)" : "");
+  return s;
+}
+
+Status DBImpl::WriteBlobRecords(uint64_t number, const std::vector<BlobRecord>& records,
+                                int* count, bool* deferred) {
+  Writer w(&mutex_);
+  w.batch = NULL;
+  w.sync = false;
+  w.done = false;
+  w.rewrite = true;
+
+  MutexLock l(&mutex_);
+  writers_.push_back(&w);
+  // no group takes in rewrite writer (see BuildBatchGroup())
+  while (&w != writers_.front()) {
+    w.cv.Wait();
+  }
+
+  Status status = MakeRoomForWrite(false);
+  LoggerId self;
+  AcquireLoggingResponsibility(&self);
+  // bucket memtables are not seen by read, can't tell whether value is live
+  if (status.ok() && (!bucket_map_.empty() || !imm_list_.empty())) {
+    *deferred = true;
+  }
+
+  if (status.ok() && !*deferred) {
+    MemTable* mem = mem_;
+    MemTable* imm = imm_;
+    Version* current = versions_->current();
+    mem->Ref();
+    if (imm != NULL) imm->Ref();
+    current->Ref();
+    const SequenceNumber last_sequence = versions_->LastSequence();
+
+    mutex_.Unlock();
+    WriteBatch batch;
+    std::string value;
+    Status s;
+    BlobIndex index;
+    for (size_t i = 0; i < records.size(); i++) {
+      // live if the latest entry of the key is still the index to this record
+      LookupKey lkey(records[i].key, last_sequence);
+      if (mem->Get(lkey, &value, &s) ||
+          (imm != NULL && imm->Get(lkey, &value, &s))) {
+        continue;
+      }
+      Version::GetStats stats;
+      bool is_blob_index = false;
+      if (current->Get(ReadOptions(), lkey, &value, &stats, &is_blob_index).ok() &&
+          is_blob_index && index.DecodeFrom(value) &&
+          index.file_number == number && index.offset == records[i].offset) {
+        // rewritten value needs no remote synchronization
+        batch.Put(records[i].key, records[i].value, true);
+      }
+    }
+    mutex_.Lock();
+
+    *count = WriteBatchInternal::Count(&batch);
+    if (versions_->LastSequence() != last_sequence) {
+      // ingested tables or range deletion came in, check again later
+      *deferred = true;
+    } else if (*count > 0) {
+      WriteBatchInternal::SetSequence(&batch, last_sequence + 1);
+      versions_->SetLastSequence(last_sequence + *count);
+      mutex_.Unlock();
+      status = log_->AddRecord(WriteBatchInternal::Contents(&batch));
+      if (status.ok()) {
+        status = WriteBatchInternal::InsertInto(&batch, mem);
+      }
+      mutex_.Lock();
+    }
+
+    mem->Unref();
+    if (imm != NULL) imm->Unref();
+    current->Unref();
+  }
+  ReleaseLoggingResponsibility(&self);
+
+  writers_.pop_front();
+  if (!writers_.empty()) {
+    writers_.front()->cv.Signal();
+  }
+  return status;
+}
+
+void DBImpl::BackgroundDeleteBlobFiles() {
+  assert(bg_compaction_scheduled_);
+  assert(manual_compaction_ != NULL); // this must be a manual compaction
+
+  ManualCompaction* m = manual_compaction_;
+  VersionEdit edit;
+  int count = 0;
+  mutex_.Lock();
+  // snapshot older than rewriting may read old entries
+  const SequenceNumber oldest = snapshots_.empty() ? kMaxSequenceNumber : snapshots_.oldest()->number_;
+  const std::map<uint64_t, BlobFileMeta>& blob_files = versions_->current()->BlobFiles();
+  for (std::map<uint64_t, SequenceNumber>::iterator it = obsolete_blob_files_.begin();
+       it != obsolete_blob_files_.end(); ) {
+    if (it->second > oldest) {
+      ++it;
+      continue;
+    }
+    std::map<uint64_t, BlobFileMeta>::const_iterator f = blob_files.find(it->first);
+    if (f != blob_files.end()) {
+      edit.DeleteBlobFile(it->first);
+      m->result_size += f->second.file_size;
+      ++count;
+    }
+    obsolete_blob_files_.erase(it++);
+  }
+  mutex_.Unlock();
+
+  if (count > 0) {
+    Status status = versions_->LogAndApply(&edit, &mutex_);
+    Log(options_.info_log, "Deleted %d blob files, %lld bytes %s\n",
+        count,
+        static_cast<unsigned long long>(m->result_size),
+        status.ToString().c_str());
+    if (status.ok()) {
+      DeleteObsoleteFiles();
+    } else {
+      m->result_size = 0;
+      m->compaction_status = status;
+    }
+  }
+
+  m->done = true;
+  // Mark it as done
+  manual_compaction_ = NULL;
+}
+
+// Ingested entries get one new sequence, so they are newer than what
+// db has now, and are not dropped by Comparator::ShouldDrop() which
+// may check sequence. Table files are rewritten for that.
+Status DBImpl::IngestTables(const std::vector<std::string>& files,
+                            void (*visitor)(void* arg, const Slice& key, const Slice& value),
+                            void* arg) {
+  if (files.empty()) {
+    return Status::OK();
+  }
+
+  IngestState ingest;
+  ingest.files.resize(files.size());
+  {
+    MutexLock l(&mutex_);
+    ingest.sequence = versions_->LastSequence() + 1;
+    versions_->SetLastSequence(ingest.sequence);
+    for (size_t i = 0; i < files.size(); i++) {
+      ingest.files[i].number = versions_->NewFileNumber();
+      pending_outputs_.insert(ingest.files[i].number);
+    }
+    ingest.first_number = ingest.files[0].number;
+  }
+
+  Status s;
+  for (size_t i = 0; s.ok() && i < files.size(); i++) {
+    s = WriteIngestedTable(files[i], ingest.sequence, &ingest.files[i], visitor, arg);
+  }
+
+  MutexLock l(&mutex_);
+  if (s.ok()) {
+    // install files with VersionEdit in background thread, like DeleteExpiredFiles()
+    ManualCompaction manual;
+    manual.level = 0;
+    manual.done = false;
+    manual.begin = NULL;
+    manual.end = NULL;
+    manual.reschedule = false;    // only run once
+    manual.bg_compaction_func = &DBImpl::BackgroundIngestTables;
+    manual.arg = &ingest;
+    s = RunManualCompaction(&manual);
+  }
+  for (size_t i = 0; i < ingest.files.size(); i++) {
+    pending_outputs_.erase(ingest.files[i].number);
+    if (!s.ok()) {
+      table_cache_->Evict(ingest.files[i].number);
+      env_->DeleteFile(TableFileName(TablePath(options_, dbname_, ingest.files[i].path_id),
+                                     ingest.files[i].number));
+    }
+  }
+  return s;
+}
+
+Status DBImpl::WriteIngestedTable(const std::string& fname, SequenceNumber sequence, FileMetaData* meta,
+                                  void (*visitor)(void* arg, const Slice& key, const Slice& value), void* arg) {
+  meta->file_size = 0;
+  meta->time_meta.Clear();
+
+  uint64_t input_size = 0;
+  RandomAccessFile* input_file = NULL;
+  Table* table = NULL;
+  Status s = env_->GetFileSize(fname, &input_size);
+  if (s.ok()) {
+    s = env_->NewRandomAccessFile(fname, &input_file);
+  }
+  if (s.ok()) {
+    s = Table::Open(options_, input_file, input_size, &table);
+  }
+  if (!s.ok()) {
+    delete input_file;
+    return s;
+  }
+
+  const std::string output_fname = TableFileName(TablePath(options_, dbname_, meta->path_id),
+                                                 meta->number);
+  WritableFile* file = NULL;
+  s = env_->NewLimitedWritableFile(output_fname, &file, kIOScan);
+  if (s.ok()) {
+    ReadOptions read_options;
+    read_options.fill_cache = false;
+    Iterator* iter = table->NewIterator(read_options);
+    TableBuilder* builder = new TableBuilder(options_, file);
+    std::string ikey;
+    ParsedInternalKey parsed;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      if (!ParseInternalKey(iter->key(), &parsed) || parsed.type != kTypeValue) {
+        s = Status::Corruption("bad entry in ingested table", fname);
+        break;
+      }
+      ikey.clear();
+      AppendInternalKey(&ikey, ParsedInternalKey(parsed.user_key, sequence, kTypeValue));
+      if (builder->NumEntries() == 0) {
+        meta->smallest.DecodeFrom(ikey);
+      }
+      meta->largest.DecodeFrom(ikey);
+      meta->time_meta.Add(user_comparator(), ikey, iter->value());
+      builder->Add(ikey, iter->value());
+      if (visitor != NULL) {
+        (*visitor)(arg, parsed.user_key, iter->value());
+      }
+    }
+    if (s.ok()) {
+      s = iter->status();
+    }
+    delete iter;
+
+    const bool empty = builder->NumEntries() == 0;
+    if (s.ok()) {
+      s = builder->Finish();
+      if (s.ok() && !empty) {
+        meta->file_size = builder->FileSize();
+      }
+    } else {
+      builder->Abandon();
+    }
+    delete builder;
+
+    if (s.ok()) {
+      s = file->Sync();
+    }
+    if (s.ok()) {
+      s = file->Close();
+    }
+    delete file;
+
+    if (s.ok() && meta->file_size > 0) {
+      // Verify that the table is usable
+      Iterator* it = table_cache_->NewIterator(ReadOptions(), meta->number, meta->file_size,
+                                               meta->path_id);
+      s = it->status();
+      delete it;
+    }
+  }
+  delete table;
+  delete input_file;
+
+  if (!s.ok() || meta->file_size == 0) {
+    env_->DeleteFile(output_fname);
+  }
+  Log(options_.info_log, "Ingested table %s => #%llu: %lld bytes %s",
+      fname.c_str(), static_cast<unsigned long long>(meta->number),
+      static_cast<unsigned long long>(meta->file_size), s.ToString().c_str());
+  return s;
+}
+
+void DBImpl::BackgroundIngestTables() {
+  assert(bg_compaction_scheduled_);
+  assert(manual_compaction_ != NULL); // this must be a manual compaction
+
+  ManualCompaction* m = manual_compaction_;
+  IngestState* ingest = reinterpret_cast<IngestState*>(m->arg);
+  Status status;
+  VersionEdit edit;
+  int count = 0;
+
+  // files of current version are changed only in background thread, so are stable here.
+  mutex_.Lock();
+  Version* current = versions_->current();
+  for (size_t i = 0; i < ingest->files.size(); i++) {
+    const FileMetaData& f = ingest->files[i];
+    if (f.file_size == 0) {
+      continue;
+    }
+    const Slice smallest_user_key = f.smallest.user_key();
+    const Slice largest_user_key = f.largest.user_key();
+    // entries in memtable may be older or newer, neither is right.
+    int level = MemTableOverlap(smallest_user_key, largest_user_key) ? -1 :
+      current->PickLevelForIngestedTable(ingest->first_number, smallest_user_key, largest_user_key);
+    if (level < 0) {
+      status = Status::InvalidArgument("ingested table overlaps newer data");
+      break;
+    }
+    edit.AddFile(level, f.number, f.file_size, f.smallest, f.largest, f.time_meta, f.path_id);
+    m->result_size += f.file_size;
+    ++count;
+    Log(options_.info_log, "Ingest table #%llu@%d", static_cast<unsigned long long>(f.number), level);
+  }
+  mutex_.Unlock();
+
+  if (status.ok() && count > 0) {
+    status = versions_->LogAndApply(&edit, &mutex_);
+  }
+  VersionSet::LevelSummaryStorage tmp;
+  Log(options_.info_log, "Ingested %d tables, %lld bytes %s: %s\n",
+      count,
+      static_cast<unsigned long long>(m->result_size),
+      status.ToString().c_str(),
+      versions_->LevelSummary(&tmp));
+  if (!status.ok()) {
+    m->result_size = 0;
+    m->compaction_status = status;
+  }
+
+  m->done = true;
+  // Mark it as done
+  manual_compaction_ = NULL;
+}
+
+static bool MemTableOverlapRange(MemTable* mem, const Comparator* ucmp,
+                                 const Slice& smallest_user_key, const Slice& largest_user_key) {
+  if (mem == NULL) {
+    return false;
+  }
+  InternalKey start(smallest_user_key, kMaxSequenceNumber, kValueTypeForSeek);
+  Iterator* iter = mem->NewIterator();
+  iter->Seek(start.Encode());
+  const bool overlap = iter->Valid() && ucmp->Compare(ExtractUserKey(iter->key()), largest_user_key) <= 0;
+  delete iter;
+  return overlap;
+}
+
+bool DBImpl::MemTableOverlap(const Slice& smallest_user_key, const Slice& largest_user_key) {
+  mutex_.AssertHeld();
+  const Comparator* ucmp = user_comparator();
+  if (MemTableOverlapRange(mem_, ucmp, smallest_user_key, largest_user_key) ||
+      MemTableOverlapRange(imm_, ucmp, smallest_user_key, largest_user_key)) {
+    return true;
+  }
+  for (BucketMap::iterator it = bucket_map_.begin(); it != bucket_map_.end(); ++it) {
+    if (MemTableOverlapRange(it->second->mem_, ucmp, smallest_user_key, largest_user_key)) {
+      return true;
+    }
+  }
+  for (BucketList::iterator it = imm_list_.begin(); it != imm_list_.end(); ++it) {
+    if (MemTableOverlapRange((*it)->mem_, ucmp, smallest_user_key, largest_user_key)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+//////////////////////////////////////////
+// special write to support multi-bucket update
+//////////////////////////////////////////
+
+
+//////////////////////////////////////////////////
+
+void DBImpl::MaybeScheduleCompaction() {
+  mutex_.AssertHeld();
+  if (bg_compaction_scheduled_) {
+    Log(options_.info_log, "com running");
+    // Already scheduled
+  } else if (shutting_down_.Acquire_Load()) {
+    // DB is being deleted; no more background compactions
+  } else if (imm_ == NULL &&
+             imm_list_.empty() && // @@ imm list
+             manual_compaction_ == NULL &&
+             !versions_->NeedsCompaction()) {
+    Log(options_.info_log, "need no com");
+    // No work to be done
+  } else {
+    bg_compaction_scheduled_ = true;
+    env_->Schedule(&DBImpl::BGWork, this);
+  }
+}
+
+void DBImpl::BGWork(void* db) {
+  reinterpret_cast<DBImpl*>(db)->BackgroundCall();
+}
+
+void DBImpl::BackgroundCall() {
+  PROFILER_START("compact start");
+  PROFILER_BEGIN("mutex");
+  MutexLock l(&mutex_);
+  PROFILER_END();
+  assert(bg_compaction_scheduled_);
+  if (!shutting_down_.Acquire_Load()) {
+    if (manual_compaction_ != NULL) {
+      mutex_.Unlock();
+      (this->*manual_compaction_->bg_compaction_func)(); // use user-defined compaction function
+      mutex_.Lock();
+    } else {
+      PROFILER_BEGIN("do com+");
+      mutex_.Unlock();
+      BackgroundCompaction();   // use default compaction
+      mutex_.Lock();
+      PROFILER_END();
+    }
+  }
+
+  bool reschedule = manual_compaction_ != NULL ? manual_compaction_->reschedule : true;
+  bg_compaction_scheduled_ = false;
+  RecordL0FileCount();
+
+  // Previous compaction may have produced too many files in a level,
+  // so reschedule another compaction if needed.
+  if (reschedule) {
+    PROFILER_BEGIN("maybesche+");
+    MaybeScheduleCompaction();
+    PROFILER_END();
+  }
+  bg_cv_.SignalAll();
+  PROFILER_DUMP();
+  PROFILER_STOP();
+}
+
+void DBImpl::RecordL0FileCount() {
+  mutex_.AssertHeld();
+  const uint64_t minute = env_->NowMicros() / 60000000;
+  const int files = versions_->NumLevelFiles(0);
+  L0History& h = l0_history_[minute % kL0HistorySize];
+  if (h.minute != minute) {
+    h.minute = minute;
+    h.max_files = files;
+  } else if (files > h.max_files) {
+    h.max_files = files;
+  }
+}
+
+// latest first, minute without record is shown as "-"
+void DBImpl::L0HistoryString(std::string* value) {
+  mutex_.AssertHeld();
+  RecordL0FileCount();
+  const uint64_t minute = env_->NowMicros() / 60000000;
+  std::string history;
+  size_t recorded_size = 0;
+  char buf[16];
+  for (int i = 0; i < kL0HistorySize && minute >= static_cast<uint64_t>(i); ++i) {
+    const L0History& h = l0_history_[(minute - i) % kL0HistorySize];
+    if (h.minute == minute - i) {
+      snprintf(buf, sizeof(buf), " %d", h.max_files);
+      history.append(buf);
+      recorded_size = history.size();
+    } else {
+      history.append(" -");
+    }
+  }
+  value->append(history, 0, recorded_size);
+  value->append("\n");
+}
+
+void DBImpl::BackgroundCompaction() {
+  if (imm_ != NULL || !imm_list_.empty()) {
+    const uint64_t imm_start = env_->NowMicros();
+    Log(options_.info_log, "only com mem");
+    PROFILER_BEGIN("com mem+");
+    CompactMemTable();
+    PROFILER_END();
+    Log(options_.info_log, "only com mem cost %ld", env_->NowMicros() - imm_start);
+    return;
+  }
+
+  Compaction* c;
+  bool is_manual = (manual_compaction_ != NULL);
+  InternalKey manual_end;
+  if (is_manual) {
+    ManualCompaction* m = manual_compaction_;
+    c = versions_->CompactRange(m->level, m->begin, m->end);
+    m->done = (c == NULL);
+    if (c != NULL) {
+      manual_end = c->input(0, c->num_input_files(0) - 1)->largest;
+    }
+    Log(options_.info_log,
+        "Manual compaction at level-%d from %s .. %s; will stop at %s\n",
+        m->level,
+        (m->begin ? m->begin->DebugString().c_str() : "(begin)"),
+        (m->end ? m->end->DebugString().c_str() : "(end)"),
+        (m->done ? "(end)" : manual_end.DebugString().c_str()));
+  } else {
+    PROFILER_BEGIN("pickcom+");
+    c = versions_->PickCompaction();
+    PROFILER_END();
+  }
+
+  Status status;
+  if (c == NULL) {
+    // Nothing to do
+  } else if (!is_manual && c->IsTrivialMove() &&
+             c->input(0, 0)->path_id == versions_->PathIdForLevel(c->level() + 1)) {
+    // file moved across paths is rewritten by compaction
+    // Move file to next level
+    assert(c->num_input_files(0) == 1);
+    FileMetaData* f = c->input(0, 0);
+    c->edit()->DeleteFile(c->level(), f->number);
+    c->edit()->AddFile(c->level() + 1, f->number, f->file_size,
+                       f->smallest, f->largest, f->time_meta, f->path_id);
+    PROFILER_BEGIN("com move lAa+");
+    status = versions_->LogAndApply(c->edit(), &mutex_);
+    PROFILER_END();
+    VersionSet::LevelSummaryStorage tmp;
+    Log(options_.info_log, "Moved #%lld to level-%d %lld bytes %s: %s\n",
+        static_cast<unsigned long long>(f->number),
+        c->level() + 1,
+        static_cast<unsigned long long>(f->file_size),
+        status.ToString().c_str(),
+        versions_->LevelSummary(&tmp));
+  } else {
+    CompactionState* compact = new CompactionState(c);
+    PROFILER_BEGIN("do com work+");
+    status = DoCompactionWork(compact);
+    PROFILER_END();
+    PROFILER_BEGIN("cleanupcom+");
+    CleanupCompaction(compact);
+    PROFILER_END();
+    c->ReleaseInputs();
+    PROFILER_BEGIN("del obsofile+");
+    DeleteObsoleteFiles();
+    PROFILER_END();
+  }
+  delete c;
+
+  if (status.ok()) {
+    // Done
+  } else if (shutting_down_.Acquire_Load()) {
+    // Ignore compaction errors found during shutting down
+  } else {
+    Log(options_.info_log,
+        "Compaction error: %s", status.ToString().c_str());
     if (options_.paranoid_checks && bg_error_.ok()) {
       bg_error_ = status;
     }
@@ -1430,9 +2835,44 @@ void DBImpl::CleanupCompaction(CompactionState* compact) {
     const CompactionState::Output& out = compact->outputs[i];
     pending_outputs_.erase(out.number);
   }
+  if (compact->blob != NULL) {
+    pending_outputs_.erase(compact->blob->number());
+    delete compact->blob;
+  }
   delete compact;
 }
 
+void DBImpl::OpenCompactionBlobFile(CompactionState* compact) {
+  assert(compact->blob == NULL);
+  if (options_.blob_value_size == 0) {
+    return;
+  }
+  uint64_t file_number;
+  {
+    mutex_.Lock();
+    file_number = versions_->NewFileNumber();
+    pending_outputs_.insert(file_number);
+    mutex_.Unlock();
+  }
+  compact->blob = new BlobFileBuilder(dbname_, options_, file_number, kIOCompaction);
+}
+
+Status DBImpl::FinishCompactionBlobFile(CompactionState* compact) {
+  Status s;
+  if (compact->blob != NULL) {
+    s = compact->blob->Finish(&compact->blob_meta);
+    if (s.ok() && compact->blob_meta.file_size > 0) {
+      Log(options_.info_log,
+          "Generated blob file #%llu: %llu values, %llu bytes",
+          (unsigned long long) compact->blob_meta.number,
+          (unsigned long long) compact->blob_meta.entries,
+          (unsigned long long) compact->blob_meta.file_size);
+      compact->total_bytes += compact->blob_meta.file_size;
+    }
+  }
+  return s;
+}
+
 Status DBImpl::OpenCompactionOutputFile(CompactionState* compact) {
   assert(compact != NULL);
   assert(compact->builder == NULL);
@@ -1443,6 +2883,7 @@ Status DBImpl::OpenCompactionOutputFile(CompactionState* compact) {
     pending_outputs_.insert(file_number);
     CompactionState::Output out;
     out.number = file_number;
+    out.path_id = versions_->PathIdForLevel(compact->output_level);
     out.smallest.Clear();
     out.largest.Clear();
     compact->outputs.push_back(out);
@@ -1450,10 +2891,11 @@ Status DBImpl::OpenCompactionOutputFile(CompactionState* compact) {
   }
 
   // Make the output file
-  std::string fname = TableFileName(dbname_, file_number);
-  Status s = env_->NewWritableFile(fname, &compact->outfile);
+  std::string fname = TableFileName(TablePath(options_, dbname_, compact->current_output()->path_id),
+                                    file_number);
+  Status s = env_->NewLimitedWritableFile(fname, &compact->outfile, kIOCompaction);
   if (s.ok()) {
-    compact->builder = new TableBuilder(options_, compact->outfile);
+    compact->builder = new TableBuilder(options_, compact->outfile, compact->output_level);
   }
   return s;
 }
@@ -1495,7 +2937,8 @@ Status DBImpl::FinishCompactionOutputFile(CompactionState* compact,
     // Verify that the table is usable
     Iterator* iter = table_cache_->NewIterator(ReadOptions(),
                                                output_number,
-                                               current_bytes);
+                                               current_bytes,
+                                               compact->current_output()->path_id);
     s = iter->status();
     delete iter;
     if (s.ok()) {
@@ -1513,13 +2956,23 @@ Status DBImpl::FinishCompactionOutputFile(CompactionState* compact,
 Status DBImpl::InstallCompactionResults(CompactionState* compact, bool uppen_level) {
   // Add compaction outputs
   compact->compaction->AddInputDeletions(compact->compaction->edit());
+  compact->compaction->edit()->SetRangeDeletionBase(
+    compact->compaction->input_version()->LastRangeDeletionSequence());
   const int level = compact->compaction->level();
   const int output_level = uppen_level ? level + 1 : level;
   for (size_t i = 0; i < compact->outputs.size(); i++) {
     const CompactionState::Output& out = compact->outputs[i];
     compact->compaction->edit()->AddFile(
         output_level,
-        out.number, out.file_size, out.smallest, out.largest);
+        out.number, out.file_size, out.smallest, out.largest, out.time_meta, out.path_id);
+  }
+  if (compact->blob_meta.file_size > 0) {
+    compact->compaction->edit()->AddBlobFile(compact->blob_meta);
+  }
+  for (std::map<uint64_t, uint64_t>::const_iterator it = compact->blob_garbage.begin();
+       it != compact->blob_garbage.end();
+       ++it) {
+    compact->compaction->edit()->AddBlobGarbage(it->first, it->second);
   }
   PROFILER_BEGIN("lAa+");
   Status s = versions_->LogAndApply(compact->compaction->edit(), &mutex_);
@@ -1568,11 +3021,11 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
   assert(versions_->NumLevelFiles(compact->compaction->level()) > 0);
   assert(compact->builder == NULL);
   assert(compact->outfile == NULL);
-  if (snapshots_.empty()) {
-    compact->smallest_snapshot = versions_->LastSequence();
-  } else {
-    compact->smallest_snapshot = snapshots_.oldest()->number_;
+  {
+    MutexLock l(&mutex_);
+    compact->smallest_snapshot = SmallestSnapshot();
   }
+  OpenCompactionBlobFile(compact);
 
   PROFILER_BEGIN("do real file com-");
 
@@ -1583,6 +3036,7 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
   std::string current_user_key;
   bool has_current_user_key = false;
   SequenceNumber last_sequence_for_key = kMaxSequenceNumber;
+  const bool range_deletion = compact->compaction->input_version()->HasRangeDeletions();
   // @ caculate expired end time only once for speed
   // @ consider cost time of one compaction (range matters), the precision (maybe) is tolerable
   uint32_t expired_end_time = start_micros/1000000;
@@ -1629,9 +3083,13 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
       } else if (user_comparator()->ShouldDrop(ikey.user_key.data(), ikey.sequence, 1 /* will gc */)) {
         // user-defined should drop, no matter what conditon.
         drop = true;
+      } else if (range_deletion && compact->RangeDeleted(ikey)) {
+        // covered by range deletion no snapshot can see
+        drop = true;
       } else if (ikey.sequence <= compact->smallest_snapshot &&
                  (ikey.type == kTypeDeletion || // deleted or ..
-                  user_comparator()->ShouldDropMaybe(ikey.user_key.data(),
+                  user_comparator()->ShouldDropMaybe(ikey.user_key,
+                                                     EntryValueHead(ikey.type, input->value()),
                                                      ikey.sequence, expired_end_time)) &&
                  // .. user-defined should drop(maybe),
                  // based on some condition(eg. this key only has this update.).
@@ -1658,7 +3116,9 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
         (int)last_sequence_for_key, (int)compact->smallest_snapshot);
 #endif
 
-    if (!drop) {
+    if (drop) {
+      compact->DropEntry(ikey, input->value());
+    } else {
       // Open output file if necessary
       if (compact->builder == NULL) {
         status = OpenCompactionOutputFile(compact);
@@ -1666,11 +3126,19 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
           break;
         }
       }
+      Slice value = input->value();
+      if (compact->blob != NULL) {
+        status = compact->blob->Separate(&key, &value);
+        if (!status.ok()) {
+          break;
+        }
+      }
       if (compact->builder->NumEntries() == 0) {
         compact->current_output()->smallest.DecodeFrom(key);
       }
       compact->current_output()->largest.DecodeFrom(key);
-      compact->builder->Add(key, input->value());
+      compact->current_output()->time_meta.Add(user_comparator(), key, value);
+      compact->builder->Add(key, value);
 
       // Close output file if it is big enough
       if (compact->builder->FileSize() >=
@@ -1694,19 +3162,27 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
   if (status.ok()) {
     status = input->status();
   }
+  if (status.ok()) {
+    status = FinishCompactionBlobFile(compact);
+  }
   delete input;
   input = NULL;
 
   CompactionStats stats;
+  stats.count = 1;
   stats.micros = env_->NowMicros() - start_micros - imm_micros;
   for (int which = 0; which < 2; which++) {
     for (int i = 0; i < compact->compaction->num_input_files(which); i++) {
       stats.bytes_read += compact->compaction->input(which, i)->file_size;
     }
+    if (which == 0) {
+      stats.bytes_read_upper = stats.bytes_read;
+    }
   }
   for (size_t i = 0; i < compact->outputs.size(); i++) {
     stats.bytes_written += compact->outputs[i].file_size;
   }
+  stats.bytes_written += compact->blob_meta.file_size;
 
   PROFILER_END();
   stats_[compact->compaction->level() + 1].Add(stats);
@@ -1750,7 +3226,8 @@ static void CleanupIteratorState(void* arg1, void* arg2) {
 }  // namespace
 
 Iterator* DBImpl::NewInternalIterator(const ReadOptions& options,
-                                      SequenceNumber* latest_snapshot) {
+                                      SequenceNumber* latest_snapshot,
+                                      Version** version) {
   IterState* cleanup = new IterState;
   mutex_.Lock();
   *latest_snapshot = versions_->LastSequence();
@@ -1773,6 +3250,9 @@ Iterator* DBImpl::NewInternalIterator(const ReadOptions& options,
   cleanup->imm = imm_;
   cleanup->version = versions_->current();
   internal_iter->RegisterCleanup(CleanupIteratorState, cleanup, NULL);
+  if (version != NULL) {
+    *version = cleanup->version;
+  }
 
   mutex_.Unlock();
   return internal_iter;
@@ -1791,6 +3271,24 @@ int64_t DBImpl::TEST_MaxNextLevelOverlappingBytes() {
 Status DBImpl::Get(const ReadOptions& options,
                    const Slice& key,
                    std::string* value) {
+  return GetImpl(options, key, value, NULL);
+}
+
+Status DBImpl::Get(const ReadOptions& options,
+                   const Slice& key,
+                   PinnableSlice* value) {
+  value->Reset();
+  Status s = GetImpl(options, key, value->GetSelf(), value);
+  if (s.ok() && !value->IsPinned()) {
+    value->PinSelf();
+  }
+  return s;
+}
+
+Status DBImpl::GetImpl(const ReadOptions& options,
+                       const Slice& key,
+                       std::string* value,
+                       PinnableSlice* pinned) {
   Status s;
   PROFILER_BEGIN("db mutex");
   MutexLock l(&mutex_);
@@ -1817,15 +3315,30 @@ Status DBImpl::Get(const ReadOptions& options,
     mutex_.Unlock();
     // First look in the memtable, then in the immutable memtable (if any).
     LookupKey lkey(key, snapshot);
-    if (mem->Get(lkey, value, &s)) {
-      // Done
-    } else if (imm != NULL && imm->Get(lkey, value, &s)) {
-      // Done
+    SequenceNumber seq = 0;
+    if (mem->Get(lkey, value, &s, &seq) ||
+        (imm != NULL && imm->Get(lkey, value, &s, &seq))) {
+      // Done, value found in memtable may be covered by range deletion
+      if (s.ok() && current->HasRangeDeletions() &&
+          current->IsRangeDeleted(key, seq, snapshot)) {
+        value->clear();
+        s = Status::NotFound(Slice());
+      }
     } else {
+      // cache_only read does no disk io, its latency tells nothing about disk
+      const bool report_latency = !options.cache_only && ShouldReportReadLatency();
+      const uint64_t start_micros = report_latency ? env_->NowMicros() : 0;
       PROFILER_BEGIN("db sst get");
-      s = current->Get(options, lkey, value, &stats);
+      s = current->Get(options, lkey, value, &stats, NULL, pinned);
       PROFILER_END();
-      have_stat_update = true;
+      // Incomplete read stops at the first block not in cache, it will be
+      // retried by read thread, so charge seek and latency only then.
+      if (!s.IsIncomplete()) {
+        if (report_latency) {
+          ReportReadLatency(env_->NowMicros() - start_micros);
+        }
+        have_stat_update = true;
+      }
     }
     mutex_.Lock();
   }
@@ -1839,14 +3352,76 @@ Status DBImpl::Get(const ReadOptions& options,
   return s;
 }
 
+// background I/O that is auto tuned by foreground read latency
+static const IOType kTunedIOTypes[] = { kIOCompaction, kIOScan };
+
+bool DBImpl::ShouldReportReadLatency() {
+  for (size_t i = 0; i < sizeof(kTunedIOTypes) / sizeof(kTunedIOTypes[0]); i++) {
+    RateLimiter* limiter = env_->GetRateLimiter(kTunedIOTypes[i]);
+    if (limiter != NULL && limiter->IsAutoTune()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void DBImpl::ReportReadLatency(uint64_t micros) {
+  for (size_t i = 0; i < sizeof(kTunedIOTypes) / sizeof(kTunedIOTypes[0]); i++) {
+    RateLimiter* limiter = env_->GetRateLimiter(kTunedIOTypes[i]);
+    if (limiter != NULL) {
+      limiter->ReportLatency(micros);
+    }
+  }
+}
+
+bool DBImpl::KeyMayExist(const ReadOptions& options, const Slice& key) {
+  bool may_exist = true;
+  std::string value;
+  Status s;
+  MutexLock l(&mutex_);
+  SequenceNumber snapshot;
+  if (options.snapshot != NULL) {
+    snapshot = reinterpret_cast<const SnapshotImpl*>(options.snapshot)->number_;
+  } else {
+    snapshot = versions_->LastSequence();
+  }
+
+  MemTable* mem = mem_;
+  MemTable* imm = imm_;
+  Version* current = versions_->current();
+  mem->Ref();
+  if (imm != NULL) imm->Ref();
+  current->Ref();
+
+  {
+    mutex_.Unlock();
+    LookupKey lkey(key, snapshot);
+    if (mem->Get(lkey, &value, &s)) {
+      may_exist = !s.IsNotFound();
+    } else if (imm != NULL && imm->Get(lkey, &value, &s)) {
+      may_exist = !s.IsNotFound();
+    } else {
+      may_exist = current->KeyMayExist(options, lkey);
+    }
+    mutex_.Lock();
+  }
+
+  mem->Unref();
+  if (imm != NULL) imm->Unref();
+  current->Unref();
+  return may_exist;
+}
+
 Iterator* DBImpl::NewIterator(const ReadOptions& options) {
   SequenceNumber latest_snapshot;
-  Iterator* internal_iter = NewInternalIterator(options, &latest_snapshot);
+  Version* version = NULL;
+  Iterator* internal_iter = NewInternalIterator(options, &latest_snapshot, &version);
   return NewDBIterator(
       &dbname_, env_, user_comparator(), internal_iter,
       (options.snapshot != NULL
        ? reinterpret_cast<const SnapshotImpl*>(options.snapshot)->number_
-       : latest_snapshot));
+       : latest_snapshot),
+      version, blob_cache_);
 }
 
 const Snapshot* DBImpl::GetSnapshot() {
@@ -1897,8 +3472,25 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* my_batch) {
   PROFILER_END();
   writers_.push_back(&w);
   PROFILER_BEGIN("db wait");
-  while (!w.done && &w != writers_.front()) {
-    w.cv.Wait();
+  while (true) {
+    while (!w.done && !w.insert_mem && &w != writers_.front()) {
+      w.cv.Wait();
+    }
+    if (!w.insert_mem) {
+      break;
+    }
+    // Leader has logged the group, insert my own batch in parallel
+    // with other members, then wait for leader to finish the group.
+    w.insert_mem = false;
+    mutex_.Unlock();
+    Status s = WriteBatchInternal::InsertInto(my_batch, w.mem, true);
+    mutex_.Lock();
+    if (!s.ok()) {
+      w.leader->status = s;
+    }
+    if (--pending_mem_writers_ == 0) {
+      w.leader->cv.Signal();
+    }
   }
   PROFILER_END();
   if (w.done) {
@@ -1911,11 +3503,28 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* my_batch) {
   PROFILER_END();
   uint64_t last_sequence = versions_->LastSequence();
   Writer* last_writer = &w;
+  // Sync log after leaving writer queue, so that next group can
+  // append to log while this one is waiting for sync.
+  const bool pipelined_sync = options.sync && options_.pipelined_log_sync;
+  uint64_t sync_ticket = 0;
   if (status.ok() && my_batch != NULL) {  // NULL batch is for compactions
     PROFILER_BEGIN("db builtbatch");
     WriteBatch* updates = BuildBatchGroup(&last_writer);
     PROFILER_END();
     WriteBatchInternal::SetSequence(updates, last_sequence + 1);
+    // Each writer inserts its own batch, so give each batch its part
+    // of the sequence in group order.
+    const bool parallel = options_.concurrent_memtable_write && updates != my_batch;
+    if (parallel) {
+      SequenceNumber seq = last_sequence + 1;
+      for (std::deque<Writer*>::iterator it = writers_.begin(); ; ++it) {
+        if ((*it)->batch != NULL) {
+          WriteBatchInternal::SetSequence((*it)->batch, seq);
+          seq += WriteBatchInternal::Count((*it)->batch);
+        }
+        if (*it == last_writer) break;
+      }
+    }
     last_sequence += WriteBatchInternal::Count(updates);
     versions_->SetLastSequence(last_sequence);
 
@@ -1927,21 +3536,72 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* my_batch) {
       mutex_.Unlock();
       PROFILER_BEGIN("db addrecord");
       status = log_->AddRecord(WriteBatchInternal::Contents(updates));
-      if (status.ok() && options.sync) {
+      if (status.ok() && options.sync && !pipelined_sync) {
         status = logfile_->Sync();
       }
       PROFILER_END();
       if (status.ok()) {
         PROFILER_BEGIN("db insertmem");
-        status = WriteBatchInternal::InsertInto(updates, mem_);
+        if (parallel) {
+          mutex_.Lock();
+          for (std::deque<Writer*>::iterator it = writers_.begin() + 1; ; ++it) {
+            if ((*it)->batch != NULL) {
+              (*it)->insert_mem = true;
+              (*it)->mem = mem_;
+              (*it)->leader = &w;
+              ++pending_mem_writers_;
+              (*it)->cv.Signal();
+            }
+            if (*it == last_writer) break;
+          }
+          mutex_.Unlock();
+          status = WriteBatchInternal::InsertInto(my_batch, mem_, true);
+        } else {
+          status = WriteBatchInternal::InsertInto(updates, mem_);
+        }
         PROFILER_END();
       }
       mutex_.Lock();
+      // all members must finish before memtable can be switched by next group
+      while (pending_mem_writers_ > 0) {
+        w.cv.Wait();
+      }
+      if (status.ok() && !w.status.ok()) {
+        status = w.status;
+      }
+      if (status.ok() && pipelined_sync) {
+        sync_ticket = ++log_sync_requested_;
+      }
     }
     if (updates == tmp_batch_) tmp_batch_->Clear();
 
   }
 
+  if (sync_ticket > 0) {
+    std::vector<Writer*> group;
+    while (true) {
+      Writer* ready = writers_.front();
+      writers_.pop_front();
+      group.push_back(ready);
+      if (ready == last_writer) break;
+    }
+    if (!writers_.empty()) {
+      writers_.front()->cv.Signal();
+    }
+
+    PROFILER_BEGIN("db syncwait");
+    status = SyncLogPipelined(sync_ticket);
+    PROFILER_END();
+    for (size_t i = 0; i < group.size(); ++i) {
+      if (group[i] != &w) {
+        group[i]->status = status;
+        group[i]->done = true;
+        group[i]->cv.Signal();
+      }
+    }
+    return status;
+  }
+
   PROFILER_BEGIN("db lastwait");
   while (true) {
     Writer* ready = writers_.front();
@@ -1963,6 +3623,81 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* my_batch) {
   return status;
 }
 
+Status DBImpl::SyncLogPipelined(uint64_t ticket) {
+  mutex_.AssertHeld();
+  while (log_synced_ < ticket) {
+    if (!bg_error_.ok()) {
+      return bg_error_;
+    }
+    if (log_syncing_) {
+      log_sync_cv_.Wait();
+      continue;
+    }
+
+    log_syncing_ = true;
+    if (options_.log_sync_delay_us > 0) {
+      // wait a little for more groups to share this sync
+      mutex_.Unlock();
+      env_->SleepForMicroseconds(options_.log_sync_delay_us);
+      mutex_.Lock();
+    }
+    // log won't be switched while syncing (see SyncLogBeforeSwitch())
+    const uint64_t target = log_sync_requested_;
+    mutex_.Unlock();
+    Status s = logfile_->Sync();
+    mutex_.Lock();
+    log_syncing_ = false;
+    if (s.ok()) {
+      log_synced_ = target;
+    } else if (bg_error_.ok()) {
+      // data may be in memtable already, stop writing
+      bg_error_ = s;
+    }
+    log_sync_cv_.SignalAll();
+  }
+  return Status::OK();
+}
+
+Status DBImpl::SyncLogBeforeSwitch() {
+  mutex_.AssertHeld();
+  while (log_syncing_) {
+    log_sync_cv_.Wait();
+  }
+  Status s;
+  if (log_synced_ < log_sync_requested_) {
+    s = logfile_->Sync();
+    if (s.ok()) {
+      log_synced_ = log_sync_requested_;
+    } else if (bg_error_.ok()) {
+      bg_error_ = s;
+    }
+    log_sync_cv_.SignalAll();
+  }
+  return s;
+}
+
+bool DBImpl::HasRoomInMemTable() {
+  mutex_.AssertHeld();
+  const size_t usage = mem_->ApproximateMemoryUsage();
+  WriteBufferManager* wbm = options_.write_buffer_manager;
+  if (wbm == NULL) {
+    return usage <= options_.write_buffer_size;
+  }
+
+  if (usage > mem_reserved_) {
+    wbm->ReserveMem(usage - mem_reserved_);
+    mem_reserved_ = usage;
+  }
+  if (usage > options_.write_buffer_size) {
+    return false;
+  }
+  // Shared budget is used up, switch memtable early to free memory
+  // unless it is too small to be worth a flush, or previous one is
+  // still being flushed (don't stall writes for shared budget).
+  return !(wbm->ShouldFlush() && imm_ == NULL &&
+           usage >= options_.write_buffer_size / 8);
+}
+
 // REQUIRES: Writer list must be non-empty
 // REQUIRES: First writer must have a non-NULL batch
 WriteBatch* DBImpl::BuildBatchGroup(Writer** last_writer) {
@@ -1986,6 +3721,11 @@ WriteBatch* DBImpl::BuildBatchGroup(Writer** last_writer) {
   ++iter;  // Advance past "first"
   for (; iter != writers_.end(); ++iter) {
     Writer* w = *iter;
+    if (w->rewrite) {
+      // blob gc or range deletion writer writes alone
+      break;
+    }
+
     if (w->sync && !first->sync) {
       // Do not include a sync write into a batch handled by a non-sync write.
       break;
@@ -2034,12 +3774,13 @@ Status DBImpl::MakeRoomForWrite(bool force) {
       // this delay hands over some CPU to the compaction thread in
       // case it is sharing the same core as the writer.
       Log(options_.info_log, "wait slow");
+      const uint64_t stall_start = env_->NowMicros();
       mutex_.Unlock();
       env_->SleepForMicroseconds(1000);
       allow_delay = false;  // Do not delay a single write more than once
       mutex_.Lock();
-    } else if (!force &&
-               (mem_->ApproximateMemoryUsage() <= options_.write_buffer_size)) {
+      RecordStall(kStallL0Slowdown, stall_start);
+    } else if (!force && HasRoomInMemTable()) {
       // There is room in current memtable
       break;
     } else if (imm_ != NULL) {
@@ -2047,16 +3788,24 @@ Status DBImpl::MakeRoomForWrite(bool force) {
       // one is still being compacted, so we wait.
       Log(options_.info_log, "wait imm ");
       MaybeScheduleCompaction();
+      const uint64_t stall_start = env_->NowMicros();
       bg_cv_.Wait();
+      RecordStall(kStallMemTable, stall_start);
       Log(options_.info_log, "wait imm over");
     } else if (ShouldLimitWrite(config::kL0_StopWritesTrigger)) {
       // There are too many level-0 files.
       Log(options_.info_log, "waiting...\n");
+      const uint64_t stall_start = env_->NowMicros();
       bg_cv_.Wait();
+      RecordStall(kStallL0Stop, stall_start);
     } else {
       // Attempt to switch to a new memtable and trigger compaction of old
       assert(versions_->PrevLogNumber() == 0);
       Log(options_.info_log, "new mem");
+      s = SyncLogBeforeSwitch();
+      if (!s.ok()) {
+        break;
+      }
       uint64_t new_log_number = versions_->NewFileNumber();
       // use ReadableAndWritableFile here to support outer reading
       ReadableAndWritableFile* lfile = NULL;
@@ -2074,6 +3823,8 @@ Status DBImpl::MakeRoomForWrite(bool force) {
       log_ = new log::Writer(lfile);
       imm_ = mem_;
       has_imm_.Release_Store(imm_);
+      imm_reserved_ = mem_reserved_;
+      mem_reserved_ = 0;
       mem_ = new MemTable(internal_comparator_, env_);
       mem_->Ref();
       force = false;   // Do not force another compaction if have room
@@ -2120,37 +3871,115 @@ bool DBImpl::GetProperty(const Slice& property, std::string* value,
       return true;
     }
   } else if (in == "stats") {
-    char buf[200];
+    char buf[256];
     snprintf(buf, sizeof(buf),
-             "                               Compactions\n"
-             "Level  Files Size(MB) Time(sec) Read(MB) Write(MB)\n"
-             "--------------------------------------------------\n"
+             "                                          Compactions\n"
+             "Level  Files Size(MB) Count Time(sec) Read(MB) ReadUp(MB) Write(MB) W-Amp Rate(MB/s)\n"
+             "-----------------------------------------------------------------------------------\n"
              );
     value->append(buf);
+    CompactionStats total;
     for (int level = 0; level < config::kNumLevels; level++) {
       int files = versions_->NumLevelFiles(level);
-      if (stats_[level].micros > 0 || files > 0) {
+      const CompactionStats& stats = stats_[level];
+      total.Add(stats);
+      if (stats.micros > 0 || files > 0) {
+        // W-Amp: bytes written to this level / bytes moved from upper level
         snprintf(
             buf, sizeof(buf),
-            "%3d %8d %8.0f %9.0f %8.0f %9.0f\n",
+            "%3d %8d %8.0f %5ld %9.0f %8.0f %10.0f %9.0f %5.1f %10.1f\n",
             level,
             files,
             versions_->NumLevelBytes(level) / 1048576.0,
-            stats_[level].micros / 1e6,
-            stats_[level].bytes_read / 1048576.0,
-            stats_[level].bytes_written / 1048576.0);
+            stats.count,
+            stats.micros / 1e6,
+            stats.bytes_read / 1048576.0,
+            stats.bytes_read_upper / 1048576.0,
+            stats.bytes_written / 1048576.0,
+            stats.bytes_read_upper > 0 ? static_cast<double>(stats.bytes_written) / stats.bytes_read_upper : 0.0,
+            stats.micros > 0 ? (stats.bytes_read + stats.bytes_written) / 1048576.0 / (stats.micros / 1e6) : 0.0);
+        value->append(buf);
+      }
+    }
+
+    const double uptime = (env_->NowMicros() - stats_start_micros_) / 1e6;
+    snprintf(buf, sizeof(buf),
+             "Flush: count %ld, write %.0f MB, time %.0f sec, avg %.1f ms, rate %.3f MB/s\n",
+             flush_stats_.count,
+             flush_stats_.bytes_written / 1048576.0,
+             flush_stats_.micros / 1e6,
+             flush_stats_.count > 0 ? flush_stats_.micros / 1e3 / flush_stats_.count : 0.0,
+             uptime > 0 ? flush_stats_.bytes_written / 1048576.0 / uptime : 0.0);
+    value->append(buf);
+    // all bytes written to sstable / bytes flushed from memtable
+    snprintf(buf, sizeof(buf),
+             "Write amplification: %.2f, compaction read %.0f MB, write %.0f MB in %.0f sec\n",
+             flush_stats_.bytes_written > 0 ?
+             static_cast<double>(flush_stats_.bytes_written + total.bytes_written) / flush_stats_.bytes_written : 0.0,
+             total.bytes_read / 1048576.0, total.bytes_written / 1048576.0, total.micros / 1e6);
+    value->append(buf);
+    snprintf(buf, sizeof(buf),
+             "Write stall(count/sec): L0 slowdown %ld/%.3f, memtable %ld/%.3f, L0 stop %ld/%.3f, "
+             "memtable count %ld/%.3f, reject %ld\n",
+             stall_stats_[kStallL0Slowdown].count, stall_stats_[kStallL0Slowdown].micros / 1e6,
+             stall_stats_[kStallMemTable].count, stall_stats_[kStallMemTable].micros / 1e6,
+             stall_stats_[kStallL0Stop].count, stall_stats_[kStallL0Stop].micros / 1e6,
+             stall_stats_[kStallMemTableCount].count, stall_stats_[kStallMemTableCount].micros / 1e6,
+             stall_stats_[kStallReject].count);
+    value->append(buf);
+    snprintf(buf, sizeof(buf), "Memtable(MB): mem %.1f, imm %.1f",
+             mem_->ApproximateMemoryUsage() / 1048576.0,
+             imm_ != NULL ? imm_->ApproximateMemoryUsage() / 1048576.0 : 0.0);
+    value->append(buf);
+    if (options_.write_buffer_manager != NULL) {
+      snprintf(buf, sizeof(buf), ", shared write buffer %.1f/%.1f",
+               options_.write_buffer_manager->memory_usage() / 1048576.0,
+               options_.write_buffer_manager->buffer_size() / 1048576.0);
+      value->append(buf);
+    }
+    value->append("\n");
+    const std::map<uint64_t, BlobFileMeta>& blob_files = versions_->current()->BlobFiles();
+    if (!blob_files.empty()) {
+      uint64_t blob_size = 0, blob_garbage = 0;
+      for (std::map<uint64_t, BlobFileMeta>::const_iterator it = blob_files.begin();
+           it != blob_files.end();
+           ++it) {
+        blob_size += it->second.file_size;
+        blob_garbage += it->second.garbage_size;
+      }
+      snprintf(buf, sizeof(buf), "Blob files: count %d, size %.1f MB, garbage %.1f MB, collecting %d\n",
+               static_cast<int>(blob_files.size()), blob_size / 1048576.0, blob_garbage / 1048576.0,
+               static_cast<int>(obsolete_blob_files_.size()));
+      value->append(buf);
+    }
+    if (options_.db_paths.size() > 1) {
+      std::vector<uint64_t> path_sizes(options_.db_paths.size(), 0);
+      std::vector<FileMetaData*>* files = versions_->current()->FileMetas();
+      for (int level = 0; level < config::kNumLevels; level++) {
+        for (size_t i = 0; i < files[level].size(); i++) {
+          path_sizes[files[level][i]->path_id] += files[level][i]->file_size;
+        }
+      }
+      value->append("Table paths(size/target MB):");
+      for (size_t p = 0; p < path_sizes.size(); p++) {
+        snprintf(buf, sizeof(buf), " %s %.1f/%.1f", options_.db_paths[p].path.c_str(),
+                 path_sizes[p] / 1048576.0, options_.db_paths[p].target_size / 1048576.0);
         value->append(buf);
       }
+      value->append("\n");
     }
+    value->append("L0 files(max per minute, latest first):");
+    L0HistoryString(value);
 
     mutex_.Unlock();
     // append cache statistics
+    // index and filter block are held by table, so table cache is for them.
     if (table_cache_ != NULL) {
-      value->append("Table Cache: ");
+      value->append("Table Cache(index/filter): ");
       table_cache_->Stats(*value);
     }
     if (options_.block_cache != NULL) {
-      value->append("Block Cache: ");
+      value->append("Block Cache(data): ");
       options_.block_cache->Stats(*value);
     }
     mutex_.Lock();
@@ -2173,6 +4002,11 @@ bool DBImpl::GetProperty(const Slice& property, std::string* value,
     snprintf(buf, sizeof(buf), "%lu", versions_->NextFileNumber());
     value->append(buf);
     return true;
+  } else if (in == "num-range-deletions") {
+    char buf[50];
+    snprintf(buf, sizeof(buf), "%lu", versions_->current()->RangeDeletions().size());
+    value->append(buf);
+    return true;
   } else if (in == "smallest-filenumber") {
     char buf [50];
     snprintf(buf, sizeof(buf), "%lu", versions_->SmallestFileNumber());
@@ -2296,6 +4130,14 @@ Status DB::Open(const Options& options, const std::string& dbname,
       impl->mutex_.Unlock();
       impl->DeleteObsoleteFiles();
       impl->mutex_.Lock();
+      // before any compaction, so files of current version stay
+      if (impl->options_.preload_table_threads > 0) {
+        const uint64_t start_us = impl->env_->NowMicros();
+        const int count = impl->versions_->PreloadTables(impl->options_.preload_table_threads);
+        Log(impl->options_.info_log, "Preload %d tables with %d threads cost %llu us",
+            count, impl->options_.preload_table_threads,
+            (unsigned long long) (impl->env_->NowMicros() - start_us));
+      }
       impl->MaybeScheduleCompaction();
     }
   }
@@ -2366,6 +4208,24 @@ Status DestroyDB(const std::string& dbname, const Options& options) {
         }
       }
     }
+    // table files under other paths
+    for (size_t p = 0; p < options.db_paths.size(); p++) {
+      const std::string& path = options.db_paths[p].path;
+      if (path == dbname) {
+        continue;
+      }
+      filenames.clear();
+      env->GetChildren(path, &filenames);
+      for (size_t i = 0; i < filenames.size(); i++) {
+        if (ParseFileName(filenames[i], &number, &type) && type == kTableFile) {
+          Status del = env->DeleteFile(path + "/" + filenames[i]);
+          if (result.ok() && !del.ok()) {
+            result = del;
+          }
+        }
+      }
+      env->DeleteDir(path);
+    }
     env->UnlockFile(lock);  // Ignore error since state is already gone
     env->DeleteFile(lockname);
     env->DeleteDir(dbname);  // Ignore error in case dir contains other files
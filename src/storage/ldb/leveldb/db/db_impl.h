@@ -12,12 +12,15 @@
 #include "db/dbformat.h"
 #include "db/log_writer.h"
 #include "db/snapshot.h"
+#include "db/version_edit.h"
 #include "leveldb/db.h"
 #include "leveldb/env.h"
 #include "port/port.h"
 
 namespace leveldb {
 
+class BlobFileBuilder;
+class BlobFileCache;
 class MemTable;
 class TableCache;
 class Version;
@@ -25,6 +28,7 @@ class VersionEdit;
 class VersionSet;
 
 struct LoggerId;
+struct BlobRecord;
 
 // multi-memtable update sharding by bucket
 struct BucketUpdate
@@ -55,6 +59,10 @@ class DBImpl : public DB {
   virtual Status Get(const ReadOptions& options,
                      const Slice& key,
                      std::string* value);
+  virtual Status Get(const ReadOptions& options,
+                     const Slice& key,
+                     PinnableSlice* value);
+  virtual bool KeyMayExist(const ReadOptions& options, const Slice& key);
   virtual Iterator* NewIterator(const ReadOptions&);
   virtual const Snapshot* GetSnapshot();
   virtual void ReleaseSnapshot(const Snapshot* snapshot);
@@ -67,6 +75,19 @@ class DBImpl : public DB {
   virtual void GetApproximateSizes(const Range* range, int n, uint64_t* sizes);
   virtual void CompactRange(const Slice* begin, const Slice* end);
   virtual Status CompactRangeSelfLevel(uint64_t limit_filenumber, const Slice* begin, const Slice* end);
+  virtual Status DeleteExpiredFiles(uint64_t* deleted_size);
+  virtual Status DeleteFilesInRange(uint64_t limit_filenumber, const Slice& begin, const Slice& end,
+                                    uint64_t* deleted_size);
+  virtual Status CompactExpiredFile(uint64_t min_expired_size, uint64_t* expired_size);
+  virtual Status ExportTables(const ReadOptions& options, const Slice& begin, const Slice& end,
+                              const std::string& dir, std::vector<std::string>* files);
+  virtual Status IngestTables(const std::vector<std::string>& files,
+                              void (*visitor)(void* arg, const Slice& key, const Slice& value) = NULL,
+                              void* arg = NULL);
+  virtual Status DeleteRange(const WriteOptions& options, const Slice& begin, const Slice& end);
+  virtual Status CompactRangeDeletions(int* remaining);
+  virtual Status CollectBlobGarbage(uint64_t* reclaimed_size);
+  virtual Status Checkpoint(const std::string& dir, uint64_t* sequence);
   virtual Status ForceCompactMemTable();
   virtual void ResetDbName(const std::string& dbname) { dbname_ = dbname; }
 
@@ -104,7 +125,8 @@ class DBImpl : public DB {
   struct Writer;
 
   Iterator* NewInternalIterator(const ReadOptions&,
-                                SequenceNumber* latest_snapshot);
+                                SequenceNumber* latest_snapshot,
+                                Version** version = NULL);
 
   Status NewDB();
 
@@ -125,10 +147,29 @@ class DBImpl : public DB {
                         VersionEdit* edit,
                         SequenceNumber* max_sequence);
 
-  Status WriteLevel0Table(MemTable* mem, VersionEdit* edit, Version* base);
+  // Insert batches in "records" into "mem" with "threads" threads.
+  Status InsertLogRecords(const std::vector<std::string>& records,
+                          MemTable* mem, int threads);
+
+  Status WriteLevel0Table(MemTable* mem, VersionEdit* edit, Version* base,
+                          SequenceNumber smallest_snapshot = kMaxSequenceNumber);
+  // Sequence of the oldest snapshot, or last sequence if none.
+  // REQUIRES: mutex_ is held
+  SequenceNumber SmallestSnapshot();
 
   Status MakeRoomForWrite(bool force /* compact even if there is room? */);
   WriteBatch* BuildBatchGroup(Writer** last_writer);
+  // Wait until log is synced up to the "ticket"th sync group,
+  // one waiter syncs for all groups appended so far.
+  // REQUIRES: mutex_ is held
+  Status SyncLogPipelined(uint64_t ticket);
+  // Sync what pipelined groups appended to current log before switching it.
+  // REQUIRES: mutex_ is held
+  Status SyncLogBeforeSwitch();
+  // Whether current memtable can take more writes, also account its
+  // memory to Options::write_buffer_manager.
+  // REQUIRES: mutex_ is held
+  bool HasRoomInMemTable();
 
   // multi-bucket memtable update
   Status MakeRoomForWrite(bool force, int bucket, BucketUpdate** bucket_update);
@@ -150,17 +191,58 @@ class DBImpl : public DB {
   Status OpenCompactionOutputFile(CompactionState* compact);
   Status FinishCompactionOutputFile(CompactionState* compact, Iterator* input);
   Status InstallCompactionResults(CompactionState* compact, bool uppen_level = true);
+  // Blob file of compaction outputs, see Options::blob_value_size
+  void OpenCompactionBlobFile(CompactionState* compact);
+  Status FinishCompactionBlobFile(CompactionState* compact);
 
   // specified selflevel compaction
   void BackgroundCompactionSelfLevel();
   Status DoCompactionWorkSelfLevel(CompactionState* compact);
 
+  // expired file stuff
+  void BackgroundDeleteExpiredFiles();
+  void BackgroundDeleteFilesInRange();
+  void BackgroundRemoveRangeDeletions();
+  // Return true if memtable or table being written may hold entries
+  // covered by deletion.
+  // REQUIRES: mutex_ is held
+  bool RangeDeletionInMemTable(const RangeDeletion& deletion);
+
+  // blob gc stuff
+  // Rewrite live values of blob file "number". *deferred is set if
+  // it can't be done now (values may be in bucket memtables).
+  Status RewriteBlobFile(uint64_t number, bool* deferred);
+  Status WriteBlobRecords(uint64_t number, const std::vector<BlobRecord>& records,
+                          int* count, bool* deferred);
+  void BackgroundDeleteBlobFiles();
+
+  // ingest table stuff
+  struct IngestState {
+    SequenceNumber sequence;    // sequence of all ingested entries
+    uint64_t first_number;      // files numbered from here may have newer entries
+    std::vector<FileMetaData> files;
+  };
+  Status WriteIngestedTable(const std::string& fname, SequenceNumber sequence, FileMetaData* meta,
+                            void (*visitor)(void* arg, const Slice& key, const Slice& value), void* arg);
+  void BackgroundIngestTables();
+  // REQUIRES: mutex_ is held
+  bool MemTableOverlap(const Slice& smallest_user_key, const Slice& largest_user_key);
+
   // rotate stuff 
   Status MaybeRotate();
 
   // should slowdown/stop write
   bool ShouldLimitWrite(int32_t trigger);
 
+  // value in sstable is pinned into *pinned if it is not NULL,
+  // then value must be pinned->GetSelf()
+  Status GetImpl(const ReadOptions& options, const Slice& key,
+                 std::string* value, PinnableSlice* pinned);
+
+  // report sstable read latency to tune background I/O rate
+  bool ShouldReportReadLatency();
+  void ReportReadLatency(uint64_t micros);
+
   // Constant after construction
   Env* const env_;
   const InternalKeyComparator internal_comparator_;
@@ -175,6 +257,8 @@ class DBImpl : public DB {
 
   // table_cache_ provides its own synchronization
   TableCache* table_cache_;
+  // blob_cache_ provides its own synchronization
+  BlobFileCache* blob_cache_;
 
   // Lock over the persistent DB state.  Non-NULL iff successfully acquired.
   FileLock* db_lock_;
@@ -197,6 +281,17 @@ class DBImpl : public DB {
   // Queue of writers.
   std::deque<Writer*> writers_;
   WriteBatch* tmp_batch_;
+  // members of current write group that are still inserting into memtable
+  int pending_mem_writers_;
+  // pipelined log sync (see Options::pipelined_log_sync).
+  // sync groups appended to log so far, and synced so far.
+  uint64_t log_sync_requested_;
+  uint64_t log_synced_;
+  bool log_syncing_;
+  port::CondVar log_sync_cv_;
+  // memory of mem_/imm_ reserved in Options::write_buffer_manager
+  size_t mem_reserved_;
+  size_t imm_reserved_;
 
   SnapshotList snapshots_;
   SnapshotList log_snapshots_;
@@ -218,6 +313,10 @@ class DBImpl : public DB {
   // part of ongoing compactions.
   std::set<uint64_t> pending_outputs_;
 
+  // Blob files whose live values are rewritten, mapped to last sequence
+  // after rewriting. They are deleted when no older snapshot exists.
+  std::map<uint64_t, SequenceNumber> obsolete_blob_files_;
+
   // how many times to delete obsolete files continuously
   int64_t has_limited_delete_obsolete_file_count_;
 
@@ -236,10 +335,16 @@ class DBImpl : public DB {
     BgCompactionFunc bg_compaction_func; // specified compaction function
     bool reschedule;            // whether re-schecheled other compaction when this compaction is completed
     Status compaction_status;
-    ManualCompaction() : bg_compaction_func(NULL), reschedule(true) {}
+    uint64_t result_size;       // bytes handled, just specified for special use
+    void* arg;                  // argument of bg_compaction_func, just specified for special use
+    ManualCompaction() : bg_compaction_func(NULL), reschedule(true), result_size(0), arg(NULL) {}
   };
   ManualCompaction* manual_compaction_;
 
+  // schedule manual compaction and wait until it's done or failed
+  // REQUIRES: mutex_ is held
+  Status RunManualCompaction(ManualCompaction* manual);
+
   VersionSet* versions_;
 
   // Have we encountered a background error in paranoid mode?
@@ -252,19 +357,61 @@ class DBImpl : public DB {
   // Per level compaction stats.  stats_[level] stores the stats for
   // compactions that produced data for the specified "level".
   struct CompactionStats {
+    int64_t count;
     int64_t micros;
     int64_t bytes_read;
+    // bytes read from the upper level(level - 1), part of bytes_read
+    int64_t bytes_read_upper;
     int64_t bytes_written;
 
-    CompactionStats() : micros(0), bytes_read(0), bytes_written(0) { }
+    CompactionStats() : count(0), micros(0), bytes_read(0), bytes_read_upper(0), bytes_written(0) { }
 
     void Add(const CompactionStats& c) {
+      this->count += c.count;
       this->micros += c.micros;
       this->bytes_read += c.bytes_read;
+      this->bytes_read_upper += c.bytes_read_upper;
       this->bytes_written += c.bytes_written;
     }
   };
   CompactionStats stats_[config::kNumLevels];
+  // memtable dump stats, bytes_written is what user writes finally.
+  CompactionStats flush_stats_;
+  uint64_t stats_start_micros_;
+
+  // Write stall stats, guarded by mutex_
+  enum StallType {
+    kStallL0Slowdown = 0,       // delay 1ms for too many level-0 files
+    kStallMemTable,             // wait for imm dumping
+    kStallL0Stop,               // wait for level-0 compaction
+    kStallMemTableCount,        // wait for too many bucket memtables
+    kStallReject,               // return SlowWrite to user
+    kNumStallTypes
+  };
+  struct StallStats {
+    int64_t count;
+    int64_t micros;
+    StallStats() : count(0), micros(0) { }
+  };
+  StallStats stall_stats_[kNumStallTypes];
+  void RecordStall(StallType type, uint64_t start_micros) {
+    stall_stats_[type].count++;
+    if (start_micros > 0) {
+      stall_stats_[type].micros += env_->NowMicros() - start_micros;
+    }
+  }
+
+  // Level-0 file count history, max count of each minute
+  // in the last kL0HistorySize minutes, guarded by mutex_
+  static const int kL0HistorySize = 60;
+  struct L0History {
+    uint64_t minute;
+    int max_files;
+  };
+  L0History l0_history_[kL0HistorySize];
+  // REQUIRES: mutex_ is held
+  void RecordL0FileCount();
+  void L0HistoryString(std::string* value);
 
   // No copying allowed
   DBImpl(const DBImpl&);
@@ -4,8 +4,10 @@
 
 #include "db/db_iter.h"
 
+#include "db/blob_file.h"
 #include "db/filename.h"
 #include "db/dbformat.h"
+#include "db/version_set.h"
 #include "leveldb/env.h"
 #include "leveldb/iterator.h"
 #include "port/port.h"
@@ -47,14 +49,18 @@ class DBIter: public Iterator {
   };
 
   DBIter(const std::string* dbname, Env* env,
-         const Comparator* cmp, Iterator* iter, SequenceNumber s)
+         const Comparator* cmp, Iterator* iter, SequenceNumber s,
+         const Version* version, BlobFileCache* blob_cache)
       : dbname_(dbname),
         env_(env),
         user_comparator_(cmp),
         iter_(iter),
         sequence_(s),
+        version_(version != NULL && version->HasRangeDeletions() ? version : NULL),
+        blob_cache_(blob_cache),
         direction_(kForward),
-        valid_(false) {
+        valid_(false),
+        blob_value_valid_(false) {
   }
   virtual ~DBIter() {
     delete iter_;
@@ -66,7 +72,10 @@ class DBIter: public Iterator {
   }
   virtual Slice value() const {
     assert(valid_);
-    return (direction_ == kForward) ? iter_->value() : saved_value_;
+    if (direction_ == kForward) {
+      return blob_value_valid_ ? Slice(blob_value_) : iter_->value();
+    }
+    return saved_value_;
   }
   virtual Status status() const {
     if (status_.ok()) {
@@ -86,6 +95,11 @@ class DBIter: public Iterator {
   void FindNextUserEntry(bool skipping, std::string* skip);
   void FindPrevUserEntry();
   bool ParseKey(ParsedInternalKey* key);
+  bool ReadBlobValue(const Slice& index, std::string* value);
+
+  inline bool IsRangeDeleted(const ParsedInternalKey& ikey) {
+    return version_ != NULL && version_->IsRangeDeleted(ikey.user_key, ikey.sequence, sequence_);
+  }
 
   inline void SaveKey(const Slice& k, std::string* dst) {
     dst->assign(k.data(), k.size());
@@ -105,12 +119,16 @@ class DBIter: public Iterator {
   const Comparator* const user_comparator_;
   Iterator* const iter_;
   SequenceNumber const sequence_;
+  const Version* const version_;  // only to check range deletions
+  BlobFileCache* const blob_cache_;
 
   Status status_;
   std::string saved_key_;     // == current key when direction_==kReverse
-  std::string saved_value_;   // == current raw value when direction_==kReverse
+  std::string saved_value_;   // == current value when direction_==kReverse
+  std::string blob_value_;    // == current value read from blob file when direction_==kForward
   Direction direction_;
   bool valid_;
+  bool blob_value_valid_;
 
   // No copying allowed
   DBIter(const DBIter&);
@@ -126,6 +144,15 @@ inline bool DBIter::ParseKey(ParsedInternalKey* ikey) {
   }
 }
 
+bool DBIter::ReadBlobValue(const Slice& index, std::string* value) {
+  if (blob_cache_ == NULL) {
+    status_ = Status::NotSupported("blob file is not supported");
+  } else {
+    status_ = blob_cache_->Get(ReadOptions(), index, value);
+  }
+  return status_.ok();
+}
+
 void DBIter::Next() {
   assert(valid_);
 
@@ -156,6 +183,7 @@ void DBIter::FindNextUserEntry(bool skipping, std::string* skip) {
   // Loop until we hit an acceptable entry to yield
   assert(iter_->Valid());
   assert(direction_ == kForward);
+  blob_value_valid_ = false;
   do {
     ParsedInternalKey ikey;
     if (ParseKey(&ikey) && ikey.sequence <= sequence_) {
@@ -167,17 +195,27 @@ void DBIter::FindNextUserEntry(bool skipping, std::string* skip) {
           skipping = true;
           break;
         case kTypeValue:
+        case kTypeBlobIndex:
           if (skipping &&
               user_comparator_->Compare(ikey.user_key, *skip) <= 0) {
             // Entry hidden
           } else if (user_comparator_->ShouldDrop(ikey.user_key.data(), ikey.sequence) ||
-                     user_comparator_->ShouldDropMaybe(ikey.user_key.data(), ikey.sequence)) {
+                     user_comparator_->ShouldDropMaybe(ikey.user_key, EntryValueHead(ikey.type, iter_->value()),
+                                                       ikey.sequence) ||
+                     IsRangeDeleted(ikey)) {
             // should drop, skip all upcoming entries for this key.
             SaveKey(ikey.user_key, skip);
             skipping = true;
           } else {
-            valid_ = true;
             saved_key_.clear();
+            if (ikey.type == kTypeBlobIndex) {
+              if (!ReadBlobValue(iter_->value(), &blob_value_)) {
+                valid_ = false;
+                return;
+              }
+              blob_value_valid_ = true;
+            }
+            valid_ = true;
             return;
           }
           break;
@@ -231,7 +269,7 @@ void DBIter::FindPrevUserEntry() {
           // We encountered a non-deleted value in entries for previous keys,
           break;
         }
-        value_type = ikey.type;
+        value_type = IsRangeDeleted(ikey) ? kTypeDeletion : ikey.type;
         if (value_type == kTypeDeletion) {
           saved_key_.clear();
           ClearSavedValue();
@@ -249,6 +287,14 @@ void DBIter::FindPrevUserEntry() {
     } while (iter_->Valid());
   }
 
+  if (value_type == kTypeBlobIndex) {
+    std::string index;
+    index.swap(saved_value_);
+    if (!ReadBlobValue(index, &saved_value_)) {
+      value_type = kTypeDeletion;
+    }
+  }
+
   if (value_type == kTypeDeletion) {
     // End
     valid_ = false;
@@ -299,8 +345,11 @@ Iterator* NewDBIterator(
     Env* env,
     const Comparator* user_key_comparator,
     Iterator* internal_iter,
-    const SequenceNumber& sequence) {
-  return new DBIter(dbname, env, user_key_comparator, internal_iter, sequence);
+    const SequenceNumber& sequence,
+    const Version* version,
+    BlobFileCache* blob_cache) {
+  return new DBIter(dbname, env, user_key_comparator, internal_iter, sequence, version,
+                    blob_cache);
 }
 
 }  // namespace leveldb
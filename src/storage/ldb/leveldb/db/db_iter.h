@@ -11,15 +11,23 @@
 
 namespace leveldb {
 
+class BlobFileCache;
+class Version;
+
 // Return a new iterator that converts internal keys (yielded by
 // "*internal_iter") that were live at the specified "sequence" number
 // into appropriate user keys.
+// Entries covered by range deletions of "version" are hidden, "version"
+// must remain live while the returned iterator is live.
+// Values moved into blob files are read through "blob_cache".
 extern Iterator* NewDBIterator(
     const std::string* dbname,
     Env* env,
     const Comparator* user_key_comparator,
     Iterator* internal_iter,
-    const SequenceNumber& sequence);
+    const SequenceNumber& sequence,
+    const Version* version = NULL,
+    BlobFileCache* blob_cache = NULL);
 
 }  // namespace leveldb
 
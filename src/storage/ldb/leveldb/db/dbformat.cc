@@ -98,12 +98,21 @@ void InternalKeyComparator::FindShortSuccessor(std::string* key) const {
   }
 }
 
+bool InternalKeyComparator::Hash(const Slice& key, uint32_t* hash) const {
+  return user_comparator_->Hash(ExtractUserKey(key), hash);
+}
+
 const char* InternalFilterPolicy::Name() const {
   return user_policy_->Name();
 }
 
 void InternalFilterPolicy::CreateFilter(const Slice* keys, int n,
                                         std::string* dst) const {
+  CreateFilterForLevel(keys, n, dst, -1);
+}
+
+void InternalFilterPolicy::CreateFilterForLevel(const Slice* keys, int n,
+                                                std::string* dst, int level) const {
   // We rely on the fact that the code in table.cc does not mind us
   // adjusting keys[].
   Slice* mkey = const_cast<Slice*>(keys);
@@ -111,7 +120,7 @@ void InternalFilterPolicy::CreateFilter(const Slice* keys, int n,
     mkey[i] = ExtractUserKey(keys[i]);
     // TODO(sanjay): Suppress dups?
   }
-  user_policy_->CreateFilter(keys, n, dst);
+  user_policy_->CreateFilterForLevel(keys, n, dst, level);
 }
 
 bool InternalFilterPolicy::KeyMayMatch(const Slice& key, const Slice& f) const {
@@ -47,6 +47,9 @@ enum ValueType {
   // DeletionWithTailer means deletde key with some tailer attached which
   // may be useful for user when parsing key directly from binlog, eg.
   kTypeDeletionWithTailer = 0x2,
+  // Value is moved into blob file, entry holds BlobIndex (see db/blob_file.h).
+  // It only exists in sstable.
+  kTypeBlobIndex = 0x3,
 };
 // kValueTypeForSeek defines the ValueType that should be passed when
 // constructing a ParsedInternalKey object for seeking to a particular
@@ -54,7 +57,7 @@ enum ValueType {
 // and the value type is embedded as the low 8 bits in the sequence
 // number in internal keys, we need to use the highest-numbered
 // ValueType, not the lowest).
-static const ValueType kValueTypeForSeek = kTypeValue;
+static const ValueType kValueTypeForSeek = kTypeBlobIndex;
 
 static const size_t kInternalKeySeqSize = 8;
 static const size_t kInternalKeyBaseSize = kInternalKeySeqSize;
@@ -120,6 +123,8 @@ class InternalKeyComparator : public Comparator {
       std::string* start,
       const Slice& limit) const;
   virtual void FindShortSuccessor(std::string* key) const;
+  // all versions of one user key have the same hash
+  virtual bool Hash(const Slice& key, uint32_t* hash) const;
 
   const Comparator* user_comparator() const { return user_comparator_; }
 
@@ -134,6 +139,8 @@ class InternalFilterPolicy : public FilterPolicy {
   explicit InternalFilterPolicy(const FilterPolicy* p) : user_policy_(p) { }
   virtual const char* Name() const;
   virtual void CreateFilter(const Slice* keys, int n, std::string* dst) const;
+  virtual void CreateFilterForLevel(const Slice* keys, int n, std::string* dst,
+                                    int level) const;
   virtual bool KeyMayMatch(const Slice& key, const Slice& filter) const;
 };
 
@@ -184,7 +191,8 @@ inline bool ParseInternalKey(const Slice& internal_key,
   result->sequence = num >> 8;
   result->type = static_cast<ValueType>(c);
   result->user_key = Slice(internal_key.data(), n - kInternalKeyBaseSize);
-  return (c <= static_cast<unsigned char>(kTypeValue));
+  return (c <= static_cast<unsigned char>(kTypeValue) ||
+          c == static_cast<unsigned char>(kTypeBlobIndex));
 }
 
 // A helper class useful for DBImpl::Get()
@@ -39,6 +39,20 @@ std::string TableFileName(const std::string& name, uint64_t number) {
   return MakeFileName(name, number, "sst");
 }
 
+std::string TablePath(const Options& options, const std::string& dbname,
+                      uint32_t path_id) {
+  if (options.db_paths.empty()) {
+    return dbname;
+  }
+  assert(path_id < options.db_paths.size());
+  return options.db_paths[path_id].path;
+}
+
+std::string BlobFileName(const std::string& name, uint64_t number) {
+  assert(number > 0);
+  return MakeFileName(name, number, "blob");
+}
+
 std::string DescriptorFileName(const std::string& dbname, uint64_t number) {
   assert(number > 0);
   char buf[100];
@@ -115,6 +129,8 @@ bool ParseFileName(const std::string& fname,
       *type = kTableFile;
     } else if (suffix == Slice(".dbtmp")) {
       *type = kTempFile;
+    } else if (suffix == Slice(".blob")) {
+      *type = kBlobFile;
     } else {
       return false;
     }
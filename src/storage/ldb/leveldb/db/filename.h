@@ -9,6 +9,7 @@
 
 #include <stdint.h>
 #include <string>
+#include "leveldb/options.h"
 #include "leveldb/slice.h"
 #include "leveldb/status.h"
 #include "port/port.h"
@@ -25,7 +26,8 @@ enum FileType {
   kCurrentFile,
   kTempFile,
   kInfoLogFile,  // Either the current one, or an old one
-  kBucketLogFile
+  kBucketLogFile,
+  kBlobFile
 };
 
 // Return the name of the bucket log file with the specified number
@@ -43,6 +45,16 @@ extern std::string LogFileName(const std::string& dbname, uint64_t number);
 // "dbname".
 extern std::string TableFileName(const std::string& dbname, uint64_t number);
 
+// Return the directory holding table files of path "path_id", that is
+// options.db_paths[path_id], or "dbname" if db_paths is empty.
+extern std::string TablePath(const Options& options, const std::string& dbname,
+                             uint32_t path_id);
+
+// Return the name of the blob file with the specified number
+// in the db named by "dbname".  The result will be prefixed with
+// "dbname".
+extern std::string BlobFileName(const std::string& dbname, uint64_t number);
+
 // Return the name of the descriptor file for the db named by
 // "dbname" and the specified incarnation number.  The result will be
 // prefixed with "dbname".
@@ -63,6 +63,10 @@ class Reader {
   // Undefined before the first call to ReadRecord.
   uint64_t LastRecordOffset();
 
+  // Returns the physical offset just past the last record returned by
+  // ReadRecord, valid right after ReadRecord returns true.
+  uint64_t EndOfLastRecordOffset() { return end_of_buffer_offset_ - buffer_.size(); }
+
   SequentialFile* SFile() { return sfile_; }
   RandomAccessFile* RFile() { return rfile_; }
 
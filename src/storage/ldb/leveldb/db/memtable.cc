@@ -22,7 +22,8 @@ MemTable::MemTable(const InternalKeyComparator& cmp, Env* env)
     : comparator_(cmp),
       refs_(0),
       table_(comparator_, &arena_),
-      env_(env) {
+      env_(env),
+      smallest_sequence_(0) {
 }
 
 MemTable::~MemTable() {
@@ -82,7 +83,8 @@ Iterator* MemTable::NewIterator() {
 
 void MemTable::Add(SequenceNumber s, ValueType type,
                    const Slice& key,
-                   const Slice& value) {
+                   const Slice& value,
+                   bool concurrent) {
   // Format of an entry is concatenation of:
   //  key_size     : varint32 of internal_key.size()
   //  key bytes    : char[internal_key.size()]
@@ -94,7 +96,8 @@ void MemTable::Add(SequenceNumber s, ValueType type,
   const size_t encoded_len =
       VarintLength(internal_key_size) + internal_key_size +
       VarintLength(val_size) + val_size;
-  char* buf = arena_.Allocate(encoded_len);
+  char* buf = concurrent ? arena_.AllocateConcurrently(encoded_len) :
+    arena_.Allocate(encoded_len);
   char* p = EncodeVarint32(buf, internal_key_size);
   memcpy(p, key.data(), key_size);
   p += key_size;
@@ -103,10 +106,24 @@ void MemTable::Add(SequenceNumber s, ValueType type,
   p = EncodeVarint32(p, val_size);
   memcpy(p, value.data(), val_size);
   assert((p + val_size) - buf == (int)encoded_len);
-  table_.Insert(buf);
+  if (!concurrent) {
+    table_.Insert(buf);
+    if (smallest_sequence_ == 0) {
+      smallest_sequence_ = s;
+    }
+  } else {
+    table_.InsertConcurrently(buf);
+    // entries are not added in sequence order, keep the smallest one
+    SequenceNumber old = smallest_sequence_;
+    while ((old == 0 || s < old) &&
+           !__sync_bool_compare_and_swap(&smallest_sequence_, old, s)) {
+      old = smallest_sequence_;
+    }
+  }
 }
 
-bool MemTable::Get(const LookupKey& key, std::string* value, Status* s) {
+bool MemTable::Get(const LookupKey& key, std::string* value, Status* s,
+                   SequenceNumber* seq) {
   Slice memkey = key.memtable_key();
   Table::Iterator iter(&table_);
   iter.Seek(memkey.data());
@@ -130,13 +147,17 @@ bool MemTable::Get(const LookupKey& key, std::string* value, Status* s) {
       const uint64_t tag = DecodeFixed64(key_ptr + key_length - kInternalKeySeqSize);
       switch (static_cast<ValueType>(tag & 0xff)) {
         case kTypeValue: {
+          Slice v = GetLengthPrefixedSlice(key_ptr + key_length);
           if (comparator_.comparator.user_comparator()->ShouldDrop(key_ptr, (tag >> 8)) ||
-              comparator_.comparator.user_comparator()->ShouldDropMaybe(key_ptr, (tag >> 8))) {
+              comparator_.comparator.user_comparator()->ShouldDropMaybe(
+                  Slice(key_ptr, key_length - kInternalKeyBaseSize), v, (tag >> 8))) {
             *s = Status::NotFound(Slice());
             return true;
           } else {
-            Slice v = GetLengthPrefixedSlice(key_ptr + key_length);
             value->assign(v.data(), v.size());
+            if (seq != NULL) {
+              *seq = tag >> 8;
+            }
             return true;
           }
         }
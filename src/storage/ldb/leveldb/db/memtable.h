@@ -53,15 +53,23 @@ class MemTable {
   // Add an entry into memtable that maps key to value at the
   // specified sequence number and with the specified type.
   // Typically value will be empty if type==kTypeDeletion.
+  // If concurrent is true, several threads can Add() at the same time
+  // (see SkipList::InsertConcurrently()).
   void Add(SequenceNumber seq, ValueType type,
            const Slice& key,
-           const Slice& value);
+           const Slice& value,
+           bool concurrent = false);
 
-  // If memtable contains a value for key, store it in *value and return true.
+  // If memtable contains a value for key, store it in *value and return true,
+  // its sequence is stored in *seq if seq is not NULL.
   // If memtable contains a deletion for key, store a NotFound() error
   // in *status and return true.
   // Else, return false.
-  bool Get(const LookupKey& key, std::string* value, Status* s);
+  bool Get(const LookupKey& key, std::string* value, Status* s,
+           SequenceNumber* seq = NULL);
+
+  // Sequence of the first entry added, 0 if memtable is empty.
+  SequenceNumber SmallestSequence() const { return smallest_sequence_; }
 
  private:
   ~MemTable();  // Private since only Unref() should be used to delete it
@@ -81,6 +89,7 @@ class MemTable {
   Arena arena_;
   Table table_;
   Env* const env_;
+  volatile SequenceNumber smallest_sequence_;
 
   // No copying allowed
   MemTable(const MemTable&);
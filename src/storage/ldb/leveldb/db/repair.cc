@@ -109,6 +109,7 @@ class Repairer {
 
   std::vector<std::string> manifests_;
   std::vector<uint64_t> table_numbers_;
+  std::vector<uint64_t> blob_numbers_;
   std::vector<uint64_t> logs_;
   std::vector<TableInfo> tables_;
   uint64_t next_file_number_;
@@ -137,6 +138,8 @@ class Repairer {
             logs_.push_back(number);
           } else if (type == kTableFile) {
             table_numbers_.push_back(number);
+          } else if (type == kBlobFile) {
+            blob_numbers_.push_back(number);
           } else {
             // Ignore other files
           }
@@ -274,7 +277,7 @@ class Repairer {
     Status status = env_->GetFileSize(fname, &t->meta.file_size);
     if (status.ok()) {
       Iterator* iter = table_cache_->NewIterator(
-          ReadOptions(), t->meta.number, t->meta.file_size);
+          ReadOptions(), t->meta.number, t->meta.file_size, 0);
       bool empty = true;
       ParsedInternalKey parsed;
       t->max_sequence = 0;
@@ -336,6 +339,15 @@ class Repairer {
                     t.meta.smallest, t.meta.largest);
     }
 
+    // keep blob files that tables may point to, garbage is unknown
+    for (size_t i = 0; i < blob_numbers_.size(); i++) {
+      BlobFileMeta meta;
+      meta.number = blob_numbers_[i];
+      if (env_->GetFileSize(BlobFileName(dbname_, meta.number), &meta.file_size).ok()) {
+        edit_.AddBlobFile(meta);
+      }
+    }
+
     //fprintf(stderr, "NewDescriptor:\n%s\n", edit_.DebugString().c_str());
     {
       log::Writer log(file);
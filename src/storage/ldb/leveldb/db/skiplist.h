@@ -6,6 +6,8 @@
 // -------------
 //
 // Writes require external synchronization, most likely a mutex.
+// Except that InsertConcurrently() can be called by several writers at
+// the same time, as long as no Insert() is running then.
 // Reads require a guarantee that the SkipList will not be destroyed
 // while the read is in progress.  Apart from that, reads progress
 // without any internal locking or synchronization.
@@ -49,6 +51,12 @@ class SkipList {
   // REQUIRES: nothing that compares equal to key is currently in the list.
   void Insert(const Key& key);
 
+  // Like Insert(), but concurrent callers are allowed. Nodes are linked
+  // with compare-and-swap, so no lock is needed among callers.
+  // REQUIRES: nothing that compares equal to key is in or being inserted
+  // into the list.
+  void InsertConcurrently(const Key& key);
+
   // Returns true iff an entry that compares equal to key is in the list.
   bool Contains(const Key& key) const;
 
@@ -112,8 +120,10 @@ class SkipList {
   // Read/written only by Insert().
   Random rnd_;
 
-  Node* NewNode(const Key& key, int height);
+  Node* NewNode(const Key& key, int height, bool concurrent = false);
   int RandomHeight();
+  // Thread-safe version of RandomHeight(), use per-thread random seed.
+  int RandomHeightConcurrently();
   bool Equal(const Key& a, const Key& b) const { return (compare_(a, b) == 0); }
 
   // Return true if key is greater than the data stored in "n"
@@ -126,6 +136,11 @@ class SkipList {
   // node at "level" for every level in [0..max_height_-1].
   Node* FindGreaterOrEqual(const Key& key, Node** prev) const;
 
+  // Search forward from "before" at "level" only, fill the pair of nodes
+  // that key should be placed between.
+  void FindSpliceForLevel(const Key& key, Node* before, int level,
+                          Node** out_prev, Node** out_next) const;
+
   // Return the latest node with a key < key.
   // Return head_ if there is no such node.
   Node* FindLessThan(const Key& key) const;
@@ -170,6 +185,11 @@ struct SkipList<Key,Comparator>::Node {
     assert(n >= 0);
     next_[n].NoBarrier_Store(x);
   }
+  // Full barrier, link is changed only if it is still "expected".
+  bool CASNext(int n, Node* expected, Node* x) {
+    assert(n >= 0);
+    return next_[n].CompareAndSwap(expected, x);
+  }
 
  private:
   // Array of length equal to the node height.  next_[0] is lowest level link.
@@ -178,9 +198,10 @@ struct SkipList<Key,Comparator>::Node {
 
 template<typename Key, class Comparator>
 typename SkipList<Key,Comparator>::Node*
-SkipList<Key,Comparator>::NewNode(const Key& key, int height) {
-  char* mem = arena_->AllocateAligned(
-      sizeof(Node) + sizeof(port::AtomicPointer) * (height - 1));
+SkipList<Key,Comparator>::NewNode(const Key& key, int height, bool concurrent) {
+  const size_t size = sizeof(Node) + sizeof(port::AtomicPointer) * (height - 1);
+  char* mem = concurrent ? arena_->AllocateAlignedConcurrently(size) :
+    arena_->AllocateAligned(size);
   return new (mem) Node(key);
 }
 
@@ -249,6 +270,24 @@ int SkipList<Key,Comparator>::RandomHeight() {
   return height;
 }
 
+template<typename Key, class Comparator>
+int SkipList<Key,Comparator>::RandomHeightConcurrently() {
+  static const unsigned int kBranching = 4;
+  static __thread uint32_t seed = 0;
+  if (seed == 0) {
+    seed = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&seed)) ^ 0xdeadbeef;
+  }
+  Random rnd(seed);
+  int height = 1;
+  while (height < kMaxHeight && ((rnd.Next() % kBranching) == 0)) {
+    height++;
+  }
+  seed = rnd.Next();
+  assert(height > 0);
+  assert(height <= kMaxHeight);
+  return height;
+}
+
 template<typename Key, class Comparator>
 bool SkipList<Key,Comparator>::KeyIsAfterNode(const Key& key, Node* n) const {
   // NULL n is considered infinite
@@ -277,6 +316,21 @@ typename SkipList<Key,Comparator>::Node* SkipList<Key,Comparator>::FindGreaterOr
   }
 }
 
+template<typename Key, class Comparator>
+void SkipList<Key,Comparator>::FindSpliceForLevel(const Key& key, Node* before, int level,
+                                                  Node** out_prev, Node** out_next) const {
+  while (true) {
+    Node* next = before->Next(level);
+    if (KeyIsAfterNode(key, next)) {
+      before = next;
+    } else {
+      *out_prev = before;
+      *out_next = next;
+      return;
+    }
+  }
+}
+
 template<typename Key, class Comparator>
 typename SkipList<Key,Comparator>::Node*
 SkipList<Key,Comparator>::FindLessThan(const Key& key) const {
@@ -366,6 +420,46 @@ void SkipList<Key,Comparator>::Insert(const Key& key) {
   }
 }
 
+template<typename Key, class Comparator>
+void SkipList<Key,Comparator>::InsertConcurrently(const Key& key) {
+  const int height = RandomHeightConcurrently();
+  int max_height = GetMaxHeight();
+  while (height > max_height) {
+    // Same as Insert(), readers seeing new height before new links
+    // from head_ just drop to lower level.
+    if (max_height_.CompareAndSwap(reinterpret_cast<void*>(max_height),
+                                   reinterpret_cast<void*>(height))) {
+      max_height = height;
+      break;
+    }
+    max_height = GetMaxHeight();
+  }
+
+  Node* prev[kMaxHeight];
+  Node* next[kMaxHeight];
+  Node* before = head_;
+  for (int i = max_height - 1; i >= 0; i--) {
+    FindSpliceForLevel(key, before, i, &prev[i], &next[i]);
+    before = prev[i];
+  }
+
+  Node* x = NewNode(key, height, true);
+  // Link from bottom up, so that a node reachable at level i is always
+  // reachable at all levels below i.
+  for (int i = 0; i < height; i++) {
+    while (true) {
+      // NoBarrier_SetNext() suffices since CASNext() is a full barrier.
+      x->NoBarrier_SetNext(i, next[i]);
+      if (prev[i]->CASNext(i, next[i], x)) {
+        break;
+      }
+      // Others inserted between prev[i] and next[i], just search
+      // forward from prev[i], since it is still before key.
+      FindSpliceForLevel(key, prev[i], i, &prev[i], &next[i]);
+    }
+  }
+}
+
 template<typename Key, class Comparator>
 bool SkipList<Key,Comparator>::Contains(const Key& key) const {
   Node* x = FindGreaterOrEqual(key, NULL);
@@ -6,6 +6,7 @@
 
 #include "db/filename.h"
 #include "leveldb/env.h"
+#include "leveldb/pinnable_slice.h"
 #include "leveldb/table.h"
 #include "util/coding.h"
 
@@ -43,14 +44,17 @@ TableCache::~TableCache() {
 }
 
 Status TableCache::FindTable(uint64_t file_number, uint64_t file_size,
-                             Cache::Handle** handle) {
+                             uint32_t path_id, Cache::Handle** handle,
+                             bool cache_only) {
   Status s;
   char buf[sizeof(file_number)];
   EncodeFixed64(buf, file_number);
   Slice key(buf, sizeof(buf));
   *handle = cache_->Lookup(key);
-  if (*handle == NULL) {
-    std::string fname = TableFileName(dbname_, file_number);
+  if (*handle == NULL && cache_only) {
+    s = Status::Incomplete("table not opened");
+  } else if (*handle == NULL) {
+    std::string fname = TableFileName(TablePath(*options_, dbname_, path_id), file_number);
     RandomAccessFile* file = NULL;
     Table* table = NULL;
     s = env_->NewRandomAccessFile(fname, &file);
@@ -75,16 +79,30 @@ Status TableCache::FindTable(uint64_t file_number, uint64_t file_size,
   return s;
 }
 
+Status TableCache::Load(uint64_t file_number,
+                        uint64_t file_size,
+                        uint32_t path_id,
+                        size_t* charge) {
+  Cache::Handle* handle = NULL;
+  Status s = FindTable(file_number, file_size, path_id, &handle);
+  if (s.ok()) {
+    *charge = reinterpret_cast<TableAndFile*>(cache_->Value(handle))->table->ApproximateMemoryUsage();
+    cache_->Release(handle);
+  }
+  return s;
+}
+
 Iterator* TableCache::NewIterator(const ReadOptions& options,
                                   uint64_t file_number,
                                   uint64_t file_size,
+                                  uint32_t path_id,
                                   Table** tableptr) {
   if (tableptr != NULL) {
     *tableptr = NULL;
   }
 
   Cache::Handle* handle = NULL;
-  Status s = FindTable(file_number, file_size, &handle);
+  Status s = FindTable(file_number, file_size, path_id, &handle, options.cache_only);
   if (!s.ok()) {
     return NewErrorIterator(s);
   }
@@ -101,21 +119,57 @@ Iterator* TableCache::NewIterator(const ReadOptions& options,
 Status TableCache::Get(const ReadOptions& options,
                        uint64_t file_number,
                        uint64_t file_size,
+                       uint32_t path_id,
                        const Slice& k,
                        void* arg,
-                       void (*saver)(void*, const Slice&, const Slice&)) {
+                       void (*saver)(void*, const Slice&, const Slice&),
+                       PinnableSlice* pinned) {
   Cache::Handle* handle = NULL;
   PROFILER_BEGIN("findtable");
-  Status s = FindTable(file_number, file_size, &handle);
+  Status s = FindTable(file_number, file_size, path_id, &handle, options.cache_only);
   PROFILER_END();
   if (s.ok()) {
     Table* t = reinterpret_cast<TableAndFile*>(cache_->Value(handle))->table;
-    s = t->InternalGet(options, k, arg, saver);
-    cache_->Release(handle);
+    s = t->InternalGet(options, k, arg, saver, pinned);
+    if (pinned != NULL && pinned->IsPinned()) {
+      // block may be in mmaped file, keep table opened
+      pinned->RegisterCleanup(&UnrefEntry, cache_, handle);
+    } else {
+      cache_->Release(handle);
+    }
   }
   return s;
 }
 
+bool TableCache::KeyMayMatch(const ReadOptions& options,
+                             uint64_t file_number,
+                             uint64_t file_size,
+                             uint32_t path_id,
+                             const Slice& k) {
+  bool may_match = true;
+  Cache::Handle* handle = NULL;
+  Status s = FindTable(file_number, file_size, path_id, &handle, options.cache_only);
+  if (s.ok()) {
+    Table* t = reinterpret_cast<TableAndFile*>(cache_->Value(handle))->table;
+    may_match = t->InternalKeyMayMatch(options, k);
+    cache_->Release(handle);
+  }
+  return may_match;
+}
+
+void TableCache::Prefetch(const ReadOptions& options,
+                          uint64_t file_number,
+                          uint64_t file_size,
+                          uint32_t path_id) {
+  Cache::Handle* handle = NULL;
+  Status s = FindTable(file_number, file_size, path_id, &handle, options.cache_only);
+  if (s.ok()) {
+    Table* t = reinterpret_cast<TableAndFile*>(cache_->Value(handle))->table;
+    t->Prefetch(options.readahead_size);
+    cache_->Release(handle);
+  }
+}
+
 void TableCache::Evict(uint64_t file_number) {
   char buf[sizeof(file_number)];
   EncodeFixed64(buf, file_number);
@@ -24,7 +24,8 @@ class TableCache {
   ~TableCache();
 
   // Return an iterator for the specified file number (the corresponding
-  // file length must be exactly "file_size" bytes).  If "tableptr" is
+  // file length must be exactly "file_size" bytes, and file is in
+  // Options::db_paths[path_id]).  If "tableptr" is
   // non-NULL, also sets "*tableptr" to point to the Table object
   // underlying the returned iterator, or NULL if no Table object underlies
   // the returned iterator.  The returned "*tableptr" object is owned by
@@ -33,28 +34,58 @@ class TableCache {
   Iterator* NewIterator(const ReadOptions& options,
                         uint64_t file_number,
                         uint64_t file_size,
+                        uint32_t path_id,
                         Table** tableptr = NULL);
 
   // If a seek to internal key "k" in specified file finds an entry,
   // call (*handle_result)(arg, found_key, found_value).
+  // If handle_result pins found value into "pinned", the table and
+  // data block are kept until "pinned" is reset.
   Status Get(const ReadOptions& options,
              uint64_t file_number,
              uint64_t file_size,
+             uint32_t path_id,
              const Slice& k,
              void* arg,
-             void (*handle_result)(void*, const Slice&, const Slice&));
+             void (*handle_result)(void*, const Slice&, const Slice&),
+             PinnableSlice* pinned = NULL);
+
+  // Return false if filter of the specified file proves that
+  // internal key "k" is absent. Any error is considered as may match.
+  bool KeyMayMatch(const ReadOptions& options,
+                   uint64_t file_number,
+                   uint64_t file_size,
+                   uint32_t path_id,
+                   const Slice& k);
+
+  // Open the specified file into cache if it is not there, and hint
+  // first options.readahead_size bytes of its data to OS.
+  void Prefetch(const ReadOptions& options,
+                uint64_t file_number,
+                uint64_t file_size,
+                uint32_t path_id);
+
+  // Open the specified file into cache if it is not there, and set
+  // *charge to memory the opened table takes in cache.
+  Status Load(uint64_t file_number,
+              uint64_t file_size,
+              uint32_t path_id,
+              size_t* charge);
 
   // Evict any entry for the specified file number
   void Evict(uint64_t file_number);
 
   void Stats(std::string& result);
+  void HitStats(uint64_t* hit, uint64_t* miss) { cache_->HitStats(hit, miss); }
  private:
   Env* const env_;
   const std::string dbname_;
   const Options* options_;
   Cache* cache_;
 
-  Status FindTable(uint64_t file_number, uint64_t file_size, Cache::Handle**);
+  // Table not opened yet is Status::Incomplete() if cache_only is true
+  Status FindTable(uint64_t file_number, uint64_t file_size, uint32_t path_id,
+                   Cache::Handle**, bool cache_only = false);
 };
 
 }  // namespace leveldb
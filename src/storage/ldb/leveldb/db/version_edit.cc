@@ -4,6 +4,7 @@
 
 #include "db/version_edit.h"
 
+#include "db/blob_file.h"
 #include "db/version_set.h"
 #include "util/coding.h"
 
@@ -20,9 +21,58 @@ enum Tag {
   kDeletedFile          = 6,
   kNewFile              = 7,
   // 8 was used for large value refs
-  kPrevLogNumber        = 9
+  kPrevLogNumber        = 9,
+  kNewFileWithTimeMeta  = 10, // kNewFile with FileTimeMeta
+  kRangeDeletion        = 11,
+  kRemovedRangeDeletion = 12,
+  kNewBlobFile          = 13,
+  kBlobGarbage          = 14,
+  kDeletedBlobFile      = 15,
+  kFilePathId           = 16  // path of preceding new file if it is not 0
 };
 
+void FileTimeMeta::Add(const Comparator* user_comparator,
+                       const Slice& internal_key, const Slice& value) {
+  uint64_t size = internal_key.size() + value.size();
+  raw_size += size;
+
+  ParsedInternalKey ikey;
+  uint32_t expired_time = 0, modify_time = 0;
+  // separated value keeps its head in blob index for time meta
+  BlobIndex index;
+  // deletion never expires, and unknown entry is considered so
+  if (user_comparator != NULL &&
+      ParseInternalKey(internal_key, &ikey) &&
+      (ikey.type == kTypeValue ||
+       (ikey.type == kTypeBlobIndex && index.DecodeFrom(value))) &&
+      user_comparator->GetTimeMeta(ikey.user_key, ikey.type == kTypeValue ? value : index.value_head,
+                                   &expired_time, &modify_time)) {
+    if (expired_time > 0) {
+      if (expire_size == 0 || expired_time < smallest_expire) {
+        smallest_expire = expired_time;
+      }
+      if (expired_time > largest_expire) {
+        largest_expire = expired_time;
+      }
+      expire_size += size;
+    }
+    if (modify_time > 0 && (smallest_mdate == 0 || modify_time < smallest_mdate)) {
+      smallest_mdate = modify_time;
+    }
+  }
+}
+
+uint64_t FileTimeMeta::ExpiredSize(uint32_t now) const {
+  if (expire_size == 0 || now <= smallest_expire) {
+    return 0;
+  }
+  if (now > largest_expire) {
+    return expire_size;
+  }
+  return static_cast<uint64_t>(static_cast<double>(expire_size) * (now - smallest_expire) /
+                               (largest_expire - smallest_expire + 1));
+}
+
 void VersionEdit::Clear() {
   comparator_.clear();
   log_number_ = 0;
@@ -36,9 +86,17 @@ void VersionEdit::Clear() {
   has_last_sequence_ = false;
   deleted_files_.clear();
   new_files_.clear();
+  new_range_deletions_.clear();
+  removed_range_deletions_.clear();
+  has_range_deletion_base_ = false;
+  range_deletion_base_ = 0;
+  kept_range_deletions_.clear();
+  new_blob_files_.clear();
+  blob_garbage_.clear();
+  deleted_blob_files_.clear();
 }
 
-void VersionEdit::EncodeTo(std::string* dst) const {
+void VersionEdit::EncodeTo(std::string* dst, bool with_time_meta) const {
   if (has_comparator_) {
     PutVarint32(dst, kComparator);
     PutLengthPrefixedSlice(dst, comparator_);
@@ -76,12 +134,65 @@ void VersionEdit::EncodeTo(std::string* dst) const {
 
   for (size_t i = 0; i < new_files_.size(); i++) {
     const FileMetaData& f = new_files_[i].second;
-    PutVarint32(dst, kNewFile);
+    const bool has_time_meta = with_time_meta && f.time_meta.Valid();
+    PutVarint32(dst, has_time_meta ? kNewFileWithTimeMeta : kNewFile);
     PutVarint32(dst, new_files_[i].first);  // level
     PutVarint64(dst, f.number);
     PutVarint64(dst, f.file_size);
     PutLengthPrefixedSlice(dst, f.smallest.Encode());
     PutLengthPrefixedSlice(dst, f.largest.Encode());
+    if (has_time_meta) {
+      PutVarint32(dst, f.time_meta.smallest_expire);
+      PutVarint32(dst, f.time_meta.largest_expire);
+      PutVarint32(dst, f.time_meta.smallest_mdate);
+      PutVarint64(dst, f.time_meta.raw_size);
+      PutVarint64(dst, f.time_meta.expire_size);
+    }
+    if (f.path_id != 0) {
+      PutVarint32(dst, kFilePathId);
+      PutVarint64(dst, f.number);
+      PutVarint32(dst, f.path_id);
+    }
+  }
+
+  for (size_t i = 0; i < new_range_deletions_.size(); i++) {
+    const RangeDeletion& d = new_range_deletions_[i];
+    PutVarint32(dst, kRangeDeletion);
+    PutLengthPrefixedSlice(dst, d.begin);
+    PutLengthPrefixedSlice(dst, d.end);
+    PutVarint64(dst, d.sequence);
+    PutVarint64(dst, d.file_number);
+  }
+
+  for (std::set<SequenceNumber>::const_iterator iter = removed_range_deletions_.begin();
+       iter != removed_range_deletions_.end();
+       ++iter) {
+    PutVarint32(dst, kRemovedRangeDeletion);
+    PutVarint64(dst, *iter);
+  }
+
+  for (size_t i = 0; i < new_blob_files_.size(); i++) {
+    const BlobFileMeta& f = new_blob_files_[i];
+    PutVarint32(dst, kNewBlobFile);
+    PutVarint64(dst, f.number);
+    PutVarint64(dst, f.file_size);
+    PutVarint64(dst, f.entries);
+    PutVarint64(dst, f.garbage_size);
+  }
+
+  for (std::map<uint64_t, uint64_t>::const_iterator iter = blob_garbage_.begin();
+       iter != blob_garbage_.end();
+       ++iter) {
+    PutVarint32(dst, kBlobGarbage);
+    PutVarint64(dst, iter->first);
+    PutVarint64(dst, iter->second);
+  }
+
+  for (std::set<uint64_t>::const_iterator iter = deleted_blob_files_.begin();
+       iter != deleted_blob_files_.end();
+       ++iter) {
+    PutVarint32(dst, kDeletedBlobFile);
+    PutVarint64(dst, *iter);
   }
 }
 
@@ -117,7 +228,12 @@ Status VersionEdit::DecodeFrom(const Slice& src) {
   uint64_t number;
   FileMetaData f;
   Slice str;
+  Slice str2;
   InternalKey key;
+  RangeDeletion deletion;
+  BlobFileMeta blob;
+  uint64_t size;
+  uint32_t path_id;
 
   while (msg == NULL && GetVarint32(&input, &tag)) {
     switch (tag) {
@@ -186,12 +302,93 @@ Status VersionEdit::DecodeFrom(const Slice& src) {
             GetVarint64(&input, &f.file_size) &&
             GetInternalKey(&input, &f.smallest) &&
             GetInternalKey(&input, &f.largest)) {
+          f.time_meta.Clear();
           new_files_.push_back(std::make_pair(level, f));
         } else {
           msg = "new-file entry";
         }
         break;
 
+      case kNewFileWithTimeMeta:
+        if (GetLevel(&input, &level) &&
+            GetVarint64(&input, &f.number) &&
+            GetVarint64(&input, &f.file_size) &&
+            GetInternalKey(&input, &f.smallest) &&
+            GetInternalKey(&input, &f.largest) &&
+            GetVarint32(&input, &f.time_meta.smallest_expire) &&
+            GetVarint32(&input, &f.time_meta.largest_expire) &&
+            GetVarint32(&input, &f.time_meta.smallest_mdate) &&
+            GetVarint64(&input, &f.time_meta.raw_size) &&
+            GetVarint64(&input, &f.time_meta.expire_size)) {
+          new_files_.push_back(std::make_pair(level, f));
+        } else {
+          msg = "new-file entry with time meta";
+        }
+        break;
+
+      case kRangeDeletion:
+        if (GetLengthPrefixedSlice(&input, &str) &&
+            GetLengthPrefixedSlice(&input, &str2) &&
+            GetVarint64(&input, &deletion.sequence) &&
+            GetVarint64(&input, &deletion.file_number)) {
+          deletion.begin = str.ToString();
+          deletion.end = str2.ToString();
+          new_range_deletions_.push_back(deletion);
+        } else {
+          msg = "range deletion";
+        }
+        break;
+
+      case kRemovedRangeDeletion:
+        if (GetVarint64(&input, &number)) {
+          removed_range_deletions_.insert(number);
+        } else {
+          msg = "removed range deletion";
+        }
+        break;
+
+      case kFilePathId:
+        msg = "file path entry";
+        if (GetVarint64(&input, &number) &&
+            GetVarint32(&input, &path_id)) {
+          for (size_t i = 0; i < new_files_.size(); i++) {
+            if (new_files_[i].second.number == number) {
+              new_files_[i].second.path_id = path_id;
+              msg = NULL;
+              break;
+            }
+          }
+        }
+        break;
+
+      case kNewBlobFile:
+        if (GetVarint64(&input, &blob.number) &&
+            GetVarint64(&input, &blob.file_size) &&
+            GetVarint64(&input, &blob.entries) &&
+            GetVarint64(&input, &blob.garbage_size)) {
+          new_blob_files_.push_back(blob);
+        } else {
+          msg = "new blob file";
+        }
+        break;
+
+      case kBlobGarbage:
+        if (GetVarint64(&input, &number) &&
+            GetVarint64(&input, &size)) {
+          blob_garbage_[number] += size;
+        } else {
+          msg = "blob garbage";
+        }
+        break;
+
+      case kDeletedBlobFile:
+        if (GetVarint64(&input, &number)) {
+          deleted_blob_files_.insert(number);
+        } else {
+          msg = "deleted blob file";
+        }
+        break;
+
       default:
         msg = "unknown tag";
         break;
@@ -258,6 +455,65 @@ std::string VersionEdit::DebugString() const {
     r.append(f.smallest.DebugString());
     r.append(" .. ");
     r.append(f.largest.DebugString());
+    if (f.time_meta.Valid()) {
+      r.append(" expire ");
+      AppendNumberTo(&r, f.time_meta.smallest_expire);
+      r.append(" .. ");
+      AppendNumberTo(&r, f.time_meta.largest_expire);
+      r.append(" mdate ");
+      AppendNumberTo(&r, f.time_meta.smallest_mdate);
+      r.append(" raw ");
+      AppendNumberTo(&r, f.time_meta.raw_size);
+      r.append(" expire-raw ");
+      AppendNumberTo(&r, f.time_meta.expire_size);
+    }
+    if (f.path_id != 0) {
+      r.append(" path ");
+      AppendNumberTo(&r, f.path_id);
+    }
+  }
+  for (size_t i = 0; i < new_range_deletions_.size(); i++) {
+    const RangeDeletion& d = new_range_deletions_[i];
+    r.append("\n  RangeDeletion: ");
+    AppendNumberTo(&r, d.sequence);
+    r.append(" ");
+    AppendNumberTo(&r, d.file_number);
+    r.append(" '");
+    AppendEscapedStringTo(&r, d.begin);
+    r.append("' .. '");
+    AppendEscapedStringTo(&r, d.end);
+    r.append("'");
+  }
+  for (std::set<SequenceNumber>::const_iterator iter = removed_range_deletions_.begin();
+       iter != removed_range_deletions_.end();
+       ++iter) {
+    r.append("\n  RemoveRangeDeletion: ");
+    AppendNumberTo(&r, *iter);
+  }
+  for (size_t i = 0; i < new_blob_files_.size(); i++) {
+    const BlobFileMeta& f = new_blob_files_[i];
+    r.append("\n  AddBlobFile: ");
+    AppendNumberTo(&r, f.number);
+    r.append(" ");
+    AppendNumberTo(&r, f.file_size);
+    r.append(" entries ");
+    AppendNumberTo(&r, f.entries);
+    r.append(" garbage ");
+    AppendNumberTo(&r, f.garbage_size);
+  }
+  for (std::map<uint64_t, uint64_t>::const_iterator iter = blob_garbage_.begin();
+       iter != blob_garbage_.end();
+       ++iter) {
+    r.append("\n  BlobGarbage: ");
+    AppendNumberTo(&r, iter->first);
+    r.append(" ");
+    AppendNumberTo(&r, iter->second);
+  }
+  for (std::set<uint64_t>::const_iterator iter = deleted_blob_files_.begin();
+       iter != deleted_blob_files_.end();
+       ++iter) {
+    r.append("\n  DeleteBlobFile: ");
+    AppendNumberTo(&r, *iter);
   }
   r.append("\n}\n");
   return r;
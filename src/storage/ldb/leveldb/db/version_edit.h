@@ -5,6 +5,7 @@
 #ifndef STORAGE_LEVELDB_DB_VERSION_EDIT_H_
 #define STORAGE_LEVELDB_DB_VERSION_EDIT_H_
 
+#include <map>
 #include <set>
 #include <utility>
 #include <vector>
@@ -14,6 +15,36 @@ namespace leveldb {
 
 class VersionSet;
 
+// Summary of user-defined time meta of all entries in one table file.
+// (see Comparator::GetTimeMeta())
+struct FileTimeMeta {
+  uint32_t smallest_expire;   // smallest expired time of entries that will expire
+  uint32_t largest_expire;    // largest expired time of entries that will expire
+  uint32_t smallest_mdate;    // smallest modify time, 0 means unknown
+  uint64_t raw_size;          // raw bytes(key + value) of all entries, 0 means no time meta
+  uint64_t expire_size;       // raw bytes of entries that will expire
+
+  FileTimeMeta() { Clear(); }
+
+  void Clear() {
+    smallest_expire = largest_expire = smallest_mdate = 0;
+    raw_size = expire_size = 0;
+  }
+  bool Valid() const { return raw_size > 0; }
+
+  // Account one entry of the file.
+  void Add(const Comparator* user_comparator, const Slice& internal_key, const Slice& value);
+
+  // All entries in the file have expired at `now.
+  bool AllExpired(uint32_t now) const {
+    return Valid() && expire_size == raw_size && largest_expire < now;
+  }
+
+  // Estimated raw bytes of entries that have expired at `now,
+  // expired time is considered to be uniform in [smallest_expire, largest_expire].
+  uint64_t ExpiredSize(uint32_t now) const;
+};
+
 struct FileMetaData {
   // int refs;
   // 'refs will be updated in VersionSet::LogAppApply()::Apply()/SaveTo() and ~Version().
@@ -24,8 +55,47 @@ struct FileMetaData {
   uint64_t file_size;         // File size in bytes
   InternalKey smallest;       // Smallest internal key served by table
   InternalKey largest;        // Largest internal key served by table
+  FileTimeMeta time_meta;     // Time meta of entries in table
+  uint32_t path_id;           // Index of Options::db_paths the file is in
+
+  // Estimated file bytes that have expired at `now
+  uint64_t ExpiredFileSize(uint32_t now) const {
+    return time_meta.Valid() ?
+      static_cast<uint64_t>(static_cast<double>(file_size) * time_meta.ExpiredSize(now) / time_meta.raw_size) : 0;
+  }
+
+  FileMetaData() : refs(0), allowed_seeks(1 << 30), file_size(0), path_id(0) { }
+};
+
+// Entries in user key range [begin, end) with sequence less than "sequence"
+// are deleted. Table files numbered not less than "file_number" are written
+// after the deletion is recorded and never hold such entries, older files
+// may hold them until they are compacted. A deletion recorded again with
+// the same sequence replaces the old record (file_number is moved forward
+// when newer files may hold covered entries, see VersionSet::LogAndApply()).
+struct RangeDeletion {
+  std::string begin;
+  std::string end;
+  SequenceNumber sequence;
+  uint64_t file_number;
+
+  RangeDeletion() : sequence(0), file_number(0) { }
+};
+
+// Blob file holding values separated from tables (see db/blob_file.h).
+// Record of value that is overwritten, deleted or dropped becomes garbage
+// when compaction drops the entry pointing to it.
+struct BlobFileMeta {
+  uint64_t number;
+  uint64_t file_size;
+  uint64_t entries;
+  uint64_t garbage_size;      // bytes of garbage records
 
-  FileMetaData() : refs(0), allowed_seeks(1 << 30), file_size(0) { }
+  BlobFileMeta() : number(0), file_size(0), entries(0), garbage_size(0) { }
+
+  double GarbageRatio() const {
+    return file_size > 0 ? static_cast<double>(garbage_size) / file_size : 0.0;
+  }
 };
 
 class VersionEdit {
@@ -65,12 +135,16 @@ class VersionEdit {
   void AddFile(int level, uint64_t file,
                uint64_t file_size,
                const InternalKey& smallest,
-               const InternalKey& largest) {
+               const InternalKey& largest,
+               const FileTimeMeta& time_meta = FileTimeMeta(),
+               uint32_t path_id = 0) {
     FileMetaData f;
     f.number = file;
     f.file_size = file_size;
     f.smallest = smallest;
     f.largest = largest;
+    f.time_meta = time_meta;
+    f.path_id = path_id;
     new_files_.push_back(std::make_pair(level, f));
   }
 
@@ -79,7 +153,49 @@ class VersionEdit {
     deleted_files_.insert(std::make_pair(level, file));
   }
 
-  void EncodeTo(std::string* dst) const;
+  void AddRangeDeletion(const RangeDeletion& deletion) {
+    new_range_deletions_.push_back(deletion);
+  }
+
+  // Remove the range deletion identified by its sequence.
+  void RemoveRangeDeletion(SequenceNumber sequence) {
+    removed_range_deletions_.insert(sequence);
+  }
+
+  // Files added by this edit are written by a job that dropped entries
+  // covered by range deletions up to "sequence" (the newest one of the
+  // version it read). Not persisted.
+  void SetRangeDeletionBase(SequenceNumber sequence) {
+    has_range_deletion_base_ = true;
+    range_deletion_base_ = sequence;
+  }
+
+  // Files added by this edit keep entries covered by the range deletion
+  // of "sequence" for snapshots. Not persisted.
+  void KeepRangeDeletion(SequenceNumber sequence) {
+    kept_range_deletions_.insert(sequence);
+  }
+
+  void AddBlobFile(const BlobFileMeta& meta) {
+    new_blob_files_.push_back(meta);
+  }
+
+  // Records of "size" bytes in blob file "number" become garbage.
+  void AddBlobGarbage(uint64_t number, uint64_t size) {
+    if (size > 0) {
+      blob_garbage_[number] += size;
+    }
+  }
+
+  void DeleteBlobFile(uint64_t number) {
+    deleted_blob_files_.insert(number);
+  }
+
+  bool HasBlobGarbage() const { return !blob_garbage_.empty(); }
+
+  // New files are recorded with time meta only if with_time_meta,
+  // which older version can NOT decode.
+  void EncodeTo(std::string* dst, bool with_time_meta = false) const;
   Status DecodeFrom(const Slice& src);
 
   std::string DebugString() const;
@@ -103,6 +219,14 @@ class VersionEdit {
   std::vector< std::pair<int, InternalKey> > compact_pointers_;
   DeletedFileSet deleted_files_;
   std::vector< std::pair<int, FileMetaData> > new_files_;
+  std::vector<RangeDeletion> new_range_deletions_;
+  std::set<SequenceNumber> removed_range_deletions_;
+  bool has_range_deletion_base_;
+  SequenceNumber range_deletion_base_;
+  std::set<SequenceNumber> kept_range_deletions_;
+  std::vector<BlobFileMeta> new_blob_files_;
+  std::map<uint64_t, uint64_t> blob_garbage_;
+  std::set<uint64_t> deleted_blob_files_;
 };
 
 }  // namespace leveldb
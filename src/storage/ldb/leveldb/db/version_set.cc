@@ -7,16 +7,19 @@
 #include <algorithm>
 #include <stdio.h>
 
+#include "db/blob_file.h"
 #include "db/filename.h"
 #include "db/log_writer.h"
 #include "db/memtable.h"
 #include "db/table_cache.h"
 #include "leveldb/env.h"
+#include "leveldb/pinnable_slice.h"
 #include "leveldb/table_builder.h"
 #include "table/merger.h"
 #include "table/two_level_iterator.h"
 #include "util/coding.h"
 #include "util/logging.h"
+#include "util/mutexlock.h"
 
 namespace leveldb {
 
@@ -199,6 +202,7 @@ class Version::LevelFileNumIterator : public Iterator {
     assert(Valid());
     EncodeFixed64(value_buf_, (*flist_)[index_]->number);
     EncodeFixed64(value_buf_+8, (*flist_)[index_]->file_size);
+    EncodeFixed32(value_buf_+16, (*flist_)[index_]->path_id);
     return Slice(value_buf_, sizeof(value_buf_));
   }
   virtual Status status() const { return Status::OK(); }
@@ -207,26 +211,69 @@ class Version::LevelFileNumIterator : public Iterator {
   const std::vector<FileMetaData*>* const flist_;
   uint32_t index_;
 
-  // Backing store for value().  Holds the file number and size.
-  mutable char value_buf_[16];
+  // Backing store for value().  Holds the file number, size and path.
+  mutable char value_buf_[20];
 };
 
 static Iterator* GetFileIterator(void* arg,
                                  const ReadOptions& options,
                                  const Slice& file_value) {
   TableCache* cache = reinterpret_cast<TableCache*>(arg);
-  if (file_value.size() != 16) {
+  if (file_value.size() != 20) {
     return NewErrorIterator(
         Status::Corruption("FileReader invoked with unexpected value"));
   } else {
     return cache->NewIterator(options,
                               DecodeFixed64(file_value.data()),
-                              DecodeFixed64(file_value.data() + 8));
+                              DecodeFixed64(file_value.data() + 8),
+                              DecodeFixed32(file_value.data() + 16));
   }
 }
 
+namespace {
+// Arg of GetScanFileIterator(), deleted with the concatenating iterator
+struct ScanFiles {
+  TableCache* table_cache;
+  const std::vector<FileMetaData*>* files;
+  static void Delete(void* arg, void* ignored) {
+    delete reinterpret_cast<ScanFiles*>(arg);
+  }
+};
+}
+
+// GetFileIterator() that also prefetches the next file of level, so a
+// sequential scan finds it opened and its head read ahead.
+static Iterator* GetScanFileIterator(void* arg,
+                                     const ReadOptions& options,
+                                     const Slice& file_value) {
+  ScanFiles* scan = reinterpret_cast<ScanFiles*>(arg);
+  Iterator* iter = GetFileIterator(scan->table_cache, options, file_value);
+  if (file_value.size() == 20) {
+    const uint64_t number = DecodeFixed64(file_value.data());
+    const std::vector<FileMetaData*>& files = *scan->files;
+    for (size_t i = 0; i + 1 < files.size(); i++) {
+      if (files[i]->number == number) {
+        scan->table_cache->Prefetch(options, files[i+1]->number,
+                                    files[i+1]->file_size, files[i+1]->path_id);
+        break;
+      }
+    }
+  }
+  return iter;
+}
+
 Iterator* Version::NewConcatenatingIterator(const ReadOptions& options,
                                             int level) const {
+  if (options.prefetch_table && options.readahead_size > 0 && !options.cache_only) {
+    ScanFiles* scan = new ScanFiles;
+    scan->table_cache = vset_->table_cache_;
+    scan->files = &files_[level];
+    Iterator* iter = NewTwoLevelIterator(
+        new LevelFileNumIterator(vset_->icmp_, &files_[level]),
+        &GetScanFileIterator, scan, options);
+    iter->RegisterCleanup(&ScanFiles::Delete, scan, NULL);
+    return iter;
+  }
   return NewTwoLevelIterator(
       new LevelFileNumIterator(vset_->icmp_, &files_[level]),
       &GetFileIterator, vset_->table_cache_, options);
@@ -238,7 +285,8 @@ void Version::AddIterators(const ReadOptions& options,
   for (size_t i = 0; i < files_[0].size(); i++) {
     iters->push_back(
         vset_->table_cache_->NewIterator(
-            options, files_[0][i]->number, files_[0][i]->file_size));
+            options, files_[0][i]->number, files_[0][i]->file_size,
+            files_[0][i]->path_id));
   }
 
   // For levels > 0, we can use a concatenating iterator that sequentially
@@ -265,6 +313,10 @@ struct Saver {
   const Comparator* ucmp;
   Slice user_key;
   std::string* value;
+  PinnableSlice* pinned;        // pin value instead of copying if not NULL
+  const Version* version;       // check range deletions if not NULL
+  SequenceNumber snapshot;
+  bool blob_index;              // found value is a BlobIndex
 };
 }
 static void SaveValue(void* arg, const Slice& ikey, const Slice& v) {
@@ -274,14 +326,22 @@ static void SaveValue(void* arg, const Slice& ikey, const Slice& v) {
     s->state = kCorrupt;
   } else {
     if (s->ucmp->Compare(parsed_key.user_key, s->user_key) == 0) {
-      if (parsed_key.type == kTypeValue) {
+      if (parsed_key.type == kTypeValue || parsed_key.type == kTypeBlobIndex) {
         // check should drop
         if (s->ucmp->ShouldDrop(parsed_key.user_key.data(), parsed_key.sequence) ||
-            s->ucmp->ShouldDropMaybe(parsed_key.user_key.data(), parsed_key.sequence)) {
+            s->ucmp->ShouldDropMaybe(parsed_key.user_key, EntryValueHead(parsed_key.type, v),
+                                     parsed_key.sequence) ||
+            (s->version != NULL &&
+             s->version->IsRangeDeleted(parsed_key.user_key, parsed_key.sequence, s->snapshot))) {
           s->state = kDropped;
         } else {
           s->state = kFound;
-          s->value->assign(v.data(), v.size());
+          s->blob_index = (parsed_key.type == kTypeBlobIndex);
+          if (s->pinned != NULL && !s->blob_index) {
+            s->pinned->PinSlice(v);
+          } else {
+            s->value->assign(v.data(), v.size());
+          }
         }
       } else {
         s->state = kDeleted;
@@ -297,7 +357,9 @@ static bool NewestFirst(FileMetaData* a, FileMetaData* b) {
 Status Version::Get(const ReadOptions& options,
                     const LookupKey& k,
                     std::string* value,
-                    GetStats* stats) {
+                    GetStats* stats,
+                    bool* is_blob_index,
+                    PinnableSlice* pinned) {
   Slice ikey = k.internal_key();
   Slice user_key = k.user_key();
   const Comparator* ucmp = vset_->icmp_.user_comparator();
@@ -305,6 +367,8 @@ Status Version::Get(const ReadOptions& options,
 
   stats->seek_file = NULL;
   stats->seek_file_level = -1;
+  // sequence of lookup key is the snapshot
+  const SequenceNumber snapshot = DecodeFixed64(ikey.data() + ikey.size() - kInternalKeySeqSize) >> 8;
   FileMetaData* last_file_read = NULL;
   int last_file_read_level = -1;
 
@@ -374,8 +438,12 @@ Status Version::Get(const ReadOptions& options,
       saver.ucmp = ucmp;
       saver.user_key = user_key;
       saver.value = value;
-      s = vset_->table_cache_->Get(options, f->number, f->file_size,
-                                   ikey, &saver, SaveValue);
+      saver.pinned = pinned;
+      saver.version = range_deletions_.empty() ? NULL : this;
+      saver.snapshot = snapshot;
+      saver.blob_index = false;
+      s = vset_->table_cache_->Get(options, f->number, f->file_size, f->path_id,
+                                   ikey, &saver, SaveValue, pinned);
       if (!s.ok()) {
         return s;
       }
@@ -383,6 +451,17 @@ Status Version::Get(const ReadOptions& options,
         case kNotFound:
           break;      // Keep searching in other files
         case kFound:
+          if (is_blob_index != NULL) {
+            *is_blob_index = saver.blob_index;
+          } else if (saver.blob_index) {
+            if (vset_->blob_cache_ == NULL) {
+              s = Status::NotSupported("blob file is not supported");
+            } else {
+              std::string index;
+              index.swap(*value);
+              s = vset_->blob_cache_->Get(options, index, value);
+            }
+          }
           return s;
         case kDeleted:          // deleted
         case kDropped:          // or dropped(expired/gc)
@@ -399,6 +478,39 @@ Status Version::Get(const ReadOptions& options,
   return Status::NotFound(Slice());  // Use an empty error message for speed
 }
 
+bool Version::KeyMayExist(const ReadOptions& options, const LookupKey& k) {
+  Slice ikey = k.internal_key();
+  Slice user_key = k.user_key();
+  const Comparator* ucmp = vset_->icmp_.user_comparator();
+
+  for (int level = 0; level < config::kNumLevels; level++) {
+    size_t num_files = files_[level].size();
+    if (num_files == 0) continue;
+
+    if (level == 0) {
+      // Level-0 files may overlap each other, check all.
+      for (uint32_t i = 0; i < num_files; i++) {
+        FileMetaData* f = files_[level][i];
+        if (ucmp->Compare(user_key, f->smallest.user_key()) >= 0 &&
+            ucmp->Compare(user_key, f->largest.user_key()) <= 0 &&
+            vset_->table_cache_->KeyMayMatch(options, f->number, f->file_size, f->path_id, ikey)) {
+          return true;
+        }
+      }
+    } else {
+      uint32_t index = FindFile(vset_->icmp_, files_[level], ikey);
+      if (index < num_files) {
+        FileMetaData* f = files_[level][index];
+        if (ucmp->Compare(user_key, f->smallest.user_key()) >= 0 &&
+            vset_->table_cache_->KeyMayMatch(options, f->number, f->file_size, f->path_id, ikey)) {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
 bool Version::UpdateStats(const GetStats& stats) {
   // ignore seek compaction
   if (!config::kDoSeekCompaction) {
@@ -471,6 +583,185 @@ bool Version::OverlapInLevel(int level,
                                smallest_user_key, largest_user_key);
 }
 
+int Version::PickLevelForIngestedTable(uint64_t newer_number,
+                                       const Slice& smallest_user_key,
+                                       const Slice& largest_user_key) {
+  const Comparator* ucmp = vset_->icmp_.user_comparator();
+  int level = config::kNumLevels - 1;
+  for (int l = config::kNumLevels - 1; l >= 0; l--) {
+    for (size_t i = 0; i < files_[l].size(); i++) {
+      FileMetaData* f = files_[l][i];
+      if (AfterFile(ucmp, &smallest_user_key, f) || BeforeFile(ucmp, &largest_user_key, f)) {
+        continue;
+      }
+      if (f->number >= newer_number) {
+        return -1;
+      }
+      // level-0 files may overlap each other, newer file is searched first.
+      level = l > 0 ? l - 1 : 0;
+    }
+  }
+  return level;
+}
+
+SequenceNumber Version::RangeDeletionCovering(const Slice& user_key,
+                                              SequenceNumber sequence) const {
+  if (range_fragments_.empty()) {
+    return 0;
+  }
+  const Comparator* ucmp = vset_->icmp_.user_comparator();
+  // last fragment beginning at or before user_key
+  size_t left = 0, right = range_fragments_.size();
+  while (left < right) {
+    const size_t mid = (left + right) / 2;
+    if (ucmp->Compare(range_fragments_[mid].begin, user_key) <= 0) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  if (left == 0) {
+    return 0;
+  }
+  const std::vector<SequenceNumber>& sequences = range_fragments_[left - 1].sequences;
+  std::vector<SequenceNumber>::const_iterator it =
+    std::upper_bound(sequences.begin(), sequences.end(), sequence);
+  return it != sequences.end() ? *it : 0;
+}
+
+bool Version::RangeDeletionInFiles(const RangeDeletion& deletion) const {
+  const Comparator* ucmp = vset_->icmp_.user_comparator();
+  const Slice begin(deletion.begin);
+  for (int level = 0; level < config::kNumLevels; level++) {
+    for (size_t i = 0; i < files_[level].size(); i++) {
+      FileMetaData* f = files_[level][i];
+      if (f->number < deletion.file_number &&
+          !AfterFile(ucmp, &begin, f) &&
+          ucmp->Compare(f->smallest.user_key(), deletion.end) < 0) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+int Version::PickExpiredFiles(uint32_t now, VersionEdit* edit, uint64_t* expired_file_size) {
+  int count = 0;
+  for (int level = 0; level < config::kNumLevels; level++) {
+    for (size_t i = 0; i < files_[level].size(); i++) {
+      FileMetaData* f = files_[level][i];
+      if (!f->time_meta.AllExpired(now)) {
+        continue;
+      }
+      const Slice smallest_user_key = f->smallest.user_key();
+      const Slice largest_user_key = f->largest.user_key();
+      bool overlap = false;
+      // file order in level-0 maybe not the data order(selflevel compaction),
+      // so any overlapping file in level-0 counts.
+      if (level == 0) {
+        const Comparator* ucmp = vset_->icmp_.user_comparator();
+        for (size_t j = 0; !overlap && j < files_[0].size(); j++) {
+          overlap = (j != i) &&
+            !AfterFile(ucmp, &smallest_user_key, files_[0][j]) &&
+            !BeforeFile(ucmp, &largest_user_key, files_[0][j]);
+        }
+      }
+      for (int l = level + 1; !overlap && l < config::kNumLevels; l++) {
+        overlap = OverlapInLevel(l, &smallest_user_key, &largest_user_key);
+      }
+      if (!overlap) {
+        edit->DeleteFile(level, f->number);
+        AddBlobGarbage(f, edit);
+        *expired_file_size += f->file_size;
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+int Version::PickFilesInRange(uint64_t limit_filenumber, const Slice& begin, const Slice& end,
+                              VersionEdit* edit, uint64_t* file_size) {
+  const Comparator* ucmp = vset_->icmp_.user_comparator();
+  int count = 0;
+  for (int level = 0; level < config::kNumLevels; level++) {
+    for (size_t i = 0; i < files_[level].size(); i++) {
+      FileMetaData* f = files_[level][i];
+      if (f->number < limit_filenumber &&
+          ucmp->Compare(f->smallest.user_key(), begin) >= 0 &&
+          ucmp->Compare(f->largest.user_key(), end) < 0) {
+        edit->DeleteFile(level, f->number);
+        AddBlobGarbage(f, edit);
+        *file_size += f->file_size;
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+void Version::AddBlobGarbage(const FileMetaData* f, VersionEdit* edit) const {
+  if (blob_files_.empty()) {
+    return;
+  }
+  ReadOptions options;
+  options.fill_cache = false;
+  Iterator* iter = vset_->table_cache_->NewIterator(options, f->number, f->file_size, f->path_id);
+  ParsedInternalKey ikey;
+  BlobIndex index;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    if (ParseInternalKey(iter->key(), &ikey) && ikey.type == kTypeBlobIndex &&
+        index.DecodeFrom(iter->value())) {
+      edit->AddBlobGarbage(index.file_number, index.size);
+    }
+  }
+  delete iter;
+}
+
+void Version::LoadTimeMeta(port::Mutex* mu) {
+  const Comparator* ucmp = vset_->icmp_.user_comparator();
+  ReadOptions options;
+  options.fill_cache = false;
+  for (int level = 0; level < config::kNumLevels; level++) {
+    for (size_t i = 0; i < files_[level].size(); i++) {
+      FileMetaData* f = files_[level][i];
+      if (f->time_meta.Valid()) {
+        continue;
+      }
+      FileTimeMeta time_meta;
+      Iterator* iter = vset_->table_cache_->NewIterator(options, f->number, f->file_size, f->path_id);
+      for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        time_meta.Add(ucmp, iter->key(), iter->value());
+      }
+      if (!iter->status().ok()) {
+        time_meta.Clear();
+      }
+      delete iter;
+      // f is shared by versions, WriteSnapshot() reads it under apply_mutex_
+      MutexLock al(&vset_->apply_mutex_);
+      MutexLock l(mu);
+      f->time_meta = time_meta;
+    }
+  }
+}
+
+FileMetaData* Version::PickMostExpiredFile(uint32_t now, int* level, uint64_t* expired_file_size) {
+  FileMetaData* most = NULL;
+  *expired_file_size = 0;
+  for (int l = 0; l < config::kNumLevels - 1; l++) {
+    for (size_t i = 0; i < files_[l].size(); i++) {
+      FileMetaData* f = files_[l][i];
+      const uint64_t size = f->ExpiredFileSize(now);
+      if (size > *expired_file_size) {
+        most = f;
+        *level = l;
+        *expired_file_size = size;
+      }
+    }
+  }
+  return most;
+}
+
 int Version::PickLevelForMemTableOutput(
     const Slice& smallest_user_key,
     const Slice& largest_user_key) {
@@ -627,6 +918,11 @@ class VersionSet::Builder {
   VersionSet* vset_;
   Version* base_;
   LevelState levels_[config::kNumLevels];
+  std::map<SequenceNumber, RangeDeletion> added_range_deletions_;
+  std::set<SequenceNumber> removed_range_deletions_;
+  std::vector<BlobFileMeta> added_blob_files_;
+  std::map<uint64_t, uint64_t> blob_garbage_;
+  std::set<uint64_t> deleted_blob_files_;
 
  public:
   // Initialize a builder with the files from *base and other info from *vset
@@ -705,6 +1001,27 @@ class VersionSet::Builder {
       levels_[level].deleted_files.erase(f->number);
       levels_[level].added_files->insert(f);
     }
+
+    // Range deletions
+    for (size_t i = 0; i < edit->new_range_deletions_.size(); i++) {
+      const RangeDeletion& d = edit->new_range_deletions_[i];
+      added_range_deletions_[d.sequence] = d;
+    }
+    removed_range_deletions_.insert(edit->removed_range_deletions_.begin(),
+                                    edit->removed_range_deletions_.end());
+
+    // Blob files
+    for (size_t i = 0; i < edit->new_blob_files_.size(); i++) {
+      added_blob_files_.push_back(edit->new_blob_files_[i]);
+      deleted_blob_files_.erase(edit->new_blob_files_[i].number);
+    }
+    for (std::map<uint64_t, uint64_t>::const_iterator it = edit->blob_garbage_.begin();
+         it != edit->blob_garbage_.end();
+         ++it) {
+      blob_garbage_[it->first] += it->second;
+    }
+    deleted_blob_files_.insert(edit->deleted_blob_files_.begin(),
+                               edit->deleted_blob_files_.end());
   }
 
   // Save the current state in *v.
@@ -754,6 +1071,60 @@ class VersionSet::Builder {
       }
 #endif
     }
+
+    SaveRangeDeletionsTo(v);
+    SaveBlobFilesTo(v);
+  }
+
+  void SaveBlobFilesTo(Version* v) {
+    v->blob_files_ = base_->blob_files_;
+    for (size_t i = 0; i < added_blob_files_.size(); i++) {
+      v->blob_files_[added_blob_files_[i].number] = added_blob_files_[i];
+    }
+    // garbage of unknown file is ignored
+    for (std::map<uint64_t, uint64_t>::const_iterator it = blob_garbage_.begin();
+         it != blob_garbage_.end();
+         ++it) {
+      std::map<uint64_t, BlobFileMeta>::iterator blob = v->blob_files_.find(it->first);
+      if (blob != v->blob_files_.end()) {
+        blob->second.garbage_size = std::min(blob->second.garbage_size + it->second,
+                                             blob->second.file_size);
+      }
+    }
+    for (std::set<uint64_t>::const_iterator it = deleted_blob_files_.begin();
+         it != deleted_blob_files_.end();
+         ++it) {
+      v->blob_files_.erase(*it);
+    }
+  }
+
+  void SaveRangeDeletionsTo(Version* v) {
+    if (added_range_deletions_.empty() && removed_range_deletions_.empty()) {
+      v->range_deletions_ = base_->range_deletions_;
+      v->range_fragments_ = base_->range_fragments_;
+      return;
+    }
+    // both are ordered by sequence, added one replaces base one of same sequence
+    const std::vector<RangeDeletion>& base = base_->range_deletions_;
+    std::vector<RangeDeletion>::const_iterator base_iter = base.begin();
+    std::map<SequenceNumber, RangeDeletion>::const_iterator added_iter =
+      added_range_deletions_.begin();
+    while (base_iter != base.end() || added_iter != added_range_deletions_.end()) {
+      const RangeDeletion* d;
+      if (added_iter == added_range_deletions_.end() ||
+          (base_iter != base.end() && base_iter->sequence < added_iter->first)) {
+        d = &*base_iter++;
+      } else {
+        if (base_iter != base.end() && base_iter->sequence == added_iter->first) {
+          ++base_iter;
+        }
+        d = &(added_iter++)->second;
+      }
+      if (removed_range_deletions_.count(d->sequence) == 0) {
+        v->range_deletions_.push_back(*d);
+      }
+    }
+    vset_->BuildRangeFragments(v);
   }
 
   void MaybeAddFile(Version* v, int level, FileMetaData* f) {
@@ -777,11 +1148,13 @@ const char* VersionSet::kBackupVersionDir = "backupversions";
 VersionSet::VersionSet(const std::string& dbname,
                        const Options* options,
                        TableCache* table_cache,
-                       const InternalKeyComparator* cmp)
+                       const InternalKeyComparator* cmp,
+                       BlobFileCache* blob_cache)
     : env_(options->env),
       dbname_(dbname),
       options_(options),
       table_cache_(table_cache),
+      blob_cache_(blob_cache),
       icmp_(*cmp),
       next_file_number_(2),
       manifest_file_number_(0),  // Filled by Recover()
@@ -848,8 +1221,10 @@ void VersionSet::CleanupVersion() {
   }
 }
 
-// LogAndApply() have no thread-safe protection
 Status VersionSet::LogAndApply(VersionEdit* edit, port::Mutex* mu) {
+  MutexLock l(&apply_mutex_);
+  RestampRangeDeletions(edit);
+
   if (edit->has_log_number_) {
     assert(edit->log_number_ >= log_number_);
     assert(edit->log_number_ < NextFileNumber());
@@ -862,7 +1237,13 @@ Status VersionSet::LogAndApply(VersionEdit* edit, port::Mutex* mu) {
   }
 
   edit->SetNextFile(NextFileNumber());
-  edit->SetLastSequence(LastSequence());
+  // last sequence is raised to range deletion after it is installed
+  // (see DBImpl::DeleteRange), but it must be recorded with the deletion.
+  SequenceNumber last_sequence = LastSequence();
+  for (size_t i = 0; i < edit->new_range_deletions_.size(); i++) {
+    last_sequence = std::max(last_sequence, edit->new_range_deletions_[i].sequence);
+  }
+  edit->SetLastSequence(last_sequence);
 
   Version* v = new Version(this);
   {
@@ -908,7 +1289,7 @@ Status VersionSet::LogAndApply(VersionEdit* edit, port::Mutex* mu) {
     // Write new record to MANIFEST log
     if (s.ok()) {
       std::string record;
-      edit->EncodeTo(&record);
+      edit->EncodeTo(&record, options_->persist_file_time_meta);
       s = (new_descriptor_log != NULL) ?
         new_descriptor_log->AddRecord(record) :
         descriptor_log_->AddRecord(record);
@@ -1076,6 +1457,10 @@ Status VersionSet::Recover(const char* manifest) {
   if (s.ok()) {
     Version* v = new Version(this);
     builder.SaveTo(v);
+    // MANIFEST written before may record range deletion newer than last sequence
+    if (last_sequence < v->LastRangeDeletionSequence()) {
+      last_sequence = v->LastRangeDeletionSequence();
+    }
     // Install recovered version
     Finalize(v);
     AppendVersion(v);
@@ -1232,6 +1617,92 @@ void VersionSet::MarkFileNumberUsed(uint64_t number) {
   }
 }
 
+namespace {
+struct UserKeyLess {
+  const Comparator* ucmp;
+  explicit UserKeyLess(const Comparator* c) : ucmp(c) { }
+  bool operator()(const Slice& a, const Slice& b) const {
+    return ucmp->Compare(a, b) < 0;
+  }
+};
+}  // namespace
+
+// Split range deletions at all their bounds, key is looked up in fragments
+// by binary search instead of checking every deletion.
+void VersionSet::BuildRangeFragments(Version* v) {
+  v->range_fragments_.clear();
+  const std::vector<RangeDeletion>& deletions = v->range_deletions_;
+  if (deletions.empty()) {
+    return;
+  }
+  const UserKeyLess less(icmp_.user_comparator());
+  std::vector<Slice> bounds;
+  bounds.reserve(deletions.size() * 2);
+  for (size_t i = 0; i < deletions.size(); i++) {
+    bounds.push_back(deletions[i].begin);
+    bounds.push_back(deletions[i].end);
+  }
+  std::sort(bounds.begin(), bounds.end(), less);
+  size_t count = 1;
+  for (size_t i = 1; i < bounds.size(); i++) {
+    if (less(bounds[count - 1], bounds[i])) {
+      bounds[count++] = bounds[i];
+    }
+  }
+  bounds.resize(count);
+
+  // fragment beginning at the last bound is covered by none
+  v->range_fragments_.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    v->range_fragments_[i].begin = bounds[i].ToString();
+  }
+  // deletions are ordered by sequence, so are sequences of each fragment
+  for (size_t i = 0; i < deletions.size(); i++) {
+    const size_t first =
+      std::lower_bound(bounds.begin(), bounds.end(), Slice(deletions[i].begin), less) - bounds.begin();
+    const size_t last =
+      std::lower_bound(bounds.begin(), bounds.end(), Slice(deletions[i].end), less) - bounds.begin();
+    for (size_t j = first; j < last; j++) {
+      v->range_fragments_[j].sequences.push_back(deletions[i].sequence);
+    }
+  }
+}
+
+// Files added by *edit may hold entries covered by range deletions that are
+// newer than the ones their writer dropped entries with, or that the writer
+// kept entries of for snapshots. Record such deletions again with a file
+// number larger than the added files', so they are not reclaimed before
+// these files are compacted (see Version::RangeDeletionInFiles()).
+void VersionSet::RestampRangeDeletions(VersionEdit* edit) {
+  if (edit->new_files_.empty() || !edit->has_range_deletion_base_) {
+    return;
+  }
+  const Comparator* ucmp = icmp_.user_comparator();
+  const std::vector<RangeDeletion>& deletions = current_->range_deletions_;
+  uint64_t file_number = 0;
+  for (size_t i = 0; i < deletions.size(); i++) {
+    const RangeDeletion& d = deletions[i];
+    if (d.sequence <= edit->range_deletion_base_ &&
+        edit->kept_range_deletions_.count(d.sequence) == 0) {
+      continue;
+    }
+    bool overlap = false;
+    for (size_t j = 0; !overlap && j < edit->new_files_.size(); j++) {
+      const FileMetaData& f = edit->new_files_[j].second;
+      overlap = ucmp->Compare(f.largest.user_key(), d.begin) >= 0 &&
+        ucmp->Compare(f.smallest.user_key(), d.end) < 0;
+    }
+    if (overlap) {
+      if (file_number == 0) {
+        file_number = NewFileNumber();
+      }
+      RangeDeletion restamped = d;
+      restamped.file_number = file_number;
+      edit->AddRangeDeletion(restamped);
+    }
+  }
+}
+
 void VersionSet::Finalize(Version* v) {
   // Precomputed best level for next compaction
   int best_level = -1;
@@ -1345,15 +1816,59 @@ Status VersionSet::WriteSnapshot(log::Writer* log) {
     const std::vector<FileMetaData*>& files = current_->files_[level];
     for (size_t i = 0; i < files.size(); i++) {
       const FileMetaData* f = files[i];
-      edit.AddFile(level, f->number, f->file_size, f->smallest, f->largest);
+      edit.AddFile(level, f->number, f->file_size, f->smallest, f->largest, f->time_meta,
+                   f->path_id);
     }
   }
 
+  // Save range deletions
+  for (size_t i = 0; i < current_->range_deletions_.size(); i++) {
+    edit.AddRangeDeletion(current_->range_deletions_[i]);
+  }
+
+  // Save blob files
+  for (std::map<uint64_t, BlobFileMeta>::const_iterator it = current_->blob_files_.begin();
+       it != current_->blob_files_.end();
+       ++it) {
+    edit.AddBlobFile(it->second);
+  }
+
   std::string record;
-  edit.EncodeTo(&record);
+  edit.EncodeTo(&record, options_->persist_file_time_meta);
   return log->AddRecord(record);
 }
 
+// mutex hold
+void VersionSet::GetCheckpoint(const std::string& dir, VersionEdit* edit,
+                               std::vector<std::pair<std::string, std::string> >* files) {
+  edit->SetComparatorName(icmp_.user_comparator()->Name());
+  edit->SetLogNumber(log_number_);
+  edit->SetPrevLogNumber(prev_log_number_);
+  edit->SetNextFile(NextFileNumber());
+  edit->SetLastSequence(LastSequence());
+
+  for (int level = 0; level < config::kNumLevels; level++) {
+    const std::vector<FileMetaData*>& level_files = current_->files_[level];
+    for (size_t i = 0; i < level_files.size(); i++) {
+      const FileMetaData* f = level_files[i];
+      edit->AddFile(level, f->number, f->file_size, f->smallest, f->largest, f->time_meta, 0);
+      files->push_back(std::make_pair(TableFileName(TablePath(*options_, dbname_, f->path_id), f->number),
+                                      TableFileName(dir, f->number)));
+    }
+  }
+
+  for (size_t i = 0; i < current_->range_deletions_.size(); i++) {
+    edit->AddRangeDeletion(current_->range_deletions_[i]);
+  }
+
+  for (std::map<uint64_t, BlobFileMeta>::const_iterator it = current_->blob_files_.begin();
+       it != current_->blob_files_.end();
+       ++it) {
+    edit->AddBlobFile(it->second);
+    files->push_back(std::make_pair(BlobFileName(dbname_, it->first), BlobFileName(dir, it->first)));
+  }
+}
+
 uint64_t VersionSet::SmallestFileNumber() const {
   // line search. TODO.
   uint64_t smallest_file_number = NextFileNumber();
@@ -1418,7 +1933,8 @@ uint64_t VersionSet::ApproximateOffsetOf(Version* v, const InternalKey& ikey) {
         // approximate offset of "ikey" within the table.
         Table* tableptr;
         Iterator* iter = table_cache_->NewIterator(
-            ReadOptions(), files[i]->number, files[i]->file_size, &tableptr);
+            ReadOptions(), files[i]->number, files[i]->file_size, files[i]->path_id,
+            &tableptr);
         if (tableptr != NULL) {
           result += tableptr->ApproximateOffsetOf(ikey.Encode());
         }
@@ -1429,6 +1945,43 @@ uint64_t VersionSet::ApproximateOffsetOf(Version* v, const InternalKey& ikey) {
   return result;
 }
 
+uint32_t VersionSet::PathIdForLevel(int level) const {
+  const std::vector<DbPath>& paths = options_->db_paths;
+  uint32_t p = 0;
+  // fill paths with levels from level-0 on, level that does not fit in
+  // remaining size of one path starts on next path, the last path takes all.
+  int cur_level = 0;
+  double level_size = MaxBytesForLevel(cur_level);
+  for (; p + 1 < paths.size(); p++) {
+    double target_size = static_cast<double>(paths[p].target_size);
+    while (target_size >= level_size) {
+      if (cur_level == level) {
+        return p;
+      }
+      target_size -= level_size;
+      level_size = MaxBytesForLevel(++cur_level);
+    }
+  }
+  return p;
+}
+
+Status VersionSet::CheckPaths() const {
+  const size_t path_count = options_->db_paths.empty() ? 1 : options_->db_paths.size();
+  for (int level = 0; level < config::kNumLevels; level++) {
+    const std::vector<FileMetaData*>& files = current_->files_[level];
+    for (size_t i = 0; i < files.size(); i++) {
+      if (files[i]->path_id >= path_count) {
+        char buf[100];
+        snprintf(buf, sizeof(buf), "table #%llu is in path %u, only %d paths",
+                 static_cast<unsigned long long>(files[i]->number),
+                 files[i]->path_id, static_cast<int>(path_count));
+        return Status::InvalidArgument(buf);
+      }
+    }
+  }
+  return Status::OK();
+}
+
 void VersionSet::AddLiveFiles(std::set<uint64_t>* live) {
   PROFILER_BEGIN("addtmplive");
   for (Version* v = dummy_versions_.next_;
@@ -1440,10 +1993,84 @@ void VersionSet::AddLiveFiles(std::set<uint64_t>* live) {
         live->insert(files[i]->number);
       }
     }
+    for (std::map<uint64_t, BlobFileMeta>::const_iterator it = v->blob_files_.begin();
+         it != v->blob_files_.end();
+         ++it) {
+      live->insert(it->first);
+    }
   }
   PROFILER_END();
 }
 
+namespace {
+// Shared by threads of VersionSet::PreloadTables()
+struct TablePreloader {
+  port::Mutex mu;
+  port::CondVar cv;
+  TableCache* table_cache;
+  Logger* info_log;
+  std::vector<const FileMetaData*> files;
+  size_t next;
+  size_t capacity;
+  size_t charge;
+  int loaded;
+  int running;
+
+  TablePreloader() : cv(&mu), next(0), capacity(0), charge(0), loaded(0), running(0) { }
+};
+
+void PreloadTableWork(void* arg) {
+  TablePreloader* p = reinterpret_cast<TablePreloader*>(arg);
+  p->mu.Lock();
+  while (p->next < p->files.size() && p->charge < p->capacity) {
+    const FileMetaData* f = p->files[p->next++];
+    p->mu.Unlock();
+    size_t charge = 0;
+    Status s = p->table_cache->Load(f->number, f->file_size, f->path_id, &charge);
+    if (!s.ok()) {
+      Log(p->info_log, "preload table #%llu fail: %s",
+          (unsigned long long) f->number, s.ToString().c_str());
+    }
+    p->mu.Lock();
+    if (s.ok()) {
+      p->charge += charge;
+      ++p->loaded;
+    }
+  }
+  if (--p->running == 0) {
+    p->cv.Signal();
+  }
+  p->mu.Unlock();
+}
+}  // namespace
+
+int VersionSet::PreloadTables(int threads) {
+  TablePreloader p;
+  p.table_cache = table_cache_;
+  p.info_log = options_->info_log;
+  p.capacity = options_->table_cache_size;
+  Version* v = current_;
+  v->Ref();
+  for (int level = 0; level < config::kNumLevels; level++) {
+    p.files.insert(p.files.end(), v->files_[level].begin(), v->files_[level].end());
+  }
+
+  // calling thread is one of the workers
+  p.running = threads > 1 ? threads : 1;
+  for (int i = 1; i < p.running; i++) {
+    env_->StartThread(&PreloadTableWork, &p);
+  }
+  PreloadTableWork(&p);
+  p.mu.Lock();
+  while (p.running > 0) {
+    p.cv.Wait();
+  }
+  p.mu.Unlock();
+
+  v->Unref();
+  return p.loaded;
+}
+
 int64_t VersionSet::NumLevelBytes(int level) const {
   assert(level >= 0);
   assert(level < config::kNumLevels);
@@ -1529,7 +2156,7 @@ Iterator* VersionSet::MakeInputIterator(Compaction* c) {
         const std::vector<FileMetaData*>& files = c->inputs_[which];
         for (size_t i = 0; i < files.size(); i++) {
           list[num++] = table_cache_->NewIterator(
-              options, files[i]->number, files[i]->file_size);
+              options, files[i]->number, files[i]->file_size, files[i]->path_id);
         }
       } else {
         // Create concatenating iterator for the files from this level
@@ -27,9 +27,11 @@ namespace leveldb {
 
 namespace log { class Writer; }
 
+class BlobFileCache;
 class Compaction;
 class Iterator;
 class MemTable;
+class PinnableSlice;
 class TableBuilder;
 class TableCache;
 class Version;
@@ -70,8 +72,19 @@ class Version {
     FileMetaData* seek_file;
     int seek_file_level;
   };
+  // Value moved into blob file is read from it, unless is_blob_index
+  // is not NULL, then *val is set to the raw entry and *is_blob_index
+  // tells whether it is a BlobIndex.
+  // If pinned is not NULL, val must be pinned->GetSelf(), and value in
+  // table is pinned into *pinned instead of being copied into *val.
   Status Get(const ReadOptions&, const LookupKey& key, std::string* val,
-             GetStats* stats);
+             GetStats* stats, bool* is_blob_index = NULL,
+             PinnableSlice* pinned = NULL);
+
+  // Return false if no file may contain key, checking
+  // file range and filter only.
+  // REQUIRES: lock is not held
+  bool KeyMayExist(const ReadOptions&, const LookupKey& key);
 
   // Adds "stats" into the current state.  Returns true if a new
   // compaction may need to be triggered, false otherwise.
@@ -111,6 +124,60 @@ class Version {
   int PickLevelForMemTableOutput(const Slice& smallest_user_key,
                                  const Slice& largest_user_key);
 
+  // Return the level at which we should place an ingested table whose
+  // entries are newer than all in this version: the deepest level that
+  // no file in it or upper levels overlaps the range.
+  // Return -1 if some overlapping file is numbered not less than newer_number,
+  // which may have entries newer than the ingested table.
+  int PickLevelForIngestedTable(uint64_t newer_number,
+                                const Slice& smallest_user_key,
+                                const Slice& largest_user_key);
+
+  // Add deletion of files whose entries have all expired at `now into *edit,
+  // and no older data of the same keys may be in other files (dropping file
+  // must not make older data visible again). Return count of files.
+  int PickExpiredFiles(uint32_t now, VersionEdit* edit, uint64_t* expired_file_size);
+
+  // Add deletion of files numbered less than limit_filenumber whose whole
+  // key range is in user key range [begin, end) into *edit. Return count of files.
+  int PickFilesInRange(uint64_t limit_filenumber, const Slice& begin, const Slice& end,
+                       VersionEdit* edit, uint64_t* file_size);
+
+  // Add blob records referenced by file f into *edit as garbage,
+  // f is being deleted as a whole.
+  void AddBlobGarbage(const FileMetaData* f, VersionEdit* edit) const;
+
+  // Recompute time meta of files not having it (MANIFEST is written without
+  // time meta, see Options::persist_file_time_meta) by scanning them.
+  // REQUIRES: *mu (db mutex) is not held, it is held to install time meta.
+  void LoadTimeMeta(port::Mutex* mu);
+
+  // Return the file with most estimated expired bytes at `now, NULL if none.
+  // File in the last level is not considered, it has no next level to compact into.
+  FileMetaData* PickMostExpiredFile(uint32_t now, int* level, uint64_t* expired_file_size);
+
+  // Return true if entry of user_key at sequence is covered by some range
+  // deletion visible at snapshot.
+  bool IsRangeDeleted(const Slice& user_key, SequenceNumber sequence,
+                      SequenceNumber snapshot) const {
+    const SequenceNumber covering = RangeDeletionCovering(user_key, sequence);
+    return covering != 0 && covering <= snapshot;
+  }
+  // Return sequence of the oldest range deletion covering entry of user_key
+  // at sequence, 0 if none covers it.
+  SequenceNumber RangeDeletionCovering(const Slice& user_key, SequenceNumber sequence) const;
+  // Return sequence of the newest range deletion, 0 if none.
+  SequenceNumber LastRangeDeletionSequence() const {
+    return range_deletions_.empty() ? 0 : range_deletions_.back().sequence;
+  }
+  // Return true if some file may still hold entries covered by deletion.
+  bool RangeDeletionInFiles(const RangeDeletion& deletion) const;
+  bool HasRangeDeletions() const { return !range_deletions_.empty(); }
+  const std::vector<RangeDeletion>& RangeDeletions() const { return range_deletions_; }
+
+  // Blob files referenced by this version, keyed by file number
+  const std::map<uint64_t, BlobFileMeta>& BlobFiles() const { return blob_files_; }
+
   int NumFiles(int level) const { return files_[level].size(); }
 
   std::vector<FileMetaData*>* FileMetas() { return files_; }
@@ -139,6 +206,18 @@ class Version {
 
   // List of files per level
   std::vector<FileMetaData*> files_[config::kNumLevels];
+  // Range deletions not reclaimed yet, ordered by sequence
+  std::vector<RangeDeletion> range_deletions_;
+  // Range deletions split at their bounds into disjoint user key ranges
+  // ordered by begin, each one is [begin, begin of next fragment) and
+  // holds ordered sequences of deletions covering it (built by Finalize()).
+  struct RangeFragment {
+    std::string begin;
+    std::vector<SequenceNumber> sequences;
+  };
+  std::vector<RangeFragment> range_fragments_;
+  // Blob files holding values of files_
+  std::map<uint64_t, BlobFileMeta> blob_files_;
   // bytesize per level
   int64_t file_sizes_[config::kNumLevels];
 
@@ -173,14 +252,15 @@ class VersionSet {
   VersionSet(const std::string& dbname,
              const Options* options,
              TableCache* table_cache,
-             const InternalKeyComparator*);
+             const InternalKeyComparator*,
+             BlobFileCache* blob_cache = NULL);
   ~VersionSet();
 
   // Apply *edit to the current version to form a new descriptor that
   // is both saved to persistent state and installed as the new
   // current version.  Will release *mu while actually writing to the file.
-  // REQUIRES: *mu is held on entry.
-  // REQUIRES: no other thread concurrently calls LogAndApply()
+  // REQUIRES: *mu is not held on entry, it is held only to install.
+  // Concurrent calls are serialized.
   Status LogAndApply(VersionEdit* edit, port::Mutex* mu);
 
   // Recover the last saved descriptor from persistent storage.
@@ -196,6 +276,12 @@ class VersionSet {
   Status BackupCurrentVersion();
   // unload backuped version, `id is MANIFEST filenumber
   Status UnloadBackupedVersion(uint64_t id);
+  // Fill *edit with a full manifest record of current version for a copy
+  // of db in "dir", where all table files are in "dir" (path 0), and
+  // append (source, target) names of live table and blob files to *files.
+  // REQUIRES: mutex is held
+  void GetCheckpoint(const std::string& dir, VersionEdit* edit,
+                     std::vector<std::pair<std::string, std::string> >* files);
 
   // Return the current version.
   Version* current() const { return current_; }
@@ -294,6 +380,19 @@ class VersionSet {
   // May also mutate some internal state.
   void AddLiveFiles(std::set<uint64_t>* live);
 
+  // Open tables of current version into table cache with "threads"
+  // threads, from level-0 down, until opened tables take
+  // Options::table_cache_size. Return count of tables opened.
+  // REQUIRES: no compaction is running.
+  int PreloadTables(int threads);
+
+  // Return index of Options::db_paths that tables of "level" are written to.
+  uint32_t PathIdForLevel(int level) const;
+
+  // Return error if any table file of current version is in a path
+  // that is not in Options::db_paths.
+  Status CheckPaths() const;
+
   // Return the approximate offset in the database of the data for
   // "key" as of version "v".
   uint64_t ApproximateOffsetOf(Version* v, const InternalKey& key);
@@ -321,6 +420,8 @@ class VersionSet {
   friend class Version;
 
   void Finalize(Version* v);
+  void BuildRangeFragments(Version* v);
+  void RestampRangeDeletions(VersionEdit* edit);
 
   bool ShouldLimitCompact(int level);
   bool LimitCompactByLevel(int level);
@@ -347,6 +448,7 @@ class VersionSet {
   const std::string dbname_;
   const Options* const options_;
   TableCache* const table_cache_;
+  BlobFileCache* const blob_cache_;
   const InternalKeyComparator icmp_;
   port::AtomicCount<uint64_t> next_file_number_;
   // uint64_t next_file_number_;
@@ -364,6 +466,9 @@ class VersionSet {
 
   // pending restart manifest
   bool pending_restart_manifest_;
+  // serializes LogAndApply(), range deletion is installed out of
+  // background thread (see DBImpl::DeleteRange())
+  port::Mutex apply_mutex_;
 
   // Opened lazily
   WritableFile* descriptor_file_;
@@ -395,6 +500,9 @@ class Compaction {
   // by this compaction.
   VersionEdit* edit() { return &edit_; }
 
+  // Return the version that inputs are picked from.
+  const Version* input_version() const { return input_version_; }
+
   // "which" must be either 0 or 1
   int num_input_files(int which) const { return inputs_[which].size(); }
 
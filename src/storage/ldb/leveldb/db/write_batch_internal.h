@@ -38,7 +38,9 @@ class WriteBatchInternal {
 
   static void SetContents(WriteBatch* batch, const Slice& contents);
 
-  static Status InsertInto(const WriteBatch* batch, MemTable* memtable);
+  // concurrent: memtable may be inserted by other threads at the same time.
+  static Status InsertInto(const WriteBatch* batch, MemTable* memtable,
+                           bool concurrent = false);
 
   static void Append(WriteBatch* dst, const WriteBatch* src);
 };
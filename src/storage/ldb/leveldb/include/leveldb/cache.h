@@ -27,7 +27,16 @@ class Cache;
 
 // Create a new cache with a fixed size capacity.  This implementation
 // of Cache uses a least-recently-used eviction policy.
-extern Cache* NewLRUCache(size_t capacity);
+// Cache is split into 2^num_shard_bits shards(each with its own lock)
+// by key hash, more shards for less lock contention.
+extern Cache* NewLRUCache(size_t capacity, int num_shard_bits = 4);
+
+// Create a view of "shared" cache, entries are stored in "shared" while
+// usage and lookup hits of entries inserted by this view are accounted
+// separately, so that several DBs can share one cache and still report
+// their own statistics.
+// "shared" must outlive the result and all entries inserted through it.
+extern Cache* NewAccountedCache(Cache* shared);
 
 class Cache {
  public:
@@ -86,6 +95,9 @@ class Cache {
   // is stored in `result.
   virtual void Stats(std::string& result) = 0;
 
+  // Return lookup statistics: how many Lookup() found the entry or not.
+  virtual void HitStats(uint64_t* hit, uint64_t* miss) { *hit = *miss = 0; }
+
  private:
   void LRU_Remove(Handle* e);
   void LRU_Append(Handle* e);
@@ -57,8 +57,21 @@ class Comparator {
   virtual bool ShouldDrop(const char* key, int64_t sequence, uint32_t now = 0) const { return false;}
   // should drop this key based on some condition. (user defined)
   virtual bool ShouldDropMaybe(const char* key, int64_t sequence, uint32_t now = 0) const { return false;}
+  // same as above, with value of entry (head of value if it is in blob file,
+  // see GetTimeMeta()) for condition kept in value. default checks key only.
+  virtual bool ShouldDropMaybe(const Slice& key, const Slice& value, int64_t sequence, uint32_t now = 0) const;
   // should stop build sst before `key based on `start_key
   virtual bool ShouldStopBefore(const Slice& start_key, const Slice& key) const { return false;}
+  // get time meta of one entry. (user defined)
+  // expired_time: 0 means never expire. modify_time: 0 means unknown.
+  // return false if this entry has no time meta.
+  virtual bool GetTimeMeta(const Slice& key, const Slice& value,
+                           uint32_t* expired_time, uint32_t* modify_time) const { return false;}
+  // hash of key for data block hash index (see Options::data_block_hash_index).
+  // keys that Compare() treats as equal must have the same hash.
+  // return false if this comparator can not hash keys that way,
+  // then point lookups just binary search in data block.
+  virtual bool Hash(const Slice& key, uint32_t* hash) const { return false;}
 };
 
 // Return a builtin comparator that uses lexicographic byte-wise
@@ -18,6 +18,7 @@ static const int kMajorVersion = 1;
 static const int kMinorVersion = 4;
 
 struct Options;
+class PinnableSlice;
 struct ReadOptions;
 struct WriteOptions;
 class WriteBatch;
@@ -117,6 +118,18 @@ class DB {
   virtual Status Get(const ReadOptions& options,
                      const Slice& key, std::string* value) = 0;
 
+  // Like Get() above, but value in sstable is pinned into *value instead
+  // of being copied (see leveldb/pinnable_slice.h). *value is reset first.
+  virtual Status Get(const ReadOptions& options,
+                     const Slice& key, PinnableSlice* value) = 0;
+
+  // Return false if "key" is proved to be absent by checking memtable and
+  // sstables' filter only (no data block will be read), true means "key"
+  // may exist. Default implementation can prove nothing.
+  virtual bool KeyMayExist(const ReadOptions& options, const Slice& key) {
+    return true;
+  }
+
   // Return a heap-allocated iterator over the contents of the database.
   // The result of NewIterator() is initially invalid (caller must
   // call one of the Seek methods on the iterator before using it).
@@ -151,6 +164,8 @@ class DB {
   //     about the internal operation of the DB.
   //  "leveldb.sstables" - returns a multi-line string that describes all
   //     of the sstables that make up the db contents.
+  //  "leveldb.num-range-deletions" - return the number of range deletions
+  //     not reclaimed yet (see DB::CompactRangeDeletions()).
   virtual bool GetProperty(const Slice& property, std::string* value,
                            void (*key_printer)(const Slice&, std::string&) = NULL) = 0;
 
@@ -186,6 +201,83 @@ class DB {
   // Compact a range of keys only in one level and files whoes filenumer is less than limit_filenumber
   virtual Status CompactRangeSelfLevel(uint64_t limit_filenumber, const Slice* begin, const Slice* end) = 0;
 
+  // Delete table files whose entries have all expired(see Comparator::GetTimeMeta())
+  // without rewriting them. *deleted_size is set to total size of deleted files.
+  virtual Status DeleteExpiredFiles(uint64_t* deleted_size) {
+    return Status::NotSupported("DeleteExpiredFiles");
+  }
+
+  // Delete table files numbered less than limit_filenumber whose entries
+  // are all in user key range [begin, end), without rewriting them.
+  // Caller must make sure these entries are all useless (eg. dropped
+  // by Comparator::ShouldDrop()). *deleted_size is set to total size of
+  // deleted files.
+  virtual Status DeleteFilesInRange(uint64_t limit_filenumber, const Slice& begin, const Slice& end,
+                                    uint64_t* deleted_size) {
+    return Status::NotSupported("DeleteFilesInRange");
+  }
+
+  // Compact the table file with most estimated expired bytes, if that is
+  // not less than min_expired_size. *expired_size is set to the estimated
+  // expired bytes of the compacted file, 0 if no file is compacted.
+  virtual Status CompactExpiredFile(uint64_t min_expired_size, uint64_t* expired_size) {
+    return Status::NotSupported("CompactExpiredFile");
+  }
+
+  // Write entries in user key range [begin, end) seen by "options"
+  // (set options.snapshot for a consistent view) into new table files
+  // under "dir". Deleted entries are not written. Paths of written files
+  // are appended to *files. An empty "end" means the end of key range.
+  virtual Status ExportTables(const ReadOptions& options, const Slice& begin, const Slice& end,
+                              const std::string& dir, std::vector<std::string>* files) {
+    return Status::NotSupported("ExportTables");
+  }
+
+  // Add table files written by ExportTables() into db directly, without
+  // going through log and memtable. Ingested entries are newer than
+  // what db has now. Return InvalidArgument if key range of some file
+  // overlaps memtable or table files written after this call began,
+  // then nothing is ingested and caller may write entries in other way.
+  // "visitor" is called with every ingested entry if not NULL.
+  virtual Status IngestTables(const std::vector<std::string>& files,
+                              void (*visitor)(void* arg, const Slice& key, const Slice& value) = NULL,
+                              void* arg = NULL) {
+    return Status::NotSupported("IngestTables");
+  }
+
+  // Remove all entries in user key range [begin, end) at once, entries
+  // written later are not affected. Space is reclaimed by
+  // CompactRangeDeletions().
+  virtual Status DeleteRange(const WriteOptions& options, const Slice& begin, const Slice& end) {
+    return Status::NotSupported("DeleteRange");
+  }
+
+  // Rewrite table files holding entries deleted by DeleteRange(), and
+  // forget range deletions that are fully reclaimed. *remaining is set to
+  // count of range deletions left.
+  virtual Status CompactRangeDeletions(int* remaining) {
+    return Status::NotSupported("CompactRangeDeletions");
+  }
+
+  // Rewrite live values of the blob file with most garbage (see
+  // Options::blob_gc_ratio) as new writes, and delete blob files no
+  // longer referenced. *reclaimed_size is set to size of deleted blob
+  // files, 0 if there is nothing to collect.
+  virtual Status CollectBlobGarbage(uint64_t* reclaimed_size) {
+    return Status::NotSupported("CollectBlobGarbage");
+  }
+
+  // Make an openable copy of the db in directory "dir" while writes go on.
+  // Table and blob files are hard linked (copied if linking fails), a
+  // manifest of current version is written, and write-ahead logs are copied
+  // up to the last complete record, whose sequence is stored in *sequence.
+  // Appending the rest of the newest copied log and later logs of this db
+  // brings the copy up to date. Writes that skip the log (Write() with a
+  // bucket) are in the copy only if they were flushed.
+  virtual Status Checkpoint(const std::string& dir, uint64_t* sequence) {
+    return Status::NotSupported("Checkpoint");
+  }
+
   // force Compact memtable
   virtual Status ForceCompactMemTable() = 0;
 
@@ -35,11 +35,20 @@ namespace leveldb {
 class FileLock;
 class Logger;
 class RandomAccessFile;
+class RateLimiter;
 class SequentialFile;
 class Slice;
 class WritableFile;
 class ReadableAndWritableFile;
 
+// Background I/O types, each one is limited by its own RateLimiter.
+enum IOType {
+  kIOFlush = 0,                 // memtable dump
+  kIOCompaction = 1,            // compaction output
+  kIOScan = 2,                  // iterating for migration, etc.
+  kNumIOTypes = 3
+};
+
 class Env {
  public:
   Env() { }
@@ -87,6 +96,16 @@ class Env {
   virtual Status NewReadableAndWritableFile(const std::string& fname,
                                             ReadableAndWritableFile** result) = 0;
 
+  // Same as NewWritableFile(), but appending to the returned file is
+  // limited by GetRateLimiter(type).
+  virtual Status NewLimitedWritableFile(const std::string& fname,
+                                        WritableFile** result,
+                                        IOType type);
+
+  // Return the rate limiter of "type" I/O, NULL means no limit.
+  // The result belongs to Env and must not be deleted.
+  virtual RateLimiter* GetRateLimiter(IOType type) { return NULL; }
+
   // Returns true iff the named file exists.
   virtual bool FileExists(const std::string& fname) = 0;
 
@@ -112,6 +131,11 @@ class Env {
   virtual Status RenameFile(const std::string& src,
                             const std::string& target) = 0;
 
+  // Create hard link "target" to file src. Both must be on one file system.
+  virtual Status LinkFile(const std::string& src, const std::string& target) {
+    return Status::NotSupported("LinkFile", src);
+  }
+
   // Lock the specified file.  Used to prevent concurrent access to
   // the same db by multiple processes.  On failure, stores NULL in
   // *lock and returns non-OK.
@@ -219,6 +243,10 @@ class RandomAccessFile {
   // Safe for concurrent use by multiple threads.
   virtual Status Read(uint64_t offset, size_t n, Slice* result,
                       char* scratch) const = 0;
+
+  // Hint that [offset, offset+n) will be read soon, so it may be read
+  // ahead in background. Default does nothing.
+  virtual void Prefetch(uint64_t offset, size_t n) const { }
 };
 
 // A file abstraction for sequential writing.  The implementation
@@ -320,6 +348,12 @@ class EnvWrapper : public Env {
   Status NewReadableAndWritableFile(const std::string& f, ReadableAndWritableFile** r) {
     return target_->NewReadableAndWritableFile(f, r);
   }
+  Status NewLimitedWritableFile(const std::string& f, WritableFile** r, IOType t) {
+    return target_->NewLimitedWritableFile(f, r, t);
+  }
+  RateLimiter* GetRateLimiter(IOType t) {
+    return target_->GetRateLimiter(t);
+  }
 
   bool FileExists(const std::string& f) { return target_->FileExists(f); }
   Status GetChildren(const std::string& dir, std::vector<std::string>* r) {
@@ -334,6 +368,9 @@ class EnvWrapper : public Env {
   Status RenameFile(const std::string& s, const std::string& t) {
     return target_->RenameFile(s, t);
   }
+  Status LinkFile(const std::string& s, const std::string& t) {
+    return target_->LinkFile(s, t);
+  }
   Status LockFile(const std::string& f, FileLock** l) {
     return target_->LockFile(f, l);
   }
@@ -41,6 +41,14 @@ class FilterPolicy {
   virtual void CreateFilter(const Slice* keys, int n, std::string* dst)
       const = 0;
 
+  // Same as CreateFilter(), but "level" is the level that table holding
+  // the filter is built for (-1 if unknown), so policy can trade memory
+  // for false positive rate per level. Default ignores "level".
+  virtual void CreateFilterForLevel(const Slice* keys, int n, std::string* dst,
+                                    int level) const {
+    CreateFilter(keys, n, dst);
+  }
+
   // "filter" contains the data appended by a preceding call to
   // CreateFilter() on this class.  This method must return true if
   // the key was in the list of keys passed to CreateFilter().
@@ -20,6 +20,8 @@
 
 namespace leveldb {
 
+class PinnableSlice;
+
 class Iterator {
  public:
   Iterator();
@@ -75,6 +77,10 @@ class Iterator {
   typedef void (*CleanupFunction)(void* arg1, void* arg2);
   void RegisterCleanup(CleanupFunction function, void* arg1, void* arg2);
 
+  // Move all registered cleanups to "pinned", so that resources held by
+  // this iterator (eg. block) live until "pinned" is reset.
+  void DelegateCleanupsTo(PinnableSlice* pinned);
+
  private:
   struct Cleanup {
     CleanupFunction function;
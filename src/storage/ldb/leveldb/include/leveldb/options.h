@@ -7,6 +7,8 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <string>
+#include <vector>
 
 namespace leveldb {
 
@@ -16,6 +18,16 @@ class Env;
 class FilterPolicy;
 class Logger;
 class Snapshot;
+class WriteBufferManager;
+
+// Directory holding table files, and how many bytes are expected there.
+struct DbPath {
+  std::string path;
+  uint64_t target_size;
+
+  DbPath() : target_size(0) { }
+  DbPath(const std::string& p, uint64_t t) : path(p), target_size(t) { }
+};
 
 // DB contents are stored in a set of blocks, each of which holds a
 // sequence of key,value pairs.  Each block may be compressed before
@@ -83,6 +95,12 @@ struct Options {
   // Default: 4MB
   size_t write_buffer_size;
 
+  // If non-NULL, memtables of all DBs using it share one memory budget,
+  // memtable will be switched before write_buffer_size is reached
+  // when total usage is over budget. (see write_buffer_manager.h)
+  // Default: NULL
+  WriteBufferManager* write_buffer_manager;
+
   // max memory usage for all memtable sharded by bucket number when batch_put(especially for FastDump).
   // Defalut: 1G
   int64_t max_mem_usage_for_memtable;
@@ -123,6 +141,15 @@ struct Options {
   // Default: 16
   int block_restart_interval;
 
+  // Append a hash index to each data block, which maps hash of key
+  // (see Comparator::Hash()) to restart point, so point lookup jumps
+  // to the restart interval holding the key instead of binary search.
+  // Blocks with hash index can NOT be read by older version.
+  // This parameter can be changed dynamically.
+  //
+  // Default: false
+  bool data_block_hash_index;
+
   // Compress blocks using the specified compression algorithm.  This
   // parameter can be changed dynamically.
   //
@@ -152,6 +179,66 @@ struct Options {
   // whether load backup versions when startup
   bool load_backup_version;
 
+  // whether writers grouped together insert their own batches into memtable
+  // in parallel (log is still written once by the group leader).
+  // Default: false
+  bool concurrent_memtable_write;
+
+  // whether sync log of a sync write after the write group leaves writer
+  // queue, so next group can append to log while previous sync is in flight,
+  // and one sync serves all groups appended meanwhile.
+  // Default: false
+  bool pipelined_log_sync;
+
+  // With pipelined_log_sync, wait at most this long before sync so that
+  // more groups can share one sync.
+  // Default: 0
+  int log_sync_delay_us;
+
+  // Values not smaller than this are moved out of sstables into blob files
+  // when memtable is dumped or sstables are compacted (see db/blob_file.h),
+  // so compaction only rewrites small value indexes. 0 means never.
+  // Db with blob files can NOT be opened by older version.
+  // Default: 0
+  size_t blob_value_size;
+
+  // Blob file is rewritten by DB::CollectBlobGarbage() when this ratio
+  // of its size is garbage (values that are overwritten or deleted).
+  // Default: 0.5
+  double blob_gc_ratio;
+
+  // Record time meta of tables (expired time range, see db/version_edit.h)
+  // in MANIFEST. Otherwise time meta is recomputed by scanning tables
+  // when expired files are picked after db is reopened.
+  // MANIFEST with time meta can NOT be read by older version.
+  // Default: false
+  bool persist_file_time_meta;
+
+  // Directories table files are put in, with target size of each, from
+  // fast to slow storage. Tables of a level go to the first path that
+  // has room for this level and all levels before it (level size is
+  // estimated by kBaseLevelSize, level-0 as level-1), the last path holds
+  // the rest. Compaction outputs are written to the path of output level,
+  // so files move between paths as they are compacted down.
+  // Manifest, logs and blob files are always under dbname.
+  // Paths can be appended but not removed or reordered, since table file
+  // records which path it is in.
+  // Default: empty, all table files are under dbname
+  std::vector<DbPath> db_paths;
+
+  // Threads inserting records of a log into memtable in parallel when db
+  // is recovered. Records are read and inserted chunk by chunk, and
+  // memtable is only dumped between chunks, so each level-0 table still
+  // holds a contiguous range of sequence.
+  // Default: 1
+  int recover_log_threads;
+
+  // Threads opening tables (index and filter blocks) of all levels into
+  // table cache when db is opened, so that first reads do not pay for it.
+  // Stop when opened tables take table_cache_size. 0 means not preload.
+  // Default: 0
+  int preload_table_threads;
+
   // sort of config that is used in db but not get by passed option ..
 
   // Level-0 compaction is started when we hit this many files.
@@ -244,10 +331,32 @@ struct ReadOptions {
   // Default: NULL
   const Snapshot* snapshot;
 
+  // If true, only data in memory (memtables, opened tables and block
+  // cache) is read. A read that needs disk I/O fails with
+  // Status::Incomplete(), so caller can redo it where blocking is fine.
+  // Default: false
+  bool cache_only;
+
+  // If non-zero, an iterator reads table data blocks through its own
+  // buffer: the buffer grows from one block up to readahead_size bytes
+  // while reads stay sequential, and the window after it is hinted to
+  // OS to be read in background. Meant for bulk scans.
+  // Default: 0
+  size_t readahead_size;
+
+  // If true (and readahead_size is non-zero), when an iterator enters
+  // a table of a level, the next table is opened and its head hinted to
+  // OS, so scan doesn't stall at table boundaries.
+  // Default: false
+  bool prefetch_table;
+
   ReadOptions()
       : verify_checksums(false),
         fill_cache(true),
-        snapshot(NULL){
+        snapshot(NULL),
+        cache_only(false),
+        readahead_size(0),
+        prefetch_table(false) {
   }
 };
 
@@ -0,0 +1,75 @@
+// Copyright (c) 2026 agent <agent@local>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// PinnableSlice holds a value got by DB::Get() without copying it: value
+// points into a data block in block cache (or in mmaped table file), and
+// the block and table are pinned until Reset() or destruction. Value that
+// can not be pinned (in memtable or blob file) is copied into own buffer.
+//
+// A PinnableSlice is not thread-safe.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_PINNABLE_SLICE_H_
+#define STORAGE_LEVELDB_INCLUDE_PINNABLE_SLICE_H_
+
+#include <string>
+#include "leveldb/slice.h"
+
+namespace leveldb {
+
+class PinnableSlice {
+ public:
+  typedef void (*CleanupFunction)(void* arg1, void* arg2);
+
+  PinnableSlice();
+  ~PinnableSlice();
+
+  // Value, valid until Reset()
+  const Slice& value() const { return value_; }
+  const char* data() const { return value_.data(); }
+  size_t size() const { return value_.size(); }
+
+  // Whether value points to memory out of own buffer
+  bool IsPinned() const { return pinned_; }
+
+  // Point value to "s", which is kept valid by cleanups registered later.
+  void PinSlice(const Slice& s) {
+    value_ = s;
+    pinned_ = true;
+  }
+
+  // Use value filled into GetSelf() buffer.
+  void PinSelf() {
+    value_ = buf_;
+    pinned_ = false;
+  }
+
+  std::string* GetSelf() { return &buf_; }
+
+  // Register function/arg1/arg2 triple invoked when pinned value is
+  // released by Reset() or destruction.
+  void RegisterCleanup(CleanupFunction function, void* arg1, void* arg2);
+
+  // Release pinned memory and clear value.
+  void Reset();
+
+ private:
+  struct Cleanup {
+    CleanupFunction function;
+    void* arg1;
+    void* arg2;
+    Cleanup* next;
+  };
+  Cleanup cleanup_;
+  Slice value_;
+  bool pinned_;
+  std::string buf_;
+
+  // No copying allowed
+  PinnableSlice(const PinnableSlice&);
+  void operator=(const PinnableSlice&);
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_PINNABLE_SLICE_H_
@@ -0,0 +1,57 @@
+// Copyright (c) 2026 agent <agent@local>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// A RateLimiter is a token bucket used to limit background I/O
+// (memtable dump, compaction, scan, etc.) so that it does not compete
+// freely with foreground reads for disk bandwidth.
+//
+// Env keeps one RateLimiter for each IOType (see Env::GetRateLimiter()).
+
+#ifndef STORAGE_LEVELDB_INCLUDE_RATE_LIMITER_H_
+#define STORAGE_LEVELDB_INCLUDE_RATE_LIMITER_H_
+
+#include <stdint.h>
+
+namespace leveldb {
+
+class Env;
+
+class RateLimiter {
+ public:
+  virtual ~RateLimiter();
+
+  // Set configured rate. bytes_per_sec <= 0 means no limit.
+  virtual void SetBytesPerSecond(int64_t bytes_per_sec) = 0;
+  // Configured rate.
+  virtual int64_t GetBytesPerSecond() = 0;
+  // Rate actually applied now, may be lower than configured when auto tuned.
+  virtual int64_t GetCurrentBytesPerSecond() = 0;
+
+  // Tune rate applied between [min_bytes_per_sec, configured rate]
+  // to keep average latency of foreground reads (see ReportLatency())
+  // under target_latency_us. target_latency_us <= 0 disables auto tune.
+  virtual void SetAutoTune(int64_t min_bytes_per_sec, int64_t target_latency_us) = 0;
+  virtual bool IsAutoTune() = 0;
+
+  // Block until "bytes" can be consumed.
+  virtual void Request(int64_t bytes) = 0;
+
+  // One foreground read costs "micros".
+  virtual void ReportLatency(uint64_t micros) = 0;
+
+  // Statistics since last ResetStat().
+  // bytes requested, bytes that have to wait, and total time waited.
+  virtual uint64_t RequestBytes() = 0;
+  virtual uint64_t ThrottledBytes() = 0;
+  virtual uint64_t ThrottledMicros() = 0;
+  virtual void ResetStat() = 0;
+};
+
+// Return a new token bucket rate limiter with no limit.
+// Caller should delete the result when it is no longer needed.
+extern RateLimiter* NewRateLimiter(Env* env);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_RATE_LIMITER_H_
@@ -52,6 +52,11 @@ class Status {
     return Status(kSlowWrite, msg, msg2);
   }
 
+  // read needs disk I/O, but ReadOptions::cache_only is set
+  static Status Incomplete(const Slice& msg, const Slice& msg2 = Slice()) {
+    return Status(kIncomplete, msg, msg2);
+  }
+
   // Returns true iff the status indicates success.
   bool ok() const { return (state_ == NULL); }
 
@@ -67,6 +72,9 @@ class Status {
   // db reject this write, user should slow write
   bool IsSlowWrite() const { return code() == kSlowWrite; }
 
+  // Returns true iff the status indicates an Incomplete read.
+  bool IsIncomplete() const { return code() == kIncomplete; }
+
   // Return a string representation of this status suitable for printing.
   // Returns the string "OK" for success.
   std::string ToString() const;
@@ -87,6 +95,7 @@ class Status {
     kInvalidArgument = 4,
     kIOError = 5,
     kSlowWrite = 6,
+    kIncomplete = 7,
   };
 
   Code code() const {
@@ -63,15 +63,34 @@ class Table {
 
   explicit Table(Rep* rep) { rep_ = rep; }
   static Iterator* BlockReader(void*, const ReadOptions&, const Slice&);
+  // point_lookup: see Block::NewIterator()
+  // Data block is read from "file" if not NULL, else from table file.
+  static Iterator* BlockReader(void*, const ReadOptions&, const Slice&,
+                               bool point_lookup, RandomAccessFile* file = NULL);
+
+  // BlockReader of iterator with ReadOptions::readahead_size,
+  // arg is the ScanState of iterator.
+  struct ScanState;
+  static Iterator* ScanBlockReader(void*, const ReadOptions&, const Slice&);
 
   // Calls (*handle_result)(arg, ...) with the entry found after a call
   // to Seek(key).  May not make such a call if filter policy says
   // that key is not present.
+  // If handle_result pins found value into "pinned", the data block
+  // is kept until "pinned" is reset.
   friend class TableCache;
   Status InternalGet(
       const ReadOptions&, const Slice& key,
       void* arg,
-      void (*handle_result)(void* arg, const Slice& k, const Slice& v));
+      void (*handle_result)(void* arg, const Slice& k, const Slice& v),
+      PinnableSlice* pinned = NULL);
+
+  // Return false if filter says "key" is not present.
+  // Only index block and filter is checked, never read data block.
+  bool InternalKeyMayMatch(const ReadOptions&, const Slice& key);
+
+  // Hint OS to read first "n" bytes of table data in background.
+  void Prefetch(size_t n) const;
 
 
   void ReadMeta(const Footer& footer);
@@ -28,7 +28,8 @@ class TableBuilder {
   // Create a builder that will store the contents of the table it is
   // building in *file.  Does not close the file.  It is up to the
   // caller to close the file after calling Finish().
-  TableBuilder(const Options& options, WritableFile* file);
+  // "level" is the level table is built for, -1 if unknown.
+  TableBuilder(const Options& options, WritableFile* file, int level = -1);
 
   // REQUIRES: Either Finish() or Abandon() has been called.
   ~TableBuilder();
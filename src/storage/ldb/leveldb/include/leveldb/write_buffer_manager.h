@@ -0,0 +1,47 @@
+// Copyright (c) 2026 agent <agent@local>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// A WriteBufferManager keeps the memory budget of memtables of all DBs
+// sharing it (see Options::write_buffer_manager). A DB switches its memtable
+// early when total usage exceeds the budget, so a busy DB can use memory
+// that idle DBs don't need, instead of a fixed write_buffer_size each.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_WRITE_BUFFER_MANAGER_H_
+#define STORAGE_LEVELDB_INCLUDE_WRITE_BUFFER_MANAGER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace leveldb {
+
+class WriteBufferManager {
+ public:
+  // buffer_size: total memtable budget, 0 means no limit(just account usage).
+  explicit WriteBufferManager(size_t buffer_size);
+  ~WriteBufferManager();
+
+  size_t buffer_size() const { return buffer_size_; }
+  // Memory of memtables(active and being flushed) of all DBs.
+  size_t memory_usage() const { return memory_used_; }
+
+  // Whether memtables should be flushed to free memory.
+  bool ShouldFlush() const {
+    return buffer_size_ > 0 && memory_used_ >= buffer_size_;
+  }
+
+  void ReserveMem(size_t mem);
+  void FreeMem(size_t mem);
+
+ private:
+  const size_t buffer_size_;
+  volatile size_t memory_used_;
+
+  // No copying allowed
+  WriteBufferManager(const WriteBufferManager&);
+  void operator=(const WriteBufferManager&);
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_WRITE_BUFFER_MANAGER_H_
@@ -104,6 +104,10 @@ class AtomicPointer {
     MemoryBarrier();
     rep_ = v;
   }
+  // Store "new_v" only if current value is "old_v", with full barrier.
+  inline bool CompareAndSwap(void* old_v, void* new_v) {
+    return __sync_bool_compare_and_swap(&rep_, old_v, new_v);
+  }
 };
 
 // AtomicPointer based on <cstdatomic>
@@ -126,6 +130,9 @@ class AtomicPointer {
   inline void NoBarrier_Store(void* v) {
     rep_.store(v, std::memory_order_relaxed);
   }
+  inline bool CompareAndSwap(void* old_v, void* new_v) {
+    return rep_.compare_exchange_strong(old_v, new_v);
+  }
 };
 
 // We have neither MemoryBarrier(), nor <cstdatomic>
@@ -15,23 +15,39 @@
 
 namespace leveldb {
 
-inline uint32_t Block::NumRestarts() const {
-  assert(size_ >= 2*sizeof(uint32_t));
-  return DecodeFixed32(data_ + size_ - sizeof(uint32_t));
-}
-
 Block::Block(const BlockContents& contents)
     : data_(contents.data.data()),
       size_(contents.data.size()),
+      restart_offset_(0),
+      num_restarts_(0),
+      hash_offset_(0),
+      num_buckets_(0),
       owned_(contents.heap_allocated) {
   if (size_ < sizeof(uint32_t)) {
     size_ = 0;  // Error marker
   } else {
-    restart_offset_ = size_ - (1 + NumRestarts()) * sizeof(uint32_t);
-    if (restart_offset_ > size_ - sizeof(uint32_t)) {
-      // The size is too small for NumRestarts() and therefore
-      // restart_offset_ wrapped around.
+    size_t limit = size_ - sizeof(uint32_t);
+    num_restarts_ = DecodeFixed32(data_ + limit);
+    if ((num_restarts_ & kBlockHashIndexFlag) != 0) {
+      // see block_builder.cc for hash index format
+      num_restarts_ &= ~kBlockHashIndexFlag;
+      if (limit >= 2) {
+        limit -= 2;
+        num_buckets_ = static_cast<uint8_t>(data_[limit]) |
+          (static_cast<uint32_t>(static_cast<uint8_t>(data_[limit + 1])) << 8);
+      }
+      if (num_buckets_ == 0 || num_buckets_ > limit) {
+        size_ = 0;
+        return;
+      }
+      limit -= num_buckets_;
+      hash_offset_ = limit;
+    }
+    if (num_restarts_ > limit / sizeof(uint32_t)) {
+      // The size is too small for num_restarts_
       size_ = 0;
+    } else {
+      restart_offset_ = limit - num_restarts_ * sizeof(uint32_t);
     }
   }
 }
@@ -78,6 +94,8 @@ class Block::Iter : public Iterator {
   const char* const data_;      // underlying block contents
   uint32_t const restarts_;     // Offset of restart array (list of fixed32)
   uint32_t const num_restarts_; // Number of uint32_t entries in restart array
+  const uint8_t* const buckets_; // Hash index, NULL if not used
+  uint32_t const num_buckets_;
 
   // current_ is offset in data_ of current entry.  >= restarts_ if !Valid
   uint32_t current_;
@@ -114,11 +132,15 @@ class Block::Iter : public Iterator {
   Iter(const Comparator* comparator,
        const char* data,
        uint32_t restarts,
-       uint32_t num_restarts)
+       uint32_t num_restarts,
+       const uint8_t* buckets = NULL,
+       uint32_t num_buckets = 0)
       : comparator_(comparator),
         data_(data),
         restarts_(restarts),
         num_restarts_(num_restarts),
+        buckets_(buckets),
+        num_buckets_(num_buckets),
         current_(restarts_),
         restart_index_(num_restarts_) {
     assert(num_restarts_ > 0);
@@ -162,6 +184,24 @@ class Block::Iter : public Iterator {
   }
 
   virtual void Seek(const Slice& target) {
+    uint32_t hash = 0;
+    if (buckets_ != NULL && comparator_->Hash(target, &hash)) {
+      const uint8_t entry = buckets_[hash % num_buckets_];
+      if (entry == kBlockHashNoEntry) {
+        // target's key is not in this block
+        current_ = restarts_;
+        restart_index_ = num_restarts_;
+        key_.clear();
+        value_.clear();
+        return;
+      }
+      if (entry < num_restarts_) {
+        LinearSeek(entry, target);
+        return;
+      }
+      // collision, go binary search
+    }
+
     // Binary search in restart array to find the first restart point
     // with a key >= target
     uint32_t left = 0;
@@ -189,16 +229,7 @@ class Block::Iter : public Iterator {
       }
     }
 
-    // Linear search (within restart block) for first key >= target
-    SeekToRestartPoint(left);
-    while (true) {
-      if (!ParseNextKey()) {
-        return;
-      }
-      if (Compare(key_, target) >= 0) {
-        return;
-      }
-    }
+    LinearSeek(left, target);
   }
 
   virtual void SeekToFirst() {
@@ -214,6 +245,19 @@ class Block::Iter : public Iterator {
   }
 
  private:
+  // Linear search (within restart block) for first key >= target
+  void LinearSeek(uint32_t restart_index, const Slice& target) {
+    SeekToRestartPoint(restart_index);
+    while (true) {
+      if (!ParseNextKey()) {
+        return;
+      }
+      if (Compare(key_, target) >= 0) {
+        return;
+      }
+    }
+  }
+
   void CorruptionError() {
     current_ = restarts_;
     restart_index_ = num_restarts_;
@@ -252,15 +296,17 @@ class Block::Iter : public Iterator {
   }
 };
 
-Iterator* Block::NewIterator(const Comparator* cmp) {
+Iterator* Block::NewIterator(const Comparator* cmp, bool point_lookup) {
   if (size_ < 2*sizeof(uint32_t)) {
     return NewErrorIterator(Status::Corruption("bad block contents"));
   }
-  const uint32_t num_restarts = NumRestarts();
-  if (num_restarts == 0) {
+  if (num_restarts_ == 0) {
     return NewEmptyIterator();
+  } else if (point_lookup && num_buckets_ > 0) {
+    return new Iter(cmp, data_, restart_offset_, num_restarts_,
+                    reinterpret_cast<const uint8_t*>(data_ + hash_offset_), num_buckets_);
   } else {
-    return new Iter(cmp, data_, restart_offset_, num_restarts);
+    return new Iter(cmp, data_, restart_offset_, num_restarts_);
   }
 }
 
@@ -22,14 +22,17 @@ class Block {
   ~Block();
 
   size_t size() const { return size_; }
-  Iterator* NewIterator(const Comparator* comparator);
+  // point_lookup: Seek() uses hash index if block has one, then it only
+  // guarantees to find target's key when the key is in this block.
+  Iterator* NewIterator(const Comparator* comparator, bool point_lookup = false);
 
  private:
-  uint32_t NumRestarts() const;
-
   const char* data_;
   size_t size_;
   uint32_t restart_offset_;     // Offset in data_ of restart array
+  uint32_t num_restarts_;
+  uint32_t hash_offset_;        // Offset in data_ of hash index buckets
+  uint32_t num_buckets_;        // 0 if no hash index
   bool owned_;                  // Block owns data_[]
 
   // No copying allowed
@@ -25,6 +25,19 @@
 //     restarts: uint32[num_restarts]
 //     num_restarts: uint32
 // restarts[i] contains the offset within the block of the ith restart point.
+//
+// Data block may have hash index between restart array and num_restarts,
+// flagged by the highest bit of num_restarts:
+//     buckets: uint8[num_buckets]
+//     num_buckets: uint16
+//     num_restarts | kBlockHashIndexFlag: uint32
+// buckets[hash(key) % num_buckets] is the index of restart interval
+// where key first appears, kBlockHashNoEntry if no key falls in the
+// bucket, or kBlockHashCollision if keys in different restart intervals
+// fall in it. Lookup starts linear search from that restart point
+// directly, and falls back to binary search on collision.
+// Blocks with more than kBlockHashMaxRestarts restart points have no
+// hash index.
 
 #include "table/block_builder.h"
 
@@ -32,15 +45,21 @@
 #include <assert.h>
 #include "leveldb/comparator.h"
 #include "leveldb/table_builder.h"
+#include "table/format.h"
 #include "util/coding.h"
 
 namespace leveldb {
 
-BlockBuilder::BlockBuilder(const Options* options)
+// Average keys per hash bucket
+static const double kHashUtilRatio = 0.75;
+
+BlockBuilder::BlockBuilder(const Options* options, bool hash_index)
     : options_(options),
       restarts_(),
       counter_(0),
-      finished_(false) {
+      finished_(false),
+      hash_index_(hash_index),
+      hash_ok_(true) {
   assert(options->block_restart_interval >= 1);
   restarts_.push_back(0);       // First restart point is at offset 0
 }
@@ -52,20 +71,57 @@ void BlockBuilder::Reset() {
   counter_ = 0;
   finished_ = false;
   last_key_.clear();
+  hash_ok_ = true;
+  hashes_.clear();
 }
 
 size_t BlockBuilder::CurrentSizeEstimate() const {
   return (buffer_.size() +                        // Raw data buffer
           restarts_.size() * sizeof(uint32_t) +   // Restart array
+          (NeedHashIndex() ?                      // Hash index
+           static_cast<size_t>(hashes_.size() / kHashUtilRatio) + 3 : 0) +
           sizeof(uint32_t));                      // Restart array length
 }
 
+bool BlockBuilder::NeedHashIndex() const {
+  return hash_index_ && options_->data_block_hash_index && hash_ok_ &&
+    !hashes_.empty() && restarts_.size() <= kBlockHashMaxRestarts;
+}
+
+void BlockBuilder::AppendHashIndex() {
+  size_t num_buckets = static_cast<size_t>(hashes_.size() / kHashUtilRatio);
+  if (num_buckets > 0xffff) {
+    num_buckets = 0xffff;
+  }
+  num_buckets |= 1;             // odd number spreads hash better
+
+  const size_t start = buffer_.size();
+  buffer_.resize(start + num_buckets, static_cast<char>(kBlockHashNoEntry));
+  uint8_t* buckets = reinterpret_cast<uint8_t*>(&buffer_[start]);
+  for (size_t i = 0; i < hashes_.size(); i++) {
+    uint8_t* bucket = buckets + hashes_[i].first % num_buckets;
+    const uint8_t restart = static_cast<uint8_t>(hashes_[i].second);
+    if (*bucket == kBlockHashNoEntry) {
+      *bucket = restart;
+    } else if (*bucket != restart) {
+      *bucket = kBlockHashCollision;
+    }
+  }
+  buffer_.push_back(static_cast<char>(num_buckets & 0xff));
+  buffer_.push_back(static_cast<char>(num_buckets >> 8));
+}
+
 Slice BlockBuilder::Finish() {
   // Append restart array
   for (size_t i = 0; i < restarts_.size(); i++) {
     PutFixed32(&buffer_, restarts_[i]);
   }
-  PutFixed32(&buffer_, restarts_.size());
+  if (NeedHashIndex()) {
+    AppendHashIndex();
+    PutFixed32(&buffer_, restarts_.size() | kBlockHashIndexFlag);
+  } else {
+    PutFixed32(&buffer_, restarts_.size());
+  }
   finished_ = true;
   return Slice(buffer_);
 }
@@ -104,6 +160,17 @@ void BlockBuilder::Add(const Slice& key, const Slice& value) {
   last_key_.append(key.data() + shared, non_shared);
   assert(Slice(last_key_) == key);
   counter_++;
+
+  if (hash_index_ && hash_ok_) {
+    // every key of block must be hashed, even if option changes midway
+    uint32_t hash = 0;
+    if (!options_->data_block_hash_index ||
+        !options_->comparator->Hash(key, &hash)) {
+      hash_ok_ = false;
+    } else if (hashes_.empty() || hashes_.back().first != hash) {
+      hashes_.push_back(std::make_pair(hash, static_cast<uint32_t>(restarts_.size() - 1)));
+    }
+  }
 }
 
 }  // namespace leveldb
@@ -16,7 +16,9 @@ struct Options;
 
 class BlockBuilder {
  public:
-  explicit BlockBuilder(const Options* options);
+  // hash_index: build hash index if options->data_block_hash_index,
+  // only data blocks need it.
+  explicit BlockBuilder(const Options* options, bool hash_index = false);
 
   // Reset the contents as if the BlockBuilder was just constructed.
   void Reset();
@@ -46,6 +48,14 @@ class BlockBuilder {
   int                   counter_;     // Number of entries emitted since restart
   bool                  finished_;    // Has Finish() been called?
   std::string           last_key_;
+  bool                  hash_index_;  // May build hash index
+  bool                  hash_ok_;     // All keys are hashed
+  // (hash, restart index) of keys, adjacent keys with same hash
+  // (eg. versions of one user key) are recorded once.
+  std::vector<std::pair<uint32_t, uint32_t> > hashes_;
+
+  bool NeedHashIndex() const;
+  void AppendHashIndex();
 
   // No copying allowed
   BlockBuilder(const BlockBuilder&);
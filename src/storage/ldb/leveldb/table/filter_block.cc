@@ -12,8 +12,9 @@ namespace leveldb {
 
 // See doc/table_format.txt for an explanation of the filter block format.
 
-FilterBlockBuilder::FilterBlockBuilder(const FilterPolicy* policy)
-    : policy_(policy) {
+FilterBlockBuilder::FilterBlockBuilder(const FilterPolicy* policy, int level)
+    : policy_(policy),
+      level_(level) {
 }
 
 void FilterBlockBuilder::StartBlock(uint64_t block_offset) {
@@ -66,7 +67,7 @@ void FilterBlockBuilder::GenerateFilter() {
 
   // Generate filter for current set of keys and append to result_.
   filter_offsets_.push_back(result_.size());
-  policy_->CreateFilter(&tmp_keys_[0], num_keys, &result_);
+  policy_->CreateFilterForLevel(&tmp_keys_[0], num_keys, &result_, level_);
 
   tmp_keys_.clear();
   keys_.clear();
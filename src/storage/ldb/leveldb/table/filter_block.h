@@ -28,7 +28,8 @@ class FilterPolicy;
 //      (StartBlock AddKey*)* Finish
 class FilterBlockBuilder {
  public:
-  explicit FilterBlockBuilder(const FilterPolicy*);
+  // "level" is passed to FilterPolicy::CreateFilterForLevel()
+  explicit FilterBlockBuilder(const FilterPolicy*, int level = -1);
 
   void StartBlock(uint64_t block_offset);
   void AddKey(const Slice& key);
@@ -38,6 +39,7 @@ class FilterBlockBuilder {
   void GenerateFilter();
 
   const FilterPolicy* policy_;
+  const int level_;
   std::string keys_;              // Flattened key contents
   std::vector<size_t> start_;     // Starting index in keys_ of each key
   std::string result_;            // Filter data computed so far
@@ -83,6 +83,14 @@ static const uint64_t kTableMagicNumber = 0xdb4775248b80fb57ull;
 // 1-byte type + 32-bit crc
 static const size_t kBlockTrailerSize = 5;
 
+// Data block hash index (see block_builder.cc).
+// Highest bit of num_restarts flags that the block has hash index.
+static const uint32_t kBlockHashIndexFlag = 0x80000000u;
+// bucket of hash index holds restart index, or one of these
+static const uint8_t kBlockHashNoEntry = 255;
+static const uint8_t kBlockHashCollision = 254;
+static const uint32_t kBlockHashMaxRestarts = 253;
+
 struct BlockContents {
   Slice data;           // Actual contents of data
   bool cachable;        // True iff data can be cached
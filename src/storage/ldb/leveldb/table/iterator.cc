@@ -3,6 +3,7 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
 #include "leveldb/iterator.h"
+#include "leveldb/pinnable_slice.h"
 
 namespace leveldb {
 
@@ -38,6 +39,20 @@ void Iterator::RegisterCleanup(CleanupFunction func, void* arg1, void* arg2) {
   c->arg2 = arg2;
 }
 
+void Iterator::DelegateCleanupsTo(PinnableSlice* pinned) {
+  if (cleanup_.function != NULL) {
+    pinned->RegisterCleanup(cleanup_.function, cleanup_.arg1, cleanup_.arg2);
+    for (Cleanup* c = cleanup_.next; c != NULL; ) {
+      pinned->RegisterCleanup(c->function, c->arg1, c->arg2);
+      Cleanup* next = c->next;
+      delete c;
+      c = next;
+    }
+    cleanup_.function = NULL;
+    cleanup_.next = NULL;
+  }
+}
+
 namespace {
 class EmptyIterator : public Iterator {
  public:
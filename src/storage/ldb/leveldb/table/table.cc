@@ -4,11 +4,16 @@
 
 #include "leveldb/table.h"
 
+#include <string.h>
+#include <algorithm>
+#include <string>
+
 #include "leveldb/cache.h"
 #include "leveldb/comparator.h"
 #include "leveldb/env.h"
 #include "leveldb/filter_policy.h"
 #include "leveldb/options.h"
+#include "leveldb/pinnable_slice.h"
 #include "table/block.h"
 #include "table/filter_block.h"
 #include "table/format.h"
@@ -134,6 +139,88 @@ Table::~Table() {
   delete rep_;
 }
 
+namespace {
+
+// Serves block reads of one scan iterator from a buffer filled by large
+// reads. The window grows from the block size up to max_size while reads
+// are sequential, and starts over after a seek. The window after the
+// buffer is hinted to OS, so the next fill is mostly from page cache.
+class ReadaheadFile : public RandomAccessFile {
+ public:
+  // only [0, limit) of file is read ahead
+  ReadaheadFile(RandomAccessFile* file, size_t max_size, uint64_t limit)
+      : file_(file),
+        max_size_(max_size),
+        limit_(limit),
+        window_(0),
+        buffer_offset_(0),
+        next_offset_(0) {
+  }
+
+  virtual Status Read(uint64_t offset, size_t n, Slice* result,
+                      char* scratch) const {
+    if (offset + n > limit_) {
+      return file_->Read(offset, n, result, scratch);
+    }
+    if (offset < buffer_offset_ ||
+        offset + n > buffer_offset_ + buffer_.size()) {
+      window_ = (offset == next_offset_) ?
+          std::min(std::max(window_ * 2, n), max_size_) : n;
+      const size_t size = static_cast<size_t>(
+          std::min(static_cast<uint64_t>(std::max(window_, n)), limit_ - offset));
+      space_.resize(size);
+      Status s = file_->Read(offset, size, &buffer_, &space_[0]);
+      if (!s.ok()) {
+        buffer_ = Slice();
+        return s;
+      }
+      buffer_offset_ = offset;
+      const uint64_t end = offset + buffer_.size();
+      if (end < limit_) {
+        file_->Prefetch(end, static_cast<size_t>(
+            std::min(static_cast<uint64_t>(std::min(window_ * 2, max_size_)),
+                     limit_ - end)));
+      }
+    }
+    // a short read leaves less than n bytes, caller finds it truncated
+    const size_t skip = static_cast<size_t>(offset - buffer_offset_);
+    const size_t size = std::min(n, buffer_.size() - skip);
+    memcpy(scratch, buffer_.data() + skip, size);
+    *result = Slice(scratch, size);
+    next_offset_ = offset + n;
+    return Status::OK();
+  }
+
+  virtual void Prefetch(uint64_t offset, size_t n) const {
+    file_->Prefetch(offset, n);
+  }
+
+ private:
+  RandomAccessFile* file_;
+  const size_t max_size_;
+  const uint64_t limit_;
+  // state of the single iterator reading through this file
+  mutable size_t window_;
+  mutable std::string space_;
+  mutable Slice buffer_;
+  mutable uint64_t buffer_offset_;
+  mutable uint64_t next_offset_;
+};
+
+}  // namespace
+
+struct Table::ScanState {
+  ScanState(const Table* t, size_t readahead_size)
+      : table(t),
+        file(t->rep_->file, readahead_size, t->rep_->metaindex_handle.offset()) {
+  }
+  static void Delete(void* arg, void* ignored) {
+    delete reinterpret_cast<ScanState*>(arg);
+  }
+  const Table* table;
+  ReadaheadFile file;
+};
+
 static void DeleteBlock(void* arg, void* ignored) {
   delete reinterpret_cast<Block*>(arg);
 }
@@ -154,7 +241,18 @@ static void ReleaseBlock(void* arg, void* h) {
 Iterator* Table::BlockReader(void* arg,
                              const ReadOptions& options,
                              const Slice& index_value) {
+  return BlockReader(arg, options, index_value, false);
+}
+
+Iterator* Table::BlockReader(void* arg,
+                             const ReadOptions& options,
+                             const Slice& index_value,
+                             bool point_lookup,
+                             RandomAccessFile* file) {
   Table* table = reinterpret_cast<Table*>(arg);
+  if (file == NULL) {
+    file = table->rep_->file;
+  }
   Cache* block_cache = table->rep_->options.block_cache;
   Block* block = NULL;
   Cache::Handle* cache_handle = NULL;
@@ -175,8 +273,10 @@ Iterator* Table::BlockReader(void* arg,
       cache_handle = block_cache->Lookup(key);
       if (cache_handle != NULL) {
         block = reinterpret_cast<Block*>(block_cache->Value(cache_handle));
+      } else if (options.cache_only) {
+        s = Status::Incomplete("block not in cache");
       } else {
-        s = ReadBlock(table->rep_->file, options, handle, &contents);
+        s = ReadBlock(file, options, handle, &contents);
         if (s.ok()) {
           block = new Block(contents);
           if (contents.cachable && options.fill_cache) {
@@ -185,8 +285,10 @@ Iterator* Table::BlockReader(void* arg,
           }
         }
       }
+    } else if (options.cache_only) {
+      s = Status::Incomplete("no block cache");
     } else {
-      s = ReadBlock(table->rep_->file, options, handle, &contents);
+      s = ReadBlock(file, options, handle, &contents);
       if (s.ok()) {
         block = new Block(contents);
       }
@@ -195,7 +297,7 @@ Iterator* Table::BlockReader(void* arg,
 
   Iterator* iter;
   if (block != NULL) {
-    iter = block->NewIterator(table->rep_->options.comparator);
+    iter = block->NewIterator(table->rep_->options.comparator, point_lookup);
     if (cache_handle == NULL) {
       iter->RegisterCleanup(&DeleteBlock, block, NULL);
     } else {
@@ -207,7 +309,23 @@ Iterator* Table::BlockReader(void* arg,
   return iter;
 }
 
+Iterator* Table::ScanBlockReader(void* arg,
+                                 const ReadOptions& options,
+                                 const Slice& index_value) {
+  ScanState* state = reinterpret_cast<ScanState*>(arg);
+  return BlockReader(const_cast<Table*>(state->table), options, index_value,
+                     false, &state->file);
+}
+
 Iterator* Table::NewIterator(const ReadOptions& options) const {
+  if (options.readahead_size > 0 && !options.cache_only) {
+    ScanState* state = new ScanState(this, options.readahead_size);
+    Iterator* iter = NewTwoLevelIterator(
+        rep_->index_block->NewIterator(rep_->options.comparator),
+        &Table::ScanBlockReader, state, options);
+    iter->RegisterCleanup(&ScanState::Delete, state, NULL);
+    return iter;
+  }
   return NewTwoLevelIterator(
       rep_->index_block->NewIterator(rep_->options.comparator),
       &Table::BlockReader, const_cast<Table*>(this), options);
@@ -215,7 +333,8 @@ Iterator* Table::NewIterator(const ReadOptions& options) const {
 
 Status Table::InternalGet(const ReadOptions& options, const Slice& k,
                           void* arg,
-                          void (*saver)(void*, const Slice&, const Slice&)) {
+                          void (*saver)(void*, const Slice&, const Slice&),
+                          PinnableSlice* pinned) {
   Status s;
   Iterator* iiter = rep_->index_block->NewIterator(rep_->options.comparator);
   PROFILER_BEGIN("sst seek block");
@@ -232,13 +351,17 @@ Status Table::InternalGet(const ReadOptions& options, const Slice& k,
     } else {
 //      Slice handle = iiter->value();
       PROFILER_BEGIN("sst read block");
-      Iterator* block_iter = BlockReader(this, options, iiter->value());
+      Iterator* block_iter = BlockReader(this, options, iiter->value(), true);
       PROFILER_END();
       PROFILER_BEGIN("blk seek");
       block_iter->Seek(k);
       PROFILER_END();
       if (block_iter->Valid()) {
         (*saver)(arg, block_iter->key(), block_iter->value());
+        if (pinned != NULL && pinned->IsPinned()) {
+          // value points into this block
+          block_iter->DelegateCleanupsTo(pinned);
+        }
       }
       s = block_iter->status();
       delete block_iter;
@@ -251,6 +374,31 @@ Status Table::InternalGet(const ReadOptions& options, const Slice& k,
   return s;
 }
 
+bool Table::InternalKeyMayMatch(const ReadOptions&, const Slice& k) {
+  bool may_match = true;
+  Iterator* iiter = rep_->index_block->NewIterator(rep_->options.comparator);
+  iiter->Seek(k);
+  if (iiter->Valid()) {
+    Slice handle_value = iiter->value();
+    FilterBlockReader* filter = rep_->filter;
+    BlockHandle handle;
+    if (filter != NULL &&
+        handle.DecodeFrom(&handle_value).ok() &&
+        !filter->KeyMayMatch(handle.offset(), k)) {
+      may_match = false;
+    }
+  } else if (iiter->status().ok()) {
+    // past the last key of this table
+    may_match = false;
+  }
+  delete iiter;
+  return may_match;
+}
+
+void Table::Prefetch(size_t n) const {
+  rep_->file->Prefetch(0, static_cast<size_t>(
+      std::min(static_cast<uint64_t>(n), rep_->metaindex_handle.offset())));
+}
 
 uint64_t Table::ApproximateOffsetOf(const Slice& key) const {
   Iterator* index_iter =
@@ -44,24 +44,24 @@ struct TableBuilder::Rep {
 
   std::string compressed_output;
 
-  Rep(const Options& opt, WritableFile* f)
+  Rep(const Options& opt, WritableFile* f, int level)
       : options(opt),
         index_block_options(opt),
         file(f),
         offset(0),
-        data_block(&options),
+        data_block(&options, true),
         index_block(&index_block_options),
         num_entries(0),
         closed(false),
         filter_block(opt.filter_policy == NULL ? NULL
-                     : new FilterBlockBuilder(opt.filter_policy)),
+                     : new FilterBlockBuilder(opt.filter_policy, level)),
         pending_index_entry(false) {
     index_block_options.block_restart_interval = 1;
   }
 };
 
-TableBuilder::TableBuilder(const Options& options, WritableFile* file)
-    : rep_(new Rep(options, file)) {
+TableBuilder::TableBuilder(const Options& options, WritableFile* file, int level)
+    : rep_(new Rep(options, file, level)) {
   if (rep_->filter_block != NULL) {
     rep_->filter_block->StartBlock(0);
   }
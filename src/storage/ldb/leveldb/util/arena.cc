@@ -12,6 +12,7 @@ Arena::Arena() {
   blocks_memory_ = 0;
   alloc_ptr_ = NULL;  // First allocation will allocate a block
   alloc_bytes_remaining_ = 0;
+  lock_ = 0;
 }
 
 Arena::~Arena() {
@@ -57,6 +58,26 @@ char* Arena::AllocateAligned(size_t bytes) {
   return result;
 }
 
+char* Arena::AllocateConcurrently(size_t bytes) {
+  while (__sync_lock_test_and_set(&lock_, 1)) {
+    while (lock_) {
+    }
+  }
+  char* result = Allocate(bytes);
+  __sync_lock_release(&lock_);
+  return result;
+}
+
+char* Arena::AllocateAlignedConcurrently(size_t bytes) {
+  while (__sync_lock_test_and_set(&lock_, 1)) {
+    while (lock_) {
+    }
+  }
+  char* result = AllocateAligned(bytes);
+  __sync_lock_release(&lock_);
+  return result;
+}
+
 char* Arena::AllocateNewBlock(size_t block_bytes) {
   char* result = new char[block_bytes];
   blocks_memory_ += block_bytes;
@@ -23,6 +23,11 @@ class Arena {
   // Allocate memory with the normal alignment guarantees provided by malloc
   char* AllocateAligned(size_t bytes);
 
+  // Same as above, but can be called by several threads at the same time.
+  // Must not be mixed with the non-concurrent version at the same time.
+  char* AllocateConcurrently(size_t bytes);
+  char* AllocateAlignedConcurrently(size_t bytes);
+
   // Returns an estimate of the total memory usage of data allocated
   // by the arena (including space allocated but not yet used for user
   // allocations).
@@ -44,6 +49,9 @@ class Arena {
   // Bytes of memory in blocks allocated so far
   size_t blocks_memory_;
 
+  // Spin lock for concurrent allocation, critical section is very short.
+  volatile int lock_;
+
   // No copying allowed
   Arena(const Arena&);
   void operator=(const Arena&);
@@ -150,6 +150,7 @@ class LRUCache {
   void Release(Cache::Handle* handle);
   void Erase(const Slice& key, uint32_t hash);
   void Stats(size_t& usage, size_t& extra_usage);
+  void HitStats(uint64_t& hit, uint64_t& miss);
 
  private:
   void LRU_Remove(LRUHandle* e);
@@ -167,6 +168,10 @@ class LRUCache {
   // extra usage statictics
   size_t extra_usage_;
 
+  // lookup statictics
+  uint64_t hit_count_;
+  uint64_t miss_count_;
+
   // Dummy head of LRU list.
   // lru.prev is newest entry, lru.next is oldest entry.
   LRUHandle lru_;
@@ -177,7 +182,9 @@ class LRUCache {
 LRUCache::LRUCache()
     : usage_(0),
       last_id_(0),
-      extra_usage_(0) {
+      extra_usage_(0),
+      hit_count_(0),
+      miss_count_(0) {
   // Make empty circular linked list
   lru_.next = &lru_;
   lru_.prev = &lru_;
@@ -223,6 +230,9 @@ Cache::Handle* LRUCache::Lookup(const Slice& key, uint32_t hash) {
     e->refs++;
     LRU_Remove(e);
     LRU_Append(e);
+    ++hit_count_;
+  } else {
+    ++miss_count_;
   }
   return reinterpret_cast<Cache::Handle*>(e);
 }
@@ -282,12 +292,19 @@ void LRUCache::Stats(size_t& usage, size_t& extra_usage) {
   extra_usage = extra_usage_;
 }
 
-static const int kNumShardBits = 4;
-static const int kNumShards = 1 << kNumShardBits;
+void LRUCache::HitStats(uint64_t& hit, uint64_t& miss) {
+  MutexLock l(&mutex_);
+  hit = hit_count_;
+  miss = miss_count_;
+}
+
+static const int kMaxNumShardBits = 10;
 
 class ShardedLRUCache : public Cache {
  private:
-  LRUCache shard_[kNumShards];
+  const int num_shard_bits_;
+  const int num_shards_;
+  LRUCache* shard_;
   port::Mutex id_mutex_;
   uint64_t last_id_;
 
@@ -295,19 +312,24 @@ class ShardedLRUCache : public Cache {
     return Hash(s.data(), s.size(), 0);
   }
 
-  static uint32_t Shard(uint32_t hash) {
-    return hash >> (32 - kNumShardBits);
+  uint32_t Shard(uint32_t hash) const {
+    return num_shard_bits_ > 0 ? hash >> (32 - num_shard_bits_) : 0;
   }
 
  public:
-  explicit ShardedLRUCache(size_t capacity)
-      : last_id_(0) {
-    const size_t per_shard = (capacity + (kNumShards - 1)) / kNumShards;
-    for (int s = 0; s < kNumShards; s++) {
+  ShardedLRUCache(size_t capacity, int num_shard_bits)
+      : num_shard_bits_(num_shard_bits),
+        num_shards_(1 << num_shard_bits),
+        shard_(new LRUCache[num_shards_]),
+        last_id_(0) {
+    const size_t per_shard = (capacity + (num_shards_ - 1)) / num_shards_;
+    for (int s = 0; s < num_shards_; s++) {
       shard_[s].SetCapacity(per_shard);
     }
   }
-  virtual ~ShardedLRUCache() { }
+  virtual ~ShardedLRUCache() {
+    delete[] shard_;
+  }
   virtual Handle* Insert(const Slice& key, void* value, size_t charge, size_t stat_charge,
                          void (*deleter)(const Slice& key, void* value)) {
     const uint32_t hash = HashSlice(key);
@@ -335,21 +357,137 @@ class ShardedLRUCache : public Cache {
   virtual void Stats(std::string& result) {
     size_t usage = 0, extra_usage = 0,
       total_usage = 0, total_extra_usage = 0;
-    for (int s = 0; s < kNumShards; s++) {
+    for (int s = 0; s < num_shards_; s++) {
       shard_[s].Stats(usage, extra_usage);
       total_usage += usage;
       total_extra_usage += extra_usage;
     }
-    char buf[128];
-    snprintf(buf, sizeof(buf), "charge usage: %lu, usage: %lu\n", total_usage, total_extra_usage);
+    uint64_t hit = 0, miss = 0;
+    HitStats(&hit, &miss);
+    char buf[256];
+    snprintf(buf, sizeof(buf), "charge usage: %lu, usage: %lu, hit: %lu, miss: %lu, hit rate: %.2f%%\n",
+             total_usage, total_extra_usage, hit, miss,
+             hit + miss > 0 ? hit * 100.0 / (hit + miss) : 0.0);
+    result.append(buf);
+  }
+  virtual void HitStats(uint64_t* hit, uint64_t* miss) {
+    uint64_t shard_hit = 0, shard_miss = 0;
+    *hit = *miss = 0;
+    for (int s = 0; s < num_shards_; s++) {
+      shard_[s].HitStats(shard_hit, shard_miss);
+      *hit += shard_hit;
+      *miss += shard_miss;
+    }
+  }
+};
+
+// Entries are stored in the shared cache, value is wrapped with the
+// account it is charged to. Account is referenced by the view and every
+// entry, since entries may be evicted after the view is deleted.
+class AccountedCache : public Cache {
+ private:
+  struct Account {
+    volatile int32_t refs;
+    volatile uint64_t charge;
+    volatile uint64_t stat_charge;
+    volatile uint64_t hit;
+    volatile uint64_t miss;
+  };
+  struct Entry {
+    void* value;
+    void (*deleter)(const Slice& key, void* value);
+    Account* account;
+    size_t charge;
+    size_t stat_charge;
+  };
+
+  Cache* const base_;
+  Account* account_;
+
+  static void UnrefAccount(Account* account) {
+    if (__sync_sub_and_fetch(&account->refs, 1) == 0) {
+      delete account;
+    }
+  }
+
+  static void DeleteEntry(const Slice& key, void* value) {
+    Entry* e = reinterpret_cast<Entry*>(value);
+    (*e->deleter)(key, e->value);
+    __sync_fetch_and_sub(&e->account->charge, e->charge);
+    __sync_fetch_and_sub(&e->account->stat_charge, e->stat_charge);
+    UnrefAccount(e->account);
+    delete e;
+  }
+
+ public:
+  explicit AccountedCache(Cache* base)
+      : base_(base),
+        account_(new Account()) {
+    account_->refs = 1;
+    account_->charge = account_->stat_charge = 0;
+    account_->hit = account_->miss = 0;
+  }
+  virtual ~AccountedCache() {
+    UnrefAccount(account_);
+  }
+  virtual Handle* Insert(const Slice& key, void* value, size_t charge, size_t stat_charge,
+                         void (*deleter)(const Slice& key, void* value)) {
+    Entry* e = new Entry();
+    e->value = value;
+    e->deleter = deleter;
+    e->account = account_;
+    e->charge = charge;
+    e->stat_charge = stat_charge;
+    __sync_fetch_and_add(&account_->refs, 1);
+    __sync_fetch_and_add(&account_->charge, charge);
+    __sync_fetch_and_add(&account_->stat_charge, stat_charge);
+    return base_->Insert(key, e, charge, stat_charge, &DeleteEntry);
+  }
+  virtual Handle* Lookup(const Slice& key) {
+    Handle* handle = base_->Lookup(key);
+    __sync_fetch_and_add(handle != NULL ? &account_->hit : &account_->miss, 1);
+    return handle;
+  }
+  virtual void Release(Handle* handle) {
+    base_->Release(handle);
+  }
+  virtual void Erase(const Slice& key) {
+    base_->Erase(key);
+  }
+  virtual void* Value(Handle* handle) {
+    return reinterpret_cast<Entry*>(base_->Value(handle))->value;
+  }
+  virtual uint64_t NewId() {
+    return base_->NewId();
+  }
+  virtual void Stats(std::string& result) {
+    const uint64_t hit = account_->hit, miss = account_->miss;
+    char buf[256];
+    snprintf(buf, sizeof(buf), "charge usage: %lu, usage: %lu, hit: %lu, miss: %lu, hit rate: %.2f%%, shared: ",
+             account_->charge, account_->stat_charge, hit, miss,
+             hit + miss > 0 ? hit * 100.0 / (hit + miss) : 0.0);
     result.append(buf);
+    base_->Stats(result);
+  }
+  virtual void HitStats(uint64_t* hit, uint64_t* miss) {
+    *hit = account_->hit;
+    *miss = account_->miss;
   }
 };
 
 }  // end anonymous namespace
 
-Cache* NewLRUCache(size_t capacity) {
-  return new ShardedLRUCache(capacity);
+Cache* NewLRUCache(size_t capacity, int num_shard_bits) {
+  if (num_shard_bits < 0) {
+    num_shard_bits = 0;
+  } else if (num_shard_bits > kMaxNumShardBits) {
+    num_shard_bits = kMaxNumShardBits;
+  }
+  return new ShardedLRUCache(capacity, num_shard_bits);
+}
+
+Cache* NewAccountedCache(Cache* shared) {
+  return new AccountedCache(shared);
 }
 
 }  // namespace leveldb
@@ -6,12 +6,18 @@
 #include <stdint.h>
 #include "leveldb/comparator.h"
 #include "leveldb/slice.h"
+#include "util/hash.h"
 #include "util/logging.h"
 
 namespace leveldb {
 
 Comparator::~Comparator() { }
 
+bool Comparator::ShouldDropMaybe(const Slice& key, const Slice& value,
+                                 int64_t sequence, uint32_t now) const {
+  return ShouldDropMaybe(key.data(), sequence, now);
+}
+
 namespace {
 class BytewiseComparatorImpl : public Comparator {
  public:
@@ -62,6 +68,11 @@ class BytewiseComparatorImpl : public Comparator {
     }
     // *key is a run of 0xffs.  Leave it alone.
   }
+
+  virtual bool Hash(const Slice& key, uint32_t* hash) const {
+    *hash = leveldb::Hash(key.data(), key.size(), 0x7a3c9d15);
+    return true;
+  }
 };
 }  // namespace
 
@@ -3,12 +3,46 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
 #include "leveldb/env.h"
+#include "leveldb/rate_limiter.h"
+#include "leveldb/slice.h"
 
 namespace leveldb {
 
 Env::~Env() {
 }
 
+namespace {
+class LimitedWritableFile : public WritableFile {
+ public:
+  LimitedWritableFile(WritableFile* file, RateLimiter* limiter)
+    : file_(file), limiter_(limiter) { }
+  virtual ~LimitedWritableFile() { delete file_; }
+
+  virtual Status Append(const Slice& data) {
+    limiter_->Request(data.size());
+    return file_->Append(data);
+  }
+  virtual Status Close() { return file_->Close(); }
+  virtual Status Flush() { return file_->Flush(); }
+  virtual Status Sync() { return file_->Sync(); }
+
+ private:
+  WritableFile* file_;
+  RateLimiter* limiter_;
+};
+}
+
+Status Env::NewLimitedWritableFile(const std::string& fname,
+                                   WritableFile** result,
+                                   IOType type) {
+  Status s = NewWritableFile(fname, result);
+  RateLimiter* limiter = GetRateLimiter(type);
+  if (s.ok() && limiter != NULL) {
+    *result = new LimitedWritableFile(*result, limiter);
+  }
+  return s;
+}
+
 SequentialFile::~SequentialFile() {
 }
 
@@ -20,6 +20,7 @@
 #include <sys/stat.h>
 #endif
 #include "leveldb/env.h"
+#include "leveldb/rate_limiter.h"
 #include "leveldb/slice.h"
 #include "port/port.h"
 #include "util/mutexlock.h"
@@ -91,6 +92,10 @@ class PosixRandomAccessFile: public RandomAccessFile {
     }
     return s;
   }
+
+  virtual void Prefetch(uint64_t offset, size_t n) const {
+    posix_fadvise(fd_, static_cast<off_t>(offset), n, POSIX_FADV_WILLNEED);
+  }
 };
 
 // mmap() based random-access
@@ -117,6 +122,17 @@ class PosixMmapReadableFile: public RandomAccessFile {
     }
     return s;
   }
+
+  virtual void Prefetch(uint64_t offset, size_t n) const {
+    if (offset < length_) {
+      // madvise() wants a page aligned start
+      const uint64_t page_size = getpagesize();
+      const uint64_t start = offset / page_size * page_size;
+      const uint64_t end = std::min(offset + n, static_cast<uint64_t>(length_));
+      madvise(reinterpret_cast<char*>(mmapped_region_) + start, end - start,
+              MADV_WILLNEED);
+    }
+  }
 };
 
 // We preallocate up to an extra megabyte and use memcpy to append new
@@ -272,6 +288,10 @@ class PosixMmapFile : public WritableFile {
   }
 
   virtual Status Sync() {
+    // Log file may be synced while others are appending to it
+    // (pipelined sync), so region can not be remapped during sync,
+    // and only sync what has been appended so far.
+    MutexLock l(mutex_);
     Status s;
 
     if (pending_sync_) {
@@ -282,12 +302,13 @@ class PosixMmapFile : public WritableFile {
       }
     }
 
-    if (dst_ > last_sync_) {
+    char* dst = dst_;
+    if (dst > last_sync_) {
       // Find the beginnings of the pages that contain the first and last
       // bytes to be synced.
       size_t p1 = TruncateToPageBoundary(last_sync_ - base_);
-      size_t p2 = TruncateToPageBoundary(dst_ - base_ - 1);
-      last_sync_ = dst_;
+      size_t p2 = TruncateToPageBoundary(dst - base_ - 1);
+      last_sync_ = dst;
       if (msync(base_ + p1, p2 - p1 + page_size_, MS_SYNC) < 0) {
         s = IOError(filename_, errno);
       }
@@ -443,6 +464,10 @@ class PosixEnv : public Env {
       // for accident signal ignore by bgthread
       PthreadCall("signal", pthread_cond_signal(&bgsignal_));
     }
+
+    for (int i = 0; i < kNumIOTypes; i++) {
+      delete rate_limiters_[i];
+    }
   }
 
   virtual Status NewSequentialFile(const std::string& fname,
@@ -571,6 +596,14 @@ class PosixEnv : public Env {
     return result;
   }
 
+  virtual Status LinkFile(const std::string& src, const std::string& target) {
+    Status result;
+    if (link(src.c_str(), target.c_str()) != 0) {
+      result = IOError(src, errno);
+    }
+    return result;
+  }
+
   virtual Status LockFile(const std::string& fname, FileLock** lock) {
     *lock = NULL;
     Status result;
@@ -657,6 +690,10 @@ class PosixEnv : public Env {
     usleep(micros);
   }
 
+  virtual RateLimiter* GetRateLimiter(IOType type) {
+    return (type >= 0 && type < kNumIOTypes) ? rate_limiters_[type] : NULL;
+  }
+
  private:
   void PthreadCall(const char* label, int result) {
     if (result != 0) {
@@ -683,12 +720,17 @@ class PosixEnv : public Env {
   typedef std::deque<BGItem> BGQueue;
   BGQueue queue_;
   port::AtomicPointer stop_;
+
+  RateLimiter* rate_limiters_[kNumIOTypes];
 };
 
 PosixEnv::PosixEnv() : page_size_(getpagesize()),
                        started_bgthread_(false), stop_(NULL){
   PthreadCall("mutex_init", pthread_mutex_init(&mu_, NULL));
   PthreadCall("cvar_init", pthread_cond_init(&bgsignal_, NULL));
+  for (int i = 0; i < kNumIOTypes; i++) {
+    rate_limiters_[i] = NewRateLimiter(this);
+  }
 }
 
 void PosixEnv::Schedule(void (*function)(void*), void* arg) {
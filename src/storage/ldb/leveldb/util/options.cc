@@ -17,6 +17,7 @@ Options::Options()
       env(Env::Default()),
       info_log(NULL),
       write_buffer_size(4<<20),
+      write_buffer_manager(NULL),
       max_mem_usage_for_memtable(1<<30),
       max_open_files(1000),
       block_cache(NULL),
@@ -24,10 +25,19 @@ Options::Options()
       table_cache_size((5UL)<<30),
       block_size(4096),
       block_restart_interval(16),
+      data_block_hash_index(false),
       compression(kSnappyCompression),
       filter_policy(NULL),
       reserve_log(false),
       load_backup_version(false),
+      concurrent_memtable_write(false),
+      pipelined_log_sync(false),
+      log_sync_delay_us(0),
+      blob_value_size(0),
+      blob_gc_ratio(0.5),
+      persist_file_time_meta(false),
+      recover_log_threads(1),
+      preload_table_threads(0),
       kL0_CompactionTrigger(4),
       kL0_SlowdownWritesTrigger(8),
       kL0_StopWritesTrigger(12),
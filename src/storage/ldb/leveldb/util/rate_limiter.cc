@@ -0,0 +1,201 @@
+// Copyright (c) 2026 agent <agent@local>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "leveldb/rate_limiter.h"
+
+#include "leveldb/env.h"
+#include "port/port.h"
+#include "util/mutexlock.h"
+
+namespace leveldb {
+
+RateLimiter::~RateLimiter() {
+}
+
+namespace {
+
+// Tokens are refilled continuously at current rate, at most one second's
+// worth can be saved for burst. Request() takes tokens first and waits for
+// the debt, so concurrent requesters are served in order.
+class TokenBucketRateLimiter : public RateLimiter {
+ public:
+  explicit TokenBucketRateLimiter(Env* env)
+      : env_(env),
+        bytes_per_sec_(0),
+        current_bytes_per_sec_(0),
+        min_bytes_per_sec_(0),
+        target_latency_us_(0),
+        available_(0),
+        last_refill_micros_(env->NowMicros()),
+        tune_start_micros_(last_refill_micros_),
+        latency_sum_(0),
+        latency_count_(0),
+        request_bytes_(0),
+        throttled_bytes_(0),
+        throttled_micros_(0) {
+  }
+
+  virtual ~TokenBucketRateLimiter() {
+  }
+
+  virtual void SetBytesPerSecond(int64_t bytes_per_sec) {
+    MutexLock l(&mu_);
+    bytes_per_sec_ = bytes_per_sec > 0 ? bytes_per_sec : 0;
+    current_bytes_per_sec_ = bytes_per_sec_;
+    if (available_ > current_bytes_per_sec_) {
+      available_ = current_bytes_per_sec_;
+    }
+    last_refill_micros_ = env_->NowMicros();
+  }
+
+  virtual int64_t GetBytesPerSecond() {
+    MutexLock l(&mu_);
+    return bytes_per_sec_;
+  }
+
+  virtual int64_t GetCurrentBytesPerSecond() {
+    MutexLock l(&mu_);
+    return current_bytes_per_sec_;
+  }
+
+  virtual void SetAutoTune(int64_t min_bytes_per_sec, int64_t target_latency_us) {
+    MutexLock l(&mu_);
+    min_bytes_per_sec_ = min_bytes_per_sec > 0 ? min_bytes_per_sec : 1;
+    target_latency_us_ = target_latency_us > 0 ? target_latency_us : 0;
+    if (target_latency_us_ <= 0) {
+      current_bytes_per_sec_ = bytes_per_sec_;
+    }
+  }
+
+  virtual bool IsAutoTune() {
+    return target_latency_us_ > 0 && bytes_per_sec_ > 0;
+  }
+
+  virtual void Request(int64_t bytes) {
+    if (bytes <= 0) {
+      return;
+    }
+    int64_t wait_micros = 0;
+    {
+      MutexLock l(&mu_);
+      request_bytes_ += bytes;
+      if (current_bytes_per_sec_ <= 0) {
+        return;
+      }
+      Refill(env_->NowMicros());
+      available_ -= bytes;
+      if (available_ < 0) {
+        wait_micros = static_cast<int64_t>(-available_ * 1000000 / current_bytes_per_sec_);
+        throttled_bytes_ += bytes;
+        throttled_micros_ += wait_micros;
+      }
+    }
+    if (wait_micros > 0) {
+      env_->SleepForMicroseconds(static_cast<int>(wait_micros));
+    }
+  }
+
+  virtual void ReportLatency(uint64_t micros) {
+    if (!IsAutoTune()) {
+      return;
+    }
+    __sync_fetch_and_add(&latency_sum_, micros);
+    __sync_fetch_and_add(&latency_count_, 1);
+    const uint64_t now = env_->NowMicros();
+    if (now >= tune_start_micros_ + kTuneIntervalMicros) {
+      MutexLock l(&mu_);
+      MaybeTune(now);
+    }
+  }
+
+  virtual uint64_t RequestBytes() {
+    MutexLock l(&mu_);
+    return request_bytes_;
+  }
+
+  virtual uint64_t ThrottledBytes() {
+    MutexLock l(&mu_);
+    return throttled_bytes_;
+  }
+
+  virtual uint64_t ThrottledMicros() {
+    MutexLock l(&mu_);
+    return throttled_micros_;
+  }
+
+  virtual void ResetStat() {
+    MutexLock l(&mu_);
+    request_bytes_ = throttled_bytes_ = throttled_micros_ = 0;
+  }
+
+ private:
+  static const uint64_t kTuneIntervalMicros = 1000000; // 1s
+  // too few reads to tell latency, consider foreground as idle
+  static const uint64_t kMinTuneSamples = 16;
+
+  // REQUIRES: mu_ is held
+  void Refill(uint64_t now) {
+    if (now > last_refill_micros_) {
+      available_ += static_cast<double>(now - last_refill_micros_) * current_bytes_per_sec_ / 1000000;
+      if (available_ > current_bytes_per_sec_) {
+        available_ = current_bytes_per_sec_;
+      }
+      last_refill_micros_ = now;
+    }
+  }
+
+  // Multiplicative decrease when foreground reads are slow,
+  // increase back to configured rate when they are fast or idle.
+  // REQUIRES: mu_ is held
+  void MaybeTune(uint64_t now) {
+    if (now < tune_start_micros_ + kTuneIntervalMicros) {
+      return;                   // tuned by others
+    }
+    const uint64_t count = latency_count_;
+    const uint64_t sum = latency_sum_;
+    __sync_fetch_and_sub(&latency_count_, count);
+    __sync_fetch_and_sub(&latency_sum_, sum);
+    tune_start_micros_ = now;
+    if (!IsAutoTune()) {
+      return;
+    }
+
+    Refill(now);
+    const uint64_t avg = count > 0 ? sum / count : 0;
+    if (count >= kMinTuneSamples && avg > static_cast<uint64_t>(target_latency_us_)) {
+      current_bytes_per_sec_ = current_bytes_per_sec_ / 4 * 3;
+      if (current_bytes_per_sec_ < min_bytes_per_sec_) {
+        current_bytes_per_sec_ = min_bytes_per_sec_;
+      }
+    } else if (count < kMinTuneSamples || avg < static_cast<uint64_t>(target_latency_us_ / 2)) {
+      current_bytes_per_sec_ = current_bytes_per_sec_ / 4 * 5 + 1;
+    }
+    if (current_bytes_per_sec_ > bytes_per_sec_) {
+      current_bytes_per_sec_ = bytes_per_sec_;
+    }
+  }
+
+  Env* const env_;
+  port::Mutex mu_;
+  int64_t bytes_per_sec_;           // configured rate
+  int64_t current_bytes_per_sec_;   // rate applied
+  int64_t min_bytes_per_sec_;
+  int64_t target_latency_us_;
+  double available_;                // tokens, negative means debt
+  uint64_t last_refill_micros_;
+  volatile uint64_t tune_start_micros_;
+  volatile uint64_t latency_sum_;
+  volatile uint64_t latency_count_;
+  uint64_t request_bytes_;
+  uint64_t throttled_bytes_;
+  uint64_t throttled_micros_;
+};
+
+}  // namespace
+
+RateLimiter* NewRateLimiter(Env* env) {
+  return new TokenBucketRateLimiter(env);
+}
+
+}  // namespace leveldb
@@ -0,0 +1,25 @@
+// Copyright (c) 2026 agent <agent@local>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "leveldb/write_buffer_manager.h"
+
+namespace leveldb {
+
+WriteBufferManager::WriteBufferManager(size_t buffer_size)
+    : buffer_size_(buffer_size),
+      memory_used_(0) {
+}
+
+WriteBufferManager::~WriteBufferManager() {
+}
+
+void WriteBufferManager::ReserveMem(size_t mem) {
+  __sync_fetch_and_add(&memory_used_, mem);
+}
+
+void WriteBufferManager::FreeMem(size_t mem) {
+  __sync_fetch_and_sub(&memory_used_, mem);
+}
+
+}  // namespace leveldb
@@ -14,6 +14,8 @@ namespace tair {
       {
         fd = -1;
         stat_info = NULL;
+        atomic_set(&read_count, 0);
+        atomic_set(&write_count, 0);
       }
 
       stat_manager::~stat_manager()
@@ -116,6 +118,15 @@ namespace tair {
         return stat_info->stat;
       }
 
+      uint64_t stat_manager::get_data_size() const
+      {
+        uint64_t size = 0;
+        for (int i = 0; i < TAIR_MAX_AREA_COUNT; ++i) {
+          size += stat_info->stat[i].data_size();
+        }
+        return size;
+      }
+
       int stat_manager::get_size()
       {
         int size = -1;
@@ -47,6 +47,14 @@ namespace tair {
         void stat_reset(int area);
 
         tair_pstat * get_stat() const;
+        // sum of data size of all areas
+        uint64_t get_data_size() const;
+
+        // read/write count, only in memory, to estimate bucket load
+        void inc_read_count() { atomic_inc(&read_count); }
+        void add_write_count(int count) { atomic_add(count, &write_count); }
+        uint32_t get_read_count() { return atomic_read(&read_count); }
+        uint32_t get_write_count() { return atomic_read(&write_count); }
 
         bool sync(void);
 
@@ -60,6 +68,8 @@ namespace tair {
         char file_name[TAIR_MAX_PATH_LEN];
         tbsys::CThreadMutex stat_lock;
         db_stat_info * stat_info;
+        atomic_t read_count;
+        atomic_t write_count;
       };
     }
   }
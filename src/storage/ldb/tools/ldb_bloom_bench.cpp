@@ -0,0 +1,187 @@
+/*
+ * (C) 2007-2010 Alibaba Group Holding Limited
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ *  Tool: memory, false positive rate and lookup speed of ldb filter policies
+ *        (classic bloom and cache-line blocked bloom). keys are in ldb format,
+ *        and are split into filters of -c keys each like filter block of sstable.
+ *
+ * Version: $Id$
+ *
+ * Authors:
+ *   agent <agent@local>
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "leveldb/env.h"
+#include "leveldb/filter_policy.h"
+#include "leveldb/slice.h"
+
+#include "ldb_define.hpp"
+
+using tair::storage::ldb::LdbKey;
+using tair::storage::ldb::LDB_KEY_AREA_SIZE;
+
+namespace tair
+{
+  namespace storage
+  {
+    namespace ldb
+    {
+      extern leveldb::FilterPolicy* NewLdbFilterPolicy(const char* type, int bits_per_key,
+                                                       const char* level_bits_per_key);
+    }
+  }
+}
+
+struct bench_result
+{
+  size_t bytes;                 // total filter size
+  double fpr;                   // false positive rate of absent keys
+  double hit_latency;           // average ns per lookup of present key
+  double miss_latency;          // average ns per lookup of absent key
+};
+
+void print_help(const char* name)
+{
+  fprintf(stderr, "%s: memory, false positive rate and lookup speed of ldb filter policies\n"
+          "\t[-n keys] [-c keys_per_filter] [-b bits_per_key] [-g gets]\n", name);
+}
+
+// binary keys, cheap to build, so lookup cost is mostly filter probing
+static leveldb::Slice make_key(char* buf, int i)
+{
+  uint64_t k = static_cast<uint64_t>(i) * 2654435761U;
+  LdbKey::build_key_meta(buf, static_cast<int32_t>(k % 1023));
+  LdbKey::encode_area(buf + LdbKey::meta_size(), 0);
+  const int prefix_size = LdbKey::meta_size() + LDB_KEY_AREA_SIZE;
+  memcpy(buf + prefix_size, &k, sizeof(k));
+  return leveldb::Slice(buf, prefix_size + sizeof(k));
+}
+
+// lookup key 2*i+odd for random i, return average ns per lookup,
+// *matched is count of matched lookups
+static double lookup(const leveldb::FilterPolicy* policy, const std::vector<std::string>& filters,
+                     int keys, int keys_per_filter, int odd, int gets, int* matched)
+{
+  leveldb::Env* env = leveldb::Env::Default();
+  char key[32];
+  uint64_t start = env->NowMicros();
+  *matched = 0;
+  uint32_t seed = 301;
+  for (int i = 0; i < gets; ++i)
+  {
+    seed = seed * 1103515245 + 12345;
+    int k = (seed >> 4) % keys;
+    if (policy->KeyMayMatch(make_key(key, 2 * k + odd), filters[k / keys_per_filter]))
+    {
+      ++*matched;
+    }
+  }
+  uint64_t cost = env->NowMicros() - start;
+  return gets > 0 ? static_cast<double>(cost) * 1000 / gets : 0;
+}
+
+// return false if failed
+bool run(const char* type, int keys, int keys_per_filter, int bits_per_key, int gets, bench_result& result)
+{
+  leveldb::FilterPolicy* policy = tair::storage::ldb::NewLdbFilterPolicy(type, bits_per_key, "");
+  if (policy == NULL)
+  {
+    fprintf(stderr, "no filter policy %s\n", type);
+    return false;
+  }
+
+  // present keys are even, absent keys are odd
+  std::vector<std::string> filters;
+  std::vector<char> key_buf(std::min(keys, keys_per_filter) * 32);
+  std::vector<leveldb::Slice> slices;
+  result.bytes = 0;
+  for (int i = 0; i < keys; i += keys_per_filter)
+  {
+    slices.clear();
+    for (int j = i; j < keys && j < i + keys_per_filter; ++j)
+    {
+      slices.push_back(make_key(&key_buf[(j - i) * 32], 2 * j));
+    }
+    filters.push_back(std::string());
+    policy->CreateFilter(&slices[0], slices.size(), &filters.back());
+    result.bytes += filters.back().size();
+  }
+
+  int matched = 0;
+  result.hit_latency = lookup(policy, filters, keys, keys_per_filter, 0, gets, &matched);
+  if (matched != gets)
+  {
+    fprintf(stderr, "%s: false negative %d\n", type, gets - matched);
+    delete policy;
+    return false;
+  }
+  result.miss_latency = lookup(policy, filters, keys, keys_per_filter, 1, gets, &matched);
+  result.fpr = gets > 0 ? static_cast<double>(matched) / gets : 0;
+
+  delete policy;
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  int i = 0;
+  int keys = 10000000;
+  int keys_per_filter = 100;
+  int bits_per_key = 10;
+  int gets = 10000000;
+  while ((i = getopt(argc, argv, "n:c:b:g:")) != EOF)
+  {
+    switch (i)
+    {
+    case 'n':
+      keys = atoi(optarg);
+      break;
+    case 'c':
+      keys_per_filter = atoi(optarg);
+      break;
+    case 'b':
+      bits_per_key = atoi(optarg);
+      break;
+    case 'g':
+      gets = atoi(optarg);
+      break;
+    default:
+      print_help(argv[0]);
+      return 1;
+    }
+  }
+
+  if (keys <= 0 || keys_per_filter <= 0 || bits_per_key <= 0 || gets < 0)
+  {
+    print_help(argv[0]);
+    return 1;
+  }
+
+  const char* types[] = { "bloom", "blocked_bloom" };
+  fprintf(stderr, "%14s %12s %10s %10s %10s %10s\n", "", "bytes", "bits/key", "fpr%", "hit ns", "miss ns");
+  for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); ++t)
+  {
+    bench_result result;
+    if (!run(types[t], keys, keys_per_filter, bits_per_key, gets, result))
+    {
+      return 1;
+    }
+    fprintf(stderr, "%14s %12lu %10.2f %10.3f %10.1f %10.1f\n", types[t], result.bytes,
+            static_cast<double>(result.bytes) * 8 / keys, result.fpr * 100,
+            result.hit_latency, result.miss_latency);
+  }
+  return 0;
+}
@@ -0,0 +1,315 @@
+/*
+ * (C) 2007-2010 Alibaba Group Holding Limited
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ *  Tool: ship ldb checkpoint (made by tairclient `checkpoint_db) to a new
+ *        data dir, and catch it up from write-ahead logs of source db.
+ *        rebuild one instance of a replica:
+ *          1. checkpoint_db dir ds_addr
+ *          2. ldb_checkpoint -m ship -c dir/ldbN/ldb -d new_data_dir/ldbN/ldb
+ *             (dest may be a mounted dir of new server), copy
+ *             dir/ldb_bucket_index_map to bucket index dir if it is used.
+ *          3. ldb_checkpoint -m catchup -s data_dir/ldbN/ldb -d new_data_dir/ldbN/ldb
+ *             right before starting new server, which can be run again.
+ *        catchup fails if the source log the checkpoint ends in is deleted
+ *        after memtable dump, then a new checkpoint is needed.
+ *
+ * Version: $Id$
+ *
+ * Authors:
+ *   agent <agent@local>
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "leveldb/env.h"
+#include "db/filename.h"
+#include "db/log_reader.h"
+
+static const char* LOG_DIR = "/logs/";
+
+void print_help(const char* name)
+{
+  fprintf(stderr, "%s: ship ldb checkpoint and catch it up from logs of source db.\n"
+          "\t-m ship -c checkpoint_db_dir -d dest_db_dir\n"
+          "\t\tcopy checkpoint to dest, files copied already are skipped\n"
+          "\t-m catchup -s source_db_dir -d dest_db_dir\n"
+          "\t\tcopy logs written after checkpoint from source db to dest\n", name);
+}
+
+// copy first "size" bytes of src to dst through a temporary file,
+// so dst is either old one or complete.
+leveldb::Status copy_file(leveldb::Env* env, const std::string& src, const std::string& dst, uint64_t size)
+{
+  leveldb::SequentialFile* sfile = NULL;
+  leveldb::Status s = env->NewSequentialFile(src, &sfile);
+  if (!s.ok())
+  {
+    return s;
+  }
+  const std::string tmp = dst + ".tmp";
+  leveldb::WritableFile* wfile = NULL;
+  s = env->NewWritableFile(tmp, &wfile);
+  if (s.ok())
+  {
+    const size_t buf_size = 4 << 20;
+    char* buf = new char[buf_size];
+    leveldb::Slice data;
+    while (s.ok() && size > 0)
+    {
+      s = sfile->Read(std::min(size, static_cast<uint64_t>(buf_size)), &data, buf);
+      if (s.ok() && data.empty())
+      {
+        s = leveldb::Status::IOError(src, "file is shorter than expected");
+      }
+      if (s.ok())
+      {
+        s = wfile->Append(data);
+        size -= data.size();
+      }
+    }
+    delete[] buf;
+    if (s.ok())
+    {
+      s = wfile->Sync();
+    }
+    if (s.ok())
+    {
+      s = wfile->Close();
+    }
+    delete wfile;
+    if (s.ok())
+    {
+      s = env->RenameFile(tmp, dst);
+    }
+    if (!s.ok())
+    {
+      env->DeleteFile(tmp);
+    }
+  }
+  delete sfile;
+  return s;
+}
+
+// offset past the last complete record of log file, the newest log may
+// have a record being written at the end.
+leveldb::Status complete_log_size(leveldb::Env* env, const std::string& fname, uint64_t* size)
+{
+  leveldb::SequentialFile* file = NULL;
+  leveldb::Status s = env->NewSequentialFile(fname, &file);
+  if (!s.ok())
+  {
+    return s;
+  }
+  leveldb::log::Reader reader(file, NULL, true, 0);
+  leveldb::Slice record;
+  std::string scratch;
+  *size = 0;
+  while (reader.ReadRecord(&record, &scratch))
+  {
+    *size = reader.EndOfLastRecordOffset();
+  }
+  delete file;
+  return s;
+}
+
+// ascending numbers of log files in db
+void get_logs(leveldb::Env* env, const std::string& db_dir, std::vector<uint64_t>& logs)
+{
+  std::vector<std::string> filenames;
+  env->GetChildren(db_dir + LOG_DIR, &filenames);
+  uint64_t number;
+  leveldb::FileType type;
+  for (size_t i = 0; i < filenames.size(); ++i)
+  {
+    if (leveldb::ParseFileName(filenames[i], &number, &type) && type == leveldb::kLogFile)
+    {
+      logs.push_back(number);
+    }
+  }
+  std::sort(logs.begin(), logs.end());
+}
+
+// copy one file unless dst has the same size
+leveldb::Status ship_file(leveldb::Env* env, const std::string& src, const std::string& dst,
+                          int64_t& files, uint64_t& bytes)
+{
+  uint64_t size = 0, dst_size = 0;
+  leveldb::Status s = env->GetFileSize(src, &size);
+  if (s.ok() && !(env->GetFileSize(dst, &dst_size).ok() && dst_size == size))
+  {
+    s = copy_file(env, src, dst, size);
+    if (s.ok())
+    {
+      ++files;
+      bytes += size;
+    }
+  }
+  return s;
+}
+
+int do_ship(const std::string& checkpoint_dir, const std::string& dest_dir)
+{
+  leveldb::Env* env = leveldb::Env::Default();
+  if (!env->FileExists(leveldb::CurrentFileName(checkpoint_dir)))
+  {
+    fprintf(stderr, "%s is not a checkpoint\n", checkpoint_dir.c_str());
+    return 1;
+  }
+  env->CreateDir(dest_dir);
+  env->CreateDir(dest_dir + LOG_DIR);
+
+  int64_t start = env->NowMicros();
+  int64_t files = 0;
+  uint64_t bytes = 0;
+  leveldb::Status s;
+  std::vector<std::string> filenames;
+  env->GetChildren(checkpoint_dir, &filenames);
+  uint64_t number;
+  leveldb::FileType type;
+  for (size_t i = 0; s.ok() && i < filenames.size(); ++i)
+  {
+    // CURRENT goes last, dest is openable only when all is there.
+    if (leveldb::ParseFileName(filenames[i], &number, &type) && type != leveldb::kCurrentFile)
+    {
+      s = ship_file(env, checkpoint_dir + "/" + filenames[i], dest_dir + "/" + filenames[i], files, bytes);
+    }
+  }
+
+  std::vector<uint64_t> logs;
+  get_logs(env, checkpoint_dir, logs);
+  for (size_t i = 0; s.ok() && i < logs.size(); ++i)
+  {
+    s = ship_file(env, leveldb::LogFileName(checkpoint_dir + LOG_DIR, logs[i]),
+                  leveldb::LogFileName(dest_dir + LOG_DIR, logs[i]), files, bytes);
+  }
+
+  if (s.ok())
+  {
+    s = ship_file(env, leveldb::CurrentFileName(checkpoint_dir), leveldb::CurrentFileName(dest_dir), files, bytes);
+  }
+
+  int64_t cost = env->NowMicros() - start;
+  fprintf(stderr, "ship %s to %s %s. files: %ld, bytes: %lu, cost: %ld us, %.2f MB/s\n",
+          checkpoint_dir.c_str(), dest_dir.c_str(), s.ok() ? "success" : s.ToString().c_str(),
+          files, bytes, cost, cost > 0 ? static_cast<double>(bytes) / cost : 0);
+  return s.ok() ? 0 : 1;
+}
+
+// Only the newest log of db grows, so logs of dest older than its newest
+// one are complete. The newest log of dest and all newer logs of source are
+// copied as is (up to the last complete record), which appends writes made
+// after checkpoint. Recovery replays them when dest db is opened.
+int do_catchup(const std::string& source_dir, const std::string& dest_dir)
+{
+  leveldb::Env* env = leveldb::Env::Default();
+  if (!env->FileExists(leveldb::CurrentFileName(dest_dir)))
+  {
+    fprintf(stderr, "%s is not a shipped checkpoint\n", dest_dir.c_str());
+    return 1;
+  }
+
+  std::vector<uint64_t> dest_logs, source_logs;
+  get_logs(env, dest_dir, dest_logs);
+  get_logs(env, source_dir, source_logs);
+  if (dest_logs.empty())
+  {
+    fprintf(stderr, "no log in %s\n", dest_dir.c_str());
+    return 1;
+  }
+  const uint64_t last_log = dest_logs.back();
+  std::vector<uint64_t>::iterator it = std::lower_bound(source_logs.begin(), source_logs.end(), last_log);
+  if (it == source_logs.end() || *it != last_log)
+  {
+    fprintf(stderr, "log %lu is gone from %s, writes after checkpoint are lost, make a new checkpoint\n",
+            last_log, source_dir.c_str());
+    return 1;
+  }
+
+  int64_t start = env->NowMicros();
+  uint64_t bytes = 0;
+  int64_t logs = 0;
+  leveldb::Status s;
+  for (; s.ok() && it != source_logs.end(); ++it)
+  {
+    const std::string src = leveldb::LogFileName(source_dir + LOG_DIR, *it);
+    const std::string dst = leveldb::LogFileName(dest_dir + LOG_DIR, *it);
+    uint64_t size = 0, dst_size = 0;
+    s = complete_log_size(env, src, &size);
+    if (s.ok() && env->GetFileSize(dst, &dst_size).ok() && dst_size > size)
+    {
+      s = leveldb::Status::Corruption(src, "shorter than log of dest");
+    }
+    if (s.ok() && size != dst_size)
+    {
+      s = copy_file(env, src, dst, size);
+      bytes += size - dst_size;
+      ++logs;
+    }
+  }
+
+  int64_t cost = env->NowMicros() - start;
+  fprintf(stderr, "catch up %s from %s %s. logs: %ld, new bytes: %lu, cost: %ld us\n",
+          dest_dir.c_str(), source_dir.c_str(), s.ok() ? "success" : s.ToString().c_str(),
+          logs, bytes, cost);
+  return s.ok() ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+  int i = 0;
+  const char* mode = NULL;
+  const char* checkpoint_dir = NULL;
+  const char* source_dir = NULL;
+  const char* dest_dir = NULL;
+  while ((i = getopt(argc, argv, "m:c:s:d:")) != EOF)
+  {
+    switch (i)
+    {
+    case 'm':
+      mode = optarg;
+      break;
+    case 'c':
+      checkpoint_dir = optarg;
+      break;
+    case 's':
+      source_dir = optarg;
+      break;
+    case 'd':
+      dest_dir = optarg;
+      break;
+    default:
+      print_help(argv[0]);
+      return 1;
+    }
+  }
+
+  int ret = 1;
+  if (mode == NULL || dest_dir == NULL)
+  {
+    print_help(argv[0]);
+  }
+  else if (strcmp(mode, "ship") == 0 && checkpoint_dir != NULL)
+  {
+    ret = do_ship(checkpoint_dir, dest_dir);
+  }
+  else if (strcmp(mode, "catchup") == 0 && source_dir != NULL)
+  {
+    ret = do_catchup(source_dir, dest_dir);
+  }
+  else
+  {
+    print_help(argv[0]);
+  }
+  return ret;
+}
@@ -55,7 +55,7 @@ void print_help(const char* name)
   fprintf(stderr, "dump ldb data to file\n"
           "%s -p db_path -f manifestfile -c comparator_desc -d dump_file [-s one_dump_file_max_size(default 1G)]"
           " -b buckets [-A no_areas] [-a yes_area]\n"
-          "\tcomparator_desc like: bitcmp OR numeric,:,2\n"
+          "\tcomparator_desc like: bitcmp OR numeric,:,2 (bitcmp_v2 OR numeric_v2,:,2 for key format 2)\n"
           "\tbuckets/areas like: 1,2\n"
           "\tdump file format: %s",
           name, file_format);
@@ -111,8 +111,10 @@ int do_dump(const char* db_path, const char* manifest, const char* cmp_desc,
   leveldb::ReadOptions scan_options;
   scan_options.verify_checksums = false;
   scan_options.fill_cache = false;
+  scan_options.readahead_size = 1 << 20; // 1M
+  scan_options.prefetch_table = true;
   leveldb::Iterator* db_it = db->NewIterator(scan_options);
-  char scan_key[LDB_KEY_META_SIZE];
+  char scan_key[LDB_KEY_META_MAX_SIZE];
 
   int32_t bucket = 0;
   int32_t area = 0;
@@ -140,7 +142,7 @@ int do_dump(const char* db_path, const char* manifest, const char* cmp_desc,
     // seek to bucket
     LdbKey::build_key_meta(scan_key, bucket);
 
-    for (db_it->Seek(leveldb::Slice(scan_key, sizeof(scan_key))); !g_stop && db_it->Valid() && ret == 0; db_it->Next())
+    for (db_it->Seek(leveldb::Slice(scan_key, LdbKey::meta_size())); !g_stop && db_it->Valid() && ret == 0; db_it->Next())
     {
       skip_in_bucket = false;
       skip_in_area = false;
@@ -0,0 +1,333 @@
+/*
+ * (C) 2007-2010 Alibaba Group Holding Limited
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ *  Tool: get throughput and latency of ldb with data block hash index off and on.
+ *        keys are in ldb format (-k key format) and compared by ldb comparator,
+ *        data is all in sstables and block cache, so lookup in block dominates.
+ *        sstable bytes are reported too, to compare key formats.
+ *        with -f, block size, block cache, bloom filter, restart interval,
+ *        compression and key format are read from dataserver config as ldb instance does,
+ *        then data may not fit in block cache.
+ *
+ * Version: $Id$
+ *
+ * Authors:
+ *   agent <agent@local>
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include "leveldb/cache.h"
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/filter_policy.h"
+#include "leveldb/options.h"
+
+#include "common/define.hpp"
+#include "ldb_define.hpp"
+#include "ldb_comparator.hpp"
+
+using tair::storage::ldb::LdbKey;
+using tair::storage::ldb::LdbItemMetaBase;
+using tair::storage::ldb::LDB_ITEM_META_BASE_SIZE;
+using tair::storage::ldb::LDB_KEY_AREA_SIZE;
+using tair::storage::ldb::LDB_KEY_FORMAT_V1;
+using tair::storage::ldb::LDB_KEY_FORMAT_V2;
+
+namespace tair
+{
+  namespace storage
+  {
+    namespace ldb
+    {
+      extern leveldb::FilterPolicy* NewLdbFilterPolicy(const char* type, int bits_per_key,
+                                                       const char* level_bits_per_key);
+    }
+  }
+}
+
+struct bench_result
+{
+  double ops;                   // ops/s
+  double latency;               // average us per get
+  int found;
+  uint64_t table_bytes;         // size of all sstables
+};
+
+void print_help(const char* name)
+{
+  fprintf(stderr, "%s: get throughput with data block hash index off and on\n"
+          "\t-d db_path [-f config_file] [-n keys] [-g gets] [-v value_size] [-r block_restart_interval]"
+          " [-k key_format] [-t runs]\n", name);
+}
+
+// read path options of [ldb] in config, the same as LdbInstance::sanitize_option()
+void load_options(leveldb::Options& options, int& key_format)
+{
+  if (TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_USE_BLOOMFILTER, 0) > 0)
+  {
+    options.filter_policy = tair::storage::ldb::NewLdbFilterPolicy(
+      TBSYS_CONFIG.getString(TAIRLDB_SECTION, LDB_FILTER_POLICY, "bloom"),
+      TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_BLOOMFILTER_BITS_PER_KEY, 10),
+      TBSYS_CONFIG.getString(TAIRLDB_SECTION, LDB_BLOOMFILTER_LEVEL_BITS_PER_KEY, ""));
+  }
+  options.block_size = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_BLOCK_SIZE, 4<<10);
+  options.block_cache_size = atoll(TBSYS_CONFIG.getString(TAIRLDB_SECTION, LDB_BLOCK_CACHE_SIZE, "8388608"));
+  options.block_cache = leveldb::NewLRUCache(options.block_cache_size,
+                                             TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_BLOCK_CACHE_SHARD_BITS, 4));
+  options.block_restart_interval = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_BLOCK_RESTART_INTERVAL, 16);
+  options.compression = static_cast<leveldb::CompressionType>(
+    TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_COMPRESSION, leveldb::kSnappyCompression));
+  key_format = TBSYS_CONFIG.getInt(TAIRLDB_SECTION, LDB_KEY_FORMAT, LDB_KEY_FORMAT_V1);
+}
+
+// some keys expire, like real data
+static uint32_t expired_time(int i)
+{
+  uint64_t k = static_cast<uint64_t>(i) * 2654435761U;
+  return (k & 3) == 0 ? 0 : 2000000000 + (k & 0xffff);
+}
+
+static leveldb::Slice make_key(char* buf, size_t size, int i)
+{
+  // spread keys over whole key space
+  uint64_t k = static_cast<uint64_t>(i) * 2654435761U;
+  LdbKey::build_key_meta(buf, static_cast<int32_t>(k % 1023), expired_time(i));
+  LdbKey::encode_area(buf + LdbKey::meta_size(), 0);
+  const int prefix_size = LdbKey::meta_size() + LDB_KEY_AREA_SIZE;
+  int n = snprintf(buf + prefix_size, size - prefix_size, "key_%016lx", k);
+  return leveldb::Slice(buf, prefix_size + n);
+}
+
+// return false if failed
+bool run(const char* path, const leveldb::Options& db_options,
+         int keys, int gets, int value_size, bench_result& result)
+{
+  leveldb::Options options = db_options;
+  options.create_if_missing = true;
+  leveldb::DestroyDB(path, options);
+
+  leveldb::DB* db = NULL;
+  leveldb::Status s = leveldb::DB::Open(options, path, &db);
+  if (!s.ok())
+  {
+    fprintf(stderr, "open db %s fail: %s\n", path, s.ToString().c_str());
+    return false;
+  }
+
+  // item meta, then data half compressible, so compression in config does not squeeze data into block cache.
+  // key format 2 reads expired time from meta
+  std::string value(LDB_ITEM_META_BASE_SIZE + value_size, 'v');
+  LdbItemMetaBase* meta = reinterpret_cast<LdbItemMetaBase*>(&value[0]);
+  *meta = LdbItemMetaBase();
+  char key[64];
+  uint32_t value_seed = 17;
+  for (int i = 0; i < keys && s.ok(); ++i)
+  {
+    meta->edate_ = expired_time(i);
+    for (int j = 0; j < value_size / 2; ++j)
+    {
+      value_seed = value_seed * 1103515245 + 12345;
+      value[LDB_ITEM_META_BASE_SIZE + j] = static_cast<char>(value_seed >> 16);
+    }
+    s = db->Put(leveldb::WriteOptions(), make_key(key, sizeof(key), i), value);
+  }
+  // reopen to dump memtable, then all data are in sstables
+  delete db;
+  db = NULL;
+  if (s.ok())
+  {
+    s = leveldb::DB::Open(options, path, &db);
+  }
+  if (!s.ok())
+  {
+    fprintf(stderr, "load data fail: %s\n", s.ToString().c_str());
+    delete db;
+    return false;
+  }
+
+  std::vector<std::string> children;
+  leveldb::Env* env = leveldb::Env::Default();
+  env->GetChildren(path, &children);
+  result.table_bytes = 0;
+  for (size_t i = 0; i < children.size(); ++i)
+  {
+    uint64_t size = 0;
+    if (children[i].size() > 4 && children[i].compare(children[i].size() - 4, 4, ".sst") == 0 &&
+        env->GetFileSize(std::string(path) + "/" + children[i], &size).ok())
+    {
+      result.table_bytes += size;
+    }
+  }
+
+  leveldb::ReadOptions read_options;
+  std::string get_value;
+  // warm up block cache (and page cache if block cache is small)
+  for (int i = 0; i < keys; ++i)
+  {
+    db->Get(read_options, make_key(key, sizeof(key), i), &get_value);
+  }
+
+  uint64_t start = env->NowMicros();
+  result.found = 0;
+  uint32_t seed = 301;
+  for (int i = 0; i < gets; ++i)
+  {
+    seed = seed * 1103515245 + 12345;
+    // 1/8 gets miss
+    int k = static_cast<int>((seed >> 8) % (keys + keys / 8));
+    if (db->Get(read_options, make_key(key, sizeof(key), k), &get_value).ok())
+    {
+      ++result.found;
+    }
+  }
+  uint64_t cost = env->NowMicros() - start;
+  result.ops = cost > 0 ? static_cast<double>(gets) * 1000000 / cost : 0;
+  result.latency = gets > 0 ? static_cast<double>(cost) / gets : 0;
+
+  delete db;
+  leveldb::DestroyDB(path, options);
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  int i = 0;
+  char* path = NULL;
+  char* config_file = NULL;
+  int keys = 500000;
+  int gets = 1000000;
+  int value_size = 100;
+  int restart_interval = 0;     // 0: from config or 16
+  int key_format = 0;           // 0: from config or LDB_KEY_FORMAT_V1
+  int runs = 1;
+  while ((i = getopt(argc, argv, "d:f:n:g:v:r:k:t:")) != EOF)
+  {
+    switch (i)
+    {
+    case 'd':
+      path = optarg;
+      break;
+    case 'f':
+      config_file = optarg;
+      break;
+    case 'n':
+      keys = atoi(optarg);
+      break;
+    case 'g':
+      gets = atoi(optarg);
+      break;
+    case 'v':
+      value_size = atoi(optarg);
+      break;
+    case 'r':
+      restart_interval = atoi(optarg);
+      break;
+    case 'k':
+      key_format = atoi(optarg);
+      break;
+    case 't':
+      runs = atoi(optarg);
+      break;
+    default:
+      print_help(argv[0]);
+      return 1;
+    }
+  }
+
+  if (path == NULL || keys <= 0 || gets < 0 || value_size < 0 || restart_interval < 0 || runs <= 0)
+  {
+    print_help(argv[0]);
+    return 1;
+  }
+
+  leveldb::Options options;
+  int config_key_format = LDB_KEY_FORMAT_V1;
+  if (config_file != NULL)
+  {
+    if (TBSYS_CONFIG.load(config_file))
+    {
+      fprintf(stderr, "load config %s fail\n", config_file);
+      return 1;
+    }
+    load_options(options, config_key_format);
+  }
+  else
+  {
+    // all data in block cache
+    options.block_cache_size = 1 << 30;
+    options.block_cache = leveldb::NewLRUCache(options.block_cache_size);
+  }
+  if (key_format == 0)
+  {
+    key_format = config_key_format;
+  }
+  if (restart_interval > 0)
+  {
+    options.block_restart_interval = restart_interval;
+  }
+  if (key_format != LDB_KEY_FORMAT_V1 && key_format != LDB_KEY_FORMAT_V2)
+  {
+    print_help(argv[0]);
+    delete options.block_cache;
+    delete options.filter_policy;
+    return 1;
+  }
+
+  // before comparator is created
+  LdbKey::set_format(key_format);
+
+  tair::storage::ldb::BitcmpLdbComparatorImpl comparator;
+  options.comparator = &comparator;
+  options.write_buffer_size = 1 << 30;  // one sstable at reopen
+  fprintf(stderr, "key format %d, block size %lu, block cache %" PRI64_PREFIX "d, restart interval %d, bloom %s, compression %d\n",
+          key_format, options.block_size, options.block_cache_size, options.block_restart_interval,
+          options.filter_policy != NULL ? options.filter_policy->Name() : "none", options.compression);
+  fprintf(stderr, "%4s %12s %14s %10s %10s %14s\n", "run", "", "ops/s", "us", "found", "sst bytes");
+
+  // off and on in turn, so both see the same state of box
+  bench_result total[2];
+  memset(total, 0, sizeof(total));
+  bool ok = true;
+  for (int r = 0; r < runs && ok; ++r)
+  {
+    for (int h = 0; h < 2 && ok; ++h)
+    {
+      bench_result result;
+      options.data_block_hash_index = h == 1;
+      ok = run(path, options, keys, gets, value_size, result);
+      if (ok)
+      {
+        fprintf(stderr, "%4d %12s %14.0f %10.2f %10d %14lu\n", r, h == 1 ? "hash index" : "binary",
+                result.ops, result.latency, result.found, result.table_bytes);
+        total[h].ops += result.ops;
+        total[h].latency += result.latency;
+        total[h].found = result.found;
+        total[h].table_bytes = result.table_bytes;
+      }
+    }
+  }
+  delete options.block_cache;
+  delete options.filter_policy;
+  if (!ok)
+  {
+    return 1;
+  }
+
+  for (int h = 0; h < 2; ++h)
+  {
+    fprintf(stderr, "%4s %12s %14.0f %10.2f %10d %14lu\n", "avg", h == 1 ? "hash index" : "binary",
+            total[h].ops / runs, total[h].latency / runs, total[h].found, total[h].table_bytes);
+  }
+  return 0;
+}
@@ -0,0 +1,228 @@
+/*
+ * (C) 2007-2010 Alibaba Group Holding Limited
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ *  Tool: rewrite a stopped ldb instance from key format 1 to key format 2
+ *        (expired time is dropped from key, it is kept in value meta).
+ *        keys are in the same order in both formats, so data is streamed to
+ *        a new db in order. after it, replace the old db dir with the new one
+ *        and start server with ldb_key_format=2.
+ *
+ * Version: $Id$
+ *
+ * Authors:
+ *   agent <agent@local>
+ *
+ */
+
+#include <signal.h>
+
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/write_batch.h"
+
+#include "ldb_define.hpp"
+#include "ldb_comparator.hpp"
+#include "ldb_util.hpp"
+
+using namespace tair::storage::ldb;
+
+bool g_stop = false;
+
+void sign_handler(int sig)
+{
+  switch (sig)
+  {
+  case SIGTERM:
+  case SIGINT:
+    fprintf(stderr, "catch sig %d\n", sig);
+    g_stop = true;
+    break;
+  default:
+    break;
+  }
+}
+
+void print_help(const char* name)
+{
+  fprintf(stderr, "rewrite ldb data from key format 1 to key format 2\n"
+          "%s -p db_path -f manifestfile -c comparator_desc -d new_db_path [-b batch_size(default 4M)]\n"
+          "\tcomparator_desc of old db like: bitcmp OR numeric,:,2\n", name);
+}
+
+// comparator description of key format 2 for the one of format 1
+std::string v2_comparator_desc(const char* cmp_desc)
+{
+  std::string desc(cmp_desc);
+  if (desc == "bitcmp")
+  {
+    desc = "bitcmp_v2";
+  }
+  else if (desc.compare(0, strlen("numeric,"), "numeric,") == 0)
+  {
+    desc.insert(strlen("numeric"), "_v2");
+  }
+  else
+  {
+    desc.clear();
+  }
+  return desc;
+}
+
+int do_upgrade(const char* db_path, const char* manifest, const char* cmp_desc,
+               const char* new_db_path, int64_t batch_size)
+{
+  std::string new_cmp_desc = v2_comparator_desc(cmp_desc);
+  if (new_cmp_desc.empty())
+  {
+    fprintf(stderr, "db must be in key format 1, comparator: %s\n", cmp_desc);
+    return 1;
+  }
+
+  // old db, its comparator keeps format 1 even the tool switches to format 2 below
+  leveldb::Options open_options;
+  leveldb::DB* db = NULL;
+  leveldb::Status s = open_db_readonly(db_path, manifest, cmp_desc, open_options, db);
+  if (!s.ok())
+  {
+    fprintf(stderr, "open db fail: %s\n", s.ToString().c_str());
+    return 1;
+  }
+  const int32_t old_skip = LdbKey::expired_time_size();
+
+  // new db, LdbKey is in format 2 from now on
+  leveldb::Options new_options;
+  new_options.comparator = new_comparator(new_cmp_desc.c_str());
+  new_options.create_if_missing = true;
+  new_options.error_if_exists = true;
+  new_options.write_buffer_size = 64 << 20;
+  new_options.env = leveldb::Env::Instance();
+  leveldb::DB* new_db = NULL;
+  s = leveldb::DB::Open(new_options, new_db_path, &new_db);
+  if (!s.ok())
+  {
+    fprintf(stderr, "open new db %s fail: %s\n", new_db_path, s.ToString().c_str());
+    delete new_options.comparator;
+    delete new_options.env;
+    delete db;
+    return 1;
+  }
+
+  leveldb::ReadOptions scan_options;
+  scan_options.verify_checksums = false;
+  scan_options.fill_cache = false;
+  scan_options.readahead_size = 1 << 20; // 1M
+  scan_options.prefetch_table = true;
+  leveldb::WriteOptions write_options;
+  write_options.sync = false;
+
+  leveldb::Iterator* db_it = db->NewIterator(scan_options);
+  leveldb::WriteBatch batch;
+  int64_t batch_bytes = 0;
+  int64_t count = 0, old_bytes = 0, new_bytes = 0;
+  int64_t start = new_options.env->NowMicros();
+
+  for (db_it->SeekToFirst(); s.ok() && !g_stop && db_it->Valid(); db_it->Next())
+  {
+    leveldb::Slice key = db_it->key();
+    if (key.size() <= static_cast<size_t>(old_skip))
+    {
+      fprintf(stderr, "skip bad key of size %lu\n", key.size());
+      continue;
+    }
+    // expired time is in value meta already, drop it from key
+    leveldb::Slice new_key(key.data() + old_skip, key.size() - old_skip);
+    batch.Put(new_key, db_it->value());
+    batch_bytes += new_key.size() + db_it->value().size();
+    ++count;
+    old_bytes += key.size() + db_it->value().size();
+    new_bytes += new_key.size() + db_it->value().size();
+
+    if (batch_bytes >= batch_size)
+    {
+      s = new_db->Write(write_options, &batch);
+      batch.Clear();
+      batch_bytes = 0;
+    }
+  }
+
+  if (s.ok() && batch_bytes > 0)
+  {
+    s = new_db->Write(write_options, &batch);
+  }
+  if (s.ok() && !db_it->status().ok())
+  {
+    s = db_it->status();
+  }
+  if (s.ok() && !g_stop)
+  {
+    // dump memtable and compact to sstables, new db is ready to serve
+    new_db->CompactRange(NULL, NULL);
+  }
+
+  int64_t cost = new_options.env->NowMicros() - start;
+  fprintf(stderr, "upgrade %s to %s %s. items: %ld, bytes: %ld -> %ld, cost: %ld us\n",
+          db_path, new_db_path, g_stop ? "stopped" : (s.ok() ? "success" : s.ToString().c_str()),
+          count, old_bytes, new_bytes, cost);
+
+  delete db_it;
+  delete new_db;
+  delete new_options.comparator;
+  delete new_options.env;
+  delete db;
+  delete open_options.comparator;
+  delete open_options.env;
+  if (open_options.info_log != NULL)
+  {
+    delete open_options.info_log;
+  }
+  return (s.ok() && !g_stop) ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+  int i = 0;
+  const char* db_path = NULL;
+  const char* manifest = NULL;
+  const char* cmp_desc = NULL;
+  const char* new_db_path = NULL;
+  int64_t batch_size = 4 << 20;
+  while ((i = getopt(argc, argv, "p:f:c:d:b:")) != EOF)
+  {
+    switch (i)
+    {
+    case 'p':
+      db_path = optarg;
+      break;
+    case 'f':
+      manifest = optarg;
+      break;
+    case 'c':
+      cmp_desc = optarg;
+      break;
+    case 'd':
+      new_db_path = optarg;
+      break;
+    case 'b':
+      batch_size = atoll(optarg);
+      break;
+    default:
+      print_help(argv[0]);
+      return 1;
+    }
+  }
+
+  if (db_path == NULL || manifest == NULL || cmp_desc == NULL || new_db_path == NULL || batch_size <= 0)
+  {
+    print_help(argv[0]);
+    return 1;
+  }
+
+  signal(SIGINT, sign_handler);
+  signal(SIGTERM, sign_handler);
+
+  return do_upgrade(db_path, manifest, cmp_desc, new_db_path, batch_size);
+}
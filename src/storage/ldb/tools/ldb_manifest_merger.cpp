@@ -51,7 +51,7 @@ void print_help(const char* name)
   fprintf(stderr, "%s: merge specified manifest files.\n"
           "\t-f manifestfiles -c comparator [-v]\n"
           "\tmanifest like: file1,file2\n"
-          "\tcomparator like: bitcmp OR numeric,:,2\n"
+          "\tcomparator like: bitcmp OR numeric,:,2 (bitcmp_v2 OR numeric_v2,:,2 for key format 2)\n"
           "\t-v verbose output\n", name);
 }
 
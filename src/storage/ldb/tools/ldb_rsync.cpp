@@ -175,8 +175,10 @@ int do_rsync(std::vector<int32_t>& buckets, DataFilter& filter,
   leveldb::ReadOptions scan_options;
   scan_options.verify_checksums = false;
   scan_options.fill_cache = false;
+  scan_options.readahead_size = 1 << 20; // 1M
+  scan_options.prefetch_table = true;
   leveldb::Iterator* db_it = db->NewIterator(scan_options);
-  char scan_key[LDB_KEY_META_SIZE];
+  char scan_key[LDB_KEY_META_MAX_SIZE];
 
   bool skip_in_bucket = false;
   bool skip_in_area = false;
@@ -221,7 +223,7 @@ int do_rsync(std::vector<int32_t>& buckets, DataFilter& filter,
 
       // seek to bucket
       LdbKey::build_key_meta(scan_key, bucket);
-      for (db_it->Seek(leveldb::Slice(scan_key, sizeof(scan_key))); !g_stop && db_it->Valid(); db_it->Next())
+      for (db_it->Seek(leveldb::Slice(scan_key, LdbKey::meta_size())); !g_stop && db_it->Valid(); db_it->Next())
       {
         ret = TAIR_RETURN_SUCCESS;
         skip_in_bucket = false;
@@ -362,7 +364,7 @@ void print_help(const char* name)
           "synchronize one ldb version data of specified buckets to remote cluster.\n"
           "%s -p dbpath -f manifest_file -c cmp_desc -r remote_cluster_addr -e faillogger_file -b buckets [-a yes_areas] [-A no_areas] [-w wait_ms] [-l local_cluster_addr] [-m] [-n]\n"
           "NOTE:\n"
-          "\tcmp_desc like bitcmp OR numeric,:,2\n"
+          "\tcmp_desc like bitcmp OR numeric,:,2 (bitcmp_v2 OR numeric_v2,:,2 for key format 2)\n"
           "\tcluster_addr like: 10.0.0.1:5198,10.0.0.1:5198,group_1\n"
           "\tbuckets/areas like: 1,2,3\n"
           "\tconfig local cluster address mean that data WILL BE RE-GOT from local cluster\n"
@@ -34,7 +34,7 @@ void print_help(const char* name)
   fprintf(stderr, "%s: pick sstable by specified buckets, output filenumber rename file and manifest of picked sstable.\n"
           "\t-f manifestfile -c comparator -b buckets -s start_num\n"
           "\tbuckets like: 1,4,5\n"
-          "\tcomparator like: bitcmp OR numeric,:,2\n"
+          "\tcomparator like: bitcmp OR numeric,:,2 (bitcmp_v2 OR numeric_v2,:,2 for key format 2)\n"
           "\t-v verbose output\n", name);
 }
 
@@ -85,8 +85,8 @@ int pick_sst(const leveldb::Options& options, const leveldb::VersionSet& version
     for (size_t i = 0; i < metas.size(); ++i)
     {
       f = metas[i];
-      smallest_bucket = LdbKey::decode_bucket_number(f->smallest.user_key().data() + LDB_EXPIRED_TIME_SIZE);
-      largest_bucket = LdbKey::decode_bucket_number(f->largest.user_key().data() + LDB_EXPIRED_TIME_SIZE);
+      smallest_bucket = LdbKey::decode_bucket_number_with_key(f->smallest.user_key().data());
+      largest_bucket = LdbKey::decode_bucket_number_with_key(f->largest.user_key().data());
 
       // [smallest, largest]
       // ...can optimize..
@@ -30,6 +30,8 @@ namespace tair
     namespace ldb
     {
 
+      // "_v2" after comparator type means keys are in LDB_KEY_FORMAT_V2,
+      // which is set for the whole tool.
       leveldb::Comparator* new_comparator(const char* cmp_desc)
       {
         leveldb::Comparator* cmp = NULL;
@@ -37,21 +39,23 @@ namespace tair
         {
           cmp = NULL;
         }
-        else if (strcmp(cmp_desc, "bitcmp") == 0)
+        else if (strcmp(cmp_desc, "bitcmp") == 0 || strcmp(cmp_desc, "bitcmp_v2") == 0)
         {
+          LdbKey::set_format(strcmp(cmp_desc, "bitcmp") == 0 ? LDB_KEY_FORMAT_V1 : LDB_KEY_FORMAT_V2);
           cmp = new BitcmpLdbComparatorImpl(NULL);
         }
         else if (strncmp(cmp_desc, "numeric", strlen("numeric")) == 0)
         {
           std::vector<std::string> strs;
           tair::util::string_util::split_str(cmp_desc, ", ", strs);
-          if (strs.size() != 3)
+          if (strs.size() != 3 || (strs[0] != "numeric" && strs[0] != "numeric_v2"))
           {
-            fprintf(stderr, "numeric description error: %s, format like: numeric,:,2\n", cmp_desc);
+            fprintf(stderr, "numeric description error: %s, format like: numeric,:,2 OR numeric_v2,:,2\n", cmp_desc);
             cmp = NULL;
           }
           else
           {
+            LdbKey::set_format(strs[0] == "numeric" ? LDB_KEY_FORMAT_V1 : LDB_KEY_FORMAT_V2);
             cmp = new NumericalComparatorImpl(NULL, strs[1].c_str()[0], atoi(strs[2].c_str()));
           }
         }
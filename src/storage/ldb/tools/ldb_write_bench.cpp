@@ -0,0 +1,208 @@
+/*
+ * (C) 2007-2010 Alibaba Group Holding Limited
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ *  Tool: write throughput and latency of leveldb with different writer threads,
+ *        concurrent memtable write (or pipelined log sync) off and on.
+ *
+ * Version: $Id$
+ *
+ * Authors:
+ *   agent <agent@local>
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <string>
+
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/options.h"
+#include "leveldb/write_batch.h"
+
+struct bench_arg
+{
+  leveldb::DB* db;
+  int id;
+  int count;
+  int value_size;
+  bool sync;
+  uint64_t cost_us;
+  leveldb::Status status;
+};
+
+struct bench_result
+{
+  double ops;                   // ops/s
+  double latency;               // average us per write
+};
+
+void print_help(const char* name)
+{
+  fprintf(stderr, "%s: write throughput with 1~max_threads writers\n"
+          "\t-d db_path [-n writes_per_thread] [-t max_threads] [-v value_size] [-s(sync write)]\n"
+          "\t[-p log_sync_delay_us(compare sync write with pipelined log sync instead of concurrent memtable write)]\n", name);
+}
+
+void* do_write(void* p)
+{
+  bench_arg* arg = reinterpret_cast<bench_arg*>(p);
+  leveldb::WriteOptions options;
+  options.sync = arg->sync;
+  std::string value(arg->value_size, 'v');
+  char key[32];
+  leveldb::Env* env = leveldb::Env::Default();
+  arg->cost_us = 0;
+  for (int i = 0; i < arg->count && arg->status.ok(); ++i)
+  {
+    // spread keys of different threads over whole key space
+    uint64_t k = (static_cast<uint64_t>(i) * 2654435761U) ^ (static_cast<uint64_t>(arg->id) << 40);
+    snprintf(key, sizeof(key), "%016lx", k);
+    uint64_t start = env->NowMicros();
+    arg->status = arg->db->Put(options, key, value);
+    arg->cost_us += env->NowMicros() - start;
+  }
+  return NULL;
+}
+
+// return false if failed
+bool run(const char* path, const leveldb::Options& db_options,
+         int threads, int count, int value_size, bool sync, bench_result& result)
+{
+  leveldb::Options options = db_options;
+  options.create_if_missing = true;
+  leveldb::DestroyDB(path, options);
+
+  leveldb::DB* db = NULL;
+  leveldb::Status s = leveldb::DB::Open(options, path, &db);
+  if (!s.ok())
+  {
+    fprintf(stderr, "open db %s fail: %s\n", path, s.ToString().c_str());
+    return false;
+  }
+
+  bench_arg* args = new bench_arg[threads];
+  pthread_t* tids = new pthread_t[threads];
+  uint64_t start = leveldb::Env::Default()->NowMicros();
+  for (int i = 0; i < threads; ++i)
+  {
+    args[i].db = db;
+    args[i].id = i;
+    args[i].count = count;
+    args[i].value_size = value_size;
+    args[i].sync = sync;
+    pthread_create(&tids[i], NULL, do_write, &args[i]);
+  }
+  for (int i = 0; i < threads; ++i)
+  {
+    pthread_join(tids[i], NULL);
+  }
+  uint64_t cost = leveldb::Env::Default()->NowMicros() - start;
+
+  bool ok = true;
+  uint64_t latency_sum = 0;
+  for (int i = 0; i < threads; ++i)
+  {
+    if (!args[i].status.ok())
+    {
+      fprintf(stderr, "write fail: %s\n", args[i].status.ToString().c_str());
+      ok = false;
+      break;
+    }
+    latency_sum += args[i].cost_us;
+  }
+  if (ok)
+  {
+    result.ops = cost > 0 ? static_cast<double>(threads) * count * 1000000 / cost : 0;
+    result.latency = static_cast<double>(latency_sum) / threads / count;
+  }
+
+  delete[] tids;
+  delete[] args;
+  delete db;
+  leveldb::DestroyDB(path, options);
+  return ok;
+}
+
+int main(int argc, char* argv[])
+{
+  int i = 0;
+  char* path = NULL;
+  int count = 100000;
+  int max_threads = 32;
+  int value_size = 100;
+  bool sync = false;
+  int log_sync_delay_us = -1;
+  while ((i = getopt(argc, argv, "d:n:t:v:sp:")) != EOF)
+  {
+    switch (i)
+    {
+    case 'd':
+      path = optarg;
+      break;
+    case 'n':
+      count = atoi(optarg);
+      break;
+    case 't':
+      max_threads = atoi(optarg);
+      break;
+    case 'v':
+      value_size = atoi(optarg);
+      break;
+    case 's':
+      sync = true;
+      break;
+    case 'p':
+      log_sync_delay_us = atoi(optarg);
+      sync = true;
+      break;
+    default:
+      print_help(argv[0]);
+      return 1;
+    }
+  }
+
+  if (path == NULL || count <= 0 || max_threads <= 0 || value_size < 0)
+  {
+    print_help(argv[0]);
+    return 1;
+  }
+
+  leveldb::Options normal_options, tuned_options;
+  const char* tuned_name = NULL;
+  if (log_sync_delay_us >= 0)
+  {
+    tuned_options.pipelined_log_sync = true;
+    tuned_options.log_sync_delay_us = log_sync_delay_us;
+    tuned_name = "pipelined";
+  }
+  else
+  {
+    tuned_options.concurrent_memtable_write = true;
+    tuned_name = "concurrent";
+  }
+
+  char tuned_ops[32], tuned_latency[32];
+  snprintf(tuned_ops, sizeof(tuned_ops), "%s(ops/s)", tuned_name);
+  snprintf(tuned_latency, sizeof(tuned_latency), "%s(us)", tuned_name);
+  fprintf(stderr, "%8s %18s %14s %18s %14s\n", "threads", "normal(ops/s)", "normal(us)",
+          tuned_ops, tuned_latency);
+  for (int threads = 1; threads <= max_threads; threads *= 2)
+  {
+    bench_result normal, tuned;
+    if (!run(path, normal_options, threads, count, value_size, sync, normal) ||
+        !run(path, tuned_options, threads, count, value_size, sync, tuned))
+    {
+      return 1;
+    }
+    fprintf(stderr, "%8d %18.0f %14.1f %18.0f %14.1f\n", threads,
+            normal.ops, normal.latency, tuned.ops, tuned.latency);
+  }
+  return 0;
+}
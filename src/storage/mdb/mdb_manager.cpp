@@ -265,6 +265,30 @@ namespace tair {
     }
   }
 
+  void mdb_manager::raw_get_hot_keys(int32_t max_count, std::vector<std::string>& keys)
+  {
+    tbsys::CThreadGuard guard(&mem_locker);
+    std::vector<uint64_t> ids;
+    cache->get_hot_item_ids(max_count, ids);
+    keys.reserve(keys.size() + ids.size());
+    uint32_t crrnt_time = static_cast<uint32_t> (time(NULL));
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+      mdb_item *it = id_to_item(ids[i]);
+      if (!is_item_expired(it, crrnt_time))
+      {
+        keys.push_back(std::string(ITEM_KEY(it), it->key_len));
+      }
+    }
+  }
+
+  void mdb_manager::raw_invalidate_area(int area)
+  {
+    assert(area >= 0 && area < TAIR_MAX_AREA_COUNT);
+    tbsys::CThreadGuard guard(&mem_locker);
+    cache->set_area_timestamp(area, static_cast<uint32_t> (time(NULL)) + 1);
+  }
+
   bool mdb_manager::raw_remove_if_exists(const char* key, int32_t key_len)
   {
     PROFILER_BEGIN("hashmap find");
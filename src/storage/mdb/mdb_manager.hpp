@@ -59,6 +59,10 @@ namespace tair {
     int raw_remove(const char* key, int32_t key_len);
     void raw_get_stats(mdb_area_stat* stat);
     void raw_update_stats(mdb_area_stat* stat);
+    // keys of about max_count most recently used items, hottest first in each lru list
+    void raw_get_hot_keys(int32_t max_count, std::vector<std::string>& keys);
+    // expire all items of area, unlike clear(), items updated in current second are included
+    void raw_invalidate_area(int area);
 
   private:
     bool raw_remove_if_exists(const char* key, int32_t key_len);
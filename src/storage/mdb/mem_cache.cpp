@@ -268,6 +268,35 @@ namespace tair {
     return slab_mng->get_item_head(area);
   }
 
+  void mem_cache::get_hot_item_ids(int max_count, std::vector<uint64_t> &ids)
+  {
+    uint64_t total_count = 0;
+    for(vector<slab_manager *>::iterator it = slab_managers.begin();
+        it != slab_managers.end(); ++it) {
+      total_count += (*it)->item_total_count;
+    }
+    if(total_count == 0 || max_count <= 0) {
+      return;
+    }
+
+    for(vector<slab_manager *>::iterator it = slab_managers.begin();
+        it != slab_managers.end(); ++it) {
+      slab_manager *slab_mng = *it;
+      for(int area = 0; area < TAIR_MAX_AREA_COUNT; ++area) {
+        if(slab_mng->item_count[area] == 0) {
+          continue;
+        }
+        // round up, every list contributes its hottest one at least
+        uint64_t count = (slab_mng->item_count[area] * max_count + total_count - 1) / total_count;
+        uint64_t item_id = slab_mng->this_item_list[area].item_head;
+        while(item_id != 0 && count-- > 0) {
+          ids.push_back(item_id);
+          item_id = id_to_item(item_id)->next;
+        }
+      }
+    }
+  }
+
   void mem_cache::display_statics()
   {
     TBSYS_LOG(WARN, "total slab : %lu", slab_managers.size());
@@ -121,6 +121,9 @@ namespace tair {
     int free_page(int slabid);
     int get_slabs_count();
     uint64_t get_item_head(int slabid, int area);
+    // ids of about max_count most recently used items, taken from the head
+    // of every area's lru list in proportion to the list length.
+    void get_hot_item_ids(int max_count, std::vector<uint64_t> &ids);
 
     //get the timestamp of the area
     inline uint32_t get_area_timestamp(int area) const {
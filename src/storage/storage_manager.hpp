@@ -63,6 +63,14 @@ const int ITEM_HEAD_LENGTH = 2;
 
       virtual int get(int bucket_number, data_entry & key,
                       data_entry & value, bool with_stat = true) = 0;
+      // Like get(), but value may reference memory pinned by storage engine
+      // (eg. block cache) instead of a copy, which is released when value's
+      // data is freed. Used when value is only kept until response is sent.
+      // read_mode is TAIR_READ_*, engine holding all data in memory ignores it.
+      virtual int get_pinned(int bucket_number, data_entry & key,
+                             data_entry & value, bool with_stat = true,
+                             int read_mode = TAIR_READ_BLOCKING)
+      { return get(bucket_number, key, value, with_stat); }
 
       virtual int remove(int bucket_number, data_entry & key,
                          bool version_care) = 0;
@@ -72,7 +80,16 @@ const int ITEM_HEAD_LENGTH = 2;
           return TAIR_RETURN_NOT_SUPPORTED;
       }
 
-      virtual int get_range(int bucket_number,data_entry & key_start,data_entry & key_end, int offset, int limit, int type, std::vector<data_entry*> &result, bool &has_next){return TAIR_RETURN_NOT_SUPPORTED;}
+      // cursor mode if cursor is not NULL: offset is ignored, non-empty *cursor (got from last call)
+      // is the position to resume from, and is set to the next unread position or cleared when done.
+      virtual int get_range(int bucket_number,data_entry & key_start,data_entry & key_end, int offset, int limit, int type, std::vector<data_entry*> &result, bool &has_next, data_entry *cursor = NULL){return TAIR_RETURN_NOT_SUPPORTED;}
+
+      // get keys of one bucket in one go, rcs[i] is result of keys[i] filled into values[i].
+      // return TAIR_RETURN_SUCCESS if all keys are looked up.
+      virtual int prefix_gets(int bucket_number, std::vector<data_entry*> &keys, std::vector<data_entry*> &values, std::vector<int> &rcs)
+      {
+        return TAIR_RETURN_NOT_SUPPORTED;
+      }
 
       virtual int del_range(int bucket_number,data_entry & key_start,data_entry & key_end, int offset, int limit, int type, std::vector<data_entry*> &result, bool &has_next){return TAIR_RETURN_NOT_SUPPORTED;}
 
@@ -88,6 +105,20 @@ const int ITEM_HEAD_LENGTH = 2;
 
       virtual void get_stats(tair_stat * stat) = 0;
 
+      // Storage engine supporting file level migration ships bucket's data files
+      // instead of items. Source exports bucket to files and sends them,
+      // target receives them piece by piece and loads them as a whole.
+      // engine not supporting it just returns TAIR_RETURN_NOT_SUPPORTED,
+      // then migrate goes in item way.
+      virtual int export_bucket(int bucket_number, std::vector<std::string>& files)
+      { return TAIR_RETURN_NOT_SUPPORTED; }
+      virtual void end_export_bucket(int bucket_number) {}
+      virtual int import_bucket_file(int bucket_number, const char* name, int64_t offset, const char* data, int32_t size)
+      { return TAIR_RETURN_NOT_SUPPORTED; }
+      // load all received files, or just clean them if abort
+      virtual int ingest_bucket(int bucket_number, bool abort)
+      { return TAIR_RETURN_NOT_SUPPORTED; }
+
       virtual int get_meta(data_entry &key, item_meta_info &meta) {
         return TAIR_RETURN_NOT_SUPPORTED;
       }
@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/options.h"
+
+using namespace std;
+
+class ldb_blob_gc_test : public testing::Test
+{
+public:
+  ldb_blob_gc_test() : db(NULL), dbname("/tmp/ldb_blob_gc_test") {}
+
+protected:
+  virtual void SetUp()
+  {
+    destroy();
+    options.create_if_missing = true;
+    options.blob_value_size = 1024;
+    options.blob_gc_ratio = 0.5;
+    reopen();
+  }
+
+  virtual void TearDown()
+  {
+    delete db;
+    db = NULL;
+    destroy();
+  }
+
+  void destroy()
+  {
+    // log files are in sub directory
+    string cmd = "rm -rf " + dbname;
+    ASSERT_EQ(0, system(cmd.c_str()));
+  }
+
+  void reopen()
+  {
+    delete db;
+    db = NULL;
+    ASSERT_TRUE(leveldb::DB::Open(options, dbname, &db).ok());
+  }
+
+  static string key(int i)
+  {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "key%06d", i);
+    return string(buf);
+  }
+
+  // large enough to go to blob file, differs by key and round
+  static string big_value(int i, char round)
+  {
+    string value(4096, round);
+    value.replace(0, key(i).size(), key(i));
+    return value;
+  }
+
+  void put_range(int from, int to, char round)
+  {
+    for (int i = from; i < to; ++i)
+    {
+      ASSERT_TRUE(db->Put(leveldb::WriteOptions(), key(i), big_value(i, round)).ok());
+    }
+  }
+
+  string get(int i, const leveldb::Snapshot* snapshot = NULL)
+  {
+    leveldb::ReadOptions read_options;
+    read_options.snapshot = snapshot;
+    string value;
+    leveldb::Status s = db->Get(read_options, key(i), &value);
+    return s.ok() ? value : (s.IsNotFound() ? "NOT_FOUND" : s.ToString());
+  }
+
+  int blob_file_count()
+  {
+    vector<string> files;
+    leveldb::Env::Default()->GetChildren(dbname, &files);
+    int n = 0;
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+      if (files[i].size() > 5 && files[i].compare(files[i].size() - 5, 5, ".blob") == 0)
+      {
+        ++n;
+      }
+    }
+    return n;
+  }
+
+  void compact_self_level()
+  {
+    string number;
+    ASSERT_TRUE(db->GetProperty("leveldb.largest-filenumber", &number));
+    ASSERT_TRUE(db->CompactRangeSelfLevel(strtoull(number.c_str(), NULL, 10), NULL, NULL).ok());
+  }
+
+  // collect until nothing is reclaimed, return total reclaimed size
+  uint64_t collect()
+  {
+    uint64_t total = 0, reclaimed = 0;
+    do
+    {
+      leveldb::Status s = db->CollectBlobGarbage(&reclaimed);
+      EXPECT_TRUE(s.ok()) << s.ToString();
+      total += reclaimed;
+    } while (reclaimed > 0);
+    return total;
+  }
+
+protected:
+  leveldb::DB* db;
+  leveldb::Options options;
+  string dbname;
+};
+
+TEST_F(ldb_blob_gc_test, small_value_stays_in_table)
+{
+  ASSERT_TRUE(db->Put(leveldb::WriteOptions(), key(0), "small").ok());
+  db->CompactRange(NULL, NULL);
+  ASSERT_EQ(0, blob_file_count());
+  ASSERT_EQ("small", get(0));
+}
+
+TEST_F(ldb_blob_gc_test, read_after_flush_and_reopen)
+{
+  put_range(0, 200, 'a');
+  db->CompactRange(NULL, NULL);
+  ASSERT_LT(0, blob_file_count());
+  ASSERT_EQ(big_value(10, 'a'), get(10));
+
+  reopen();
+  for (int i = 0; i < 200; ++i)
+  {
+    ASSERT_EQ(big_value(i, 'a'), get(i));
+  }
+}
+
+TEST_F(ldb_blob_gc_test, rewrite_live_values_and_reclaim)
+{
+  put_range(0, 200, 'a');
+  db->CompactRange(NULL, NULL);
+  ASSERT_EQ(0U, collect());     // no garbage yet
+
+  // most values of the first blob file become garbage
+  put_range(0, 150, 'b');
+  for (int i = 150; i < 180; ++i)
+  {
+    ASSERT_TRUE(db->Delete(leveldb::WriteOptions(), key(i)).ok());
+  }
+  db->CompactRange(NULL, NULL);
+
+  ASSERT_LT(0U, collect());
+  for (int i = 0; i < 150; ++i)
+  {
+    ASSERT_EQ(big_value(i, 'b'), get(i));
+  }
+  ASSERT_EQ("NOT_FOUND", get(160));
+  ASSERT_EQ(big_value(190, 'a'), get(190));  // rewritten live value
+
+  reopen();
+  ASSERT_EQ(big_value(0, 'b'), get(0));
+  ASSERT_EQ("NOT_FOUND", get(179));
+  ASSERT_EQ(big_value(199, 'a'), get(199));
+}
+
+TEST_F(ldb_blob_gc_test, snapshot_keeps_blob_file)
+{
+  put_range(0, 100, 'a');
+  db->CompactRange(NULL, NULL);
+  put_range(0, 90, 'b');
+  db->CompactRange(NULL, NULL);
+  const leveldb::Snapshot* snapshot = db->GetSnapshot();
+
+  // live values are rewritten, but file is kept for older snapshot
+  ASSERT_EQ(0U, collect());
+  ASSERT_EQ(big_value(95, 'a'), get(95, snapshot));
+  ASSERT_EQ(big_value(5, 'b'), get(5));
+  ASSERT_EQ(big_value(95, 'a'), get(95));
+
+  db->ReleaseSnapshot(snapshot);
+  ASSERT_LT(0U, collect());
+  ASSERT_EQ(big_value(5, 'b'), get(5));
+  ASSERT_EQ(big_value(95, 'a'), get(95));
+  reopen();
+  ASSERT_EQ(big_value(95, 'a'), get(95));
+}
+
+TEST_F(ldb_blob_gc_test, garbage_kept_for_snapshot_is_not_counted)
+{
+  put_range(0, 100, 'a');
+  db->CompactRange(NULL, NULL);
+  const leveldb::Snapshot* snapshot = db->GetSnapshot();
+  put_range(0, 90, 'b');
+  db->CompactRange(NULL, NULL);
+
+  // overwritten indexes are kept by compaction for snapshot
+  ASSERT_EQ(0U, collect());
+  ASSERT_EQ(big_value(5, 'a'), get(5, snapshot));
+
+  // files at the last level are rewritten only in their own level
+  db->ReleaseSnapshot(snapshot);
+  compact_self_level();
+  ASSERT_LT(0U, collect());
+  ASSERT_EQ(big_value(5, 'b'), get(5));
+  ASSERT_EQ(big_value(95, 'a'), get(95));
+}
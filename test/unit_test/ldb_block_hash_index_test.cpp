@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+#include "leveldb/comparator.h"
+#include "leveldb/db.h"
+#include "leveldb/iterator.h"
+#include "leveldb/options.h"
+#include "table/block.h"
+#include "table/block_builder.h"
+#include "table/format.h"
+#include "util/coding.h"
+
+using namespace std;
+
+static string key(int i)
+{
+  char buf[16];
+  snprintf(buf, sizeof(buf), "key%06d", i);
+  return string(buf);
+}
+
+static string value(int i)
+{
+  return "value_" + key(i);
+}
+
+class ldb_block_hash_index_test : public testing::Test
+{
+protected:
+  // keys of even number from 0 to 2 * (count - 1)
+  string build_block(bool hash_index, int count)
+  {
+    options.data_block_hash_index = hash_index;
+    leveldb::BlockBuilder builder(&options, true/* data block */);
+    for (int i = 0; i < count; ++i)
+    {
+      builder.Add(key(i * 2), value(i * 2));
+    }
+    return builder.Finish().ToString();
+  }
+
+  static bool has_hash_index(const string& block)
+  {
+    uint32_t num_restarts = leveldb::DecodeFixed32(block.data() + block.size() - sizeof(uint32_t));
+    return (num_restarts & leveldb::kBlockHashIndexFlag) != 0;
+  }
+
+  // seek every key and some absent ones, then scan all
+  void verify_block(const string& data, int count, bool point_lookup)
+  {
+    leveldb::BlockContents contents;
+    contents.data = leveldb::Slice(data);
+    contents.cachable = false;
+    contents.heap_allocated = false;
+    leveldb::Block block(contents);
+    ASSERT_LT(0U, block.size());
+    leveldb::Iterator* it = block.NewIterator(leveldb::BytewiseComparator(), point_lookup);
+    for (int i = 0; i < count * 2; ++i)
+    {
+      it->Seek(key(i));
+      if (i % 2 == 0)
+      {
+        ASSERT_TRUE(it->Valid()) << key(i);
+        ASSERT_EQ(key(i), it->key().ToString());
+        ASSERT_EQ(value(i), it->value().ToString());
+      }
+      else if (!point_lookup)
+      {
+        // absent key, positioned at next one
+        ASSERT_TRUE(it->Valid() || i == count * 2 - 1) << key(i);
+        if (it->Valid())
+        {
+          ASSERT_EQ(key(i + 1), it->key().ToString());
+        }
+      }
+      else
+      {
+        ASSERT_TRUE(!it->Valid() || it->key().ToString() != key(i)) << key(i);
+      }
+    }
+    int n = 0;
+    for (it->SeekToFirst(); it->Valid(); it->Next(), ++n)
+    {
+      ASSERT_EQ(key(n * 2), it->key().ToString());
+    }
+    ASSERT_EQ(count, n);
+    ASSERT_TRUE(it->status().ok());
+    delete it;
+  }
+
+protected:
+  leveldb::Options options;
+};
+
+TEST_F(ldb_block_hash_index_test, flag_off_keeps_old_format)
+{
+  string block = build_block(false, 100);
+  ASSERT_FALSE(has_hash_index(block));
+  // same as a block that never builds hash index
+  leveldb::BlockBuilder builder(&options, false);
+  for (int i = 0; i < 100; ++i)
+  {
+    builder.Add(key(i * 2), value(i * 2));
+  }
+  ASSERT_EQ(builder.Finish().ToString(), block);
+  verify_block(block, 100, false);
+  verify_block(block, 100, true);
+}
+
+TEST_F(ldb_block_hash_index_test, point_lookup_by_hash_index)
+{
+  string block = build_block(true, 100);
+  ASSERT_TRUE(has_hash_index(block));
+  verify_block(block, 100, true);
+  // iterators other than point lookup use binary search
+  verify_block(block, 100, false);
+}
+
+TEST_F(ldb_block_hash_index_test, too_many_restarts)
+{
+  options.block_restart_interval = 1;
+  string block = build_block(true, leveldb::kBlockHashMaxRestarts + 1);
+  ASSERT_FALSE(has_hash_index(block));
+  verify_block(block, leveldb::kBlockHashMaxRestarts + 1, true);
+}
+
+class ldb_block_hash_index_db_test : public testing::Test
+{
+public:
+  ldb_block_hash_index_db_test() : db(NULL), dbname("/tmp/ldb_block_hash_index_test") {}
+
+protected:
+  virtual void SetUp()
+  {
+    destroy();
+    options.create_if_missing = true;
+  }
+
+  virtual void TearDown()
+  {
+    delete db;
+    db = NULL;
+    destroy();
+  }
+
+  void destroy()
+  {
+    // log files are in sub directory
+    string cmd = "rm -rf " + dbname;
+    ASSERT_EQ(0, system(cmd.c_str()));
+  }
+
+  void reopen(bool hash_index)
+  {
+    delete db;
+    db = NULL;
+    options.data_block_hash_index = hash_index;
+    ASSERT_TRUE(leveldb::DB::Open(options, dbname, &db).ok());
+  }
+
+  void verify(int count)
+  {
+    string v;
+    for (int i = 0; i < count * 2; ++i)
+    {
+      leveldb::Status s = db->Get(leveldb::ReadOptions(), key(i), &v);
+      if (i % 2 == 0)
+      {
+        ASSERT_TRUE(s.ok()) << key(i) << " " << s.ToString();
+        ASSERT_EQ(value(i), v);
+      }
+      else
+      {
+        ASSERT_TRUE(s.IsNotFound()) << key(i) << " " << s.ToString();
+      }
+    }
+    leveldb::Iterator* it = db->NewIterator(leveldb::ReadOptions());
+    int n = 0;
+    for (it->SeekToFirst(); it->Valid(); it->Next(), ++n)
+    {
+      ASSERT_EQ(key(n * 2), it->key().ToString());
+    }
+    delete it;
+    ASSERT_EQ(count, n);
+  }
+
+protected:
+  leveldb::DB* db;
+  leveldb::Options options;
+  string dbname;
+};
+
+TEST_F(ldb_block_hash_index_db_test, switch_flag_over_reopen)
+{
+  const int count = 20000;
+  reopen(true);
+  for (int i = 0; i < count; ++i)
+  {
+    ASSERT_TRUE(db->Put(leveldb::WriteOptions(), key(i * 2), value(i * 2)).ok());
+  }
+  db->CompactRange(NULL, NULL);
+  verify(count);
+
+  // blocks with hash index are read with the flag off
+  reopen(false);
+  verify(count);
+  // and rewritten without it
+  for (int i = 0; i < count; i += 3)
+  {
+    ASSERT_TRUE(db->Put(leveldb::WriteOptions(), key(i * 2), value(i * 2)).ok());
+  }
+  db->CompactRange(NULL, NULL);
+  verify(count);
+
+  reopen(true);
+  verify(count);
+}
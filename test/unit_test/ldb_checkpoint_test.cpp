@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/iterator.h"
+#include "leveldb/options.h"
+
+using namespace std;
+
+class ldb_checkpoint_test : public testing::Test
+{
+public:
+  ldb_checkpoint_test()
+    : db(NULL), copy(NULL), dbname("/tmp/ldb_checkpoint_test"), copyname("/tmp/ldb_checkpoint_test_copy") {}
+
+protected:
+  virtual void SetUp()
+  {
+    destroy();
+    options.create_if_missing = true;
+    options.write_buffer_size = 64 << 10;
+    options.blob_value_size = 1024;
+    ASSERT_TRUE(leveldb::DB::Open(options, dbname, &db).ok());
+  }
+
+  virtual void TearDown()
+  {
+    delete copy;
+    copy = NULL;
+    delete db;
+    db = NULL;
+    destroy();
+  }
+
+  void destroy()
+  {
+    // log files are in sub directory
+    string cmd = "rm -rf " + dbname + " " + copyname;
+    ASSERT_EQ(0, system(cmd.c_str()));
+  }
+
+  void open_copy()
+  {
+    delete copy;
+    copy = NULL;
+    leveldb::Options copy_options = options;
+    copy_options.create_if_missing = false;
+    leveldb::Status s = leveldb::DB::Open(copy_options, copyname, &copy);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+  }
+
+  static string key(int i)
+  {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "key%06d", i);
+    return string(buf);
+  }
+
+  static string value(int i, size_t size = 100)
+  {
+    string v(size, 'v');
+    return v.replace(0, key(i).size(), key(i));
+  }
+
+  void put_range(int from, int to, size_t value_size = 100)
+  {
+    for (int i = from; i < to; ++i)
+    {
+      ASSERT_TRUE(db->Put(leveldb::WriteOptions(), key(i), value(i, value_size)).ok());
+    }
+  }
+
+  static string get(leveldb::DB* d, int i)
+  {
+    string v;
+    leveldb::Status s = d->Get(leveldb::ReadOptions(), key(i), &v);
+    return s.ok() ? v : (s.IsNotFound() ? "NOT_FOUND" : s.ToString());
+  }
+
+  static int count(leveldb::DB* d)
+  {
+    leveldb::Iterator* it = d->NewIterator(leveldb::ReadOptions());
+    int n = 0;
+    for (it->SeekToFirst(); it->Valid(); it->Next())
+    {
+      ++n;
+    }
+    delete it;
+    return n;
+  }
+
+  uint64_t last_sequence()
+  {
+    string seq;
+    EXPECT_TRUE(db->GetProperty("leveldb.sequence", &seq));
+    return strtoull(seq.c_str(), NULL, 10);
+  }
+
+protected:
+  leveldb::DB* db;
+  leveldb::DB* copy;
+  leveldb::Options options;
+  string dbname;
+  string copyname;
+};
+
+TEST_F(ldb_checkpoint_test, open_tables_and_logs)
+{
+  put_range(0, 1000);
+  db->CompactRange(NULL, NULL);
+  put_range(1000, 1100);          // only in log
+  ASSERT_TRUE(db->Delete(leveldb::WriteOptions(), key(5)).ok());
+
+  uint64_t sequence = 0;
+  ASSERT_TRUE(db->Checkpoint(copyname, &sequence).ok());
+  ASSERT_EQ(last_sequence(), sequence);
+
+  // later writes are not in the copy
+  put_range(2000, 2010);
+  open_copy();
+  ASSERT_EQ(1099, count(copy));
+  ASSERT_EQ(value(0), get(copy, 0));
+  ASSERT_EQ("NOT_FOUND", get(copy, 5));
+  ASSERT_EQ(value(1050), get(copy, 1050));
+  ASSERT_EQ("NOT_FOUND", get(copy, 2000));
+
+  // copy is a db of its own
+  ASSERT_TRUE(copy->Put(leveldb::WriteOptions(), key(3000), value(3000)).ok());
+  ASSERT_EQ("NOT_FOUND", get(db, 3000));
+  ASSERT_EQ(1109, count(db));
+}
+
+TEST_F(ldb_checkpoint_test, exists_already)
+{
+  put_range(0, 10);
+  uint64_t sequence = 0;
+  ASSERT_TRUE(db->Checkpoint(copyname, &sequence).ok());
+  ASSERT_FALSE(db->Checkpoint(copyname, &sequence).ok());
+}
+
+TEST_F(ldb_checkpoint_test, outlive_source)
+{
+  put_range(0, 500);
+  put_range(500, 600, 4096);      // blob values
+  db->CompactRange(NULL, NULL);
+  ASSERT_TRUE(db->DeleteRange(leveldb::WriteOptions(), key(100), key(200)).ok());
+
+  uint64_t sequence = 0;
+  ASSERT_TRUE(db->Checkpoint(copyname, &sequence).ok());
+  // linked files are deleted by source
+  put_range(0, 600);
+  db->CompactRange(NULL, NULL);
+  delete db;
+  db = NULL;
+  string cmd = "rm -rf " + dbname;
+  ASSERT_EQ(0, system(cmd.c_str()));
+
+  open_copy();
+  ASSERT_EQ(500, count(copy));
+  ASSERT_EQ("NOT_FOUND", get(copy, 150));
+  ASSERT_EQ(value(99), get(copy, 99));
+  ASSERT_EQ(value(550, 4096), get(copy, 550));
+  // range deletion survives reopen of copy
+  open_copy();
+  ASSERT_EQ("NOT_FOUND", get(copy, 199));
+  ASSERT_EQ(500, count(copy));
+}
+
+struct writer_arg
+{
+  leveldb::DB* db;
+  volatile bool stop;
+  int written;
+};
+
+static void* keep_writing(void* arg)
+{
+  writer_arg* w = reinterpret_cast<writer_arg*>(arg);
+  char buf[16];
+  string value(100, 'w');
+  for (w->written = 0; !w->stop; ++w->written)
+  {
+    snprintf(buf, sizeof(buf), "zkey%06d", w->written);
+    if (!w->db->Put(leveldb::WriteOptions(), buf, value).ok())
+    {
+      break;
+    }
+  }
+  return NULL;
+}
+
+TEST_F(ldb_checkpoint_test, consistent_while_writing)
+{
+  put_range(0, 1000);
+  const uint64_t base = last_sequence();
+  writer_arg w;
+  w.db = db;
+  w.stop = false;
+  pthread_t tid;
+  ASSERT_EQ(0, pthread_create(&tid, NULL, keep_writing, &w));
+  usleep(20000);
+  uint64_t sequence = 0;
+  leveldb::Status s = db->Checkpoint(copyname, &sequence);
+  usleep(20000);
+  w.stop = true;
+  pthread_join(tid, NULL);
+  ASSERT_TRUE(s.ok()) << s.ToString();
+
+  // one put is one sequence, copy has exactly puts up to sequence
+  open_copy();
+  ASSERT_LE(base, sequence);
+  ASSERT_EQ(static_cast<int>(1000 + sequence - base), count(copy));
+}
@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/iterator.h"
+#include "leveldb/options.h"
+#include "leveldb/write_batch.h"
+
+using namespace std;
+
+static const int kThreadCount = 8;
+static const int kBatchPerThread = 500;
+static const int kKeyPerBatch = 4;
+
+class ldb_concurrent_write_test : public testing::Test
+{
+public:
+  ldb_concurrent_write_test() : db(NULL), dbname("/tmp/ldb_concurrent_write_test") {}
+
+protected:
+  virtual void SetUp()
+  {
+    destroy();
+    options.create_if_missing = true;
+    options.write_buffer_size = 256 << 10;   // flush meanwhile
+  }
+
+  virtual void TearDown()
+  {
+    delete db;
+    db = NULL;
+    destroy();
+  }
+
+  void destroy()
+  {
+    // log files are in sub directory
+    string cmd = "rm -rf " + dbname;
+    ASSERT_EQ(0, system(cmd.c_str()));
+  }
+
+  void reopen()
+  {
+    delete db;
+    db = NULL;
+    ASSERT_TRUE(leveldb::DB::Open(options, dbname, &db).ok());
+  }
+
+  static string key(int thread, int i)
+  {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "t%02d_key%06d", thread, i);
+    return string(buf);
+  }
+
+  static string value(int thread, int i)
+  {
+    string v(64, 'a' + thread);
+    return v + key(thread, i);
+  }
+
+  struct writer_arg
+  {
+    leveldb::DB* db;
+    int thread;
+    int sync_every;            // sync every N batches, 0 never
+    int failed;
+  };
+
+  // each batch puts kKeyPerBatch keys and deletes one key of previous batch
+  static void* do_write(void* arg)
+  {
+    writer_arg* w = reinterpret_cast<writer_arg*>(arg);
+    w->failed = 0;
+    for (int b = 0; b < kBatchPerThread; ++b)
+    {
+      leveldb::WriteBatch batch;
+      for (int k = 0; k < kKeyPerBatch; ++k)
+      {
+        int i = b * kKeyPerBatch + k;
+        batch.Put(key(w->thread, i), value(w->thread, i));
+      }
+      if (b > 0)
+      {
+        batch.Delete(key(w->thread, (b - 1) * kKeyPerBatch));
+      }
+      leveldb::WriteOptions write_options;
+      write_options.sync = w->sync_every > 0 && b % w->sync_every == 0;
+      if (!w->db->Write(write_options, &batch).ok())
+      {
+        ++w->failed;
+      }
+    }
+    return NULL;
+  }
+
+  void write_concurrently(int sync_every)
+  {
+    pthread_t tids[kThreadCount];
+    writer_arg args[kThreadCount];
+    for (int t = 0; t < kThreadCount; ++t)
+    {
+      args[t].db = db;
+      args[t].thread = t;
+      args[t].sync_every = sync_every;
+      ASSERT_EQ(0, pthread_create(&tids[t], NULL, do_write, &args[t]));
+    }
+    for (int t = 0; t < kThreadCount; ++t)
+    {
+      pthread_join(tids[t], NULL);
+      ASSERT_EQ(0, args[t].failed);
+    }
+  }
+
+  // every write of every thread is there, and nothing else
+  void verify()
+  {
+    const int last_batch_first = (kBatchPerThread - 1) * kKeyPerBatch;
+    for (int t = 0; t < kThreadCount; ++t)
+    {
+      for (int i = 0; i < kBatchPerThread * kKeyPerBatch; ++i)
+      {
+        string v;
+        leveldb::Status s = db->Get(leveldb::ReadOptions(), key(t, i), &v);
+        if (i % kKeyPerBatch == 0 && i != last_batch_first)
+        {
+          ASSERT_TRUE(s.IsNotFound()) << key(t, i) << " " << s.ToString();
+        }
+        else
+        {
+          ASSERT_TRUE(s.ok()) << key(t, i) << " " << s.ToString();
+          ASSERT_EQ(value(t, i), v);
+        }
+      }
+    }
+
+    const int expected = kThreadCount * (kBatchPerThread * (kKeyPerBatch - 1) + 1);
+    leveldb::Iterator* it = db->NewIterator(leveldb::ReadOptions());
+    int n = 0;
+    for (it->SeekToFirst(); it->Valid(); it->Next())
+    {
+      ++n;
+    }
+    delete it;
+    ASSERT_EQ(expected, n);
+  }
+
+protected:
+  leveldb::DB* db;
+  leveldb::Options options;
+  string dbname;
+};
+
+TEST_F(ldb_concurrent_write_test, grouped_writes)
+{
+  reopen();
+  write_concurrently(0);
+  verify();
+  reopen();
+  verify();
+}
+
+TEST_F(ldb_concurrent_write_test, concurrent_memtable_write)
+{
+  options.concurrent_memtable_write = true;
+  reopen();
+  write_concurrently(0);
+  verify();
+  // recovered from log and flushed tables
+  reopen();
+  verify();
+}
+
+TEST_F(ldb_concurrent_write_test, concurrent_memtable_write_with_sync)
+{
+  options.concurrent_memtable_write = true;
+  reopen();
+  write_concurrently(7);
+  verify();
+  reopen();
+  verify();
+}
+
+TEST_F(ldb_concurrent_write_test, pipelined_log_sync)
+{
+  options.pipelined_log_sync = true;
+  reopen();
+  write_concurrently(1);
+  verify();
+  reopen();
+  verify();
+}
+
+TEST_F(ldb_concurrent_write_test, pipelined_log_sync_with_delay_and_concurrent_memtable_write)
+{
+  options.pipelined_log_sync = true;
+  options.log_sync_delay_us = 200;
+  options.concurrent_memtable_write = true;
+  reopen();
+  write_concurrently(3);
+  verify();
+  reopen();
+  verify();
+}
@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string>
+
+#include "leveldb/comparator.h"
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/iterator.h"
+#include "leveldb/options.h"
+#include "db/log_reader.h"
+#include "db/version_edit.h"
+
+using namespace std;
+
+// bytewise order, value is "<expired time>:<data>"
+class ExpireComparator : public leveldb::Comparator
+{
+public:
+  virtual int Compare(const leveldb::Slice& a, const leveldb::Slice& b) const
+  {
+    return leveldb::BytewiseComparator()->Compare(a, b);
+  }
+  virtual const char* Name() const { return "ldb_expired_file_test.ExpireComparator"; }
+  virtual void FindShortestSeparator(std::string* start, const leveldb::Slice& limit) const
+  {
+    leveldb::BytewiseComparator()->FindShortestSeparator(start, limit);
+  }
+  virtual void FindShortSuccessor(std::string* key) const
+  {
+    leveldb::BytewiseComparator()->FindShortSuccessor(key);
+  }
+  virtual bool GetTimeMeta(const leveldb::Slice& key, const leveldb::Slice& value,
+                           uint32_t* expired_time, uint32_t* modify_time) const
+  {
+    string v = value.ToString();
+    *expired_time = static_cast<uint32_t>(strtoul(v.c_str(), NULL, 10));
+    *modify_time = 0;
+    return true;
+  }
+};
+
+class ldb_expired_file_test : public testing::Test
+{
+public:
+  ldb_expired_file_test() : db(NULL), dbname("/tmp/ldb_expired_file_test") {}
+
+protected:
+  virtual void SetUp()
+  {
+    destroy();
+    options.create_if_missing = true;
+    options.comparator = &comparator;
+  }
+
+  virtual void TearDown()
+  {
+    delete db;
+    db = NULL;
+    destroy();
+  }
+
+  void destroy()
+  {
+    string cmd = "rm -rf " + dbname;
+    ASSERT_EQ(0, system(cmd.c_str()));
+  }
+
+  void reopen()
+  {
+    delete db;
+    db = NULL;
+    ASSERT_TRUE(leveldb::DB::Open(options, dbname, &db).ok());
+  }
+
+  static string key(int i)
+  {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "key%06d", i);
+    return string(buf);
+  }
+
+  // one table of entries all expired
+  void put_expired(int count)
+  {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%u:", static_cast<uint32_t>(time(NULL)) - 100);
+    for (int i = 0; i < count; ++i)
+    {
+      ASSERT_TRUE(db->Put(leveldb::WriteOptions(), key(i), string(buf) + key(i)).ok());
+    }
+    db->CompactRange(NULL, NULL);
+  }
+
+  int count()
+  {
+    leveldb::Iterator* it = db->NewIterator(leveldb::ReadOptions());
+    int n = 0;
+    for (it->SeekToFirst(); it->Valid(); it->Next())
+    {
+      ++n;
+    }
+    delete it;
+    return n;
+  }
+
+  // whether any new file in current MANIFEST is recorded with time meta
+  bool manifest_has_time_meta()
+  {
+    leveldb::Env* env = leveldb::Env::Default();
+    string current;
+    EXPECT_TRUE(leveldb::ReadFileToString(env, dbname + "/CURRENT", &current).ok());
+    leveldb::SequentialFile* file = NULL;
+    EXPECT_TRUE(env->NewSequentialFile(dbname + "/" + current.substr(0, current.size() - 1), &file).ok());
+    leveldb::log::Reader reader(file, NULL, true, 0);
+    leveldb::Slice record;
+    string scratch;
+    bool found = false;
+    while (reader.ReadRecord(&record, &scratch))
+    {
+      leveldb::VersionEdit edit;
+      EXPECT_TRUE(edit.DecodeFrom(record).ok());
+      found = found || edit.DebugString().find(" expire ") != string::npos;
+    }
+    delete file;
+    return found;
+  }
+
+  // time meta is lost on reopen unless persisted, expired file is found either way
+  void check_delete_expired(bool persist)
+  {
+    options.persist_file_time_meta = persist;
+    reopen();
+    put_expired(1000);
+    reopen();
+    ASSERT_EQ(persist, manifest_has_time_meta());
+    ASSERT_EQ(1000, count());
+
+    uint64_t deleted_size = 0;
+    ASSERT_TRUE(db->DeleteExpiredFiles(&deleted_size).ok());
+    ASSERT_LT(0U, deleted_size);
+    ASSERT_EQ(0, count());
+  }
+
+protected:
+  ExpireComparator comparator;
+  leveldb::Options options;
+  leveldb::DB* db;
+  string dbname;
+};
+
+TEST_F(ldb_expired_file_test, time_meta_recomputed)
+{
+  check_delete_expired(false);
+}
+
+TEST_F(ldb_expired_file_test, time_meta_persisted)
+{
+  check_delete_expired(true);
+}
+
+// time meta of table picked most expired is recomputed too
+TEST_F(ldb_expired_file_test, compact_expired_file)
+{
+  reopen();
+  put_expired(1000);
+  reopen();
+  uint64_t expired_size = 0;
+  ASSERT_TRUE(db->CompactExpiredFile(1, &expired_size).ok());
+  ASSERT_LT(0U, expired_size);
+}
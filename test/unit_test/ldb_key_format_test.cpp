@@ -0,0 +1,333 @@
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include "define.hpp"
+#include "data_entry.hpp"
+#include "ldb_instance.hpp"
+
+using namespace std;
+using namespace tair::common;
+using namespace tair::storage::ldb;
+
+static const int kBucket = 1;
+static const int kOtherBucket = 2;
+static const int kArea = 7;
+
+static string rc_string(int rc)
+{
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%d", rc);
+  return string(buf);
+}
+
+class ldb_key_format_test : public testing::Test
+{
+public:
+  ldb_key_format_test() : ldb(NULL), dir("/tmp/ldb_key_format_test") {}
+
+  // key format is set for the whole process before any db is opened
+  static void SetUpTestCase()
+  {
+    const char* conf = "/tmp/ldb_key_format_test.conf";
+    FILE* f = fopen(conf, "w");
+    ASSERT_TRUE(f != NULL);
+    fprintf(f, "[%s]\n%s=/tmp/ldb_key_format_test/data\n", TAIRLDB_SECTION, LDB_DATA_DIR);
+    fclose(f);
+    ASSERT_EQ(EXIT_SUCCESS, TBSYS_CONFIG.load(conf));
+    TBSYS_LOGGER.setLogLevel("warn");
+    LdbKey::set_format(LDB_KEY_FORMAT_V2);
+  }
+
+protected:
+  virtual void SetUp()
+  {
+    destroy();
+    ldb = open(0);
+    ASSERT_TRUE(ldb != NULL);
+  }
+
+  virtual void TearDown()
+  {
+    delete ldb;
+    ldb = NULL;
+    LdbKey::set_format(LDB_KEY_FORMAT_V2);
+    destroy();
+  }
+
+  void destroy()
+  {
+    string cmd = "rm -rf " + dir;
+    ASSERT_EQ(0, system(cmd.c_str()));
+  }
+
+  // db of index is under <data_dir><index + 1>
+  static LdbInstance* open(int index)
+  {
+    LdbInstance* instance = new LdbInstance(index, true, NULL);
+    vector<int32_t> buckets;
+    buckets.push_back(kBucket);
+    buckets.push_back(kOtherBucket);
+    if (!instance->init_buckets(buckets))
+    {
+      delete instance;
+      instance = NULL;
+    }
+    return instance;
+  }
+
+  void reopen()
+  {
+    delete ldb;
+    ldb = open(0);
+    ASSERT_TRUE(ldb != NULL);
+  }
+
+  void compact()
+  {
+    ldb->db()->CompactRange(NULL, NULL);
+  }
+
+  static string key(int i)
+  {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "key%06d", i);
+    return string(buf);
+  }
+
+  static string value(int i)
+  {
+    return "value_" + key(i);
+  }
+
+  // area | pkey | skey, prefix size is size of pkey, no prefix if pkey is empty
+  static void tair_key(data_entry& entry, const string& pkey, const string& skey)
+  {
+    data_entry p(pkey.data(), static_cast<int>(pkey.size())), s(skey.data(), static_cast<int>(skey.size()));
+    merge_key(p, s, entry);
+    if (pkey.empty())
+    {
+      entry.set_prefix_size(0);
+    }
+    entry.merge_area(kArea);
+  }
+
+  static int put(LdbInstance* instance, int bucket, int i, int expire = 0, const string& pkey = "")
+  {
+    data_entry k, v(value(i).c_str());
+    tair_key(k, pkey, key(i));
+    return instance->put(bucket, k, v, false, expire);
+  }
+
+  // value if found, or rc
+  static string get(LdbInstance* instance, int bucket, int i, const string& pkey = "",
+                    uint32_t* edate = NULL)
+  {
+    data_entry k, v;
+    tair_key(k, pkey, key(i));
+    int rc = instance->get(bucket, k, v);
+    if (rc != TAIR_RETURN_SUCCESS)
+    {
+      return rc_string(rc);
+    }
+    if (edate != NULL)
+    {
+      *edate = v.data_meta.edate;
+    }
+    return string(v.get_data(), v.get_size());
+  }
+
+  int range_count(const string& pkey)
+  {
+    data_entry key_start, key_end;
+    tair_key(key_start, pkey, "");
+    tair_key(key_end, pkey, "");
+    vector<data_entry*> result;
+    bool has_next = false;
+    ldb->get_range(kBucket, key_start, key_end, 0, 1000, CMD_RANGE_KEY_ONLY, result, has_next);
+    for (size_t i = 0; i < result.size(); ++i)
+    {
+      delete result[i];
+    }
+    return static_cast<int>(result.size());
+  }
+
+protected:
+  LdbInstance* ldb;
+  string dir;
+};
+
+TEST_F(ldb_key_format_test, key_starts_with_bucket)
+{
+  ASSERT_EQ(TAIR_RETURN_SUCCESS, put(ldb, kBucket, 1, 100));
+  ASSERT_EQ(TAIR_RETURN_SUCCESS, put(ldb, kOtherBucket, 2));
+  compact();
+
+  // bucket | area | key, expired time is only in value
+  leveldb::Iterator* it = ldb->db()->NewIterator(leveldb::ReadOptions());
+  int n = 0;
+  for (it->SeekToFirst(); it->Valid(); it->Next(), ++n)
+  {
+    ASSERT_EQ(static_cast<size_t>(LDB_KEY_BUCKET_NUM_SIZE + LDB_KEY_AREA_SIZE + key(1).size()), it->key().size());
+    ASSERT_EQ(n == 0 ? kBucket : kOtherBucket, LdbKey::decode_bucket_number_with_key(it->key().data()));
+    ASSERT_EQ(kArea, LdbKey::decode_area_with_key(it->key().data()));
+    ASSERT_EQ(key(n + 1), string(it->key().data() + LDB_KEY_BUCKET_NUM_SIZE + LDB_KEY_AREA_SIZE, key(1).size()));
+  }
+  delete it;
+  ASSERT_EQ(2, n);
+}
+
+TEST_F(ldb_key_format_test, put_get_over_flush_and_reopen)
+{
+  for (int i = 0; i < 1000; ++i)
+  {
+    ASSERT_EQ(TAIR_RETURN_SUCCESS, put(ldb, kBucket, i));
+  }
+  ASSERT_EQ(value(10), get(ldb, kBucket, 10));
+  ASSERT_EQ(rc_string(TAIR_RETURN_DATA_NOT_EXIST), get(ldb, kOtherBucket, 10));
+  compact();
+  ASSERT_EQ(value(10), get(ldb, kBucket, 10));
+
+  data_entry k;
+  tair_key(k, "", key(20));
+  ASSERT_EQ(TAIR_RETURN_SUCCESS, ldb->remove(kBucket, k, false));
+  reopen();
+  for (int i = 0; i < 1000; ++i)
+  {
+    ASSERT_EQ(i == 20 ? rc_string(TAIR_RETURN_DATA_NOT_EXIST) : value(i), get(ldb, kBucket, i));
+  }
+}
+
+TEST_F(ldb_key_format_test, expire)
+{
+  const uint32_t now = time(NULL);
+  ASSERT_EQ(TAIR_RETURN_SUCCESS, put(ldb, kBucket, 1, 1));
+  ASSERT_EQ(TAIR_RETURN_SUCCESS, put(ldb, kBucket, 2, now + 1000));
+  ASSERT_EQ(TAIR_RETURN_SUCCESS, put(ldb, kBucket, 3));
+  uint32_t edate = 0;
+  ASSERT_EQ(value(2), get(ldb, kBucket, 2, "", &edate));
+  ASSERT_EQ(now + 1000, edate);
+
+  // expired in memtable, and after compaction
+  sleep(2);
+  ASSERT_EQ(rc_string(TAIR_RETURN_DATA_NOT_EXIST), get(ldb, kBucket, 1));
+  compact();
+  ASSERT_EQ(rc_string(TAIR_RETURN_DATA_NOT_EXIST), get(ldb, kBucket, 1));
+  ASSERT_EQ(value(2), get(ldb, kBucket, 2));
+  ASSERT_EQ(value(3), get(ldb, kBucket, 3));
+
+  // expire of existing item is changed by put
+  ASSERT_EQ(TAIR_RETURN_SUCCESS, put(ldb, kBucket, 3, 1));
+  sleep(2);
+  reopen();
+  ASSERT_EQ(rc_string(TAIR_RETURN_DATA_NOT_EXIST), get(ldb, kBucket, 3));
+  ASSERT_EQ(value(2), get(ldb, kBucket, 2, "", &edate));
+  ASSERT_EQ(now + 1000, edate);
+}
+
+TEST_F(ldb_key_format_test, range_and_delete_range)
+{
+  for (int i = 0; i < 100; ++i)
+  {
+    ASSERT_EQ(TAIR_RETURN_SUCCESS, put(ldb, kBucket, i, 0, "p"));
+    ASSERT_EQ(TAIR_RETURN_SUCCESS, put(ldb, kBucket, i, 0, "q"));
+  }
+  // expired one is not in range
+  ASSERT_EQ(TAIR_RETURN_SUCCESS, put(ldb, kBucket, 100, 1, "p"));
+  sleep(2);
+  ASSERT_EQ(100, range_count("p"));
+  compact();
+  ASSERT_EQ(100, range_count("p"));
+  ASSERT_EQ(value(5), get(ldb, kBucket, 5, "p"));
+
+  data_entry key_start, key_end;
+  tair_key(key_start, "p", "");
+  tair_key(key_end, "p", "");
+  vector<data_entry*> result;
+  bool has_next = false;
+  ASSERT_EQ(TAIR_RETURN_SUCCESS, ldb->del_range(kBucket, key_start, key_end, 0, 0, CMD_DEL_RANGE_ALL, result, has_next));
+  ASSERT_TRUE(result.empty());
+  ASSERT_EQ(0, range_count("p"));
+  ASSERT_EQ(rc_string(TAIR_RETURN_DATA_NOT_EXIST), get(ldb, kBucket, 5, "p"));
+  ASSERT_EQ(100, range_count("q"));
+  reopen();
+  ASSERT_EQ(0, range_count("p"));
+  ASSERT_EQ(value(5), get(ldb, kBucket, 5, "q"));
+}
+
+TEST_F(ldb_key_format_test, migrate_items)
+{
+  const uint32_t now = time(NULL);
+  for (int i = 0; i < 3000; ++i)
+  {
+    ASSERT_EQ(TAIR_RETURN_SUCCESS, put(ldb, kBucket, i, i % 2 == 0 ? now + 1000 : 0, i < 100 ? "p" : ""));
+    ASSERT_EQ(TAIR_RETURN_SUCCESS, put(ldb, kOtherBucket, i));
+  }
+  compact();
+
+  // items of bucket are put into destination as data server does
+  LdbInstance* dest = open(1);
+  ASSERT_TRUE(dest != NULL);
+  ASSERT_TRUE(ldb->begin_scan(kBucket));
+  vector<tair::item_data_info*> items;
+  int count = 0;
+  bool still_have = true;
+  while (still_have)
+  {
+    still_have = ldb->get_next_items(items);
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+      tair::item_data_info* item = items[i];
+      data_entry k(item->m_data, item->header.keysize, false);
+      k.data_meta = item->header;
+      k.has_merged = true;
+      k.set_prefix_size(item->header.prefixsize);
+      data_entry v(item->m_data + item->header.keysize, item->header.valsize, false);
+      v.data_meta = item->header;
+      EXPECT_EQ(TAIR_RETURN_SUCCESS, dest->put(kBucket, k, v, false, 0));
+      ++count;
+      delete[] reinterpret_cast<char*>(item);
+    }
+    items.clear();
+  }
+  ldb->end_scan();
+  ASSERT_EQ(3000, count);
+
+  for (int i = 0; i < 3000; ++i)
+  {
+    uint32_t edate = 0;
+    ASSERT_EQ(value(i), get(dest, kBucket, i, i < 100 ? "p" : "", &edate));
+    ASSERT_EQ(i % 2 == 0 ? now + 1000 : 0, edate);
+  }
+  ASSERT_EQ(rc_string(TAIR_RETURN_DATA_NOT_EXIST), get(dest, kOtherBucket, 1));
+  delete dest;
+}
+
+TEST_F(ldb_key_format_test, db_of_other_format_is_refused)
+{
+  delete ldb;
+  ldb = NULL;
+  string cmd = "rm -rf " + dir;
+  ASSERT_EQ(0, system(cmd.c_str()));
+
+  LdbKey::set_format(LDB_KEY_FORMAT_V1);
+  ldb = open(0);
+  ASSERT_TRUE(ldb != NULL);
+  ASSERT_EQ(TAIR_RETURN_SUCCESS, put(ldb, kBucket, 1));
+  delete ldb;
+  ldb = NULL;
+
+  // comparator name differs by format
+  LdbKey::set_format(LDB_KEY_FORMAT_V2);
+  ASSERT_TRUE(open(0) == NULL);
+
+  LdbKey::set_format(LDB_KEY_FORMAT_V1);
+  ldb = open(0);
+  ASSERT_TRUE(ldb != NULL);
+  ASSERT_EQ(value(1), get(ldb, kBucket, 1));
+}
@@ -0,0 +1,285 @@
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "define.hpp"
+#include "data_entry.hpp"
+#include "ldb_instance.hpp"
+
+using namespace std;
+using namespace tair::common;
+using namespace tair::storage::ldb;
+
+static const int kBucket = 1;
+static const int kArea = 7;
+static const int kCount = 100;
+static const int kRangeMaxSize = 1024;
+
+class ldb_range_cursor_test : public testing::Test
+{
+public:
+  ldb_range_cursor_test() : ldb(NULL), dir("/tmp/ldb_range_cursor_test") {}
+
+  // range_max_size is read once, so config is loaded once for all tests
+  static void SetUpTestCase()
+  {
+    const char* conf = "/tmp/ldb_range_cursor_test.conf";
+    FILE* f = fopen(conf, "w");
+    ASSERT_TRUE(f != NULL);
+    fprintf(f, "[%s]\n%s=/tmp/ldb_range_cursor_test/data\n%s=%d\n",
+            TAIRLDB_SECTION, LDB_DATA_DIR, LDB_RANGE_MAX_SIZE, kRangeMaxSize);
+    fclose(f);
+    ASSERT_EQ(EXIT_SUCCESS, TBSYS_CONFIG.load(conf));
+    TBSYS_LOGGER.setLogLevel("warn");
+  }
+
+protected:
+  virtual void SetUp()
+  {
+    destroy();
+    ldb = new LdbInstance(0, true, NULL);
+    vector<int32_t> buckets(1, kBucket);
+    ASSERT_TRUE(ldb->init_buckets(buckets));
+
+    // neighbour prefixes must never show up in range of "p"
+    for (int i = 0; i < 10; ++i)
+    {
+      ASSERT_EQ(TAIR_RETURN_SUCCESS, put("o", skey(i)));
+      ASSERT_EQ(TAIR_RETURN_SUCCESS, put("q", skey(i)));
+    }
+    for (int i = 0; i < kCount; ++i)
+    {
+      ASSERT_EQ(TAIR_RETURN_SUCCESS, put("p", skey(i)));
+    }
+  }
+
+  virtual void TearDown()
+  {
+    delete ldb;
+    ldb = NULL;
+    destroy();
+  }
+
+  void destroy()
+  {
+    string cmd = "rm -rf " + dir;
+    ASSERT_EQ(0, system(cmd.c_str()));
+  }
+
+  static string skey(int i)
+  {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "s%04d", i);
+    return string(buf);
+  }
+
+  static string value(const string& skey)
+  {
+    string v(100, 'v');
+    return v.replace(0, skey.size(), skey);
+  }
+
+  // area | pkey | skey, prefix size is size of pkey
+  static void range_key(data_entry& key, const string& pkey, const string& skey)
+  {
+    data_entry p(pkey.data(), static_cast<int>(pkey.size())), s(skey.data(), static_cast<int>(skey.size()));
+    merge_key(p, s, key);
+    key.merge_area(kArea);
+  }
+
+  int put(const string& pkey, const string& skey)
+  {
+    string v = value(skey);
+    data_entry key, value_entry(v.data(), static_cast<int>(v.size()));
+    range_key(key, pkey, skey);
+    return ldb->put(kBucket, key, value_entry, false, 0);
+  }
+
+  int remove(const string& pkey, const string& skey)
+  {
+    data_entry key;
+    range_key(key, pkey, skey);
+    return ldb->remove(kBucket, key, false);
+  }
+
+  // read one page of "p" in [start, end) or (end, start] if reverse, skeys into keys
+  int get_page(const string& start, const string& end, bool reverse, int offset, int limit,
+               vector<string>& keys, bool& has_next, data_entry* cursor)
+  {
+    data_entry key_start, key_end;
+    range_key(key_start, "p", start);
+    range_key(key_end, "p", end);
+    vector<data_entry*> result;
+    int rc = ldb->get_range(kBucket, key_start, key_end, offset, limit,
+                            reverse ? CMD_RANGE_ALL_REVERSE : CMD_RANGE_ALL, result, has_next, cursor);
+    EXPECT_EQ(0U, result.size() % 2);
+    for (size_t i = 0; i + 1 < result.size(); i += 2)
+    {
+      string k(result[i]->get_data(), result[i]->get_size());
+      EXPECT_EQ(value(k), string(result[i + 1]->get_data(), result[i + 1]->get_size()));
+      keys.push_back(k);
+    }
+    for (size_t i = 0; i < result.size(); ++i)
+    {
+      delete result[i];
+    }
+    return rc;
+  }
+
+  // page with cursor until it is done, return count of pages
+  int get_all(const string& start, const string& end, bool reverse, int limit, vector<string>& keys)
+  {
+    data_entry cursor;
+    bool has_next = true;
+    int pages = 0;
+    while (has_next)
+    {
+      size_t before = keys.size();
+      int rc = get_page(start, end, reverse, 0, limit, keys, has_next, &cursor);
+      ++pages;
+      EXPECT_TRUE(rc == TAIR_RETURN_SUCCESS || (rc == TAIR_RETURN_DATA_NOT_EXIST && !has_next)) << rc;
+      EXPECT_GE(static_cast<size_t>(limit), keys.size() - before);
+      EXPECT_EQ(has_next, cursor.get_size() > 0);
+      if (pages > kCount + 1)
+      {
+        ADD_FAILURE() << "cursor does not move";
+        break;
+      }
+    }
+    return pages;
+  }
+
+protected:
+  LdbInstance* ldb;
+  string dir;
+};
+
+TEST_F(ldb_range_cursor_test, forward_paging)
+{
+  vector<string> keys;
+  ASSERT_EQ(15, get_all("", "", false, 7, keys));
+  ASSERT_EQ(static_cast<size_t>(kCount), keys.size());
+  for (int i = 0; i < kCount; ++i)
+  {
+    ASSERT_EQ(skey(i), keys[i]);
+  }
+
+  // bounded range, end is excluded
+  keys.clear();
+  get_all(skey(10), skey(20), false, 3, keys);
+  ASSERT_EQ(10U, keys.size());
+  ASSERT_EQ(skey(10), keys.front());
+  ASSERT_EQ(skey(19), keys.back());
+}
+
+TEST_F(ldb_range_cursor_test, reverse_paging)
+{
+  vector<string> keys;
+  ASSERT_EQ(15, get_all("", "", true, 7, keys));
+  ASSERT_EQ(static_cast<size_t>(kCount), keys.size());
+  for (int i = 0; i < kCount; ++i)
+  {
+    ASSERT_EQ(skey(kCount - 1 - i), keys[i]);
+  }
+
+  // from start down to end, end is excluded
+  keys.clear();
+  get_all(skey(20), skey(10), true, 3, keys);
+  ASSERT_EQ(10U, keys.size());
+  ASSERT_EQ(skey(20), keys.front());
+  ASSERT_EQ(skey(11), keys.back());
+}
+
+TEST_F(ldb_range_cursor_test, page_break_by_size)
+{
+  // each entry is more than 100 bytes, page is cut by range max size
+  for (int r = 0; r < 2; ++r)
+  {
+    data_entry cursor;
+    vector<string> keys;
+    bool has_next = false;
+    ASSERT_EQ(TAIR_RETURN_SUCCESS, get_page("", "", r == 1, 0, kCount, keys, has_next, &cursor));
+    ASSERT_TRUE(has_next);
+    ASSERT_GT(static_cast<size_t>(kCount), keys.size());
+    ASSERT_LT(static_cast<size_t>(kRangeMaxSize / 200), keys.size());
+
+    // nothing is lost or read twice at page boundaries
+    keys.clear();
+    get_all("", "", r == 1, kCount, keys);
+    ASSERT_EQ(static_cast<size_t>(kCount), keys.size());
+    for (int i = 0; i < kCount; ++i)
+    {
+      ASSERT_EQ(skey(r == 1 ? kCount - 1 - i : i), keys[i]);
+    }
+  }
+}
+
+TEST_F(ldb_range_cursor_test, resume_after_cursor_entry_deleted)
+{
+  for (int r = 0; r < 2; ++r)
+  {
+    const bool reverse = r == 1;
+    data_entry cursor;
+    vector<string> keys;
+    bool has_next = false;
+    ASSERT_EQ(TAIR_RETURN_SUCCESS, get_page("", "", reverse, 0, 5, keys, has_next, &cursor));
+    ASSERT_TRUE(has_next);
+    ASSERT_EQ(5U, keys.size());
+
+    // cursor is the next unread entry, delete it and the one after
+    const int next = reverse ? kCount - 6 : 5;
+    ASSERT_EQ(TAIR_RETURN_SUCCESS, remove("p", skey(next)));
+    ASSERT_EQ(TAIR_RETURN_SUCCESS, remove("p", skey(reverse ? next - 1 : next + 1)));
+    keys.clear();
+    ASSERT_EQ(TAIR_RETURN_SUCCESS, get_page("", "", reverse, 0, 5, keys, has_next, &cursor));
+    ASSERT_TRUE(has_next);
+    ASSERT_EQ(5U, keys.size());
+    // never goes back to entries read already
+    ASSERT_EQ(skey(reverse ? next - 2 : next + 2), keys.front());
+    ASSERT_EQ(skey(reverse ? next - 6 : next + 6), keys.back());
+  }
+}
+
+TEST_F(ldb_range_cursor_test, invalid_cursor)
+{
+  // cursor of other prefix
+  data_entry cursor;
+  range_key(cursor, "q", skey(1));
+  vector<string> keys;
+  bool has_next = false;
+  ASSERT_EQ(TAIR_RETURN_INVALID_ARGUMENT, get_page("", "", false, 0, 5, keys, has_next, &cursor));
+  ASSERT_TRUE(keys.empty());
+}
+
+TEST_F(ldb_range_cursor_test, offset_mode_has_next)
+{
+  vector<string> keys;
+  bool has_next = true;
+  // page full by limit: has_next is false as it always is, client pages on by count
+  ASSERT_EQ(TAIR_RETURN_SUCCESS, get_page("", "", false, 0, 5, keys, has_next, NULL));
+  ASSERT_EQ(5U, keys.size());
+  ASSERT_FALSE(has_next);
+
+  // page full by size
+  keys.clear();
+  ASSERT_EQ(TAIR_RETURN_SUCCESS, get_page("", "", false, 10, kCount, keys, has_next, NULL));
+  ASSERT_TRUE(has_next);
+  ASSERT_EQ(skey(10), keys.front());
+  ASSERT_GT(static_cast<size_t>(kCount - 10), keys.size());
+
+  // last page
+  keys.clear();
+  ASSERT_EQ(TAIR_RETURN_SUCCESS, get_page("", "", true, kCount - 3, 5, keys, has_next, NULL));
+  ASSERT_EQ(3U, keys.size());
+  ASSERT_EQ(skey(2), keys.front());
+  ASSERT_EQ(skey(0), keys.back());
+  ASSERT_FALSE(has_next);
+
+  keys.clear();
+  ASSERT_EQ(TAIR_RETURN_DATA_NOT_EXIST, get_page("", "", false, kCount, 5, keys, has_next, NULL));
+  ASSERT_TRUE(keys.empty());
+  ASSERT_FALSE(has_next);
+}
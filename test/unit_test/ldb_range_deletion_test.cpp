@@ -0,0 +1,288 @@
+#include <gtest/gtest.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/iterator.h"
+#include "leveldb/options.h"
+
+using namespace std;
+
+class ldb_range_deletion_test : public testing::Test
+{
+public:
+  ldb_range_deletion_test() : db(NULL), dbname("/tmp/ldb_range_deletion_test") {}
+
+protected:
+  virtual void SetUp()
+  {
+    destroy();
+    options.create_if_missing = true;
+    options.write_buffer_size = 64 << 10;
+    reopen();
+  }
+
+  virtual void TearDown()
+  {
+    delete db;
+    db = NULL;
+    destroy();
+  }
+
+  void destroy()
+  {
+    // log files are in sub directory
+    string cmd = "rm -rf " + dbname;
+    ASSERT_EQ(0, system(cmd.c_str()));
+  }
+
+  void reopen()
+  {
+    delete db;
+    db = NULL;
+    ASSERT_TRUE(leveldb::DB::Open(options, dbname, &db).ok());
+  }
+
+  static string key(int i)
+  {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "key%06d", i);
+    return string(buf);
+  }
+
+  void put_range(int from, int to, const string& value)
+  {
+    for (int i = from; i < to; ++i)
+    {
+      ASSERT_TRUE(db->Put(leveldb::WriteOptions(), key(i), value).ok());
+    }
+  }
+
+  string get(int i, const leveldb::Snapshot* snapshot = NULL)
+  {
+    leveldb::ReadOptions read_options;
+    read_options.snapshot = snapshot;
+    string value;
+    leveldb::Status s = db->Get(read_options, key(i), &value);
+    return s.ok() ? value : (s.IsNotFound() ? "NOT_FOUND" : s.ToString());
+  }
+
+  int count(const leveldb::Snapshot* snapshot = NULL)
+  {
+    leveldb::ReadOptions read_options;
+    read_options.snapshot = snapshot;
+    leveldb::Iterator* it = db->NewIterator(read_options);
+    int n = 0;
+    for (it->SeekToFirst(); it->Valid(); it->Next())
+    {
+      ++n;
+    }
+    delete it;
+    return n;
+  }
+
+  void delete_range(int from, int to)
+  {
+    ASSERT_TRUE(db->DeleteRange(leveldb::WriteOptions(), key(from), key(to)).ok());
+  }
+
+protected:
+  leveldb::DB* db;
+  leveldb::Options options;
+  string dbname;
+};
+
+TEST_F(ldb_range_deletion_test, delete_memtable_and_table_entries)
+{
+  put_range(0, 1000, "v1");
+  db->CompactRange(NULL, NULL);
+  put_range(500, 600, "v2");   // in memtable
+  delete_range(100, 700);
+
+  ASSERT_EQ("v1", get(99));
+  ASSERT_EQ("NOT_FOUND", get(100));
+  ASSERT_EQ("NOT_FOUND", get(550));
+  ASSERT_EQ("NOT_FOUND", get(699));
+  ASSERT_EQ("v1", get(700));
+  ASSERT_EQ(400, count());
+
+  // written after deletion is not covered
+  put_range(200, 210, "v3");
+  ASSERT_EQ("v3", get(205));
+  ASSERT_EQ(410, count());
+
+  ASSERT_FALSE(db->DeleteRange(leveldb::WriteOptions(), key(5), key(5)).ok());
+}
+
+TEST_F(ldb_range_deletion_test, overlapped_deletions)
+{
+  put_range(0, 100, "v1");
+  delete_range(10, 30);
+  put_range(20, 40, "v2");
+  delete_range(35, 50);
+  delete_range(5, 15);
+
+  ASSERT_EQ("v1", get(4));
+  ASSERT_EQ("NOT_FOUND", get(5));
+  ASSERT_EQ("NOT_FOUND", get(19));
+  ASSERT_EQ("v2", get(20));
+  ASSERT_EQ("v2", get(34));
+  ASSERT_EQ("NOT_FOUND", get(35));
+  ASSERT_EQ("NOT_FOUND", get(49));
+  ASSERT_EQ("v1", get(50));
+  ASSERT_EQ(5 + 15 + 50, count());
+}
+
+TEST_F(ldb_range_deletion_test, snapshot_sees_covered_entries)
+{
+  put_range(0, 1000, "v1");
+  const leveldb::Snapshot* snapshot = db->GetSnapshot();
+  delete_range(0, 500);
+
+  ASSERT_EQ("NOT_FOUND", get(10));
+  ASSERT_EQ("v1", get(10, snapshot));
+  ASSERT_EQ(500, count());
+  ASSERT_EQ(1000, count(snapshot));
+
+  // flush and compaction keep covered entries for the snapshot
+  db->CompactRange(NULL, NULL);
+  ASSERT_EQ("v1", get(10, snapshot));
+  ASSERT_EQ(1000, count(snapshot));
+  int remaining = -1;
+  ASSERT_TRUE(db->CompactRangeDeletions(&remaining).ok());
+  ASSERT_EQ(1, remaining);
+  ASSERT_EQ("v1", get(499, snapshot));
+
+  // dropped once no snapshot can see them, then deletion is reclaimed
+  db->ReleaseSnapshot(snapshot);
+  ASSERT_TRUE(db->CompactRangeDeletions(&remaining).ok());
+  ASSERT_EQ(0, remaining);
+  ASSERT_EQ("NOT_FOUND", get(10));
+  ASSERT_EQ("v1", get(500));
+  ASSERT_EQ(500, count());
+}
+
+TEST_F(ldb_range_deletion_test, survive_reopen)
+{
+  put_range(0, 1000, "v1");
+  db->CompactRange(NULL, NULL);
+  put_range(0, 100, "v2");     // only in log
+  delete_range(50, 150);
+  put_range(60, 70, "v3");
+
+  reopen();
+  ASSERT_EQ("v2", get(49));
+  ASSERT_EQ("NOT_FOUND", get(50));
+  ASSERT_EQ("v3", get(65));
+  ASSERT_EQ("NOT_FOUND", get(149));
+  ASSERT_EQ("v1", get(150));
+  ASSERT_EQ(910, count());
+
+  int remaining = -1;
+  ASSERT_TRUE(db->CompactRangeDeletions(&remaining).ok());
+  ASSERT_EQ(0, remaining);
+  reopen();
+  ASSERT_EQ("NOT_FOUND", get(100));
+  ASSERT_EQ("v3", get(60));
+  ASSERT_EQ(910, count());
+}
+
+TEST_F(ldb_range_deletion_test, survive_reopen_without_later_write)
+{
+  put_range(0, 1000, "v1");
+  db->CompactRange(NULL, NULL);
+  delete_range(100, 200);
+
+  // last write is the deletion
+  reopen();
+  ASSERT_EQ("v1", get(99));
+  ASSERT_EQ("NOT_FOUND", get(100));
+  ASSERT_EQ("NOT_FOUND", get(199));
+  ASSERT_EQ(900, count());
+
+  // next deletion takes a new sequence, both are kept
+  delete_range(300, 400);
+  reopen();
+  ASSERT_EQ("NOT_FOUND", get(150));
+  ASSERT_EQ("NOT_FOUND", get(350));
+  ASSERT_EQ("v1", get(400));
+  ASSERT_EQ(800, count());
+  string property;
+  ASSERT_TRUE(db->GetProperty("leveldb.num-range-deletions", &property));
+  ASSERT_EQ("2", property);
+}
+
+TEST_F(ldb_range_deletion_test, reclaimed_after_compaction)
+{
+  put_range(0, 2000, "v1");
+  delete_range(0, 1000);
+  // memtable still holds covered entries
+  int remaining = -1;
+  ASSERT_TRUE(db->CompactRangeDeletions(&remaining).ok());
+  ASSERT_EQ(1, remaining);
+  ASSERT_EQ(1000, count());
+  string property;
+  ASSERT_TRUE(db->GetProperty("leveldb.num-range-deletions", &property));
+  ASSERT_EQ("1", property);
+
+  put_range(3000, 3010, "v2");
+  db->CompactRange(NULL, NULL);
+  ASSERT_TRUE(db->CompactRangeDeletions(&remaining).ok());
+  ASSERT_EQ(0, remaining);
+  property.clear();
+  ASSERT_TRUE(db->GetProperty("leveldb.num-range-deletions", &property));
+  ASSERT_EQ("0", property);
+  ASSERT_EQ(1010, count());
+  ASSERT_EQ("NOT_FOUND", get(999));
+  ASSERT_EQ("v1", get(1000));
+}
+
+struct writer_arg
+{
+  leveldb::DB* db;
+  volatile bool stop;
+  int written;
+};
+
+static void* keep_writing(void* arg)
+{
+  writer_arg* w = reinterpret_cast<writer_arg*>(arg);
+  char buf[16];
+  string value(100, 'w');
+  for (w->written = 0; !w->stop; ++w->written)
+  {
+    snprintf(buf, sizeof(buf), "zkey%06d", w->written);
+    w->db->Put(leveldb::WriteOptions(), buf, value);
+  }
+  return NULL;
+}
+
+TEST_F(ldb_range_deletion_test, delete_while_flushing)
+{
+  put_range(0, 5000, string(100, 'v'));
+  writer_arg w;
+  w.db = db;
+  w.stop = false;
+  pthread_t tid;
+  ASSERT_EQ(0, pthread_create(&tid, NULL, keep_writing, &w));
+  // flush and compaction run meanwhile, their outputs may hold covered entries
+  for (int i = 0; i < 5000; i += 250)
+  {
+    delete_range(i, i + 250);
+  }
+  w.stop = true;
+  pthread_join(tid, NULL);
+
+  ASSERT_EQ(w.written, count());
+  db->CompactRange(NULL, NULL);
+  int remaining = -1;
+  ASSERT_TRUE(db->CompactRangeDeletions(&remaining).ok());
+  ASSERT_EQ(0, remaining);
+  ASSERT_EQ(w.written, count());
+  reopen();
+  ASSERT_EQ(w.written, count());
+}
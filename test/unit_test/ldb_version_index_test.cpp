@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "define.hpp"
+#include "data_entry.hpp"
+#include "ldb_instance.hpp"
+
+using namespace std;
+using namespace tair::common;
+using namespace tair::storage::ldb;
+
+static const int kBucket = 1;
+static const int kArea = 3;
+static const int kCount = 5;
+
+class ldb_version_index_test : public testing::Test
+{
+public:
+  ldb_version_index_test() : ldb(NULL), dir("/tmp/ldb_version_index_test") {}
+
+  // blind write mode is on when version index has slots
+  static void SetUpTestCase()
+  {
+    const char* conf = "/tmp/ldb_version_index_test.conf";
+    FILE* f = fopen(conf, "w");
+    ASSERT_TRUE(f != NULL);
+    fprintf(f, "[%s]\n%s=/tmp/ldb_version_index_test/data\n%s=1024\n",
+            TAIRLDB_SECTION, LDB_DATA_DIR, LDB_VERSION_INDEX_SLOT_COUNT);
+    fclose(f);
+    ASSERT_EQ(EXIT_SUCCESS, TBSYS_CONFIG.load(conf));
+    TBSYS_LOGGER.setLogLevel("warn");
+  }
+
+protected:
+  virtual void SetUp()
+  {
+    destroy();
+    ldb = new LdbInstance(0, true, NULL);
+    vector<int32_t> buckets(1, kBucket);
+    ASSERT_TRUE(ldb->init_buckets(buckets));
+  }
+
+  virtual void TearDown()
+  {
+    delete ldb;
+    ldb = NULL;
+    destroy();
+  }
+
+  void destroy()
+  {
+    string cmd = "rm -rf " + dir;
+    ASSERT_EQ(0, system(cmd.c_str()));
+  }
+
+  static string skey(int i)
+  {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "s%04d", i);
+    return string(buf);
+  }
+
+  // area | pkey | skey, prefix size is size of pkey
+  static void range_key(data_entry& key, const string& pkey, const string& skey)
+  {
+    data_entry p(pkey.data(), static_cast<int>(pkey.size())), s(skey.data(), static_cast<int>(skey.size()));
+    merge_key(p, s, key);
+    key.merge_area(kArea);
+  }
+
+  // version care put, version of item after put is in *item_version
+  int put(int i, int version, int* item_version = NULL)
+  {
+    string v = "value_" + skey(i);
+    data_entry key, value(v.data(), static_cast<int>(v.size()));
+    range_key(key, "p", skey(i));
+    key.data_meta.version = version;
+    int rc = ldb->put(kBucket, key, value, true, 0);
+    if (item_version != NULL)
+    {
+      *item_version = key.data_meta.version;
+    }
+    return rc;
+  }
+
+  // every key is written twice, so it is at version 2 and in version index
+  void put_twice()
+  {
+    for (int i = 0; i < kCount; ++i)
+    {
+      int version = 0;
+      ASSERT_EQ(TAIR_RETURN_SUCCESS, put(i, 0));
+      ASSERT_EQ(TAIR_RETURN_SUCCESS, put(i, 1, &version));
+      ASSERT_EQ(2, version);
+    }
+  }
+
+  // a put with old version is a new item once the key is deleted
+  void check_put_after_delete()
+  {
+    for (int i = 0; i < kCount; ++i)
+    {
+      int version = 0;
+      ASSERT_EQ(TAIR_RETURN_SUCCESS, put(i, 1, &version)) << skey(i);
+      ASSERT_EQ(1, version) << skey(i);
+    }
+  }
+
+protected:
+  LdbInstance* ldb;
+  string dir;
+};
+
+TEST_F(ldb_version_index_test, put_checks_version_from_index)
+{
+  put_twice();
+  int version = 0;
+  ASSERT_EQ(TAIR_RETURN_VERSION_ERROR, put(0, 1));
+  ASSERT_EQ(TAIR_RETURN_SUCCESS, put(0, 2, &version));
+  ASSERT_EQ(3, version);
+}
+
+TEST_F(ldb_version_index_test, remove)
+{
+  put_twice();
+  for (int i = 0; i < kCount; ++i)
+  {
+    data_entry key;
+    range_key(key, "p", skey(i));
+    ASSERT_EQ(TAIR_RETURN_SUCCESS, ldb->remove(kBucket, key, false));
+  }
+  check_put_after_delete();
+}
+
+TEST_F(ldb_version_index_test, del_range)
+{
+  const int types[] = {CMD_DEL_RANGE, CMD_DEL_RANGE_REVERSE, CMD_DEL_RANGE_ALL};
+  for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); ++t)
+  {
+    put_twice();
+    data_entry key_start, key_end;
+    range_key(key_start, "p", "");
+    range_key(key_end, "p", "");
+    vector<data_entry*> result;
+    bool has_next = true;
+    ASSERT_EQ(TAIR_RETURN_SUCCESS, ldb->del_range(kBucket, key_start, key_end, 0, kCount * 2, types[t],
+                                                  result, has_next)) << types[t];
+    ASSERT_FALSE(has_next);
+    ASSERT_EQ(static_cast<size_t>(types[t] == CMD_DEL_RANGE_ALL ? 0 : kCount), result.size());
+    for (size_t i = 0; i < result.size(); ++i)
+    {
+      delete result[i];
+    }
+    check_put_after_delete();
+
+    // clean up for next type
+    for (int i = 0; i < kCount; ++i)
+    {
+      data_entry key;
+      range_key(key, "p", skey(i));
+      ASSERT_EQ(TAIR_RETURN_SUCCESS, ldb->remove(kBucket, key, false));
+    }
+  }
+}